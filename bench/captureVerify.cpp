@@ -0,0 +1,516 @@
+// Capture path checks against the synthetic backend, QtCore / QtGui only so it runs on Linux CI ( QT_QPA_PLATFORM=offscreen )
+//
+//  SnippingToolCaptureVerify
+//
+// session     : CCaptureService over CSyntheticBackend::SetScript scripts ( static desktop, a burst of presents,
+//               pointer-only updates, access lost once and for good ), status, frame reason and sessions built per capture;
+//               a fresh frame of the same session must differ from the previous image, a cached one must be the same image
+// canvas      : CaptureAll over synthetic layouts with negative origins and mixed sizes against every output's pattern
+//               placed by hand; each slice must be a view at its output's offset, the gaps between outputs transparent,
+//               CDesktopStrips fed uneven strips and CaptureRegion across a gap must give the same pixels
+// failures    : CaptureAll, CaptureRegion and CaptureOutputs over outputs that time out or lose access, the status of
+//               each call and a null image unless at least one output was captured
+// async       : CaptureAllAsync, CaptureOutputsAsync and CaptureRegionAsync over sessions that take long to open ( real time ):
+//               started before the deadline and kept, queued past it, canceled while queued, nothing presented;
+//               all three must finish with the same status
+// files       : SupportedImageFormats, then a capture with transparent gaps written ( WriteImage ) and read back ( ReadImage )
+//               through every lossless format, the kernel's qoi / raw and png
+//
+// exit code 0 when every check passed, 1 otherwise
+
+#include "../src/captureService.hpp"
+#include "../src/imageFile.hpp"
+#include "../src/syntheticBackend.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace nsCapture;
+
+namespace
+{
+    typedef CScriptedDuplicationSource  CScriptedSource;
+
+    // struct tagSessionStep_s : one CaptureOutput call and what it must return
+    typedef struct tagSessionStep_s
+    {
+        tagCaptureStatus                Status;
+        tagFrameReason                  Reason;
+    } tagSessionStep;
+
+    const char* statusName( tagCaptureStatus Status )
+    {
+        switch( Status )
+        {
+            case tagCaptureStatus_Ok:           return "ok";
+            case tagCaptureStatus_Timeout:      return "timeout";
+            case tagCaptureStatus_AccessLost:   return "access-lost";
+            case tagCaptureStatus_NoOutput:     return "no-output";
+            case tagCaptureStatus_Canceled:     return "canceled";
+            default:                            return "failed";
+        }
+    }
+
+    // every session of the backend runs Script, the captures run back to back on one output
+    bool runScriptedSession( const char* Name, CSyntheticBackend::ScriptFn Script, const std::vector< tagSessionStep >& Steps, quint64 SessionsBuilt )
+    {
+        auto Backend = std::make_unique< CSyntheticBackend >( QVector< QRect >{ QRect( 0, 0, 640, 360 ) } );
+        Backend->SetScript( std::move( Script ) );
+        CCaptureService Service( std::move( Backend ) );
+
+        tagCaptureRequest Request;
+        Request.TimeoutMs = 50;
+
+        bool IsExact = true;
+        QImage Previous;
+        QString Trail;
+
+        for( const auto& Step : Steps )
+        {
+            QImage Image;
+            tagFrameReason Reason = tagFrameReason_None;
+            const quint64 BuiltBefore = Service.Stats().SessionsBuilt;
+            const auto Status = Service.CaptureOutput( 0, Request, &Image, &Reason );
+            // a rebuilt session starts its pattern over
+            const bool IsSameSession = Service.Stats().SessionsBuilt == BuiltBefore;
+
+            bool IsStepExact = Status == Step.Status && Reason == Step.Reason;
+            if( Status == tagCaptureStatus_Ok && Reason == tagFrameReason_Fresh )
+                IsStepExact &= Image.isNull() == false && ( IsSameSession == false || Image != Previous );
+            else if( Status == tagCaptureStatus_Ok && Reason == tagFrameReason_Cached )
+                IsStepExact &= Image.isNull() == false && Image == Previous;
+
+            if( Status == tagCaptureStatus_Ok )
+                Previous = Image;
+
+            Trail += QString( " %1/%2" ).arg( statusName( Status ) ).arg( FrameReasonToString( Reason ) );
+            IsExact &= IsStepExact;
+        }
+
+        const auto Stats = Service.Stats();
+        IsExact &= Stats.SessionsBuilt == SessionsBuilt;
+
+        printf( "session %-24s |%s | sessions %llu ( expected %llu ) | %s\n", Name, qPrintable( Trail ),
+                ( unsigned long long )Stats.SessionsBuilt, ( unsigned long long )SessionsBuilt, IsExact ? "exact" : "MISMATCH" );
+
+        return IsExact;
+    }
+
+    bool runScriptedSessions()
+    {
+        bool IsExact = true;
+
+        // nothing is ever presented : the cold capture waits to its deadline with nothing to fall back on
+        IsExact &= runScriptedSession( "static desktop", []( const tagOutputInfo&, CScriptedSource* ) {},
+            { { tagCaptureStatus_Timeout, tagFrameReason_Timeout }, { tagCaptureStatus_Timeout, tagFrameReason_Timeout } }, 1 );
+
+        IsExact &= runScriptedSession( "present, then static", []( const tagOutputInfo&, CScriptedSource* pSource ) {
+            pSource->Push( CScriptedSource::tagScriptEvent_Present );
+        }, { { tagCaptureStatus_Ok, tagFrameReason_Fresh }, { tagCaptureStatus_Ok, tagFrameReason_Cached }, { tagCaptureStatus_Ok, tagFrameReason_Cached } }, 1 );
+
+        // queued presents are picked up by warm captures without waiting, then the last frame is reused
+        IsExact &= runScriptedSession( "burst", []( const tagOutputInfo&, CScriptedSource* pSource ) {
+            pSource->Push( CScriptedSource::tagScriptEvent_Present, 0, 3 );
+        }, { { tagCaptureStatus_Ok, tagFrameReason_Fresh }, { tagCaptureStatus_Ok, tagFrameReason_Fresh },
+             { tagCaptureStatus_Ok, tagFrameReason_Fresh }, { tagCaptureStatus_Ok, tagFrameReason_Cached } }, 1 );
+
+        IsExact &= runScriptedSession( "mouse only", []( const tagOutputInfo&, CScriptedSource* pSource ) {
+            pSource->Push( CScriptedSource::tagScriptEvent_Present );
+            pSource->Push( CScriptedSource::tagScriptEvent_MouseOnly, 0, 3 );
+        }, { { tagCaptureStatus_Ok, tagFrameReason_Fresh }, { tagCaptureStatus_Ok, tagFrameReason_Cached } }, 1 );
+
+        // the lost session is rebuilt within the same capture, the new one presents again
+        IsExact &= runScriptedSession( "access lost once", []( const tagOutputInfo&, CScriptedSource* pSource ) {
+            pSource->Push( CScriptedSource::tagScriptEvent_Present );
+            pSource->Push( CScriptedSource::tagScriptEvent_AccessLost );
+        }, { { tagCaptureStatus_Ok, tagFrameReason_Fresh }, { tagCaptureStatus_Ok, tagFrameReason_Fresh } }, 2 );
+
+        // a rebuilt session that loses access again is reported, the next capture starts over
+        IsExact &= runScriptedSession( "access lost for good", []( const tagOutputInfo&, CScriptedSource* pSource ) {
+            pSource->Push( CScriptedSource::tagScriptEvent_AccessLost );
+        }, { { tagCaptureStatus_AccessLost, tagFrameReason_AccessLost }, { tagCaptureStatus_AccessLost, tagFrameReason_AccessLost } }, 4 );
+
+        return IsExact;
+    }
+
+    // every output's pattern of its first present, placed by hand; what is not covered stays transparent
+    QImage expectedDesktop( const QVector< tagOutputInfo >& Outputs, const QRect& Bounds )
+    {
+        QImage Desktop( Bounds.size(), QImage::Format_ARGB32_Premultiplied );
+        Desktop.fill( Qt::transparent );
+
+        for( const auto& Output : Outputs )
+        {
+            QImage Frame( Output.Bounds.size(), QImage::Format_ARGB32_Premultiplied );
+            CSyntheticBackend::RenderPattern( Output, 1, &Frame );
+
+            const QPoint At = Output.Bounds.topLeft() - Bounds.topLeft();
+            for( int y = 0; y < Frame.height(); ++y )
+                memcpy( Desktop.scanLine( At.y() + y ) + At.x() * 4, Frame.constScanLine( y ), ( size_t )Frame.width() * 4 );
+        }
+
+        return Desktop;
+    }
+
+    // mismatching pixels per output ( canvas coordinates ), the last entry counts the gaps
+    QVector< qint64 > countMismatches( const QImage& Image, const QImage& Expected, const QVector< QRect >& Rects )
+    {
+        QVector< qint64 > Mismatches( Rects.size() + 1, 0 );
+        if( Image.size() != Expected.size() || Image.format() != Expected.format() )
+        {
+            Mismatches.fill( -1 );
+            return Mismatches;
+        }
+
+        for( int y = 0; y < Image.height(); ++y )
+        {
+            const quint32* pLine = reinterpret_cast< const quint32* >( Image.constScanLine( y ) );
+            const quint32* pExpected = reinterpret_cast< const quint32* >( Expected.constScanLine( y ) );
+
+            for( int x = 0; x < Image.width(); ++x )
+            {
+                if( pLine[ x ] == pExpected[ x ] )
+                    continue;
+
+                int Owner = 0;
+                while( Owner < Rects.size() && Rects[ Owner ].contains( x, y ) == false )
+                    ++Owner;
+                ++Mismatches[ Owner ];
+            }
+        }
+
+        return Mismatches;
+    }
+
+    // the desktop composed a strip at a time from per-output frames, strip heights cycle through uneven sizes
+    QImage composeStrips( const CDesktopStrips& Strips )
+    {
+        const QRect Bounds = Strips.Bounds();
+        QImage Desktop( Bounds.size(), QImage::Format_ARGB32_Premultiplied );
+        const int Heights[] = { 1, 7, 64, 3, 300, 2, 1000 };
+
+        int Row = 0;
+        for( size_t i = 0; Row < Bounds.height(); ++i )
+        {
+            const int Rows = qMin( Heights[ i % ( sizeof( Heights ) / sizeof( Heights[ 0 ] ) ) ], Bounds.height() - Row );
+            QImage Strip( Bounds.width(), Rows, QImage::Format_ARGB32_Premultiplied );
+            // leftovers of an earlier strip must not show through the gaps
+            Strip.fill( Qt::red );
+            if( Strips.Fill( Row, &Strip ) == false )
+                return QImage();
+
+            for( int y = 0; y < Rows; ++y )
+                memcpy( Desktop.scanLine( Row + y ), Strip.constScanLine( y ), ( size_t )Bounds.width() * 4 );
+            Row += Rows;
+        }
+
+        return Desktop;
+    }
+
+    bool runCanvasLayout( const QString& Layout, const QRect& Region )
+    {
+        const auto OutputBounds = CSyntheticBackend::ParseLayout( Layout );
+        CCaptureService Service( std::make_unique< CSyntheticBackend >( OutputBounds ) );
+
+        const auto Outputs = Service.Outputs();
+        const QRect Desktop = Service.VirtualBounds();
+        const QImage Expected = expectedDesktop( Outputs, Desktop );
+
+        QVector< QRect > Rects;
+        QVector< int > Idxs;
+        for( const auto& Output : Outputs )
+        {
+            Rects.push_back( Output.Bounds.translated( -Desktop.topLeft() ) );
+            Idxs.push_back( Output.Idx );
+        }
+
+        bool IsExact = OutputBounds.isEmpty() == false && Outputs.size() == OutputBounds.size();
+
+        // slices are views into the canvas at their output's offset
+        CDesktopCanvas Canvas;
+        IsExact &= Canvas.Reset( OutputBounds ) && Canvas.Bounds() == Desktop;
+        for( int i = 0; i < Outputs.size(); ++i )
+        {
+            const QImage Slice = Canvas.Slice( Outputs[ i ].Bounds );
+            IsExact &= Canvas.SliceRect( Outputs[ i ].Bounds ) == Rects[ i ] && Slice.size() == Rects[ i ].size()
+                    && Slice.constBits() == Canvas.Image().constScanLine( Rects[ i ].top() ) + Rects[ i ].left() * 4;
+        }
+
+        tagCaptureRequest Request;
+        const QImage All = Service.CaptureAll( Request );
+        const auto Mismatches = countMismatches( All, Expected, Rects );
+
+        QString Trail;
+        for( int i = 0; i < Mismatches.size(); ++i )
+        {
+            IsExact &= Mismatches[ i ] == 0;
+            if( i < Rects.size() )
+                Trail += QString( " output %1 @ %2,%3 %4" ).arg( i ).arg( Rects[ i ].left() ).arg( Rects[ i ].top() ).arg( Mismatches[ i ] );
+            else
+                Trail += QString( " | gaps %1" ).arg( Mismatches[ i ] );
+        }
+
+        // the save path : per-output frames composed a strip at a time
+        QVector< QImage > Frames;
+        CDesktopStrips Strips;
+        const bool IsStripsExact = Service.CaptureOutputs( Idxs, Request, &Frames ) == Idxs.size()
+                                && Strips.Reset( OutputBounds, Frames ) && Strips.Bounds() == Desktop
+                                && composeStrips( Strips ) == Expected;
+
+        const QImage Part = Service.CaptureRegion( Region, Request );
+        const bool IsRegionExact = Part == Expected.copy( Region.translated( -Desktop.topLeft() ) );
+
+        IsExact &= IsStripsExact && IsRegionExact;
+
+        printf( "canvas %-48s | %dx%d @ %d,%d |%s | strips %s | region %s | %s\n", qPrintable( Layout ),
+                Desktop.width(), Desktop.height(), Desktop.left(), Desktop.top(), qPrintable( Trail ),
+                IsStripsExact ? "exact" : "MISMATCH", IsRegionExact ? "exact" : "MISMATCH", IsExact ? "exact" : "MISMATCH" );
+
+        return IsExact;
+    }
+
+    bool runCanvasLayouts()
+    {
+        bool IsExact = true;
+
+        // left of and above the primary, mixed sizes, gaps above / below the shorter outputs
+        IsExact &= runCanvasLayout( QStringLiteral( "1920x1080+-1920+0;2560x1440+0+-200;1280x1024+2560+0" ), QRect( -100, -150, 2800, 400 ) );
+        // X11 style offsets, a portrait output reaching above and below its neighbour
+        IsExact &= runCanvasLayout( QStringLiteral( "1920x1080+0+0;1080x1920+1920-420;1280x720-1280+1000" ), QRect( -640, 900, 3000, 600 ) );
+        // the same layouts written both ways parse the same
+        IsExact &= CSyntheticBackend::ParseLayout( QStringLiteral( "1920x1080-1920+0;2560x1440+0-200" ) )
+                == CSyntheticBackend::ParseLayout( QStringLiteral( "1920x1080+-1920+0;2560x1440+0+-200" ) );
+
+        return IsExact;
+    }
+
+    // every multi output capture on a fresh service whose sessions run Script, all three must report Expected
+    bool runFailedCapture( const char* Name, CSyntheticBackend::ScriptFn Script, tagCaptureStatus Expected, int ExpectedCaptured )
+    {
+        auto Backend = std::make_unique< CSyntheticBackend >( CSyntheticBackend::ParseLayout( QStringLiteral( "320x200+0+0;160x120+320+40" ) ) );
+        Backend->SetScript( std::move( Script ) );
+        CCaptureService Service( std::move( Backend ) );
+
+        tagCaptureRequest Request;
+        Request.TimeoutMs = 50;
+
+        tagCaptureStatus AllStatus = tagCaptureStatus_Ok;
+        tagCaptureStatus RegionStatus = tagCaptureStatus_Ok;
+        tagCaptureStatus OutputsStatus = tagCaptureStatus_Ok;
+
+        const QImage All = Service.CaptureAll( Request, nullptr, &AllStatus );
+        const QImage Part = Service.CaptureRegion( QRect( 100, 50, 300, 100 ), Request, nullptr, &RegionStatus );
+        QVector< QImage > Frames;
+        const int Captured = Service.CaptureOutputs( { 0, 1 }, Request, &Frames, nullptr, &OutputsStatus );
+
+        const bool IsNull = ExpectedCaptured == 0;
+        const bool IsExact = AllStatus == Expected && RegionStatus == Expected && OutputsStatus == Expected && Captured == ExpectedCaptured
+                          && All.isNull() == IsNull && Part.isNull() == IsNull;
+
+        printf( "failed %-24s | all %s%s | region %s%s | outputs %s, %d captured | %s\n", Name,
+                statusName( AllStatus ), All.isNull() ? " null" : "", statusName( RegionStatus ), Part.isNull() ? " null" : "",
+                statusName( OutputsStatus ), Captured, IsExact ? "exact" : "MISMATCH" );
+
+        return IsExact;
+    }
+
+    bool runFailedCaptures()
+    {
+        bool IsExact = true;
+
+        // nothing is ever presented, every cold output times out
+        IsExact &= runFailedCapture( "static desktop", []( const tagOutputInfo&, CScriptedSource* ) {}, tagCaptureStatus_Timeout, 0 );
+
+        IsExact &= runFailedCapture( "access lost for good", []( const tagOutputInfo&, CScriptedSource* pSource ) {
+            pSource->Push( CScriptedSource::tagScriptEvent_AccessLost );
+        }, tagCaptureStatus_AccessLost, 0 );
+
+        // the second output never presents : the image keeps the first, the status still reports the timeout
+        IsExact &= runFailedCapture( "one output static", []( const tagOutputInfo& Output, CScriptedSource* pSource ) {
+            if( Output.Idx == 0 )
+                pSource->Push( CScriptedSource::tagScriptEvent_Present );
+        }, tagCaptureStatus_Timeout, 1 );
+
+        return IsExact;
+    }
+
+    // session creation ( device, duplication ) takes this long in wall clock time, the scripts still run on virtual time
+    const int SLOW_OPEN_MS = 200;
+
+    // struct tagAsyncCase_s : one asynchronous capture on a fresh service
+    typedef struct tagAsyncCase_s
+    {
+        const char*                     Name;
+        bool                            IsPresenting;       // one present per session, otherwise every cold output times out
+        int                             Blockers;           // captures without a deadline queued first ( the pool runs two )
+        int                             DeadlineMs;
+        bool                            IsCanceled;         // canceled right after it was queued
+        tagCaptureStatus                Status;             // Canceled : no result
+        bool                            HasImage;
+    } tagAsyncCase;
+
+    typedef std::function< QFuture< tagCaptureResult >( CCaptureService& Service, const tagCaptureRequest& Request, int DeadlineMs ) >  AsyncCaptureFn;
+
+    tagCaptureStatus runAsyncCapture( const tagAsyncCase& Case, const AsyncCaptureFn& Capture, bool* pRetHasImage )
+    {
+        auto Backend = std::make_unique< CSyntheticBackend >( CSyntheticBackend::ParseLayout( QStringLiteral( "320x200+0+0;160x120+320+40" ) ) );
+        const bool IsPresenting = Case.IsPresenting;
+        Backend->SetScript( [IsPresenting]( const tagOutputInfo&, CScriptedSource* pSource ) {
+            std::this_thread::sleep_for( std::chrono::milliseconds( SLOW_OPEN_MS ) );
+            if( IsPresenting )
+                pSource->Push( CScriptedSource::tagScriptEvent_Present );
+        } );
+        CCaptureService Service( std::move( Backend ) );
+
+        tagCaptureRequest Request;
+        Request.TimeoutMs = 50;
+
+        std::vector< QFuture< tagCaptureResult > > Blockers;
+        for( int i = 0; i < Case.Blockers; ++i )
+            Blockers.push_back( Service.CaptureAllAsync( Request ) );
+
+        auto Future = Capture( Service, Request, Case.DeadlineMs );
+        if( Case.IsCanceled )
+            Future.cancel();
+
+        Future.waitForFinished();
+        for( auto& Blocker : Blockers )
+            Blocker.waitForFinished();
+
+        *pRetHasImage = false;
+        if( Future.isCanceled() || Future.resultCount() == 0 )
+            return tagCaptureStatus_Canceled;
+
+        const auto Result = Future.result();
+        *pRetHasImage = Result.Image.isNull() == false
+                     || std::any_of( Result.Images.cbegin(), Result.Images.cend(), []( const QImage& Image ) { return Image.isNull() == false; } );
+        return Result.Status;
+    }
+
+    bool runAsyncCaptures()
+    {
+        const tagAsyncCase Cases[] = {
+            // every output starts at once and finishes after the deadline, the frames are kept
+            { "started before the deadline",    true,   0,  50,     false,  tagCaptureStatus_Ok,        true    },
+            // both pool threads are busy opening sessions until long after the deadline, nothing starts
+            { "queued past the deadline",       true,   2,  50,     false,  tagCaptureStatus_Timeout,   false   },
+            { "canceled while queued",          true,   2,  0,      true,   tagCaptureStatus_Canceled,  false   },
+            { "nothing presented",              false,  0,  0,      false,  tagCaptureStatus_Timeout,   false   },
+        };
+
+        const std::pair< const char*, AsyncCaptureFn > Captures[] = {
+            { "all", []( CCaptureService& Service, const tagCaptureRequest& Request, int DeadlineMs ) {
+                return Service.CaptureAllAsync( Request, DeadlineMs );
+            } },
+            { "outputs", []( CCaptureService& Service, const tagCaptureRequest& Request, int DeadlineMs ) {
+                return Service.CaptureOutputsAsync( { 0, 1 }, Request, DeadlineMs );
+            } },
+            { "region", []( CCaptureService& Service, const tagCaptureRequest& Request, int DeadlineMs ) {
+                return Service.CaptureRegionAsync( QRect( 100, 50, 300, 100 ), Request, DeadlineMs );
+            } },
+        };
+
+        bool IsExact = true;
+        for( const auto& Case : Cases )
+        {
+            bool IsCaseExact = true;
+            QString Trail;
+            for( const auto& Item : Captures )
+            {
+                bool HasImage = false;
+                const auto Status = runAsyncCapture( Case, Item.second, &HasImage );
+                IsCaseExact &= Status == Case.Status && HasImage == Case.HasImage;
+                Trail += QString( " %1 %2%3 |" ).arg( Item.first ).arg( statusName( Status ) ).arg( HasImage ? "" : " null" );
+            }
+
+            printf( "async  %-28s |%s %s\n", Case.Name, qPrintable( Trail ), IsCaseExact ? "exact" : "MISMATCH" );
+            IsExact &= IsCaseExact;
+        }
+
+        return IsExact;
+    }
+
+    // Image written as Format and read back, compared premultiplied ( exact for opaque pixels and transparent gaps )
+    bool runFileRoundTrip( const QImage& Image, const QByteArray& Format, const QString& Dir )
+    {
+        const QString FilePath = Dir + QStringLiteral( "/capture." ) + QString::fromLatin1( Format );
+        QString ErrorText;
+
+        QFile File( FilePath );
+        bool IsExact = File.open( QIODevice::WriteOnly | QIODevice::Truncate ) && WriteImage( &File, Image, Format, -1, nullptr, &ErrorText );
+        File.close();
+
+        // a raw image maps the file, released before the directory is removed
+        QImage Read;
+        if( IsExact )
+        {
+            Read = ReadImage( FilePath, &ErrorText );
+            IsExact = Read.isNull() == false
+                   && Read.convertToFormat( QImage::Format_ARGB32_Premultiplied ) == Image.convertToFormat( QImage::Format_ARGB32_Premultiplied );
+        }
+
+        printf( "file   %-6s | %-6s | %dx%d -> %dx%d | %s %s\n", Format.constData(), IsNativeImageFormat( Format ) ? "kernel" : "qt",
+                Image.width(), Image.height(), Read.width(), Read.height(), IsExact ? "exact" : "MISMATCH", qPrintable( ErrorText ) );
+        return IsExact;
+    }
+
+    bool runImageFiles()
+    {
+        const auto Formats = SupportedImageFormats();
+        bool IsExact = Formats.contains( "qoi" ) && Formats.contains( "raw" ) && std::is_sorted( Formats.cbegin(), Formats.cend() );
+        for( const auto& Format : Formats )
+            IsExact &= IsSupportedImageFormat( Format );
+
+        printf( "formats %s | %s\n", Formats.join( ' ' ).constData(), IsExact ? "exact" : "MISMATCH" );
+
+        QTemporaryDir Dir;
+        if( Dir.isValid() == false )
+        {
+            printf( "file   no temporary directory | MISMATCH\n" );
+            return false;
+        }
+
+        CCaptureService Service( std::make_unique< CSyntheticBackend >( CSyntheticBackend::ParseLayout( QStringLiteral( "320x200-320+0;160x120+0-40" ) ) ) );
+        const QImage Image = Service.CaptureAll( tagCaptureRequest() );
+        IsExact &= Image.isNull() == false;
+
+        for( const char* Format : { "qoi", "raw", "png" } )
+        {
+            if( Formats.contains( Format ) )
+                IsExact &= runFileRoundTrip( Image, Format, Dir.path() );
+        }
+
+        return IsExact;
+    }
+}
+
+int main( int argc, char* argv[] )
+{
+    QCoreApplication App( argc, argv );
+
+    printf( "scripted sessions, synthetic backend\n" );
+
+    bool IsExact = runScriptedSessions();
+
+    printf( "\nvirtual desktop canvas, synthetic layouts\n" );
+
+    IsExact &= runCanvasLayouts();
+
+    printf( "\nfailing outputs, synchronous captures\n" );
+
+    IsExact &= runFailedCaptures();
+
+    printf( "\nasynchronous captures, deadline and cancel\n" );
+
+    IsExact &= runAsyncCaptures();
+
+    printf( "\nimage files, write and read back\n" );
+
+    IsExact &= runImageFiles();
+
+    return IsExact ? 0 : 1;
+}
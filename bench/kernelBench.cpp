@@ -0,0 +1,1524 @@
+// Pixel kernel benchmarks, std-only so it also runs on Linux CI
+//
+//  SnippingToolBench [--frames N] [--size WxH] [--stream rects.txt]
+//  SnippingToolBench --matrix [--json results.json]
+//
+// incremental : bytes copied per frame by CIncrementalFrame against a full-frame copy,
+//               the incremental surface is compared with the reference frame after every present
+// rotate      : RotateSurface per quarter turn against the per-pixel reference, outputs must match bit for bit
+// cursor      : CompositeCursor per shape type against the per-pixel reference, plus known XOR / AND results
+// resample    : ResampleSurface ( SIMD, row-parallel ) per filter against the scalar single thread reference,
+//               4K down to thumbnails, up to 1440p, and a target clipped by the surface edges
+// convert     : every pixel conversion at every CPU level this machine has, exhaustive over all 2^24 colours
+//               ( every channel value meets every alpha ), ragged widths and in place runs, GB/s on a WxH frame
+// png         : EncodePng per source layout, inflated and unfiltered here and compared with the converted pixels;
+//               the scalar single thread output must equal the SIMD multi-thread output byte for byte,
+//               and CPngStreamEncoder fed uneven row strips must write the same file,
+//               size against one unsplit block, MB/s per thread count on a desktop-like WxH frame
+// codec       : QOI and raw round trips per source layout ( exhaustive pattern, ragged widths, truncated QOI streams,
+//               the stream encoders fed uneven row strips ),
+//               encode / decode MB/s and size next to PNG on the desktop-like frame
+// acquire     : CFrameAcquirer against CScriptedDuplicationSource on its virtual clock ( static screen to the deadline,
+//               bursts of presents, pointer-only updates, access lost in the middle of a wait ), reason, elapsed virtual
+//               time and the acquire / release pairing must match the script
+//
+// --matrix      : throughput only, no verification; every kernel over 1080p, 1440p, 4K, 8K and multi-monitor
+//                 desktops ( cursor blend, cursor mask processing, rotation, conversion, crop, scaling, preview pyramid
+//                 build and one resized preview frame from it ), median
+//                 and best of repeated runs; --json writes the same rows for release to release comparison.
+//                 the encoders run on a desktop-like frame ( random bytes do not compress ) : PNG single thread and all
+//                 threads, QOI encode and decode, raw write
+
+#include "../src/cursorShape.hpp"
+#include "../src/frameAcquirer.hpp"
+#include "../src/frameResample.hpp"
+#include "../src/frameRotate.hpp"
+#include "../src/imageCodec.hpp"
+#include "../src/incrementalFrame.hpp"
+#include "../src/pixelConvert.hpp"
+#ifdef SNIPPINGTOOL_HAVE_ZLIB
+#include "../src/pngEncoder.hpp"
+
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace nsKernel;
+
+namespace
+{
+    typedef std::chrono::steady_clock   Clock;
+
+    // struct tagScenario_s
+    typedef struct tagScenario_s
+    {
+        std::string                     Name;
+        std::vector< tagFrameDelta >    Frames;
+    } tagScenario;
+
+    tagPixelRect makeRect( int32_t X, int32_t Y, int32_t W, int32_t H )
+    {
+        return tagPixelRect{ X, Y, X + W, Y + H };
+    }
+
+    // caret blink and a few glyphs per frame
+    tagScenario makeTyping( int32_t Width, int32_t Height, int Frames )
+    {
+        tagScenario Scenario{ "typing", {} };
+        int32_t X = 200, Y = 300;
+
+        for( int i = 0; i < Frames; ++i )
+        {
+            tagFrameDelta Frame;
+            Frame.Dirty.push_back( makeRect( X, Y, 9, 18 ) );
+            Frame.Dirty.push_back( makeRect( X + 9, Y, 2, 18 ) );
+            X += 9;
+            if( X > Width - 200 )
+            {
+                X = 200;
+                Y = ( Y + 20 ) % ( Height - 40 );
+            }
+            Scenario.Frames.push_back( Frame );
+        }
+
+        return Scenario;
+    }
+
+    // browser scroll : one large move plus the exposed strip and a scrollbar
+    tagScenario makeScrolling( int32_t Width, int32_t Height, int Frames )
+    {
+        tagScenario Scenario{ "scrolling", {} };
+        const int32_t Left = 100, Top = 120, W = Width - 220, H = Height - 200, Step = 48;
+
+        for( int i = 0; i < Frames; ++i )
+        {
+            tagFrameDelta Frame;
+            tagMoveRect Move;
+            Move.SourceX = Left;
+            Move.SourceY = Top + Step;
+            Move.Destination = makeRect( Left, Top, W, H - Step );
+            Frame.Moves.push_back( Move );
+            Frame.Dirty.push_back( makeRect( Left, Top + H - Step, W, Step ) );
+            Frame.Dirty.push_back( makeRect( Left + W, Top, 16, H ) );
+            Scenario.Frames.push_back( Frame );
+        }
+
+        return Scenario;
+    }
+
+    // window dragged to the right : move of the window, exposed background on the left
+    tagScenario makeWindowDrag( int32_t Width, int32_t Height, int Frames )
+    {
+        tagScenario Scenario{ "window-drag", {} };
+        const int32_t W = 800, H = 600, Step = 6;
+        int32_t X = 0;
+        const int32_t Y = ( Height - H ) / 2;
+
+        for( int i = 0; i < Frames; ++i )
+        {
+            if( X + Step + W > Width )
+                X = 0;
+
+            tagFrameDelta Frame;
+            tagMoveRect Move;
+            Move.SourceX = X;
+            Move.SourceY = Y;
+            Move.Destination = makeRect( X + Step, Y, W, H );
+            Frame.Moves.push_back( Move );
+            Frame.Dirty.push_back( makeRect( X, Y, Step, H ) );
+            X += Step;
+            Scenario.Frames.push_back( Frame );
+        }
+
+        return Scenario;
+    }
+
+    // video player plus a clock, overlapping tiles as reported by some drivers
+    tagScenario makeVideo( int32_t Width, int32_t Height, int Frames )
+    {
+        tagScenario Scenario{ "video", {} };
+        const int32_t X = ( Width - 1280 ) / 2, Y = ( Height - 720 ) / 2;
+
+        for( int i = 0; i < Frames; ++i )
+        {
+            tagFrameDelta Frame;
+            for( int32_t ty = 0; ty < 720; ty += 180 )
+                for( int32_t tx = 0; tx < 1280; tx += 320 )
+                    Frame.Dirty.push_back( makeRect( X + tx - 4, Y + ty - 4, 328, 188 ) );
+            Frame.Dirty.push_back( makeRect( Width - 120, Height - 40, 100, 30 ) );
+            Scenario.Frames.push_back( Frame );
+        }
+
+        return Scenario;
+    }
+
+    tagScenario makeFullScreen( int32_t Width, int32_t Height, int Frames )
+    {
+        tagScenario Scenario{ "full-screen", {} };
+
+        for( int i = 0; i < Frames; ++i )
+        {
+            tagFrameDelta Frame;
+            Frame.Dirty.push_back( makeRect( 0, 0, Width, Height ) );
+            Scenario.Frames.push_back( Frame );
+        }
+
+        return Scenario;
+    }
+
+    // what the desktop would look like after Frame : moves, then new content in every dirty rect
+    void renderReference( std::vector< uint8_t >* pFrame, int32_t Width, int32_t Height, const tagFrameDelta& Frame, uint32_t Seed )
+    {
+        tagSurface Surface{ pFrame->data(), Width, Height, ( ptrdiff_t )Width * 4 };
+
+        for( const auto& Move : Frame.Moves )
+            MoveRect( Surface, Move );
+
+        for( const auto& Dirty : Frame.Dirty )
+        {
+            const int32_t Left   = std::max( Dirty.Left, 0 );
+            const int32_t Top    = std::max( Dirty.Top, 0 );
+            const int32_t Right  = std::min( Dirty.Right, Width );
+            const int32_t Bottom = std::min( Dirty.Bottom, Height );
+
+            for( int32_t y = Top; y < Bottom; ++y )
+            {
+                auto Line = reinterpret_cast< uint32_t* >( Surface.Bits + y * Surface.Pitch );
+                for( int32_t x = Left; x < Right; ++x )
+                    Line[ x ] = 0xFF000000u | ( ( Seed * 2654435761u ) ^ ( uint32_t )( x * 31 + y * 17 ) );
+            }
+        }
+    }
+
+    bool runIncremental( const tagScenario& Scenario, int32_t Width, int32_t Height )
+    {
+        const size_t FrameBytes = ( size_t )Width * Height * 4;
+        std::vector< uint8_t > Reference( FrameBytes );
+        std::vector< uint8_t > FullCopy( FrameBytes );
+
+        std::mt19937 Random( 1 );
+        for( auto& Byte : Reference )
+            Byte = ( uint8_t )Random();
+
+        CIncrementalFrame Engine;
+        Engine.Reset( Width, Height );
+        Engine.Store( Reference.data(), ( ptrdiff_t )Width * 4 );
+        Engine.ResetStats();
+
+        Clock::duration IncrementalTime{}, FullTime{};
+        bool IsExact = true;
+
+        for( size_t i = 0; i < Scenario.Frames.size(); ++i )
+        {
+            const auto& Frame = Scenario.Frames[ i ];
+            renderReference( &Reference, Width, Height, Frame, ( uint32_t )i + 1 );
+
+            auto Start = Clock::now();
+            Engine.Apply( Frame, Reference.data(), ( ptrdiff_t )Width * 4 );
+            IncrementalTime += Clock::now() - Start;
+
+            Start = Clock::now();
+            memcpy( FullCopy.data(), Reference.data(), FrameBytes );
+            FullTime += Clock::now() - Start;
+
+            if( memcmp( Engine.Surface().Bits, Reference.data(), FrameBytes ) != 0 )
+                IsExact = false;
+        }
+
+        const auto& Stat = Engine.Stats();
+        const double Frames = Stat.Frames ? ( double )Stat.Frames : 1.0;
+        const double IncUs = std::chrono::duration< double, std::micro >( IncrementalTime ).count() / Frames;
+        const double FullUs = std::chrono::duration< double, std::micro >( FullTime ).count() / Frames;
+
+        printf( "%-14s %6llu frames | rects in/out %6.1f/%6.1f | copied %10.0f B/frame moved %10.0f B/frame | full %10.0f B/frame | %6.2f%% | %8.1f us vs %8.1f us | %s\n",
+                Scenario.Name.c_str(), ( unsigned long long )Stat.Frames,
+                Stat.RectsIn / Frames, Stat.RectsOut / Frames,
+                Stat.BytesCopied / Frames, Stat.BytesMoved / Frames, Stat.FullFrameBytes / Frames,
+                Stat.FullFrameBytes ? 100.0 * ( double )Stat.BytesCopied / ( double )Stat.FullFrameBytes : 0.0,
+                IncUs, FullUs, IsExact ? "exact" : "MISMATCH" );
+
+        return IsExact;
+    }
+
+    bool runRotate( tagRotation Rotation, int32_t Width, int32_t Height, int Frames )
+    {
+        int32_t DstWidth = 0, DstHeight = 0;
+        RotatedSize( Rotation, Width, Height, &DstWidth, &DstHeight );
+
+        // odd pitches keep the ragged tile edges and unaligned rows in the measurement
+        const ptrdiff_t SrcPitch = ( ptrdiff_t )Width * 4 + 16;
+        const ptrdiff_t DstPitch = ( ptrdiff_t )DstWidth * 4 + 48;
+        std::vector< uint8_t > Source( SrcPitch * Height );
+        std::vector< uint8_t > Kernel( DstPitch * DstHeight );
+        std::vector< uint8_t > Reference( DstPitch * DstHeight );
+
+        std::mt19937 Random( 7 );
+        for( auto& Byte : Source )
+            Byte = ( uint8_t )Random();
+
+        const tagSurface Src{ Source.data(), Width, Height, SrcPitch };
+        const tagSurface KernelDst{ Kernel.data(), DstWidth, DstHeight, DstPitch };
+        const tagSurface ReferenceDst{ Reference.data(), DstWidth, DstHeight, DstPitch };
+
+        Clock::duration KernelTime{}, ReferenceTime{};
+        for( int i = 0; i < Frames; ++i )
+        {
+            auto Start = Clock::now();
+            RotateSurface( KernelDst, Src, Rotation );
+            KernelTime += Clock::now() - Start;
+
+            Start = Clock::now();
+            RotateSurfaceReference( ReferenceDst, Src, Rotation );
+            ReferenceTime += Clock::now() - Start;
+        }
+
+        bool IsExact = true;
+        for( int32_t y = 0; y < DstHeight; ++y )
+        {
+            if( memcmp( Kernel.data() + y * DstPitch, Reference.data() + y * DstPitch, ( size_t )DstWidth * 4 ) != 0 )
+                IsExact = false;
+        }
+
+        const double KernelMs = std::chrono::duration< double, std::milli >( KernelTime ).count() / Frames;
+        const double ReferenceMs = std::chrono::duration< double, std::milli >( ReferenceTime ).count() / Frames;
+        const double FrameMB = ( double )Width * Height * 4 / ( 1024.0 * 1024.0 );
+
+        printf( "rotate %3d     %5dx%-5d -> %5dx%-5d | kernel %7.2f ms ( %7.0f MB/s ) | reference %7.2f ms | %s\n",
+                ( int )Rotation * 90, Width, Height, DstWidth, DstHeight,
+                KernelMs, KernelMs > 0.0 ? FrameMB * 1000.0 / KernelMs : 0.0, ReferenceMs,
+                IsExact ? "exact" : "MISMATCH" );
+
+        return IsExact;
+    }
+
+    // pointer shape bytes as the duplication delivers them
+    tagCursorShape makeCursorShape( uint32_t Type, int32_t Size, std::vector< uint8_t >* pBytes )
+    {
+        std::mt19937 Random( Type );
+        tagCursorShape Shape;
+        Shape.Type   = Type;
+        Shape.Width  = Size;
+        Shape.Height = Type == tagCursorShapeType_Monochrome ? Size * 2 : Size;
+        Shape.Pitch  = Type == tagCursorShapeType_Monochrome ? ( Size + 7 ) / 8 : Size * 4;
+
+        pBytes->resize( Shape.Size() );
+        for( auto& Byte : *pBytes )
+            Byte = ( uint8_t )Random();
+
+        // mask bytes of a masked color shape are 0x00 or 0xFF only
+        if( Type == tagCursorShapeType_MaskedColor )
+        {
+            for( size_t i = 3; i < pBytes->size(); i += 4 )
+                ( *pBytes )[ i ] = ( Random() & 1 ) ? 0xFF : 0x00;
+        }
+
+        Shape.Bits = pBytes->data();
+        Shape.Hash = HashCursorShape( Shape );
+        return Shape;
+    }
+
+    bool runCursor( uint32_t Type, int32_t Size, int32_t Width, int32_t Height, int Frames )
+    {
+        std::vector< uint8_t > Bytes;
+        const tagCursorShape Shape = makeCursorShape( Type, Size, &Bytes );
+
+        tagCursorImage Cursor;
+        if( !BuildCursorImage( Shape, tagRotation_0, &Cursor ) )
+            return false;
+
+        const ptrdiff_t Pitch = ( ptrdiff_t )Width * 4;
+        std::vector< uint8_t > Background( Pitch * Height );
+        std::mt19937 Random( 11 );
+        for( auto& Byte : Background )
+            Byte = ( uint8_t )Random();
+
+        std::vector< uint8_t > Kernel( Background ), Reference( Background );
+        const tagSurface KernelDst{ Kernel.data(), Width, Height, Pitch };
+        const tagSurface ReferenceDst{ Reference.data(), Width, Height, Pitch };
+
+        // walk across the surface including the clipped edges
+        Clock::duration KernelTime{}, ReferenceTime{};
+        for( int i = 0; i < Frames; ++i )
+        {
+            const int32_t X = ( int32_t )( ( i * 37 ) % ( Width + Size ) ) - Size / 2;
+            const int32_t Y = ( int32_t )( ( i * 23 ) % ( Height + Size ) ) - Size / 2;
+
+            auto Start = Clock::now();
+            CompositeCursor( KernelDst, Cursor, X, Y );
+            KernelTime += Clock::now() - Start;
+
+            Start = Clock::now();
+            CompositeCursorReference( ReferenceDst, Cursor, X, Y );
+            ReferenceTime += Clock::now() - Start;
+        }
+
+        const bool IsExact = Kernel == Reference;
+        const char* Name = Type == tagCursorShapeType_Color ? "color" : Type == tagCursorShapeType_Monochrome ? "monochrome" : "masked-color";
+
+        printf( "cursor %-12s %3dx%-3d | kernel %7.3f us | reference %7.3f us | %s\n",
+                Name, Size, Size,
+                std::chrono::duration< double, std::micro >( KernelTime ).count() / Frames,
+                std::chrono::duration< double, std::micro >( ReferenceTime ).count() / Frames,
+                IsExact ? "exact" : "MISMATCH" );
+
+        return IsExact;
+    }
+
+    // hand computed results of the three shape semantics
+    bool runCursorGolden()
+    {
+        const uint32_t Screen = 0xFF123456u;
+        uint32_t Pixels[ 4 ] = { Screen, Screen, Screen, Screen };
+        const tagSurface Dst{ reinterpret_cast< uint8_t* >( Pixels ), 4, 1, 16 };
+
+        // monochrome, AND / XOR bits per column : 1/1 invert, 1/0 keep, 0/1 white, 0/0 black
+        uint8_t Mono[ 2 ] = { 0xC0, 0xA0 };
+        tagCursorShape Shape;
+        Shape.Bits = Mono; Shape.Type = tagCursorShapeType_Monochrome; Shape.Width = 4; Shape.Height = 2; Shape.Pitch = 1;
+
+        tagCursorImage Cursor;
+        BuildCursorImage( Shape, tagRotation_0, &Cursor );
+        CompositeCursor( Dst, Cursor, 0, 0 );
+        bool IsExact = Pixels[ 0 ] == 0xFFEDCBA9u && Pixels[ 1 ] == Screen && Pixels[ 2 ] == 0xFFFFFFFFu && Pixels[ 3 ] == 0xFF000000u;
+
+        // masked color : mask 0x00 replaces the RGB, 0xFF XORs it
+        const uint32_t Masked[ 2 ] = { 0x00ABCDEFu, 0xFF00FF00u };
+        Shape.Bits = reinterpret_cast< const uint8_t* >( Masked ); Shape.Type = tagCursorShapeType_MaskedColor; Shape.Width = 2; Shape.Height = 1; Shape.Pitch = 8;
+        Pixels[ 0 ] = Pixels[ 1 ] = Screen;
+        BuildCursorImage( Shape, tagRotation_0, &Cursor );
+        CompositeCursor( Dst, Cursor, 0, 0 );
+        IsExact &= Pixels[ 0 ] == 0xFFABCDEFu && Pixels[ 1 ] == 0xFF12CB56u;
+
+        // color : straight alpha over the screen, rounded
+        Cursor.Type = tagCursorShapeType_Color; Cursor.Width = 4; Cursor.Height = 1; Cursor.Mask.clear();
+        Cursor.Pixels = { 0x80FFFFFFu, 0x00000000u, 0xFF000000u, 0x40FF0000u };
+        const uint32_t Backdrop[ 4 ] = { 0xFF000000u, 0xFFFFFFFFu, 0xFF808080u, 0xFF102030u };
+        memcpy( Pixels, Backdrop, sizeof( Pixels ) );
+        CompositeCursor( Dst, Cursor, 0, 0 );
+        IsExact &= Pixels[ 0 ] == 0xFF808080u && Pixels[ 1 ] == 0xFFFFFFFFu && Pixels[ 2 ] == 0xFF000000u && Pixels[ 3 ] == 0xFF4C1824u;
+
+        printf( "cursor golden                | %s\n", IsExact ? "exact" : "MISMATCH" );
+        return IsExact;
+    }
+
+    const char* filterName( tagResampleFilter Filter )
+    {
+        switch( Filter )
+        {
+            case tagResampleFilter_Box:         return "box";
+            case tagResampleFilter_Lanczos3:    return "lanczos3";
+            default:                            return "bilinear";
+        }
+    }
+
+    // Target in a DstWidth x DstHeight surface, may be clipped
+    bool runResample( tagResampleFilter Filter, int32_t Width, int32_t Height, int32_t DstWidth, int32_t DstHeight, const tagPixelRect& Target, int Frames )
+    {
+        const ptrdiff_t SrcPitch = ( ptrdiff_t )Width * 4 + 16;
+        const ptrdiff_t DstPitch = ( ptrdiff_t )DstWidth * 4 + 48;
+        std::vector< uint8_t > Source( SrcPitch * Height );
+        std::vector< uint8_t > Kernel( DstPitch * DstHeight );
+        std::vector< uint8_t > Reference( DstPitch * DstHeight );
+
+        // smooth gradient with noise on top, premultiplied opaque
+        std::mt19937 Random( 13 );
+        for( int32_t y = 0; y < Height; ++y )
+        {
+            for( int32_t x = 0; x < Width; ++x )
+            {
+                uint8_t* pPixel = Source.data() + y * SrcPitch + x * 4;
+                pPixel[ 0 ] = ( uint8_t )( x * 255 / Width + ( Random() & 15 ) );
+                pPixel[ 1 ] = ( uint8_t )( y * 255 / Height + ( Random() & 15 ) );
+                pPixel[ 2 ] = ( uint8_t )( ( ( x / 8 + y / 8 ) & 1 ) ? 0xF0 : 0x10 );
+                pPixel[ 3 ] = 0xFF;
+            }
+        }
+
+        const tagSurface Src{ Source.data(), Width, Height, SrcPitch };
+        const tagSurface KernelDst{ Kernel.data(), DstWidth, DstHeight, DstPitch };
+        const tagSurface ReferenceDst{ Reference.data(), DstWidth, DstHeight, DstPitch };
+
+        Clock::duration KernelTime{}, ReferenceTime{};
+        for( int i = 0; i < Frames; ++i )
+        {
+            auto Start = Clock::now();
+            ResampleSurface( KernelDst, Target, Src, Filter );
+            KernelTime += Clock::now() - Start;
+        }
+
+        auto Start = Clock::now();
+        ResampleSurfaceReference( ReferenceDst, Target, Src, Filter );
+        ReferenceTime += Clock::now() - Start;
+
+        const bool IsExact = Kernel == Reference;
+        const double KernelMs = std::chrono::duration< double, std::milli >( KernelTime ).count() / Frames;
+        const double SourceMB = ( double )Width * Height * 4 / ( 1024.0 * 1024.0 );
+
+        printf( "resample %-8s %5dx%-5d -> %5dx%-5d | kernel %7.2f ms ( %7.0f MB/s ) | reference %7.2f ms | %s\n",
+                filterName( Filter ), Width, Height, Target.Width(), Target.Height(),
+                KernelMs, KernelMs > 0.0 ? SourceMB * 1000.0 / KernelMs : 0.0,
+                std::chrono::duration< double, std::milli >( ReferenceTime ).count(),
+                IsExact ? "exact" : "MISMATCH" );
+
+        return IsExact;
+    }
+
+    // unit scale bilinear is a copy, a flat colour stays flat through every filter
+    bool runResampleGolden()
+    {
+        const int32_t Size = 37;
+        std::vector< uint32_t > Source( Size * Size ), Output( Size * Size );
+        std::mt19937 Random( 17 );
+        for( auto& Pixel : Source )
+            Pixel = Random() | 0xFF000000u;
+
+        const tagSurface Src{ reinterpret_cast< uint8_t* >( Source.data() ), Size, Size, Size * 4 };
+        const tagSurface Dst{ reinterpret_cast< uint8_t* >( Output.data() ), Size, Size, Size * 4 };
+        ResampleSurface( Dst, tagPixelRect{ 0, 0, Size, Size }, Src, tagResampleFilter_Bilinear );
+        bool IsExact = Output == Source;
+
+        for( auto Filter : { tagResampleFilter_Bilinear, tagResampleFilter_Box, tagResampleFilter_Lanczos3 } )
+        {
+            std::fill( Source.begin(), Source.end(), 0xFF3C7AB4u );
+            std::fill( Output.begin(), Output.end(), 0u );
+            ResampleSurface( Dst, tagPixelRect{ 3, 5, 3 + 11, 5 + 29 }, Src, Filter );
+            for( int32_t y = 0; y < Size; ++y )
+            {
+                for( int32_t x = 0; x < Size; ++x )
+                {
+                    const bool IsInside = x >= 3 && x < 14 && y >= 5 && y < 34;
+                    IsExact &= Output[ y * Size + x ] == ( IsInside ? 0xFF3C7AB4u : 0u );
+                }
+            }
+        }
+
+        printf( "resample golden              | %s\n", IsExact ? "exact" : "MISMATCH" );
+        return IsExact;
+    }
+
+    const char* conversionName( tagPixelConversion Conversion )
+    {
+        switch( Conversion )
+        {
+            case tagPixelConversion_SwapRedBlue:    return "swap-rb";
+            case tagPixelConversion_Premultiply:    return "premultiply";
+            case tagPixelConversion_Unpremultiply:  return "unpremultiply";
+            case tagPixelConversion_Opaque:         return "opaque";
+            case tagPixelConversion_ToRGB888:       return "rgb888";
+            default:                                return "gray8";
+        }
+    }
+
+    // Width pixels per row through Row and through the reference, pitches padded
+    bool matchesReference( PixelRowFn Row, tagPixelConversion Conversion, const uint8_t* pSrc, int32_t Width, int32_t Height )
+    {
+        const ptrdiff_t SrcPitch = ( ptrdiff_t )Width * 4;
+        const ptrdiff_t DstPitch = ( ptrdiff_t )Width * ConvertedPixelSize( Conversion ) + 8;
+        std::vector< uint8_t > Kernel( DstPitch * Height, 0xCD ), Reference( DstPitch * Height, 0xCD );
+
+        for( int32_t y = 0; y < Height; ++y )
+            Row( Kernel.data() + y * DstPitch, pSrc + y * SrcPitch, Width );
+        ConvertPixelsReference( Conversion, Reference.data(), DstPitch, pSrc, SrcPitch, Width, Height );
+
+        // padding included, nothing may be written past the row
+        if( Kernel != Reference )
+            return false;
+
+        // the 32bpp conversions also run in place
+        if( ConvertedPixelSize( Conversion ) == 4 )
+        {
+            std::vector< uint8_t > InPlace( pSrc, pSrc + SrcPitch * Height );
+            for( int32_t y = 0; y < Height; ++y )
+                Row( InPlace.data() + y * SrcPitch, InPlace.data() + y * SrcPitch, Width );
+            for( int32_t y = 0; y < Height; ++y )
+            {
+                if( memcmp( InPlace.data() + y * SrcPitch, Reference.data() + y * DstPitch, ( size_t )SrcPitch ) != 0 )
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool runConvert( tagPixelConversion Conversion, tagCpuLevel Level, const std::vector< uint8_t >& Exhaustive, int32_t Width, int32_t Height, int Frames )
+    {
+        const PixelRowFn Row = PixelRowConverter( Conversion, Level );
+
+        // 4096 x 4096 : pixel i is b = i, g = i >> 8, r = i >> 16 with alpha g ^ b
+        bool IsExact = matchesReference( Row, Conversion, Exhaustive.data(), 4096, 4096 );
+
+        // every row tail length of the vector loops
+        std::mt19937 Random( 19 );
+        for( int32_t Ragged = 1; Ragged <= 67 && IsExact; ++Ragged )
+        {
+            std::vector< uint8_t > Source( ( size_t )Ragged * 4 * 3 );
+            for( auto& Byte : Source )
+                Byte = ( uint8_t )Random();
+            IsExact &= matchesReference( Row, Conversion, Source.data(), Ragged, 3 );
+        }
+
+        // timed on the head of the exhaustive pattern : partial alpha everywhere, the worst case of unpremultiply
+        const ptrdiff_t SrcPitch = ( ptrdiff_t )Width * 4;
+        const ptrdiff_t DstPitch = ( ptrdiff_t )Width * ConvertedPixelSize( Conversion );
+        std::vector< uint8_t > Source( Exhaustive.begin(), Exhaustive.begin() + std::min( Exhaustive.size(), ( size_t )( SrcPitch * Height ) ) );
+        Source.resize( SrcPitch * Height, 0xFF );
+        std::vector< uint8_t > Output( DstPitch * Height );
+
+        auto Start = Clock::now();
+        for( int i = 0; i < Frames; ++i )
+        {
+            for( int32_t y = 0; y < Height; ++y )
+                Row( Output.data() + y * DstPitch, Source.data() + y * SrcPitch, Width );
+        }
+        const double Seconds = std::chrono::duration< double >( Clock::now() - Start ).count() / Frames;
+        const double SourceGB = ( double )SrcPitch * Height / ( 1024.0 * 1024.0 * 1024.0 );
+
+        printf( "convert %-14s %-6s | %6.2f GB/s ( %6.2f ms ) | %s\n",
+                conversionName( Conversion ), CpuLevelName( Level ),
+                Seconds > 0.0 ? SourceGB / Seconds : 0.0, Seconds * 1000.0,
+                IsExact ? "exact" : "MISMATCH" );
+
+        return IsExact;
+    }
+
+    // background gradient, flat windows with title bars, glyph-like text runs and a noisy photo; a translucent
+    // band at the bottom so that the alpha sources carry partial alpha, premultiplied
+    std::vector< uint8_t > makeDesktopLike( int32_t Width, int32_t Height )
+    {
+        std::vector< uint8_t > Frame( ( size_t )Width * Height * 4 );
+        std::mt19937 Random( 29 );
+
+        auto fill = [&]( int32_t X, int32_t Y, int32_t W, int32_t H, uint32_t Color ) {
+            for( int32_t y = std::max( 0, Y ); y < std::min( Height, Y + H ); ++y )
+            {
+                for( int32_t x = std::max( 0, X ); x < std::min( Width, X + W ); ++x )
+                    memcpy( Frame.data() + ( ( size_t )y * Width + x ) * 4, &Color, 4 );
+            }
+        };
+
+        for( int32_t y = 0; y < Height; ++y )
+            fill( 0, y, Width, 1, 0xFF000000u | ( uint32_t )( 0x30 + y * 0x60 / Height ) << 8 | ( uint32_t )( 0x50 + y * 0x80 / Height ) );
+
+        for( int Window = 0; Window < 6; ++Window )
+        {
+            const int32_t W = Width / 3 + ( int32_t )( Random() % ( uint32_t )( Width / 4 + 1 ) );
+            const int32_t H = Height / 3 + ( int32_t )( Random() % ( uint32_t )( Height / 4 + 1 ) );
+            const int32_t X = ( int32_t )( Random() % ( uint32_t )( Width - W / 2 ) );
+            const int32_t Y = ( int32_t )( Random() % ( uint32_t )( Height - H / 2 ) );
+
+            fill( X, Y, W, H, 0xFFF3F3F3u );
+            fill( X, Y, W, 30, 0xFF2B579Au );
+
+            // lines of 9 x 16 glyph cells, sparse dark pixels
+            for( int32_t Line = Y + 44; Line + 16 < Y + H - 8; Line += 22 )
+            {
+                const int32_t Length = ( int32_t )( Random() % ( uint32_t )std::max( 1, W - 40 ) );
+                for( int32_t Cell = X + 16; Cell < X + 16 + Length; Cell += 9 )
+                {
+                    const uint32_t Glyph = Random();
+                    for( int32_t Dot = 0; Dot < 24; ++Dot )
+                    {
+                        if( ( Glyph >> ( Dot % 32 ) ) & 1 )
+                            fill( Cell + Dot % 7, Line + ( Dot * 5 ) % 16, 1, 1, 0xFF202020u );
+                    }
+                }
+            }
+        }
+
+        const int32_t PhotoX = Width / 2, PhotoY = Height / 5, PhotoW = Width / 4, PhotoH = Height / 4;
+        for( int32_t y = PhotoY; y < std::min( Height, PhotoY + PhotoH ); ++y )
+        {
+            for( int32_t x = PhotoX; x < std::min( Width, PhotoX + PhotoW ); ++x )
+            {
+                uint8_t* pPixel = Frame.data() + ( ( size_t )y * Width + x ) * 4;
+                pPixel[ 0 ] = ( uint8_t )( x * 3 + ( Random() & 31 ) );
+                pPixel[ 1 ] = ( uint8_t )( y * 2 + ( Random() & 31 ) );
+                pPixel[ 2 ] = ( uint8_t )( ( x + y ) + ( Random() & 31 ) );
+            }
+        }
+
+        for( int32_t y = Height - Height / 8; y < Height; ++y )
+        {
+            for( int32_t x = 0; x < Width; ++x )
+            {
+                uint8_t* pPixel = Frame.data() + ( ( size_t )y * Width + x ) * 4;
+                const uint32_t Alpha = ( uint32_t )( x * 255 / Width );
+                for( int Channel = 0; Channel < 3; ++Channel )
+                    pPixel[ Channel ] = ( uint8_t )( pPixel[ Channel ] * Alpha / 255 );
+                pPixel[ 3 ] = ( uint8_t )Alpha;
+            }
+        }
+
+        return Frame;
+    }
+
+    const char* sourceName( tagPixelSource Source )
+    {
+        switch( Source )
+        {
+            case tagPixelSource_BGRX:           return "bgrx";
+            case tagPixelSource_BGRA:           return "bgra";
+            default:                            return "bgra-premul";
+        }
+    }
+
+    // what a decoder must return for Source : straight BGRA, opaque for BGRX
+    std::vector< uint8_t > straightPixels( const tagSurface& Src, tagPixelSource Source )
+    {
+        const ptrdiff_t Pitch = ( ptrdiff_t )Src.Width * 4;
+        std::vector< uint8_t > Pixels( ( size_t )Pitch * Src.Height );
+        if( Source == tagPixelSource_BGRA )
+        {
+            for( int32_t y = 0; y < Src.Height; ++y )
+                memcpy( Pixels.data() + Pitch * y, Src.Bits + Src.Pitch * y, ( size_t )Pitch );
+        }
+        else
+        {
+            ConvertPixelsReference( Source == tagPixelSource_BGRX ? tagPixelConversion_Opaque : tagPixelConversion_Unpremultiply,
+                                    Pixels.data(), Pitch, Src.Bits, Src.Pitch, Src.Width, Src.Height );
+        }
+        return Pixels;
+    }
+
+    ImageWriteFn appendTo( std::vector< uint8_t >* pFile )
+    {
+        return [pFile]( const uint8_t* pData, size_t Size ) {
+            pFile->insert( pFile->end(), pData, pData + Size );
+            return true;
+        };
+    }
+
+    // Src through a stream encoder in strips of uneven heights, from single rows to several PNG blocks
+    bool writeStrips( CImageStreamEncoder* pEncoder, const tagSurface& Src, size_t Seed )
+    {
+        static const int32_t Heights[] = { 1, 7, 64, 3, 300, 2, 1000 };
+        const size_t Count = sizeof( Heights ) / sizeof( Heights[ 0 ] );
+        for( int32_t y = 0; y < Src.Height; ++Seed )
+        {
+            const int32_t Rows = std::min( Heights[ Seed % Count ], Src.Height - y );
+            if( !pEncoder->WriteRows( tagSurface{ Src.Bits + Src.Pitch * y, Src.Width, Rows, Src.Pitch } ) )
+                return false;
+            y += Rows;
+        }
+        return pEncoder->Finish();
+    }
+
+    bool matchesQoiRoundTrip( const tagSurface& Src, tagPixelSource Source )
+    {
+        std::vector< uint8_t > File;
+        const bool IsEncoded = EncodeQoi( Src, Source, [&File]( const uint8_t* pData, size_t Size ) {
+            File.insert( File.end(), pData, pData + Size );
+            return true;
+        } );
+
+        tagQoiHeader Header;
+        if( !IsEncoded || !ReadQoiHeader( File.data(), File.size(), &Header ) || Header.Width != Src.Width || Header.Height != Src.Height ||
+            Header.Channels != ( Source == tagPixelSource_BGRX ? 3 : 4 ) )
+            return false;
+
+        std::vector< uint8_t > Decoded( ( size_t )Src.Width * Src.Height * 4 );
+        if( !DecodeQoi( File.data(), File.size(), tagSurface{ Decoded.data(), Src.Width, Src.Height, ( ptrdiff_t )Src.Width * 4 } ) )
+            return false;
+
+        // cut into the pixel ops : rejected, never read past the end
+        for( size_t Cut = 9; Cut < std::min< size_t >( File.size(), 64 ); Cut += 5 )
+        {
+            std::vector< uint8_t > Scratch( Decoded.size() );
+            std::vector< uint8_t > Truncated( File.begin(), File.end() - Cut );
+            if( DecodeQoi( Truncated.data(), Truncated.size(), tagSurface{ Scratch.data(), Src.Width, Src.Height, ( ptrdiff_t )Src.Width * 4 } ) )
+                return false;
+        }
+
+        std::vector< uint8_t > Streamed;
+        CQoiStreamEncoder Stream( Src.Width, Src.Height, Source, appendTo( &Streamed ) );
+        if( !writeStrips( &Stream, Src, 0 ) || Streamed != File )
+            return false;
+
+        return Decoded == straightPixels( Src, Source );
+    }
+
+    bool matchesRawRoundTrip( const tagSurface& Src, tagPixelSource Source )
+    {
+        std::vector< uint8_t > File;
+        tagRawHeader Header;
+        if( !WriteRawImage( Src, Source, [&File]( const uint8_t* pData, size_t Size ) {
+                File.insert( File.end(), pData, pData + Size );
+                return true;
+            } ) || !ReadRawHeader( File.data(), File.size(), &Header ) )
+            return false;
+
+        if( Header.Width != ( uint32_t )Src.Width || Header.Height != ( uint32_t )Src.Height || Header.Layout != ( uint32_t )Source ||
+            ReadRawHeader( File.data(), File.size() - 1, &Header ) )
+            return false;
+
+        std::vector< uint8_t > Streamed;
+        CRawStreamWriter Stream( Src.Width, Src.Height, Source, appendTo( &Streamed ) );
+        if( !writeStrips( &Stream, Src, 1 ) || Streamed != File )
+            return false;
+
+        for( int32_t y = 0; y < Src.Height; ++y )
+        {
+            if( memcmp( File.data() + Header.HeaderBytes + ( size_t )Header.Pitch * y, Src.Bits + Src.Pitch * y, ( size_t )Src.Width * 4 ) != 0 )
+                return false;
+        }
+        return true;
+    }
+
+    // QOI and raw against the exhaustive pattern and ragged widths, then encode / decode speed and size next to PNG
+    bool runCodec( tagPixelSource Source, const std::vector< uint8_t >& Exhaustive, int32_t Width, int32_t Height, int Frames )
+    {
+        const tagSurface Pattern{ const_cast< uint8_t* >( Exhaustive.data() ), 1024, 512, 4096 * 4 };
+        bool IsExact = matchesQoiRoundTrip( Pattern, Source ) && matchesRawRoundTrip( Pattern, Source );
+        for( int32_t Ragged = 1; Ragged <= 37 && IsExact; Ragged += 3 )
+        {
+            const tagSurface Small{ Pattern.Bits, Ragged, 9, Pattern.Pitch };
+            IsExact &= matchesQoiRoundTrip( Small, Source ) && matchesRawRoundTrip( Small, Source );
+        }
+
+        std::vector< uint8_t > Frame = makeDesktopLike( Width, Height );
+        const tagSurface Src{ Frame.data(), Width, Height, ( ptrdiff_t )Width * 4 };
+        IsExact &= matchesQoiRoundTrip( Src, Source ) && matchesRawRoundTrip( Src, Source );
+
+        std::vector< uint8_t > File;
+        File.reserve( Frame.size() + RAW_HEADER_BYTES );
+        const auto collect = [&File]( const uint8_t* pData, size_t Size ) {
+            File.insert( File.end(), pData, pData + Size );
+            return true;
+        };
+        const double SourceMB = ( double )Frame.size() / ( 1024.0 * 1024.0 );
+
+        auto timed = [&]( auto&& Run ) {
+            auto Start = Clock::now();
+            for( int i = 0; i < Frames; ++i )
+            {
+                File.clear();
+                Run();
+            }
+            return std::chrono::duration< double, std::milli >( Clock::now() - Start ).count() / Frames;
+        };
+
+        size_t PngBytes = 0;
+        double PngMs = 0.0;
+#ifdef SNIPPINGTOOL_HAVE_ZLIB
+        PngMs = timed( [&]() { EncodePng( Src, Source, tagPngOptions(), collect ); } );
+        PngBytes = File.size();
+#endif
+        const double QoiMs = timed( [&]() { EncodeQoi( Src, Source, collect ); } );
+        const size_t QoiBytes = File.size();
+
+        std::vector< uint8_t > Decoded( Frame.size() );
+        const std::vector< uint8_t > QoiFile = File;
+        auto Start = Clock::now();
+        for( int i = 0; i < Frames; ++i )
+            DecodeQoi( QoiFile.data(), QoiFile.size(), tagSurface{ Decoded.data(), Width, Height, ( ptrdiff_t )Width * 4 } );
+        const double QoiDecodeMs = std::chrono::duration< double, std::milli >( Clock::now() - Start ).count() / Frames;
+
+        const double RawMs = timed( [&]() { WriteRawImage( Src, Source, collect ); } );
+        const size_t RawBytes = File.size();
+
+        const auto print = [&]( const char* Codec, const char* Step, double Ms, size_t Bytes, double ToPngBytes ) {
+            printf( "codec %-4s %-6s %-11s | %8.2f ms ( %7.1f MB/s ) | ", Codec, Step, sourceName( Source ), Ms, Ms > 0.0 ? SourceMB * 1000.0 / Ms : 0.0 );
+            if( Bytes > 0 )
+                printf( "%9zu bytes ( %5.1f%% )", Bytes, 100.0 * Bytes / Frame.size() );
+            else
+                printf( "%25s", "" );
+            if( PngBytes > 0 && Bytes > 0 )
+                printf( ", %5.2fx png size %6.1fx png speed", ToPngBytes, Ms > 0.0 ? PngMs / Ms : 0.0 );
+            printf( " | %s\n", IsExact ? "exact" : "MISMATCH" );
+        };
+
+        if( PngBytes > 0 )
+            print( "png", "encode", PngMs, PngBytes, 1.0 );
+        print( "qoi", "encode", QoiMs, QoiBytes, PngBytes > 0 ? ( double )QoiBytes / PngBytes : 0.0 );
+        print( "qoi", "decode", QoiDecodeMs, 0, 0.0 );
+        print( "raw", "write", RawMs, RawBytes, PngBytes > 0 ? ( double )RawBytes / PngBytes : 0.0 );
+
+        return IsExact;
+    }
+
+#ifdef SNIPPINGTOOL_HAVE_ZLIB
+
+    bool encodePng( const tagSurface& Src, tagPixelSource Source, const tagPngOptions& Options, std::vector< uint8_t >* pFile )
+    {
+        pFile->clear();
+        return EncodePng( Src, Source, Options, [pFile]( const uint8_t* pData, size_t Size ) {
+            pFile->insert( pFile->end(), pData, pData + Size );
+            return true;
+        } );
+    }
+
+    uint32_t loadBigEndian( const uint8_t* p )
+    {
+        return ( uint32_t )p[ 0 ] << 24 | ( uint32_t )p[ 1 ] << 16 | ( uint32_t )p[ 2 ] << 8 | p[ 3 ];
+    }
+
+    // chunk CRCs, IHDR, one zlib stream over the IDATs ( Adler-32 checked by inflate ), unfiltered rows into pPixels
+    bool decodePng( const std::vector< uint8_t >& File, int32_t* pWidth, int32_t* pHeight, size_t* pBpp, std::vector< uint8_t >* pPixels )
+    {
+        static const uint8_t Signature[ 8 ] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        if( File.size() < 8 || memcmp( File.data(), Signature, 8 ) != 0 )
+            return false;
+
+        std::vector< uint8_t > Stream;
+        bool IsEnd = false;
+        for( size_t Offset = 8; Offset + 12 <= File.size() && !IsEnd; )
+        {
+            const uint32_t Length = loadBigEndian( File.data() + Offset );
+            if( Offset + 12 + Length > File.size() )
+                return false;
+
+            const uint8_t* pType = File.data() + Offset + 4;
+            if( crc32( 0, pType, Length + 4 ) != loadBigEndian( pType + 4 + Length ) )
+                return false;
+
+            if( memcmp( pType, "IHDR", 4 ) == 0 )
+            {
+                *pWidth = ( int32_t )loadBigEndian( pType + 4 );
+                *pHeight = ( int32_t )loadBigEndian( pType + 8 );
+                if( pType[ 12 ] != 8 || ( pType[ 13 ] != 2 && pType[ 13 ] != 6 ) || pType[ 16 ] != 0 )
+                    return false;
+                *pBpp = pType[ 13 ] == 2 ? 3 : 4;
+            }
+            else if( memcmp( pType, "IDAT", 4 ) == 0 )
+                Stream.insert( Stream.end(), pType + 4, pType + 4 + Length );
+            else if( memcmp( pType, "IEND", 4 ) == 0 )
+                IsEnd = true;
+
+            Offset += 12 + Length;
+        }
+
+        const size_t RowBytes = ( size_t )*pWidth * *pBpp;
+        std::vector< uint8_t > Filtered( ( RowBytes + 1 ) * *pHeight );
+        uLongf FilteredSize = ( uLongf )Filtered.size();
+        if( !IsEnd || uncompress( Filtered.data(), &FilteredSize, Stream.data(), ( uLong )Stream.size() ) != Z_OK || FilteredSize != Filtered.size() )
+            return false;
+
+        pPixels->assign( RowBytes * *pHeight, 0 );
+        const size_t Bpp = *pBpp;
+        for( int32_t y = 0; y < *pHeight; ++y )
+        {
+            const uint8_t* pIn = Filtered.data() + ( RowBytes + 1 ) * y;
+            uint8_t* pRow = pPixels->data() + RowBytes * y;
+            const uint8_t* pPrior = y > 0 ? pRow - RowBytes : nullptr;
+            for( size_t x = 0; x < RowBytes; ++x )
+            {
+                const int32_t a = x >= Bpp ? pRow[ x - Bpp ] : 0;
+                const int32_t b = pPrior != nullptr ? pPrior[ x ] : 0;
+                const int32_t c = pPrior != nullptr && x >= Bpp ? pPrior[ x - Bpp ] : 0;
+                int32_t Predictor = 0;
+                switch( pIn[ 0 ] )
+                {
+                    case 0:     break;
+                    case 1:     Predictor = a; break;
+                    case 2:     Predictor = b; break;
+                    case 3:     Predictor = ( a + b ) >> 1; break;
+                    case 4:
+                    {
+                        const int32_t pa = abs( b - c ), pb = abs( a - c ), pc = abs( a + b - 2 * c );
+                        Predictor = pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+                        break;
+                    }
+                    default:    return false;
+                }
+                pRow[ x ] = ( uint8_t )( pIn[ 1 + x ] + Predictor );
+            }
+        }
+
+        return true;
+    }
+
+    // round trip of Source, scalar single thread against SIMD on every worker
+    bool matchesPngRoundTrip( const tagSurface& Src, tagPixelSource Source, int32_t BlockRows )
+    {
+        std::vector< uint8_t > Expected( ( size_t )Src.Width * Src.Height * 4 );
+        const ptrdiff_t RowBytes = ( ptrdiff_t )Src.Width * ( Source == tagPixelSource_BGRX ? 3 : 4 );
+        if( Source == tagPixelSource_BGRX )
+            ConvertPixelsReference( tagPixelConversion_ToRGB888, Expected.data(), RowBytes, Src.Bits, Src.Pitch, Src.Width, Src.Height );
+        else if( Source == tagPixelSource_BGRA )
+            ConvertPixelsReference( tagPixelConversion_SwapRedBlue, Expected.data(), RowBytes, Src.Bits, Src.Pitch, Src.Width, Src.Height );
+        else
+        {
+            ConvertPixelsReference( tagPixelConversion_Unpremultiply, Expected.data(), RowBytes, Src.Bits, Src.Pitch, Src.Width, Src.Height );
+            ConvertPixelsReference( tagPixelConversion_SwapRedBlue, Expected.data(), RowBytes, Expected.data(), RowBytes, Src.Width, Src.Height );
+        }
+        Expected.resize( ( size_t )RowBytes * Src.Height );
+
+        tagPngOptions Scalar;
+        Scalar.Threads      = 1;
+        Scalar.BlockRows    = BlockRows;
+        Scalar.CpuLevel     = tagCpuLevel_Scalar;
+        // the worker pipeline even on small machines
+        tagPngOptions Parallel;
+        Parallel.Threads    = std::max( 4u, std::thread::hardware_concurrency() );
+        Parallel.BlockRows  = BlockRows;
+
+        std::vector< uint8_t > ScalarFile, ParallelFile, ScalarStrips, ParallelStrips, Pixels;
+        CPngStreamEncoder ScalarStream( Src.Width, Src.Height, Source, Scalar, appendTo( &ScalarStrips ) );
+        CPngStreamEncoder ParallelStream( Src.Width, Src.Height, Source, Parallel, appendTo( &ParallelStrips ) );
+        int32_t Width = 0, Height = 0;
+        size_t Bpp = 0;
+        return encodePng( Src, Source, Scalar, &ScalarFile ) && encodePng( Src, Source, Parallel, &ParallelFile ) &&
+               ScalarFile == ParallelFile &&
+               writeStrips( &ScalarStream, Src, 2 ) && ScalarStrips == ScalarFile &&
+               writeStrips( &ParallelStream, Src, 4 ) && ParallelStrips == ParallelFile &&
+               decodePng( ParallelFile, &Width, &Height, &Bpp, &Pixels ) &&
+               Width == Src.Width && Height == Src.Height && Pixels == Expected;
+    }
+
+    bool runPng( tagPixelSource Source, const std::vector< uint8_t >& Exhaustive, int32_t Width, int32_t Height, int Frames )
+    {
+        // partial alpha everywhere, ragged widths for the SIMD tails, one row blocks, a single block
+        const tagSurface Pattern{ const_cast< uint8_t* >( Exhaustive.data() ), 1024, 512, 4096 * 4 };
+        bool IsExact = matchesPngRoundTrip( Pattern, Source, 0 );
+        IsExact &= matchesPngRoundTrip( Pattern, Source, 1 );
+        IsExact &= matchesPngRoundTrip( Pattern, Source, 512 );
+        for( int32_t Ragged = 1; Ragged <= 37 && IsExact; Ragged += 3 )
+            IsExact &= matchesPngRoundTrip( tagSurface{ Pattern.Bits, Ragged, 9, Pattern.Pitch }, Source, 2 );
+
+        std::vector< uint8_t > Frame = makeDesktopLike( Width, Height );
+        const tagSurface Src{ Frame.data(), Width, Height, ( ptrdiff_t )Width * 4 };
+        IsExact &= matchesPngRoundTrip( Src, Source, 0 );
+
+        // cost of the split : the same rows as one block
+        std::vector< uint8_t > File;
+        tagPngOptions Single;
+        Single.Threads      = 1;
+        Single.BlockRows    = Height;
+        encodePng( Src, Source, Single, &File );
+        const size_t SingleBytes = File.size();
+
+        const double SourceMB = ( double )Width * Height * 4 / ( 1024.0 * 1024.0 );
+        const uint32_t MaxThreads = std::max( 1u, std::thread::hardware_concurrency() );
+        for( uint32_t Threads = 1; ; Threads = std::min( Threads * 2, MaxThreads ) )
+        {
+            tagPngOptions Options;
+            Options.Threads = Threads;
+
+            auto Start = Clock::now();
+            for( int i = 0; i < Frames; ++i )
+                encodePng( Src, Source, Options, &File );
+            const double Ms = std::chrono::duration< double, std::milli >( Clock::now() - Start ).count() / Frames;
+
+            printf( "png %-11s %2u threads | %8.2f ms ( %7.1f MB/s ) | %9zu bytes, %+.2f%% against one block | %s\n",
+                    sourceName( Source ), Threads, Ms, Ms > 0.0 ? SourceMB * 1000.0 / Ms : 0.0,
+                    File.size(), SingleBytes > 0 ? ( ( double )File.size() / SingleBytes - 1.0 ) * 100.0 : 0.0,
+                    IsExact ? "exact" : "MISMATCH" );
+
+            if( Threads == MaxThreads )
+                break;
+        }
+
+        return IsExact;
+    }
+#endif
+
+    typedef nsCapture::CScriptedDuplicationSource   CScriptedSource;
+
+    // struct tagAcquireCase_s : one Acquire call on a fresh scripted source, times are virtual milliseconds
+    typedef struct tagAcquireCase_s
+    {
+        const char*                     Name;
+        std::vector< CScriptedSource::tagScriptStep >  Script;
+        int64_t                         TimeoutMs;
+        bool                            HasCachedFrame;
+        nsCapture::tagFrameReason       Reason;
+        int64_t                         ElapsedMs;
+        uint32_t                        SkippedUpdates;
+    } tagAcquireCase;
+
+    int64_t elapsedMs( const CScriptedSource& Source, nsCapture::AcquireClock::time_point Start )
+    {
+        return std::chrono::duration_cast< std::chrono::milliseconds >( Source.Now() - Start ).count();
+    }
+
+    bool runAcquire( const tagAcquireCase& Case )
+    {
+        CScriptedSource Source;
+        for( const auto& Step : Case.Script )
+            Source.Push( Step.Event, Step.DelayMs, Step.Repeat );
+
+        nsCapture::CFrameAcquirer Acquirer( &Source, Source.Clock() );
+        const auto Start = Source.Now();
+        const auto Result = Acquirer.Acquire( std::chrono::milliseconds( Case.TimeoutMs ), Case.HasCachedFrame );
+        const int64_t Elapsed = elapsedMs( Source, Start );
+
+        // a fresh frame stays held for the caller, every pointer-only update was released while waiting
+        const bool IsExact = Result.Reason == Case.Reason && Elapsed == Case.ElapsedMs
+                          && Result.SkippedUpdates == Case.SkippedUpdates
+                          && Source.IsFrameHeld() == Result.IsFrameHeld()
+                          && Source.ReleaseCalls() == Case.SkippedUpdates;
+
+        printf( "acquire %-28s | %-11s after %4lld ms ( expected %-11s after %4lld ms ) | attempts %u skipped %u | %s\n",
+                Case.Name, nsCapture::FrameReasonToString( Result.Reason ), ( long long )Elapsed,
+                nsCapture::FrameReasonToString( Case.Reason ), ( long long )Case.ElapsedMs,
+                Result.Attempts, Result.SkippedUpdates, IsExact ? "exact" : "MISMATCH" );
+
+        return IsExact;
+    }
+
+    // back to back captures against a burst : queued presents return at once, then one per 16 ms, then the deadline
+    bool runAcquireBurst()
+    {
+        CScriptedSource Source;
+        Source.Push( CScriptedSource::tagScriptEvent_Present, 0, 5 );
+        Source.Push( CScriptedSource::tagScriptEvent_Present, 16, 3 );
+
+        nsCapture::CFrameAcquirer Acquirer( &Source, Source.Clock() );
+        const int64_t Expected[] = { 0, 0, 0, 0, 0, 16, 16, 16 };
+
+        bool IsExact = true;
+        for( const int64_t ElapsedMs : Expected )
+        {
+            const auto Start = Source.Now();
+            const auto Result = Acquirer.Acquire( std::chrono::milliseconds( 100 ), true );
+            IsExact &= Result.Reason == nsCapture::tagFrameReason_Fresh && elapsedMs( Source, Start ) == ElapsedMs;
+            Source.ReleaseFrame();
+        }
+
+        // the burst is over, the desktop is static again
+        const auto Start = Source.Now();
+        const auto Result = Acquirer.Acquire( std::chrono::milliseconds( 100 ), true );
+        IsExact &= Result.Reason == nsCapture::tagFrameReason_Cached && elapsedMs( Source, Start ) == 100;
+
+        IsExact &= Source.Presents() == 8 && Source.ReleaseCalls() == 8 && Source.AcquireCalls() == 9 && Source.IsScriptDone();
+
+        printf( "acquire %-28s | presents %llu acquire calls %llu release calls %llu | %s\n", "burst",
+                ( unsigned long long )Source.Presents(), ( unsigned long long )Source.AcquireCalls(),
+                ( unsigned long long )Source.ReleaseCalls(), IsExact ? "exact" : "MISMATCH" );
+
+        return IsExact;
+    }
+
+    bool runAcquireScripts()
+    {
+        using namespace nsCapture;
+
+        const auto Present    = CScriptedSource::tagScriptEvent_Present;
+        const auto MouseOnly  = CScriptedSource::tagScriptEvent_MouseOnly;
+        const auto AccessLost = CScriptedSource::tagScriptEvent_AccessLost;
+        const auto Failed     = CScriptedSource::tagScriptEvent_Failed;
+        const auto Idle       = CScriptedSource::tagScriptEvent_Idle;
+
+        const tagAcquireCase Cases[] =
+        {
+            { "static screen",                {},                                             100, false, tagFrameReason_Timeout,    100, 0 },
+            { "static screen, cached",        {},                                             100, true,  tagFrameReason_Cached,     100, 0 },
+            { "quiet, then present",          { { Idle, 40, 1 }, { Present, 30, 1 } },        100, true,  tagFrameReason_Fresh,       70, 0 },
+            { "present after the deadline",   { { Present, 150, 1 } },                        100, true,  tagFrameReason_Cached,     100, 0 },
+            { "mouse only",                   { { MouseOnly, 10, 3 } },                       100, true,  tagFrameReason_Cached,     100, 3 },
+            { "mouse, then present",          { { MouseOnly, 10, 3 }, { Present, 20, 1 } },   100, false, tagFrameReason_Fresh,       50, 3 },
+            { "access lost mid-wait",         { { Idle, 30, 1 }, { AccessLost, 10, 1 } },     100, true,  tagFrameReason_AccessLost,  40, 0 },
+            { "mouse, then access lost",      { { MouseOnly, 5, 2 }, { AccessLost, 20, 1 } }, 100, true,  tagFrameReason_AccessLost,  30, 2 },
+            { "failed",                       { { Failed, 5, 1 } },                           100, true,  tagFrameReason_Failed,       5, 0 },
+            { "zero timeout, queued present", { { Present, 0, 1 } },                            0, false, tagFrameReason_Fresh,        0, 0 },
+            { "zero timeout, later present",  { { Present, 5, 1 } },                            0, true,  tagFrameReason_Cached,       0, 0 },
+        };
+
+        bool IsExact = true;
+        for( const auto& Case : Cases )
+            IsExact &= runAcquire( Case );
+
+        IsExact &= runAcquireBurst();
+        return IsExact;
+    }
+
+    // struct tagMatrixLayout_s : desktop size of the throughput matrix, multi-monitor entries are the bounding box
+    typedef struct tagMatrixLayout_s
+    {
+        const char*                     Name;
+        int32_t                         Width;
+        int32_t                         Height;
+    } tagMatrixLayout;
+
+    const tagMatrixLayout MATRIX_LAYOUTS[] =
+    {
+        { "1080p",      1920, 1080 },
+        { "1440p",      2560, 1440 },
+        { "4K",         3840, 2160 },
+        { "8K",         7680, 4320 },
+        { "2x1080p",    3840, 1080 },
+        { "3x1440p",    7680, 1440 },
+        { "1080p+4K",   5760, 2160 },
+    };
+
+    // struct tagMatrixResult_s
+    typedef struct tagMatrixResult_s
+    {
+        std::string                     Kernel;
+        std::string                     Layout;
+        int32_t                         Width           = 0;
+        int32_t                         Height          = 0;
+        double                          Bytes           = 0.0;  // source bytes per run
+        double                          MedianMs        = 0.0;
+        double                          BestMs          = 0.0;
+        size_t                          Runs            = 0;
+    } tagMatrixResult;
+
+    // one warm-up, then at least 3 and up to 200 runs within about 200 ms
+    template< typename Fn >
+    void timeRuns( Fn&& Run, tagMatrixResult* pResult )
+    {
+        Run();
+
+        std::vector< double > Samples;
+        const auto Begin = Clock::now();
+        while( Samples.size() < 3 || ( Samples.size() < 200 && Clock::now() - Begin < std::chrono::milliseconds( 200 ) ) )
+        {
+            const auto Start = Clock::now();
+            Run();
+            Samples.push_back( std::chrono::duration< double, std::milli >( Clock::now() - Start ).count() );
+        }
+
+        std::sort( Samples.begin(), Samples.end() );
+        pResult->Runs       = Samples.size();
+        pResult->BestMs     = Samples.front();
+        pResult->MedianMs   = Samples[ Samples.size() / 2 ];
+    }
+
+    void addMatrixResult( std::vector< tagMatrixResult >* pResults, const std::string& Kernel, const tagMatrixLayout& Layout, double Bytes, const tagMatrixResult& Timing )
+    {
+        tagMatrixResult Result = Timing;
+        Result.Kernel   = Kernel;
+        Result.Layout   = Layout.Name;
+        Result.Width    = Layout.Width;
+        Result.Height   = Layout.Height;
+        Result.Bytes    = Bytes;
+
+        printf( "%-26s %-9s %5dx%-5d | median %9.3f ms best %9.3f ms | %7.2f GB/s | %3zu runs\n",
+                Result.Kernel.c_str(), Result.Layout.c_str(), Result.Width, Result.Height,
+                Result.MedianMs, Result.BestMs,
+                Result.MedianMs > 0.0 ? Bytes / ( Result.MedianMs * 1e6 ) : 0.0, Result.Runs );
+
+        pResults->push_back( Result );
+    }
+
+    void runMatrixLayout( const tagMatrixLayout& Layout, std::vector< tagMatrixResult >* pResults )
+    {
+        const int32_t Width = Layout.Width, Height = Layout.Height;
+        const ptrdiff_t Pitch = ( ptrdiff_t )Width * 4;
+        const double FrameBytes = ( double )Pitch * Height;
+
+        std::vector< uint8_t > Source( Pitch * Height );
+        std::vector< uint8_t > Target( Pitch * Height );
+        std::mt19937 Random( 23 );
+        for( auto& Byte : Source )
+            Byte = ( uint8_t )Random();
+
+        const tagSurface Src{ Source.data(), Width, Height, Pitch };
+        tagMatrixResult Timing;
+
+        // cursor blend : 64 x 64 per shape type at the centre, the per-capture cost on top of the frame copy
+        for( auto Type : { tagCursorShapeType_Color, tagCursorShapeType_Monochrome, tagCursorShapeType_MaskedColor } )
+        {
+            std::vector< uint8_t > Bytes;
+            tagCursorImage Cursor;
+            BuildCursorImage( makeCursorShape( Type, 64, &Bytes ), tagRotation_0, &Cursor );
+
+            const tagSurface Dst{ Target.data(), Width, Height, Pitch };
+            timeRuns( [&]() { CompositeCursor( Dst, Cursor, Width / 2, Height / 2 ); }, &Timing );
+            addMatrixResult( pResults, std::string( "cursor_blend_" ) + ( Type == tagCursorShapeType_Color ? "color" : Type == tagCursorShapeType_Monochrome ? "mono" : "masked" ),
+                             Layout, 64.0 * 64.0 * 4.0, Timing );
+        }
+
+        // rotation : portrait outputs, every quarter turn
+        for( auto Rotation : { tagRotation_90, tagRotation_180, tagRotation_270 } )
+        {
+            int32_t DstWidth = 0, DstHeight = 0;
+            RotatedSize( Rotation, Width, Height, &DstWidth, &DstHeight );
+            const tagSurface Dst{ Target.data(), DstWidth, DstHeight, ( ptrdiff_t )DstWidth * 4 };
+
+            timeRuns( [&]() { RotateSurface( Dst, Src, Rotation ); }, &Timing );
+            addMatrixResult( pResults, "rotate_" + std::to_string( ( int )Rotation * 90 ), Layout, FrameBytes, Timing );
+        }
+
+        // conversion : every conversion at the best level of this CPU
+        for( int Conversion = 0; Conversion < tagPixelConversion_Count; ++Conversion )
+        {
+            const ptrdiff_t DstPitch = ( ptrdiff_t )Width * ConvertedPixelSize( ( tagPixelConversion )Conversion );
+            timeRuns( [&]() { ConvertPixels( ( tagPixelConversion )Conversion, Target.data(), DstPitch, Source.data(), Pitch, Width, Height ); }, &Timing );
+            addMatrixResult( pResults, std::string( "convert_" ) + conversionName( ( tagPixelConversion )Conversion ), Layout, FrameBytes, Timing );
+        }
+
+        // crop : a centred quarter of the desktop, the region capture read
+        {
+            const tagPixelRect Crop = makeRect( Width / 4, Height / 4, Width / 2, Height / 2 );
+            const tagSurface Dst{ Target.data(), Width, Height, Pitch };
+            timeRuns( [&]() { CopyRect( Dst, Source.data(), Pitch, Crop ); }, &Timing );
+            addMatrixResult( pResults, "crop_quarter", Layout, ( double )Crop.Area() * 4.0, Timing );
+        }
+
+        // scaling : half size ( Auto -> box ), the preview thumbnail, and a 2/3 bilinear zoom
+        const struct { const char* Name; int32_t W; int32_t H; tagResampleFilter Filter; } Scales[] =
+        {
+            { "scale_half_box",         Width / 2,      Height / 2,     tagResampleFilter_Box },
+            { "scale_thumb_box",        320,            180,            tagResampleFilter_Box },
+            { "scale_two_thirds_bilinear", Width * 2 / 3, Height * 2 / 3, tagResampleFilter_Bilinear },
+        };
+        for( const auto& Scale : Scales )
+        {
+            const tagSurface Dst{ Target.data(), Scale.W, Scale.H, ( ptrdiff_t )Scale.W * 4 };
+            timeRuns( [&]() { ResampleSurface( Dst, makeRect( 0, 0, Scale.W, Scale.H ), Src, Scale.Filter ); }, &Timing );
+            addMatrixResult( pResults, Scale.Name, Layout, FrameBytes, Timing );
+        }
+
+        // preview pyramid ( CImagePyramid ) : box halves down to 256, then one 1600 x 900 window frame from the
+        // smallest level covering it, the cost of a resize step
+        {
+            std::vector< std::vector< uint8_t > > Levels;
+            std::vector< tagSurface > Surfaces{ Src };
+            const auto buildLevels = [&]() {
+                Surfaces.resize( 1 );
+                for( size_t Level = 0; std::max( Surfaces.back().Width, Surfaces.back().Height ) / 2 >= 256; ++Level )
+                {
+                    const tagSurface& Last = Surfaces.back();
+                    const int32_t W = ( Last.Width + 1 ) / 2, H = ( Last.Height + 1 ) / 2;
+                    if( Levels.size() <= Level )
+                        Levels.emplace_back( ( size_t )W * H * 4 );
+                    const tagSurface Half{ Levels[ Level ].data(), W, H, ( ptrdiff_t )W * 4 };
+                    ResampleSurface( Half, makeRect( 0, 0, W, H ), Last, tagResampleFilter_Box );
+                    Surfaces.push_back( Half );
+                }
+            };
+            timeRuns( buildLevels, &Timing );
+            addMatrixResult( pResults, "preview_pyramid", Layout, FrameBytes, Timing );
+
+            const double Fit = std::min( 1600.0 / Width, 900.0 / Height );
+            const int32_t FitWidth = std::max( 1, ( int32_t )( Width * Fit ) ), FitHeight = std::max( 1, ( int32_t )( Height * Fit ) );
+            size_t Level = 0;
+            while( Level + 1 < Surfaces.size() && Surfaces[ Level + 1 ].Width >= FitWidth && Surfaces[ Level + 1 ].Height >= FitHeight )
+                ++Level;
+
+            const tagSurface Dst{ Target.data(), FitWidth, FitHeight, ( ptrdiff_t )FitWidth * 4 };
+            timeRuns( [&]() { ResampleSurface( Dst, makeRect( 0, 0, FitWidth, FitHeight ), Surfaces[ Level ], tagResampleFilter_Auto ); }, &Timing );
+            addMatrixResult( pResults, "preview_frame", Layout, ( double )FitWidth * FitHeight * 4.0, Timing );
+        }
+
+        // encoders : premultiplied desktop as the canvas holds it
+        std::vector< uint8_t > Desktop = makeDesktopLike( Width, Height );
+        const tagSurface DesktopSrc{ Desktop.data(), Width, Height, Pitch };
+        std::vector< uint8_t > File;
+        File.reserve( Desktop.size() + RAW_HEADER_BYTES );
+        const ImageWriteFn Collect = [&File]( const uint8_t* pData, size_t Size ) {
+            File.insert( File.end(), pData, pData + Size );
+            return true;
+        };
+
+#ifdef SNIPPINGTOOL_HAVE_ZLIB
+        // PNG : one worker and every worker
+        for( uint32_t Threads : { 1u, 0u } )
+        {
+            tagPngOptions Options;
+            Options.Threads = Threads;
+            timeRuns( [&]() { File.clear(); EncodePng( DesktopSrc, tagPixelSource_BGRAPremultiplied, Options, Collect ); }, &Timing );
+            addMatrixResult( pResults, Threads == 1 ? "png_encode_1t" : "png_encode", Layout, FrameBytes, Timing );
+        }
+#endif
+
+        timeRuns( [&]() { File.clear(); EncodeQoi( DesktopSrc, tagPixelSource_BGRAPremultiplied, Collect ); }, &Timing );
+        addMatrixResult( pResults, "qoi_encode", Layout, FrameBytes, Timing );
+
+        const std::vector< uint8_t > QoiFile = File;
+        const tagSurface Decoded{ Target.data(), Width, Height, Pitch };
+        timeRuns( [&]() { DecodeQoi( QoiFile.data(), QoiFile.size(), Decoded ); }, &Timing );
+        addMatrixResult( pResults, "qoi_decode", Layout, FrameBytes, Timing );
+
+        timeRuns( [&]() { File.clear(); WriteRawImage( DesktopSrc, tagPixelSource_BGRAPremultiplied, Collect ); }, &Timing );
+        addMatrixResult( pResults, "raw_write", Layout, FrameBytes, Timing );
+    }
+
+    // shape expansion and rotation, independent of the desktop size
+    void runMatrixCursorMasks( std::vector< tagMatrixResult >* pResults )
+    {
+        for( auto Type : { tagCursorShapeType_Color, tagCursorShapeType_Monochrome, tagCursorShapeType_MaskedColor } )
+        {
+            for( int32_t Size : { 32, 64, 256 } )
+            {
+                std::vector< uint8_t > Bytes;
+                const tagCursorShape Shape = makeCursorShape( Type, Size, &Bytes );
+                const std::string Name = std::string( "cursor_mask_" ) + ( Type == tagCursorShapeType_Color ? "color" : Type == tagCursorShapeType_Monochrome ? "mono" : "masked" );
+                const tagMatrixLayout Layout{ Size == 32 ? "32px" : Size == 64 ? "64px" : "256px", Size, Size };
+
+                tagCursorImage Cursor;
+                tagMatrixResult Timing;
+                timeRuns( [&]() { BuildCursorImage( Shape, tagRotation_90, &Cursor ); }, &Timing );
+                addMatrixResult( pResults, Name, Layout, ( double )Shape.Size(), Timing );
+            }
+        }
+    }
+
+    bool writeMatrixJson( const std::string& FilePath, const std::vector< tagMatrixResult >& Results )
+    {
+        FILE* pFile = fopen( FilePath.c_str(), "w" );
+        if( pFile == nullptr )
+            return false;
+
+        // names are fixed identifiers, nothing needs escaping
+        fprintf( pFile, "{\n  \"schema\": 1,\n  \"cpu\": \"%s\",\n  \"threads\": %u,\n  \"results\": [",
+                 CpuLevelName( DetectCpuLevel() ), std::max( 1u, std::thread::hardware_concurrency() ) );
+        for( size_t idx = 0; idx < Results.size(); ++idx )
+        {
+            const auto& Result = Results[ idx ];
+            fprintf( pFile, "%s\n    { \"kernel\": \"%s\", \"layout\": \"%s\", \"width\": %d, \"height\": %d, \"bytes\": %.0f, "
+                            "\"median_ms\": %.4f, \"best_ms\": %.4f, \"gb_per_s\": %.3f, \"runs\": %zu }",
+                     idx == 0 ? "" : ",",
+                     Result.Kernel.c_str(), Result.Layout.c_str(), Result.Width, Result.Height, Result.Bytes,
+                     Result.MedianMs, Result.BestMs, Result.MedianMs > 0.0 ? Result.Bytes / ( Result.MedianMs * 1e6 ) : 0.0, Result.Runs );
+        }
+        fprintf( pFile, "\n  ]\n}\n" );
+
+        return fclose( pFile ) == 0;
+    }
+
+    int runMatrix( const std::string& JsonPath )
+    {
+        printf( "throughput matrix, cpu %s, %u threads\n", CpuLevelName( DetectCpuLevel() ), std::max( 1u, std::thread::hardware_concurrency() ) );
+
+        std::vector< tagMatrixResult > Results;
+        runMatrixCursorMasks( &Results );
+        for( const auto& Layout : MATRIX_LAYOUTS )
+            runMatrixLayout( Layout, &Results );
+
+        if( !JsonPath.empty() && !writeMatrixJson( JsonPath, Results ) )
+        {
+            fprintf( stderr, "cannot write %s\n", JsonPath.c_str() );
+            return 2;
+        }
+
+        return 0;
+    }
+}
+
+int main( int argc, char* argv[] )
+{
+    int Frames = 300;
+    int32_t Width = 3840, Height = 2160;
+    std::string StreamPath;
+    std::string JsonPath;
+    bool IsMatrix = false;
+
+    for( int i = 1; i < argc; ++i )
+    {
+        const std::string Arg = argv[ i ];
+        if( Arg == "--frames" && i + 1 < argc )
+            Frames = std::max( 1, atoi( argv[ ++i ] ) );
+        else if( Arg == "--size" && i + 1 < argc )
+            sscanf( argv[ ++i ], "%dx%d", &Width, &Height );
+        else if( Arg == "--stream" && i + 1 < argc )
+            StreamPath = argv[ ++i ];
+        else if( Arg == "--matrix" )
+            IsMatrix = true;
+        else if( Arg == "--json" && i + 1 < argc )
+        {
+            JsonPath = argv[ ++i ];
+            IsMatrix = true;
+        }
+        else
+        {
+            fprintf( stderr, "usage: %s [--frames N] [--size WxH] [--stream rects.txt] | --matrix [--json results.json]\n", argv[ 0 ] );
+            return 2;
+        }
+    }
+
+    if( IsMatrix )
+        return runMatrix( JsonPath );
+
+    std::vector< tagScenario > Scenarios;
+    if( !StreamPath.empty() )
+    {
+        std::ifstream File( StreamPath );
+        tagScenario Recorded{ StreamPath, {} };
+        if( !File || !ReadRectStream( File, &Recorded.Frames ) )
+        {
+            fprintf( stderr, "cannot read rect stream : %s\n", StreamPath.c_str() );
+            return 2;
+        }
+        Scenarios.push_back( Recorded );
+    }
+    else
+    {
+        Scenarios.push_back( makeTyping( Width, Height, Frames ) );
+        Scenarios.push_back( makeScrolling( Width, Height, Frames ) );
+        Scenarios.push_back( makeWindowDrag( Width, Height, Frames ) );
+        Scenarios.push_back( makeVideo( Width, Height, Frames ) );
+        Scenarios.push_back( makeFullScreen( Width, Height, Frames ) );
+    }
+
+    printf( "frame acquisition, scripted duplication\n" );
+
+    bool IsExact = runAcquireScripts();
+
+    printf( "\nincremental framebuffer, %dx%d\n", Width, Height );
+
+    for( const auto& Scenario : Scenarios )
+        IsExact &= runIncremental( Scenario, Width, Height );
+
+    printf( "\nrotation, %dx%d\n", Width, Height );
+
+    const int RotateFrames = std::max( 1, std::min( Frames, 20 ) );
+    for( auto Rotation : { tagRotation_90, tagRotation_180, tagRotation_270 } )
+        IsExact &= runRotate( Rotation, Width, Height, RotateFrames );
+
+    printf( "\ncursor compositing, %dx%d\n", Width, Height );
+
+    IsExact &= runCursorGolden();
+    for( auto Type : { tagCursorShapeType_Color, tagCursorShapeType_Monochrome, tagCursorShapeType_MaskedColor } )
+    {
+        for( int32_t Size : { 32, 64, 256 } )
+            IsExact &= runCursor( Type, Size, Width, Height, Frames * 10 );
+    }
+
+    printf( "\nresampling, %dx%d\n", Width, Height );
+
+    IsExact &= runResampleGolden();
+    const int ResampleFrames = std::max( 1, std::min( Frames, 10 ) );
+    for( auto Filter : { tagResampleFilter_Box, tagResampleFilter_Bilinear, tagResampleFilter_Lanczos3 } )
+    {
+        IsExact &= runResample( Filter, Width, Height, 320, 180, makeRect( 0, 0, 320, 180 ), ResampleFrames );
+        IsExact &= runResample( Filter, Width, Height, 1280, 720, makeRect( 0, 0, 1280, 720 ), ResampleFrames );
+        IsExact &= runResample( Filter, Width / 2, Height / 2, Width * 2 / 3, Height * 2 / 3, makeRect( 0, 0, Width * 2 / 3, Height * 2 / 3 ), ResampleFrames );
+        // letterboxed and partly off the surface
+        IsExact &= runResample( Filter, Width, Height, 1000, 700, makeRect( -37, 100, 1075, 605 ), ResampleFrames );
+    }
+
+    printf( "\npixel conversion, %dx%d, cpu %s\n", Width, Height, CpuLevelName( DetectCpuLevel() ) );
+
+    std::vector< uint8_t > Exhaustive( ( size_t )4096 * 4096 * 4 );
+    for( uint32_t i = 0; i < 4096u * 4096u; ++i )
+    {
+        const uint32_t Pixel = i | ( ( ( i ^ ( i >> 8 ) ) & 0xFFu ) << 24 );
+        memcpy( Exhaustive.data() + ( size_t )i * 4, &Pixel, sizeof( Pixel ) );
+    }
+
+    const int ConvertFrames = std::max( 1, std::min( Frames, 50 ) );
+    for( int Conversion = 0; Conversion < tagPixelConversion_Count; ++Conversion )
+    {
+        for( int Level = tagCpuLevel_Scalar; Level <= DetectCpuLevel(); ++Level )
+            IsExact &= runConvert( ( tagPixelConversion )Conversion, ( tagCpuLevel )Level, Exhaustive, Width, Height, ConvertFrames );
+    }
+
+    printf( "\nqoi / raw against png, %dx%d\n", Width, Height );
+
+    const int CodecFrames = std::max( 1, std::min( Frames, 5 ) );
+    for( auto Source : { tagPixelSource_BGRX, tagPixelSource_BGRA, tagPixelSource_BGRAPremultiplied } )
+        IsExact &= runCodec( Source, Exhaustive, Width, Height, CodecFrames );
+
+#ifdef SNIPPINGTOOL_HAVE_ZLIB
+    printf( "\npng encoding, %dx%d, cpu %s\n", Width, Height, CpuLevelName( DetectCpuLevel() ) );
+
+    const int PngFrames = std::max( 1, std::min( Frames, 3 ) );
+    for( auto Source : { tagPixelSource_BGRX, tagPixelSource_BGRA, tagPixelSource_BGRAPremultiplied } )
+        IsExact &= runPng( Source, Exhaustive, Width, Height, PngFrames );
+#endif
+
+    return IsExact ? 0 : 1;
+}
@@ -0,0 +1,821 @@
+#include "captureService.hpp"
+#include "syntheticBackend.hpp"
+
+#ifdef Q_OS_WIN
+#include "dxgiMgr.hpp"
+#endif
+
+namespace nsCapture
+{
+    namespace
+    {
+        // an asynchronous capture is Ok when at least one output was captured, otherwise it tells why none was
+        tagCaptureStatus asyncStatusOf( bool IsCaptured, tagCaptureStatus Status )
+        {
+            if( IsCaptured )
+                return tagCaptureStatus_Ok;
+
+            return Status == tagCaptureStatus_Timeout || Status == tagCaptureStatus_Canceled ? Status : tagCaptureStatus_Failed;
+        }
+    }
+
+    bool operator==( const tagOutputInfo& Lhs, const tagOutputInfo& Rhs )
+    {
+        return Lhs.Idx == Rhs.Idx &&
+            Lhs.Bounds == Rhs.Bounds &&
+            Lhs.RotationDegrees == Rhs.RotationDegrees &&
+            Lhs.Handle == Rhs.Handle;
+    }
+
+    void tagLatencyStats_s::Add( quint64 Us )
+    {
+        if( Count == 0 || Us < MinUs )
+            MinUs = Us;
+        if( Us > MaxUs )
+            MaxUs = Us;
+
+        ++Count;
+        TotalUs += Us;
+        LastUs = Us;
+    }
+
+    tagCaptureStatus ICaptureSession::CaptureInto( const tagCaptureRequest& Request, QImage* pTarget, tagFrameReason* pRetReason )
+    {
+        if( pTarget == nullptr )
+            return tagCaptureStatus_Failed;
+
+        QImage Image;
+        const auto Status = Capture( Request, &Image, pRetReason );
+        if( Status != tagCaptureStatus_Ok )
+            return Status;
+
+        return CDesktopCanvas::Blit( Image, pTarget ) ? tagCaptureStatus_Ok : tagCaptureStatus_Failed;
+    }
+
+    tagCaptureStatus ICaptureSession::CaptureRect( const tagCaptureRequest& Request, const QRect& Rect, QImage* pTarget, tagFrameReason* pRetReason )
+    {
+        if( pTarget == nullptr )
+            return tagCaptureStatus_Failed;
+
+        QImage Image;
+        const auto Status = Capture( Request, &Image, pRetReason );
+        if( Status != tagCaptureStatus_Ok )
+            return Status;
+
+        if( Image.depth() != 32 || QRect( QPoint( 0, 0 ), Image.size() ).contains( Rect ) == false )
+            return tagCaptureStatus_Failed;
+
+        // view of Rect inside the frame, no copy before the blit
+        const QImage Part( Image.constBits() + Rect.top() * Image.bytesPerLine() + Rect.left() * 4,
+                           Rect.width(), Rect.height(), Image.bytesPerLine(), Image.format() );
+        return CDesktopCanvas::Blit( Part, pTarget ) ? tagCaptureStatus_Ok : tagCaptureStatus_Failed;
+    }
+
+    std::unique_ptr< ICaptureBackend > CreateDefaultBackend()
+    {
+#ifdef Q_OS_WIN
+        return std::make_unique< nsDXGI::CDXGICaptureBackend >();
+#else
+        return std::make_unique< CSyntheticBackend >();
+#endif
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// class CCaptureService
+    //
+
+    CCaptureService::CCaptureService( std::unique_ptr< ICaptureBackend > Backend )
+        : m_backend( std::move( Backend ) )
+        , m_isTopologyDirty( true )
+        , m_refreshIntervalMs( 0 )
+        , m_isRefreshStopping( false )
+        , m_idleReleaseMs( 0 )
+        , m_lastUseTick( Clock::now() )
+    {
+        // captures of different outputs already run in parallel inside one request
+        m_asyncPool.setMaxThreadCount( 2 );
+    }
+
+    CCaptureService::~CCaptureService()
+    {
+        // pending asynchronous captures finish against the live sessions, bounded by their TimeoutMs
+        m_asyncPool.waitForDone();
+        stopRefreshThread();
+        Release();
+    }
+
+    QString CCaptureService::BackendName() const
+    {
+        std::lock_guard< std::mutex > Lock( m_lock );
+        return m_backend ? m_backend->Name() : QString();
+    }
+
+    bool CCaptureService::Refresh( bool IsForce )
+    {
+        std::lock_guard< std::mutex > Lock( m_lock );
+        return refreshLocked( IsForce );
+    }
+
+    void CCaptureService::Release()
+    {
+        std::lock_guard< std::mutex > Lock( m_lock );
+        // a worker still holding a slot finishes on it, the session goes away with the last reference
+        m_sessions.clear();
+        m_isTopologyDirty = true;
+    }
+
+    void CCaptureService::Invalidate()
+    {
+        std::lock_guard< std::mutex > Lock( m_lock );
+        m_isTopologyDirty = true;
+    }
+
+    void CCaptureService::SetBackgroundRefresh( int IntervalMs )
+    {
+        stopRefreshThread();
+
+        if( IntervalMs <= 0 )
+            return;
+
+        {
+            std::lock_guard< std::mutex > Lock( m_lock );
+            m_refreshIntervalMs = IntervalMs;
+            m_isRefreshStopping = false;
+        }
+
+        m_refreshThread = std::thread( &CCaptureService::refreshThreadProc, this );
+    }
+
+    void CCaptureService::SetIdleRelease( int IdleMs )
+    {
+        {
+            std::lock_guard< std::mutex > Lock( m_lock );
+            m_idleReleaseMs = qMax( 0, IdleMs );
+            m_lastUseTick = Clock::now();
+        }
+        m_refreshWake.notify_all();
+    }
+
+    int CCaptureService::Prepare( int TimeoutMs )
+    {
+        QVector< tagOutputInfo > Outputs;
+        {
+            std::lock_guard< std::mutex > Lock( m_lock );
+            refreshLocked( false );
+            Outputs = m_outputs;
+            m_lastUseTick = Clock::now();
+        }
+
+        std::vector< int > IsWarm( ( size_t )Outputs.size(), 0 );
+
+        runParallel( Outputs.size(), [&]( int i ) {
+            std::shared_ptr< tagSessionSlot > Slot;
+            {
+                std::lock_guard< std::mutex > Lock( m_lock );
+                Slot = slotLocked( Outputs.at( i ) );
+            }
+
+            std::lock_guard< std::mutex > SlotLock( Slot->Lock );
+            if( !Slot->Session )
+            {
+                Slot->Session = m_backend->OpenSession( Outputs.at( i ) );
+                if( !Slot->Session )
+                    return;
+
+                std::lock_guard< std::mutex > Lock( m_lock );
+                ++m_stats.SessionsBuilt;
+            }
+
+            // the first present fills the cache, a timeout leaves the session open for the next capture
+            IsWarm[ i ] = Slot->Session->Refresh( TimeoutMs ) == tagCaptureStatus_Ok ? 1 : 0;
+        } );
+
+        return ( int )std::count( IsWarm.cbegin(), IsWarm.cend(), 1 );
+    }
+
+    QVector< tagOutputInfo > CCaptureService::Outputs()
+    {
+        std::lock_guard< std::mutex > Lock( m_lock );
+        refreshLocked( false );
+        return m_outputs;
+    }
+
+    QRect CCaptureService::VirtualBounds()
+    {
+        std::lock_guard< std::mutex > Lock( m_lock );
+        refreshLocked( false );
+
+        QRect Bounds;
+        for( const auto& Output : m_outputs )
+            Bounds |= Output.Bounds;
+        return Bounds;
+    }
+
+    tagCaptureStatus CCaptureService::CaptureOutput( int OutputIdx, const tagCaptureRequest& Request, QImage* pRetImage, tagFrameReason* pRetReason )
+    {
+        tagOutputInfo Output;
+        {
+            std::lock_guard< std::mutex > Lock( m_lock );
+            refreshLocked( false );
+
+            const auto Found = std::find_if( m_outputs.cbegin(), m_outputs.cend(), [OutputIdx]( const tagOutputInfo& Info ) {
+                return Info.Idx == OutputIdx;
+            } );
+
+            if( Found == m_outputs.cend() )
+                return tagCaptureStatus_NoOutput;
+
+            Output = *Found;
+        }
+
+        const auto Outcome = captureOne( Output, Request, pRetImage, nullptr );
+        if( pRetReason != nullptr )
+            *pRetReason = Outcome.Reason;
+
+        std::lock_guard< std::mutex > Lock( m_lock );
+        recordLocked( Outcome );
+        return Outcome.Status;
+    }
+
+    int CCaptureService::CaptureOutputs( const QVector< int >& OutputIdxs, const tagCaptureRequest& Request, QVector< QImage >* pRetImages,
+                                         const tagCaptureControl* pControl, tagCaptureStatus* pRetStatus )
+    {
+        if( pRetStatus != nullptr )
+            *pRetStatus = tagCaptureStatus_Failed;
+
+        if( pRetImages == nullptr )
+            return 0;
+
+        QVector< tagOutputInfo > Targets;
+        {
+            std::lock_guard< std::mutex > Lock( m_lock );
+            refreshLocked( false );
+
+            for( const int Idx : OutputIdxs )
+            {
+                const auto Found = std::find_if( m_outputs.cbegin(), m_outputs.cend(), [Idx]( const tagOutputInfo& Info ) {
+                    return Info.Idx == Idx;
+                } );
+
+                tagOutputInfo Output;
+                if( Found != m_outputs.cend() )
+                    Output = *Found;
+                Targets.push_back( Output );
+            }
+        }
+
+        pRetImages->fill( QImage(), Targets.size() );
+        std::vector< tagCaptureOutcome > Outcomes( ( size_t )Targets.size() );
+
+        // each worker writes only its own element, the container is sized ( and detached ) before the workers start
+        QImage* pImages = pRetImages->data();
+
+        if( pControl != nullptr && pControl->OutputsPlanned )
+            pControl->OutputsPlanned( Targets.size() );
+
+        runParallel( Targets.size(), [&]( int i ) {
+            if( Targets.at( i ).Idx < 0 )
+            {
+                Outcomes[ i ].Status = tagCaptureStatus_NoOutput;
+                return;
+            }
+
+            if( isCanceled( pControl ) )
+            {
+                Outcomes[ i ].Status = tagCaptureStatus_Canceled;
+                return;
+            }
+
+            Outcomes[ i ] = captureOne( Targets.at( i ), boundedRequest( Request, pControl ), &pImages[ i ], nullptr );
+            if( pControl != nullptr && pControl->OutputDone )
+                pControl->OutputDone();
+        } );
+
+        std::lock_guard< std::mutex > Lock( m_lock );
+        for( int i = 0; i < Targets.size(); ++i )
+        {
+            if( Outcomes[ i ].Status != tagCaptureStatus_Ok )
+                ( *pRetImages )[ i ] = QImage();
+
+            if( Outcomes[ i ].Status == tagCaptureStatus_NoOutput || Outcomes[ i ].Status == tagCaptureStatus_Canceled )
+                continue;
+
+            recordLocked( Outcomes[ i ] );
+        }
+
+        return summarize( Outcomes, pRetStatus );
+    }
+
+    QImage CCaptureService::CaptureAll( const tagCaptureRequest& Request, const tagCaptureControl* pControl, tagCaptureStatus* pRetStatus )
+    {
+        if( pRetStatus != nullptr )
+            *pRetStatus = tagCaptureStatus_Failed;
+
+        QVector< tagOutputInfo > Outputs;
+        {
+            std::lock_guard< std::mutex > Lock( m_lock );
+            refreshLocked( false );
+            Outputs = m_outputs;
+        }
+
+        QVector< QRect > Bounds;
+        for( const auto& Output : Outputs )
+            Bounds.push_back( Output.Bounds );
+
+        CDesktopCanvas Canvas;
+        if( Canvas.Reset( Bounds ) == false )
+            return QImage();
+
+        // slices are cut on this thread, workers only touch their own rows of the shared buffer
+        std::vector< QImage > Slices;
+        for( const auto& Output : Outputs )
+            Slices.push_back( Canvas.Slice( Output.Bounds ) );
+
+        std::vector< tagCaptureOutcome > Outcomes( ( size_t )Outputs.size() );
+
+        if( pControl != nullptr && pControl->OutputsPlanned )
+            pControl->OutputsPlanned( Outputs.size() );
+
+        runParallel( Outputs.size(), [&]( int i ) {
+            if( Slices[ i ].isNull() )
+            {
+                Outcomes[ i ].Status = tagCaptureStatus_NoOutput;
+                return;
+            }
+
+            if( isCanceled( pControl ) )
+            {
+                Outcomes[ i ].Status = tagCaptureStatus_Canceled;
+                return;
+            }
+
+            Outcomes[ i ] = captureOne( Outputs.at( i ), boundedRequest( Request, pControl ), nullptr, &Slices[ i ] );
+            if( Outcomes[ i ].Status != tagCaptureStatus_Ok )
+                Slices[ i ].fill( Qt::transparent );
+            if( pControl != nullptr && pControl->OutputDone )
+                pControl->OutputDone();
+        } );
+
+        std::lock_guard< std::mutex > Lock( m_lock );
+        for( const auto& Outcome : Outcomes )
+            recordLocked( Outcome );
+
+        // every output failed : a fully transparent image is not a capture
+        if( summarize( Outcomes, pRetStatus ) == 0 )
+            return QImage();
+
+        return Canvas.Image();
+    }
+
+    QImage CCaptureService::CaptureRegion( const QRect& Region, const tagCaptureRequest& Request, const tagCaptureControl* pControl, tagCaptureStatus* pRetStatus )
+    {
+        if( pRetStatus != nullptr )
+            *pRetStatus = tagCaptureStatus_Failed;
+
+        QVector< tagOutputInfo > Outputs;
+        {
+            std::lock_guard< std::mutex > Lock( m_lock );
+            refreshLocked( false );
+            Outputs = m_outputs;
+        }
+
+        CDesktopCanvas Canvas;
+        if( Region.isEmpty() || Canvas.Reset( { Region } ) == false )
+            return QImage();
+
+        // only the outputs under the region take part, each one with the piece it covers
+        QVector< tagOutputInfo > Covered;
+        std::vector< QRect > Parts;
+        for( const auto& Output : Outputs )
+        {
+            const QRect Part = Region.intersected( Output.Bounds );
+            if( Part.isEmpty() )
+                continue;
+
+            Covered.push_back( Output );
+            Parts.push_back( Part );
+        }
+
+        if( Parts.empty() )
+        {
+            if( pRetStatus != nullptr )
+                *pRetStatus = tagCaptureStatus_NoOutput;
+            return QImage();
+        }
+
+        // a region over gaps between outputs keeps them transparent
+        qint64 CoveredPixels = 0;
+        std::vector< QImage > Slices;
+        for( const auto& Part : Parts )
+        {
+            Slices.push_back( Canvas.Slice( Part ) );
+            CoveredPixels += ( qint64 )Part.width() * Part.height();
+        }
+        if( CoveredPixels < ( qint64 )Region.width() * Region.height() )
+            Canvas.Slice( Region ).fill( Qt::transparent );
+
+        std::vector< tagCaptureOutcome > Outcomes( Parts.size() );
+
+        if( pControl != nullptr && pControl->OutputsPlanned )
+            pControl->OutputsPlanned( Covered.size() );
+
+        runParallel( Covered.size(), [&]( int i ) {
+            if( Slices[ i ].isNull() )
+            {
+                Outcomes[ i ].Status = tagCaptureStatus_NoOutput;
+                return;
+            }
+
+            if( isCanceled( pControl ) )
+            {
+                Outcomes[ i ].Status = tagCaptureStatus_Canceled;
+                return;
+            }
+
+            Outcomes[ i ] = captureOne( Covered.at( i ), boundedRequest( Request, pControl ), nullptr, &Slices[ i ],
+                                        Parts[ i ].translated( -Covered.at( i ).Bounds.topLeft() ) );
+            if( Outcomes[ i ].Status != tagCaptureStatus_Ok )
+                Slices[ i ].fill( Qt::transparent );
+            if( pControl != nullptr && pControl->OutputDone )
+                pControl->OutputDone();
+        } );
+
+        std::lock_guard< std::mutex > Lock( m_lock );
+        for( const auto& Outcome : Outcomes )
+            recordLocked( Outcome );
+
+        // every output failed : a fully transparent image is not a capture
+        if( summarize( Outcomes, pRetStatus ) == 0 )
+            return QImage();
+
+        return Canvas.Image();
+    }
+
+    QFuture< tagCaptureResult > CCaptureService::CaptureOutputsAsync( const QVector< int >& OutputIdxs, const tagCaptureRequest& Request, int DeadlineMs )
+    {
+        return startAsync( DeadlineMs, [this, OutputIdxs, Request]( const tagCaptureControl& Control ) {
+            tagCaptureResult Result;
+            tagCaptureStatus Status = tagCaptureStatus_Failed;
+            const int Captured = CaptureOutputs( OutputIdxs, Request, &Result.Images, &Control, &Status );
+            Result.Status = asyncStatusOf( Captured > 0, Status );
+            return Result;
+        } );
+    }
+
+    QFuture< tagCaptureResult > CCaptureService::CaptureAllAsync( const tagCaptureRequest& Request, int DeadlineMs )
+    {
+        return startAsync( DeadlineMs, [this, Request]( const tagCaptureControl& Control ) {
+            tagCaptureResult Result;
+            tagCaptureStatus Status = tagCaptureStatus_Failed;
+            Result.Image = CaptureAll( Request, &Control, &Status );
+            Result.Status = asyncStatusOf( Result.Image.isNull() == false, Status );
+            return Result;
+        } );
+    }
+
+    QFuture< tagCaptureResult > CCaptureService::CaptureRegionAsync( const QRect& Region, const tagCaptureRequest& Request, int DeadlineMs )
+    {
+        return startAsync( DeadlineMs, [this, Region, Request]( const tagCaptureControl& Control ) {
+            tagCaptureResult Result;
+            tagCaptureStatus Status = tagCaptureStatus_Failed;
+            Result.Image = CaptureRegion( Region, Request, &Control, &Status );
+            Result.Status = asyncStatusOf( Result.Image.isNull() == false, Status );
+            return Result;
+        } );
+    }
+
+    tagCaptureServiceStats CCaptureService::Stats() const
+    {
+        tagCaptureServiceStats Stat;
+        std::vector< std::shared_ptr< tagSessionSlot > > Slots;
+        {
+            std::lock_guard< std::mutex > Lock( m_lock );
+            Stat = m_stats;
+            for( const auto& Item : m_sessions )
+                Slots.push_back( Item.second );
+        }
+
+        for( const auto& Slot : Slots )
+        {
+            std::lock_guard< std::mutex > SlotLock( Slot->Lock );
+            if( Slot->Session )
+                Stat.Cache += Slot->Session->CacheStats();
+        }
+
+        return Stat;
+    }
+
+    QString CCaptureService::FormatStats() const
+    {
+        const auto Stat = Stats();
+        return QString( "cold: n=%1 avg=%2us min=%3us max=%4us | warm: n=%5 avg=%6us min=%7us max=%8us | sessions=%9 topology=%10" )
+            .arg( Stat.Cold.Count ).arg( Stat.Cold.AverageUs() ).arg( Stat.Cold.MinUs ).arg( Stat.Cold.MaxUs )
+            .arg( Stat.Warm.Count ).arg( Stat.Warm.AverageUs() ).arg( Stat.Warm.MinUs ).arg( Stat.Warm.MaxUs )
+            .arg( Stat.SessionsBuilt ).arg( Stat.TopologyChanges )
+            + QString( " idle=%1" ).arg( Stat.IdleReleases )
+            + QString( " | frames: fresh=%1 cached=%2 timeout=%3" )
+            .arg( Stat.FreshFrames ).arg( Stat.CachedFrames ).arg( Stat.Timeouts )
+            + QString( " | cache: hit=%1 miss=%2 full=%3 partial=%4 copied=%5 moved=%6 fullcost=%7" )
+            .arg( Stat.Cache.Hits ).arg( Stat.Cache.Misses )
+            .arg( Stat.Cache.FullRefreshes ).arg( Stat.Cache.PartialRefreshes )
+            .arg( Stat.Cache.BytesCopied ).arg( Stat.Cache.BytesMoved ).arg( Stat.Cache.FullFrameBytes )
+            + QString( " | output: direct=%1 rendered=%2 copied=%3" )
+            .arg( Stat.Cache.DirectFrames ).arg( Stat.Cache.RenderedFrames ).arg( Stat.Cache.OutputBytes );
+    }
+
+    bool CCaptureService::refreshLocked( bool IsForce )
+    {
+        if( !m_backend )
+            return false;
+
+        if( !IsForce && !m_isTopologyDirty && m_backend->IsTopologyCurrent() )
+            return true;
+
+        QVector< tagOutputInfo > Outputs;
+        if( m_backend->EnumerateOutputs( &Outputs ) == false )
+            return false;
+
+        // keep sessions whose output is unchanged, everything else is rebuilt lazily on next capture
+        for( auto it = m_sessions.begin(); it != m_sessions.end(); )
+        {
+            const auto Found = std::find( Outputs.cbegin(), Outputs.cend(), it->second->Output );
+
+            if( Found == Outputs.cend() )
+                it = m_sessions.erase( it );
+            else
+                ++it;
+        }
+
+        if( m_outputs != Outputs )
+            ++m_stats.TopologyChanges;
+
+        m_outputs = Outputs;
+        m_isTopologyDirty = false;
+        return true;
+    }
+
+    std::shared_ptr< CCaptureService::tagSessionSlot > CCaptureService::slotLocked( const tagOutputInfo& Output )
+    {
+        m_lastUseTick = Clock::now();
+
+        auto it = m_sessions.find( Output.Idx );
+        if( it != m_sessions.end() && it->second->Output == Output )
+            return it->second;
+
+        auto Slot = std::make_shared< tagSessionSlot >( Output );
+        m_sessions[ Output.Idx ] = Slot;
+
+        // the refresh worker sleeps while there is no session
+        m_refreshWake.notify_all();
+        return Slot;
+    }
+
+    CCaptureService::tagCaptureOutcome CCaptureService::captureOne( const tagOutputInfo& Output, const tagCaptureRequest& Request, QImage* pRetImage, QImage* pTarget, const QRect& Rect )
+    {
+        const auto StartTick = Clock::now();
+        CTraceSpan Span( tagTraceStage_Capture );
+        tagCaptureOutcome Outcome;
+
+        // a lost session is rebuilt once, a second failure is reported to the caller
+        for( int Retry = 0; Retry < 2; ++Retry )
+        {
+            std::shared_ptr< tagSessionSlot > Slot;
+            {
+                std::lock_guard< std::mutex > Lock( m_lock );
+                Slot = slotLocked( Output );
+            }
+
+            std::lock_guard< std::mutex > SlotLock( Slot->Lock );
+
+            // session creation ( device, duplication ) runs outside the service lock
+            if( !Slot->Session )
+            {
+                Slot->Session = m_backend->OpenSession( Output );
+                if( !Slot->Session )
+                {
+                    Outcome.Status = tagCaptureStatus_Failed;
+                    break;
+                }
+
+                Outcome.IsCold = true;
+                std::lock_guard< std::mutex > Lock( m_lock );
+                ++m_stats.SessionsBuilt;
+            }
+
+            if( pTarget != nullptr && Rect.isValid() )
+                Outcome.Status = Slot->Session->CaptureRect( Request, Rect, pTarget, &Outcome.Reason );
+            else if( pTarget != nullptr )
+                Outcome.Status = Slot->Session->CaptureInto( Request, pTarget, &Outcome.Reason );
+            else
+                Outcome.Status = Slot->Session->Capture( Request, pRetImage, &Outcome.Reason );
+
+            if( Outcome.Status != tagCaptureStatus_AccessLost )
+                break;
+
+            Slot->Session.reset();
+
+            std::lock_guard< std::mutex > Lock( m_lock );
+            auto it = m_sessions.find( Output.Idx );
+            if( it != m_sessions.end() && it->second == Slot )
+                m_sessions.erase( it );
+            m_isTopologyDirty = true;
+        }
+
+        Outcome.ElapsedUs = ( quint64 )std::chrono::duration_cast< std::chrono::microseconds >( Clock::now() - StartTick ).count();
+        return Outcome;
+    }
+
+    void CCaptureService::recordLocked( const tagCaptureOutcome& Outcome )
+    {
+        if( Outcome.Reason == tagFrameReason_Fresh )
+            ++m_stats.FreshFrames;
+        else if( Outcome.Reason == tagFrameReason_Cached )
+            ++m_stats.CachedFrames;
+        else if( Outcome.Reason == tagFrameReason_Timeout )
+            ++m_stats.Timeouts;
+
+        if( Outcome.Status == tagCaptureStatus_Ok )
+            ( Outcome.IsCold ? m_stats.Cold : m_stats.Warm ).Add( Outcome.ElapsedUs );
+    }
+
+    int CCaptureService::summarize( const std::vector< tagCaptureOutcome >& Outcomes, tagCaptureStatus* pRetStatus )
+    {
+        int Captured = 0;
+        tagCaptureStatus Status = tagCaptureStatus_Ok;
+        for( const auto& Outcome : Outcomes )
+        {
+            if( Outcome.Status == tagCaptureStatus_Ok )
+                ++Captured;
+            else if( Outcome.Status == tagCaptureStatus_NoOutput )
+                continue;
+            else if( Outcome.Status == tagCaptureStatus_Canceled || Status == tagCaptureStatus_Ok )
+                Status = Outcome.Status;
+            else if( Outcome.Status == tagCaptureStatus_Timeout && Status != tagCaptureStatus_Canceled )
+                Status = tagCaptureStatus_Timeout;
+        }
+
+        // nothing took part
+        if( Captured == 0 && Status == tagCaptureStatus_Ok )
+            Status = tagCaptureStatus_NoOutput;
+
+        if( pRetStatus != nullptr )
+            *pRetStatus = Status;
+        return Captured;
+    }
+
+    QFuture< tagCaptureResult > CCaptureService::startAsync( int DeadlineMs, AsyncWorkFn Work )
+    {
+        auto Promise = std::make_shared< QPromise< tagCaptureResult > >();
+        QFuture< tagCaptureResult > Future = Promise->future();
+        Promise->start();
+
+        const auto Deadline = Clock::now() + std::chrono::milliseconds( qMax( 0, DeadlineMs ) );
+
+        m_asyncPool.start( [Promise, Deadline, DeadlineMs, Work = std::move( Work )]() {
+            std::atomic< int > Done( 0 );
+
+            // the deadline is only checked before an output starts, a started one runs to its ( capped ) TimeoutMs
+            tagCaptureControl Control;
+            Control.IsCanceled = [&]() {
+                return ( DeadlineMs > 0 && Clock::now() >= Deadline ) || Promise->isCanceled();
+            };
+            Control.RemainingMs = [&]() {
+                if( DeadlineMs <= 0 )
+                    return -1;
+                return ( int )qMax< qint64 >( 0, std::chrono::duration_cast< std::chrono::milliseconds >( Deadline - Clock::now() ).count() );
+            };
+            Control.OutputsPlanned = [&]( int Count ) {
+                Promise->setProgressRange( 0, Count );
+            };
+            // QPromise ignores progress values below the current one, out of order reports are harmless
+            Control.OutputDone = [&]() {
+                Promise->setProgressValue( Done.fetch_add( 1 ) + 1 );
+            };
+
+            tagCaptureResult Result;
+            Result.Status = tagCaptureStatus_Canceled;
+            if( Control.IsCanceled() == false )
+                Result = Work( Control );
+
+            // outputs that finished are kept, only the caller's cancel drops them; skipped outputs report Canceled,
+            // without a cancel they were skipped for the deadline
+            if( Promise->isCanceled() )
+                Result = tagCaptureResult{ tagCaptureStatus_Canceled, QImage(), QVector< QImage >() };
+            else if( Result.Status == tagCaptureStatus_Canceled )
+                Result.Status = tagCaptureStatus_Timeout;
+
+            // a canceled promise drops the result, the future then has none
+            Promise->addResult( std::move( Result ) );
+            Promise->finish();
+        } );
+
+        return Future;
+    }
+
+    bool CCaptureService::isCanceled( const tagCaptureControl* pControl )
+    {
+        return pControl != nullptr && pControl->IsCanceled && pControl->IsCanceled();
+    }
+
+    tagCaptureRequest CCaptureService::boundedRequest( const tagCaptureRequest& Request, const tagCaptureControl* pControl )
+    {
+        if( pControl == nullptr || !pControl->RemainingMs )
+            return Request;
+
+        const int RemainingMs = pControl->RemainingMs();
+        if( RemainingMs < 0 )
+            return Request;
+
+        tagCaptureRequest Bounded = Request;
+        Bounded.TimeoutMs = qMin( Request.TimeoutMs, RemainingMs );
+        return Bounded;
+    }
+
+    void CCaptureService::runParallel( int Count, const std::function< void( int ) >& Fn )
+    {
+        if( Count <= 0 )
+            return;
+
+        std::vector< std::thread > Workers;
+        Workers.reserve( ( size_t )Count - 1 );
+
+        for( int i = 1; i < Count; ++i )
+            Workers.emplace_back( Fn, i );
+
+        Fn( 0 );
+
+        // completion barrier
+        for( auto& Worker : Workers )
+            Worker.join();
+    }
+
+    void CCaptureService::stopRefreshThread()
+    {
+        {
+            std::lock_guard< std::mutex > Lock( m_lock );
+            m_isRefreshStopping = true;
+        }
+        m_refreshWake.notify_all();
+
+        if( m_refreshThread.joinable() )
+            m_refreshThread.join();
+    }
+
+    void CCaptureService::refreshThreadProc()
+    {
+        std::unique_lock< std::mutex > Lock( m_lock );
+
+        while( true )
+        {
+            // nothing to keep warm : no periodic wake-ups until a session opens
+            if( m_sessions.empty() )
+                m_refreshWake.wait( Lock, [this]() { return m_isRefreshStopping || !m_sessions.empty(); } );
+            else
+                m_refreshWake.wait_for( Lock, std::chrono::milliseconds( m_refreshIntervalMs ), [this]() { return m_isRefreshStopping; } );
+
+            if( m_isRefreshStopping )
+                break;
+
+            if( m_sessions.empty() )
+                continue;
+
+            if( m_idleReleaseMs > 0 && Clock::now() - m_lastUseTick >= std::chrono::milliseconds( m_idleReleaseMs ) )
+            {
+                // same as Release(), sessions still held by a capture go away with it
+                m_sessions.clear();
+                m_isTopologyDirty = true;
+                ++m_stats.IdleReleases;
+                continue;
+            }
+
+            std::vector< std::shared_ptr< tagSessionSlot > > Slots;
+            for( const auto& Item : m_sessions )
+                Slots.push_back( Item.second );
+
+            // slot locks are never taken under the service lock
+            Lock.unlock();
+
+            for( const auto& Slot : Slots )
+            {
+                std::lock_guard< std::mutex > SlotLock( Slot->Lock );
+                if( !Slot->Session )
+                    continue;
+
+                // only warm sessions are kept current, a zero timeout never blocks captures behind the refresh
+                if( Slot->Session->Refresh( 0 ) != tagCaptureStatus_AccessLost )
+                    continue;
+
+                Slot->Session.reset();
+
+                std::lock_guard< std::mutex > ServiceLock( m_lock );
+                auto it = m_sessions.find( Slot->Output.Idx );
+                if( it != m_sessions.end() && it->second == Slot )
+                    m_sessions.erase( it );
+                m_isTopologyDirty = true;
+            }
+
+            Lock.lock();
+        }
+    }
+
+} // nsCapture
@@ -0,0 +1,255 @@
+#ifndef CAPTURESERVICE_HPP
+#define CAPTURESERVICE_HPP
+
+#include <QtCore>
+#include <QtGui>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "captureTrace.hpp"
+#include "desktopCanvas.hpp"
+#include "frameAcquirer.hpp"
+#include "frameCache.hpp"
+
+namespace nsCapture
+{
+    // enum tagCaptureStatus_e
+    typedef enum tagCaptureStatus_e : quint32
+    {
+        tagCaptureStatus_Ok             = 0x0,
+        tagCaptureStatus_Timeout        = 0x1,
+        tagCaptureStatus_AccessLost     = 0x2,      // session must be rebuilt ( mode change, desktop switch, ... )
+        tagCaptureStatus_NoOutput       = 0x3,
+        tagCaptureStatus_Failed         = 0x4,
+        tagCaptureStatus_Canceled       = 0x5,      // asynchronous capture canceled by the caller
+    } tagCaptureStatus;
+
+    // struct tagOutputInfo_s
+    typedef struct tagOutputInfo_s
+    {
+        int                     Idx             = -1;
+        QString                 Name;
+        QRect                   Bounds;             // virtual desktop coordinates, physical pixels
+        int                     RotationDegrees = 0;
+        quintptr                Handle          = 0;    // HMONITOR on Windows, 0 for synthetic outputs
+    } tagOutputInfo;
+
+    bool operator==( const tagOutputInfo& Lhs, const tagOutputInfo& Rhs );
+    inline bool operator!=( const tagOutputInfo& Lhs, const tagOutputInfo& Rhs ) { return !( Lhs == Rhs ); }
+
+    // struct tagCaptureRequest_s
+    typedef struct tagCaptureRequest_s
+    {
+        bool                    IncludeCursor   = false;
+        int                     TimeoutMs       = 500;      // deadline for a new desktop present, the last frame is reused after it
+        int                     MaxStalenessMs  = 0;        // a cached frame checked within this bound is returned as is, 0 = always check
+    } tagCaptureRequest;
+
+    // struct tagCaptureControl_s : hooks of an asynchronous capture, polled before each output starts ( a started output waits
+    // at most the smaller of its TimeoutMs and RemainingMs )
+    typedef struct tagCaptureControl_s
+    {
+        std::function< bool() >         IsCanceled;
+        std::function< int() >          RemainingMs;        // time left before the deadline, -1 = none
+        std::function< void( int ) >    OutputsPlanned;     // number of outputs taking part, before the first starts
+        std::function< void() >         OutputDone;         // called from the capture workers
+    } tagCaptureControl;
+
+    // struct tagCaptureResult_s : result of an asynchronous capture
+    typedef struct tagCaptureResult_s
+    {
+        tagCaptureStatus        Status          = tagCaptureStatus_Failed;
+        QImage                  Image;              // CaptureAllAsync, CaptureRegionAsync
+        QVector< QImage >       Images;             // CaptureOutputsAsync, one per requested index ( null on failure )
+    } tagCaptureResult;
+
+    // struct tagLatencyStats_s
+    typedef struct tagLatencyStats_s
+    {
+        quint64                 Count           = 0;
+        quint64                 TotalUs         = 0;
+        quint64                 MinUs           = 0;
+        quint64                 MaxUs           = 0;
+        quint64                 LastUs          = 0;
+
+        void                    Add( quint64 Us );
+        quint64                 AverageUs() const { return Count == 0 ? 0 : TotalUs / Count; }
+    } tagLatencyStats;
+
+    // struct tagCaptureServiceStats_s
+    typedef struct tagCaptureServiceStats_s
+    {
+        tagLatencyStats         Cold;           // capture that had to create or rebuild its session
+        tagLatencyStats         Warm;           // capture served by an already open session
+        quint64                 SessionsBuilt   = 0;
+        quint64                 TopologyChanges = 0;
+        quint64                 FreshFrames     = 0;
+        quint64                 CachedFrames    = 0;
+        quint64                 Timeouts        = 0;
+        quint64                 IdleReleases    = 0;
+        tagFrameCacheStats      Cache;          // sum over the open sessions
+    } tagCaptureServiceStats;
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// Backend interfaces
+    ///
+
+    // One open capture pipeline for a single output. Owns every resource that depends on the output mode.
+    // Calls on one session are serialized by the service, different sessions run concurrently.
+    class ICaptureSession
+    {
+    public:
+        virtual ~ICaptureSession() = default;
+
+        virtual const tagOutputInfo&    Output() const = 0;
+        virtual tagCaptureStatus        Capture( const tagCaptureRequest& Request, QImage* pRetImage, tagFrameReason* pRetReason ) = 0;
+        // write the frame straight into pTarget ( a canvas slice ), default goes through Capture
+        virtual tagCaptureStatus        CaptureInto( const tagCaptureRequest& Request, QImage* pTarget, tagFrameReason* pRetReason );
+        // only Rect ( output coordinates, inside the output ) into pTarget of the same size, default cuts it from Capture
+        virtual tagCaptureStatus        CaptureRect( const tagCaptureRequest& Request, const QRect& Rect, QImage* pTarget, tagFrameReason* pRetReason );
+        // pull a newer present into the frame cache without producing an image
+        virtual tagCaptureStatus        Refresh( int TimeoutMs ) = 0;
+        virtual tagFrameCacheStats      CacheStats() const = 0;
+    };
+
+    class ICaptureBackend
+    {
+    public:
+        virtual ~ICaptureBackend() = default;
+
+        virtual QString                 Name() const = 0;
+        // false when the adapter / output topology changed since the last EnumerateOutputs
+        virtual bool                    IsTopologyCurrent() = 0;
+        virtual bool                    EnumerateOutputs( QVector< tagOutputInfo >* pRetOutputs ) = 0;
+        // may be called from several capture workers at once
+        virtual std::unique_ptr< ICaptureSession > OpenSession( const tagOutputInfo& Output ) = 0;
+    };
+
+    // DXGI backend on Windows, synthetic frame source elsewhere
+    std::unique_ptr< ICaptureBackend >  CreateDefaultBackend();
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// CCaptureService
+    ///
+    /// Long-lived owner of the per-output capture sessions. Sessions stay warm between captures and are
+    /// rebuilt only when the backend reports a topology change or a session loses access to its output.
+    /// Every output is captured on its own worker; the service lock only guards the session table and
+    /// the counters, each session has its own lock.
+
+    class CCaptureService
+    {
+    public:
+        explicit CCaptureService( std::unique_ptr< ICaptureBackend > Backend );
+        ~CCaptureService();
+
+        QString                         BackendName() const;
+
+        // re-enumerate outputs when the topology changed; sessions of unchanged outputs are kept
+        bool                            Refresh( bool IsForce = false );
+        // drop every open session, the next capture is cold
+        void                            Release();
+        // mark the topology dirty ( QGuiApplication screen notifications )
+        void                            Invalidate();
+        // keep the frame cache of every open session current from a worker thread, 0 = off
+        void                            SetBackgroundRefresh( int IntervalMs );
+        // drop every session ( GPU resources ) after IdleMs without a capture, 0 = never; checked by the background refresh
+        void                            SetIdleRelease( int IdleMs );
+        // open a session for every output and fill its frame cache, returns the number of warm outputs
+        int                             Prepare( int TimeoutMs );
+
+        QVector< tagOutputInfo >        Outputs();
+        QRect                           VirtualBounds();
+
+        tagCaptureStatus                CaptureOutput( int OutputIdx, const tagCaptureRequest& Request, QImage* pRetImage, tagFrameReason* pRetReason = nullptr );
+        // pRetStatus of the multi output captures : Ok when every output taking part was captured, otherwise Canceled,
+        // Timeout or the first other failure, in that order ( indexes without an output do not take part )
+
+        // capture the given outputs concurrently, pRetImages gets one entry per index ( null on failure ), returns the number captured
+        int                             CaptureOutputs( const QVector< int >& OutputIdxs, const tagCaptureRequest& Request, QVector< QImage >* pRetImages,
+                                                        const tagCaptureControl* pControl = nullptr, tagCaptureStatus* pRetStatus = nullptr );
+        // every output concurrently, composed into one virtual desktop image; failed outputs stay transparent, null when none was captured
+        QImage                          CaptureAll( const tagCaptureRequest& Request, const tagCaptureControl* pControl = nullptr, tagCaptureStatus* pRetStatus = nullptr );
+        // Region of the virtual desktop ( physical pixels ), every output under it reads only its part; outside the outputs stays transparent,
+        // null when no output under it was captured
+        QImage                          CaptureRegion( const QRect& Region, const tagCaptureRequest& Request, const tagCaptureControl* pControl = nullptr,
+                                                       tagCaptureStatus* pRetStatus = nullptr );
+
+        // the same on the service worker pool, the calling thread never blocks. The future is cancellable
+        // ( tagCaptureStatus_Canceled, or no result when canceled before it finished ), progress counts finished outputs;
+        // outputs not started within DeadlineMs ( 0 = none ) are skipped, a started one waits at most until the deadline and
+        // is kept. The result is Ok when at least one output was captured, otherwise Timeout ( skipped or no present ) or Failed
+        QFuture< tagCaptureResult >     CaptureOutputsAsync( const QVector< int >& OutputIdxs, const tagCaptureRequest& Request, int DeadlineMs = 0 );
+        QFuture< tagCaptureResult >     CaptureAllAsync( const tagCaptureRequest& Request, int DeadlineMs = 0 );
+        QFuture< tagCaptureResult >     CaptureRegionAsync( const QRect& Region, const tagCaptureRequest& Request, int DeadlineMs = 0 );
+
+        tagCaptureServiceStats          Stats() const;
+        QString                         FormatStats() const;
+
+    private:
+        typedef std::chrono::steady_clock   Clock;
+
+        // struct tagSessionSlot_s : one output, Lock serializes every call on Session
+        typedef struct tagSessionSlot_s
+        {
+            explicit tagSessionSlot_s( const tagOutputInfo& Info ) : Output( Info ) {}
+
+            const tagOutputInfo                 Output;
+            std::mutex                          Lock;
+            std::unique_ptr< ICaptureSession >  Session;
+        } tagSessionSlot;
+
+        // struct tagCaptureOutcome_s
+        typedef struct tagCaptureOutcome_s
+        {
+            tagCaptureStatus            Status          = tagCaptureStatus_Failed;
+            tagFrameReason              Reason          = tagFrameReason_None;
+            bool                        IsCold          = false;
+            quint64                     ElapsedUs       = 0;
+        } tagCaptureOutcome;
+
+        // lock order: a slot lock may take m_lock, never the other way round
+        bool                            refreshLocked( bool IsForce );
+        std::shared_ptr< tagSessionSlot >   slotLocked( const tagOutputInfo& Output );
+        // m_lock must not be held, exactly one of pRetImage / pTarget is set; a valid Rect ( output coordinates ) reads only that part into pTarget
+        tagCaptureOutcome               captureOne( const tagOutputInfo& Output, const tagCaptureRequest& Request, QImage* pRetImage, QImage* pTarget, const QRect& Rect = QRect() );
+        void                            recordLocked( const tagCaptureOutcome& Outcome );
+        // pRetStatus of the multi output captures, returns the number of outputs captured
+        static int                      summarize( const std::vector< tagCaptureOutcome >& Outcomes, tagCaptureStatus* pRetStatus );
+        // Work runs on m_asyncPool with the control of the returned future
+        typedef std::function< tagCaptureResult( const tagCaptureControl& Control ) >  AsyncWorkFn;
+        QFuture< tagCaptureResult >     startAsync( int DeadlineMs, AsyncWorkFn Work );
+        static bool                     isCanceled( const tagCaptureControl* pControl );
+        // Request with its TimeoutMs capped by the time left before the deadline of pControl
+        static tagCaptureRequest        boundedRequest( const tagCaptureRequest& Request, const tagCaptureControl* pControl );
+        // Fn( i ) for i in [0, Count), Count - 1 workers plus the calling thread, returns after all finished
+        static void                     runParallel( int Count, const std::function< void( int ) >& Fn );
+        void                            stopRefreshThread();
+        void                            refreshThreadProc();
+
+        mutable std::mutex              m_lock;
+        std::unique_ptr< ICaptureBackend >  m_backend;
+        QVector< tagOutputInfo >        m_outputs;
+        std::map< int, std::shared_ptr< tagSessionSlot > > m_sessions;
+        bool                            m_isTopologyDirty;
+        tagCaptureServiceStats          m_stats;
+
+        std::condition_variable         m_refreshWake;
+        std::thread                     m_refreshThread;
+        int                             m_refreshIntervalMs;
+        bool                            m_isRefreshStopping;
+        int                             m_idleReleaseMs;
+        Clock::time_point               m_lastUseTick;
+
+        QThreadPool                     m_asyncPool;
+    };
+
+} // nsCapture
+
+#endif //CAPTURESERVICE_HPP
@@ -0,0 +1,240 @@
+#include "captureTrace.hpp"
+
+namespace nsCapture
+{
+    const char* TraceStageToString( tagTraceStage Stage )
+    {
+        switch( Stage )
+        {
+            case tagTraceStage_Capture:     return "capture";
+            case tagTraceStage_Acquire:     return "acquire";
+            case tagTraceStage_GpuCopy:     return "gpu_copy";
+            case tagTraceStage_Map:         return "map";
+            case tagTraceStage_Cursor:      return "cursor";
+            case tagTraceStage_Render:      return "render";
+            case tagTraceStage_Compose:     return "compose";
+            case tagTraceStage_Pixmap:      return "pixmap";
+            case tagTraceStage_Encode:      return "encode";
+            case tagTraceStage_Clipboard:   return "clipboard";
+            case tagTraceStage_Overlay:     return "overlay";
+            case tagTraceStage_Preview:     return "preview";
+            case tagTraceStage_OverlayRepaint:  return "overlay_repaint";
+            default:                        return "unknown";
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// class CCaptureTrace
+    //
+
+    std::atomic< bool > CCaptureTrace::s_isEnabled( false );
+
+    CCaptureTrace& CCaptureTrace::Instance()
+    {
+        static CCaptureTrace Trace;
+        return Trace;
+    }
+
+    CCaptureTrace::CCaptureTrace()
+        : m_origin( Clock::now() ), m_isRecordingEvents( false )
+    {
+        Reset();
+
+        const QString Config = qEnvironmentVariable( "SNIPPINGTOOL_TRACE" ).trimmed();
+        if( Config.isEmpty() || Config == QLatin1String( "0" ) )
+            return;
+
+        if( Config != QLatin1String( "1" ) )
+            SetTraceFile( Config );
+        SetEnabled( true );
+    }
+
+    void CCaptureTrace::SetEnabled( bool IsEnabled )
+    {
+        s_isEnabled.store( IsEnabled, std::memory_order_relaxed );
+    }
+
+    void CCaptureTrace::SetTraceFile( const QString& FilePath )
+    {
+        std::lock_guard< std::mutex > Lock( m_lock );
+        m_traceFile = FilePath;
+        m_isRecordingEvents.store( FilePath.isEmpty() == false, std::memory_order_relaxed );
+    }
+
+    QString CCaptureTrace::TraceFile() const
+    {
+        std::lock_guard< std::mutex > Lock( m_lock );
+        return m_traceFile;
+    }
+
+    void CCaptureTrace::Record( tagTraceStage Stage, Clock::time_point Begin, Clock::time_point End )
+    {
+        if( Stage >= tagTraceStage_Count )
+            return;
+
+        const qint64 Us = qMax< qint64 >( 0, std::chrono::duration_cast< std::chrono::microseconds >( End - Begin ).count() );
+        auto& Histogram = m_stages[ Stage ];
+
+        Histogram.Count.fetch_add( 1, std::memory_order_relaxed );
+        Histogram.TotalUs.fetch_add( ( quint64 )Us, std::memory_order_relaxed );
+        Histogram.Buckets[ bucketOf( ( quint64 )Us ) ].fetch_add( 1, std::memory_order_relaxed );
+
+        quint64 Max = Histogram.MaxUs.load( std::memory_order_relaxed );
+        while( ( quint64 )Us > Max && !Histogram.MaxUs.compare_exchange_weak( Max, ( quint64 )Us, std::memory_order_relaxed ) )
+            ;
+
+        if( !m_isRecordingEvents.load( std::memory_order_relaxed ) )
+            return;
+
+        // small per-thread ids keep the trace viewer rows readable
+        static std::atomic< quint32 > s_nextThreadId( 1 );
+        thread_local const quint32 ThreadId = s_nextThreadId.fetch_add( 1, std::memory_order_relaxed );
+
+        tagTraceEvent Event;
+        Event.Stage         = Stage;
+        Event.ThreadId      = ThreadId;
+        Event.BeginUs       = std::chrono::duration_cast< std::chrono::microseconds >( Begin - m_origin ).count();
+        Event.DurationUs    = Us;
+
+        std::lock_guard< std::mutex > Lock( m_lock );
+        if( m_events.size() < MAX_EVENTS )
+            m_events.push_back( Event );
+    }
+
+    void CCaptureTrace::Reset()
+    {
+        for( auto& Histogram : m_stages )
+        {
+            Histogram.Count.store( 0, std::memory_order_relaxed );
+            Histogram.TotalUs.store( 0, std::memory_order_relaxed );
+            Histogram.MaxUs.store( 0, std::memory_order_relaxed );
+            for( auto& Bucket : Histogram.Buckets )
+                Bucket.store( 0, std::memory_order_relaxed );
+        }
+
+        std::lock_guard< std::mutex > Lock( m_lock );
+        m_events.clear();
+    }
+
+    tagStageLatency CCaptureTrace::Latency( tagTraceStage Stage ) const
+    {
+        tagStageLatency Latency;
+        if( Stage >= tagTraceStage_Count )
+            return Latency;
+
+        const auto& Histogram = m_stages[ Stage ];
+
+        // concurrent Records may land between the loads, the snapshot is approximate by at most those samples
+        std::array< quint64, BUCKET_COUNT > Buckets;
+        quint64 Count = 0;
+        for( size_t idx = 0; idx < Buckets.size(); ++idx )
+        {
+            Buckets[ idx ] = Histogram.Buckets[ idx ].load( std::memory_order_relaxed );
+            Count += Buckets[ idx ];
+        }
+
+        Latency.Count   = Count;
+        Latency.TotalUs = Histogram.TotalUs.load( std::memory_order_relaxed );
+        Latency.MaxUs   = Histogram.MaxUs.load( std::memory_order_relaxed );
+        if( Count == 0 )
+            return Latency;
+
+        const auto percentile = [&]( quint64 Permille ) {
+            const quint64 Rank = qMax< quint64 >( 1, ( Count * Permille + 999 ) / 1000 );
+            quint64 Seen = 0;
+            for( size_t idx = 0; idx < Buckets.size(); ++idx )
+            {
+                Seen += Buckets[ idx ];
+                if( Seen >= Rank )
+                    return qMin( bucketUpperUs( idx ), Latency.MaxUs );
+            }
+            return Latency.MaxUs;
+        };
+
+        Latency.P50Us = percentile( 500 );
+        Latency.P99Us = percentile( 990 );
+        return Latency;
+    }
+
+    QString CCaptureTrace::FormatStats() const
+    {
+        QStringList Lines;
+        for( quint32 Stage = 0; Stage < tagTraceStage_Count; ++Stage )
+        {
+            const auto Stat = Latency( ( tagTraceStage )Stage );
+            if( Stat.Count == 0 )
+                continue;
+
+            Lines.push_back( QString( "%1: n=%2 avg=%3us p50=%4us p99=%5us max=%6us" )
+                             .arg( TraceStageToString( ( tagTraceStage )Stage ), -9 )
+                             .arg( Stat.Count ).arg( Stat.TotalUs / Stat.Count )
+                             .arg( Stat.P50Us ).arg( Stat.P99Us ).arg( Stat.MaxUs ) );
+        }
+
+        return Lines.join( '\n' );
+    }
+
+    bool CCaptureTrace::WriteChromeTrace( const QString& FilePath ) const
+    {
+        std::vector< tagTraceEvent > Events;
+        {
+            std::lock_guard< std::mutex > Lock( m_lock );
+            Events = m_events;
+        }
+
+        QFile File( FilePath );
+        if( File.open( QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text ) == false )
+            return false;
+
+        // complete events ( ph X ), timestamps in microseconds since the trace was created
+        QTextStream Out( &File );
+        Out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        for( size_t idx = 0; idx < Events.size(); ++idx )
+        {
+            const auto& Event = Events[ idx ];
+            Out << ( idx == 0 ? "\n" : ",\n" )
+                << "{\"name\":\"" << TraceStageToString( Event.Stage ) << "\",\"cat\":\"capture\",\"ph\":\"X\""
+                << ",\"ts\":" << Event.BeginUs << ",\"dur\":" << Event.DurationUs
+                << ",\"pid\":" << QCoreApplication::applicationPid() << ",\"tid\":" << Event.ThreadId << "}";
+        }
+        Out << "\n]}\n";
+        Out.flush();
+
+        return File.error() == QFileDevice::NoError;
+    }
+
+    bool CCaptureTrace::Flush() const
+    {
+        const QString FilePath = TraceFile();
+        if( FilePath.isEmpty() )
+            return true;
+
+        return WriteChromeTrace( FilePath );
+    }
+
+    size_t CCaptureTrace::bucketOf( quint64 Us )
+    {
+        if( Us < SUB_BUCKETS )
+            return ( size_t )Us;
+
+        int Exponent = 63;
+        while( ( Us >> Exponent ) == 0 )
+            --Exponent;
+
+        // Exponent >= 4 : the 4 bits below the leading one pick the sub-bucket
+        const size_t Bucket = SUB_BUCKETS + ( size_t )( Exponent - 4 ) * SUB_BUCKETS + ( size_t )( ( Us >> ( Exponent - 4 ) ) & ( SUB_BUCKETS - 1 ) );
+        return qMin( Bucket, ( size_t )BUCKET_COUNT - 1 );
+    }
+
+    quint64 CCaptureTrace::bucketUpperUs( size_t Bucket )
+    {
+        if( Bucket < SUB_BUCKETS )
+            return ( quint64 )Bucket;
+
+        const size_t Exponent = 4 + ( Bucket - SUB_BUCKETS ) / SUB_BUCKETS;
+        const quint64 Sub = ( quint64 )( ( Bucket - SUB_BUCKETS ) % SUB_BUCKETS );
+        // values ( 16 + Sub ) << ( Exponent - 4 ) up to the next sub-bucket, exclusive
+        return ( ( ( quint64 )SUB_BUCKETS + Sub + 1 ) << ( Exponent - 4 ) ) - 1;
+    }
+
+} // nsCapture
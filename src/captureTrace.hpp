@@ -0,0 +1,153 @@
+#ifndef CAPTURETRACE_HPP
+#define CAPTURETRACE_HPP
+
+#include <QtCore>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace nsCapture
+{
+    // enum tagTraceStage_e : timed steps between the hotkey and the clipboard
+    typedef enum tagTraceStage_e : quint32
+    {
+        tagTraceStage_Capture           = 0x0,      // one output through the capture service, every stage below included
+        tagTraceStage_Acquire,                      // waiting on AcquireNextFrame
+        tagTraceStage_GpuCopy,                      // desktop texture -> staging / mirror texture
+        tagTraceStage_Map,                          // staging texture -> frame cache ( readback )
+        tagTraceStage_Cursor,                       // pointer composition on the CPU
+        tagTraceStage_Render,                       // rotation, resampling, D2D render and WIC / format conversion
+        tagTraceStage_Compose,                      // output frames into the virtual desktop canvas
+        tagTraceStage_Pixmap,                       // QImage -> QPixmap
+        tagTraceStage_Encode,                       // image file writer
+        tagTraceStage_Clipboard,
+        tagTraceStage_Overlay,                      // global hotkey -> first paint of the region overlay
+        tagTraceStage_Preview,                      // main window preview : pyramid build, one resized frame
+        tagTraceStage_OverlayRepaint,               // one region overlay paint while the selection moves
+        tagTraceStage_Count
+    } tagTraceStage;
+
+    const char*                         TraceStageToString( tagTraceStage Stage );
+
+    // struct tagStageLatency_s : percentiles are bucket upper bounds ( ~6% resolution ), clamped to MaxUs
+    typedef struct tagStageLatency_s
+    {
+        quint64                 Count           = 0;
+        quint64                 TotalUs         = 0;
+        quint64                 P50Us           = 0;
+        quint64                 P99Us           = 0;
+        quint64                 MaxUs           = 0;
+    } tagStageLatency;
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// CCaptureTrace
+    ///
+    /// Process wide span sink. Spans feed lock-free log-linear histograms per stage; with a trace file
+    /// they are also kept as Chrome trace_event records ( chrome://tracing, Perfetto ).
+    /// Configured from SNIPPINGTOOL_TRACE : unset or 0 = off, 1 = histograms only, anything else = trace file path.
+    /// While off a span costs one relaxed atomic load.
+
+    class CCaptureTrace
+    {
+    public:
+        typedef std::chrono::steady_clock   Clock;
+
+        static CCaptureTrace&           Instance();
+        static bool                     IsEnabled() { return s_isEnabled.load( std::memory_order_relaxed ); }
+
+        void                            SetEnabled( bool IsEnabled );
+        // empty = no event records
+        void                            SetTraceFile( const QString& FilePath );
+        QString                         TraceFile() const;
+
+        void                            Record( tagTraceStage Stage, Clock::time_point Begin, Clock::time_point End );
+        void                            Reset();
+
+        tagStageLatency                 Latency( tagTraceStage Stage ) const;
+        // one line per stage that has samples
+        QString                         FormatStats() const;
+        bool                            WriteChromeTrace( const QString& FilePath ) const;
+        // write the configured trace file, if any
+        bool                            Flush() const;
+
+    private:
+        CCaptureTrace();
+
+        // 16 linear buckets, then 16 per power of two up to 2^40 us
+        enum { SUB_BUCKETS = 16, BUCKET_COUNT = SUB_BUCKETS + ( 40 - 4 ) * SUB_BUCKETS };
+        // trace_event records kept in memory, later spans only go to the histograms
+        enum { MAX_EVENTS = 1 << 20 };
+
+        static size_t                   bucketOf( quint64 Us );
+        static quint64                  bucketUpperUs( size_t Bucket );
+
+        // struct tagStageHistogram_s
+        typedef struct tagStageHistogram_s
+        {
+            std::atomic< quint64 >      Count;
+            std::atomic< quint64 >      TotalUs;
+            std::atomic< quint64 >      MaxUs;
+            std::array< std::atomic< quint64 >, BUCKET_COUNT > Buckets;
+        } tagStageHistogram;
+
+        // struct tagTraceEvent_s
+        typedef struct tagTraceEvent_s
+        {
+            tagTraceStage               Stage;
+            quint32                     ThreadId;
+            qint64                      BeginUs;
+            qint64                      DurationUs;
+        } tagTraceEvent;
+
+        static std::atomic< bool >      s_isEnabled;
+
+        const Clock::time_point         m_origin;
+        std::array< tagStageHistogram, tagTraceStage_Count > m_stages;
+
+        mutable std::mutex              m_lock;
+        QString                         m_traceFile;
+        std::atomic< bool >             m_isRecordingEvents;
+        std::vector< tagTraceEvent >    m_events;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// CTraceSpan
+    ///
+    /// Times its scope ( or up to End ) into CCaptureTrace when tracing was on at construction.
+
+    class CTraceSpan
+    {
+    public:
+        explicit CTraceSpan( tagTraceStage Stage )
+            : m_stage( Stage ), m_isActive( CCaptureTrace::IsEnabled() )
+        {
+            if( m_isActive )
+                m_begin = CCaptureTrace::Clock::now();
+        }
+
+        ~CTraceSpan() { End(); }
+
+        void End()
+        {
+            if( !m_isActive )
+                return;
+
+            m_isActive = false;
+            CCaptureTrace::Instance().Record( m_stage, m_begin, CCaptureTrace::Clock::now() );
+        }
+
+        CTraceSpan( const CTraceSpan& ) = delete;
+        CTraceSpan& operator=( const CTraceSpan& ) = delete;
+
+    private:
+        tagTraceStage                   m_stage;
+        bool                            m_isActive;
+        CCaptureTrace::Clock::time_point m_begin;
+    };
+
+} // nsCapture
+
+#endif //CAPTURETRACE_HPP
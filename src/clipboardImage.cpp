@@ -0,0 +1,82 @@
+#include "clipboardImage.hpp"
+
+#include "captureTrace.hpp"
+#include "imageFile.hpp"
+
+namespace
+{
+    const QLatin1String                 MIME_QT_IMAGE( "application/x-qt-image" );
+    const QLatin1String                 MIME_PNG( "image/png" );
+    const QLatin1String                 MIME_BMP( "image/bmp" );
+    const QLatin1String                 MIME_RAW( "application/x-snippingtool-raw" );
+
+    QByteArray imageFormatOf( const QString& MimeType )
+    {
+        if( MimeType == MIME_PNG )
+            return "png";
+        if( MimeType == MIME_BMP )
+            return "bmp";
+        if( MimeType == MIME_RAW )
+            return "raw";
+        return QByteArray();
+    }
+}
+
+QClipboardImage::QClipboardImage( const QImage& Image )
+    : image( Image )
+{
+}
+
+QStringList QClipboardImage::formats() const
+{
+    if( image.isNull() )
+        return QStringList();
+
+    // 원본 이미지가 먼저, 붙여넣는 쪽은 앞의 형식을 우선
+    return QStringList{ MIME_QT_IMAGE, MIME_PNG, MIME_BMP, MIME_RAW };
+}
+
+bool QClipboardImage::hasFormat( const QString& MimeType ) const
+{
+    return image.isNull() == false && ( MimeType == MIME_QT_IMAGE || imageFormatOf( MimeType ).isEmpty() == false );
+}
+
+#if QT_VERSION >= QT_VERSION_CHECK( 6, 0, 0 )
+QVariant QClipboardImage::retrieveData( const QString& MimeType, QMetaType Type ) const
+#else
+QVariant QClipboardImage::retrieveData( const QString& MimeType, QVariant::Type Type ) const
+#endif
+{
+    Q_UNUSED( Type );
+
+    if( image.isNull() )
+        return QVariant();
+
+    if( MimeType == MIME_QT_IMAGE )
+        return QVariant::fromValue( image );
+
+    const QByteArray Bytes = encoded( MimeType );
+    return Bytes.isEmpty() ? QVariant() : QVariant( Bytes );
+}
+
+QByteArray QClipboardImage::encoded( const QString& MimeType ) const
+{
+    const QByteArray Format = imageFormatOf( MimeType );
+    if( Format.isEmpty() )
+        return QByteArray();
+
+    // 같은 형식을 동시에 두 번 인코딩하지 않도록 인코딩 동안 잠금 유지
+    QMutexLocker Guard( &lock );
+    const auto Found = cache.constFind( MimeType );
+    if( Found != cache.constEnd() )
+        return Found.value();
+
+    nsCapture::CTraceSpan ClipboardSpan( nsCapture::tagTraceStage_Clipboard );
+    QByteArray Bytes;
+    QBuffer Buffer( &Bytes );
+    if( Buffer.open( QIODevice::WriteOnly ) == false || nsCapture::WriteImage( &Buffer, image, Format, -1 ) == false )
+        return QByteArray();
+
+    cache.insert( MimeType, Bytes );
+    return Bytes;
+}
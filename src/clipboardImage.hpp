@@ -0,0 +1,36 @@
+#ifndef CLIPBOARDIMAGE_HPP
+#define CLIPBOARDIMAGE_HPP
+
+#include <QtCore>
+#include <QtGui>
+
+// 클립보드에 올리는 스크린샷 : 형식 목록만 먼저 알리고, 각 형식의 데이터는 붙여넣는 쪽이 요청할 때 만든다
+// application/x-qt-image 는 원본 QImage 를 공유하여 그대로 전달 ( DIB 변환은 플랫폼 계층이 요청 시 수행 )
+// image/png, image/bmp, application/x-snippingtool-raw 는 nsCapture::WriteImage 로 인코딩하고, 한 번 만든 결과는 보관
+class QClipboardImage : public QMimeData
+{
+    Q_OBJECT
+public:
+    // Image 는 암시적 공유로 보관되어 복사되지 않음
+    explicit QClipboardImage( const QImage& Image );
+
+    QStringList                         formats() const override;
+    bool                                hasFormat( const QString& MimeType ) const override;
+
+protected:
+#if QT_VERSION >= QT_VERSION_CHECK( 6, 0, 0 )
+    QVariant                            retrieveData( const QString& MimeType, QMetaType Type ) const override;
+#else
+    QVariant                            retrieveData( const QString& MimeType, QVariant::Type Type ) const override;
+#endif
+
+private:
+    // MimeType 의 인코딩 결과, 처음 요청될 때 만듦
+    QByteArray                          encoded( const QString& MimeType ) const;
+
+    const QImage                        image;
+    mutable QMutex                      lock;               // 플랫폼 계층이 다른 스레드에서 요청하는 경우
+    mutable QHash< QString, QByteArray > cache;
+};
+
+#endif //CLIPBOARDIMAGE_HPP
@@ -0,0 +1,321 @@
+#include "cursorShape.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define NSKERNEL_CURSOR_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace nsKernel
+{
+    namespace
+    {
+        const uint64_t                  HASH_OFFSET             = 0xCBF29CE484222325ull;
+        const uint64_t                  HASH_PRIME              = 0x100000001B3ull;
+
+        // mask / XOR pair of one masked color or monochrome pixel
+        const uint32_t                  KEEP_RGB                = 0xFFFFFFFFu;
+        const uint32_t                  KEEP_ALPHA              = 0xFF000000u;
+
+        // shape in source orientation, 32bpp planes
+        bool expandShape( const tagCursorShape& Shape, tagCursorImage* pRetImage )
+        {
+            const int32_t Width  = Shape.Width;
+            const int32_t Height = Shape.Type == tagCursorShapeType_Monochrome ? Shape.Height / 2 : Shape.Height;
+            if( Width <= 0 || Height <= 0 )
+                return false;
+
+            const size_t Count = ( size_t )Width * Height;
+            pRetImage->Type   = Shape.Type;
+            pRetImage->Width  = Width;
+            pRetImage->Height = Height;
+            pRetImage->Pixels.resize( Count );
+            pRetImage->Mask.clear();
+            uint32_t* pXor = pRetImage->Pixels.data();
+
+            switch( Shape.Type )
+            {
+                case tagCursorShapeType_Color:
+                {
+                    if( Shape.Pitch < Width * 4 )
+                        return false;
+                    for( int32_t y = 0; y < Height; ++y )
+                        memcpy( pXor + ( size_t )y * Width, Shape.Bits + ( size_t )y * Shape.Pitch, ( size_t )Width * 4 );
+                } break;
+
+                case tagCursorShapeType_Monochrome:
+                {
+                    if( Shape.Pitch * 8 < Width )
+                        return false;
+                    pRetImage->Mask.resize( Count );
+                    uint32_t* pAnd = pRetImage->Mask.data();
+
+                    // AND mask rows first, XOR mask rows below
+                    for( int32_t y = 0; y < Height; ++y )
+                    {
+                        const uint8_t* pAndBits = Shape.Bits + ( size_t )y * Shape.Pitch;
+                        const uint8_t* pXorBits = Shape.Bits + ( size_t )( y + Height ) * Shape.Pitch;
+                        for( int32_t x = 0; x < Width; ++x )
+                        {
+                            const uint8_t Bit = ( uint8_t )( 0x80 >> ( x & 7 ) );
+                            pAnd[ ( size_t )y * Width + x ] = ( pAndBits[ x >> 3 ] & Bit ) ? KEEP_RGB : KEEP_ALPHA;
+                            pXor[ ( size_t )y * Width + x ] = ( pXorBits[ x >> 3 ] & Bit ) ? 0x00FFFFFFu : 0x00000000u;
+                        }
+                    }
+                } break;
+
+                case tagCursorShapeType_MaskedColor:
+                {
+                    if( Shape.Pitch < Width * 4 )
+                        return false;
+                    pRetImage->Mask.resize( Count );
+                    uint32_t* pAnd = pRetImage->Mask.data();
+
+                    for( int32_t y = 0; y < Height; ++y )
+                    {
+                        const uint8_t* pRow = Shape.Bits + ( size_t )y * Shape.Pitch;
+                        for( int32_t x = 0; x < Width; ++x )
+                        {
+                            uint32_t Pixel;
+                            memcpy( &Pixel, pRow + ( size_t )x * 4, sizeof( Pixel ) );
+                            // mask byte 0xFF : XOR with the screen, 0x00 : replace the screen RGB
+                            pAnd[ ( size_t )y * Width + x ] = ( Pixel >> 24 ) ? KEEP_RGB : KEEP_ALPHA;
+                            pXor[ ( size_t )y * Width + x ] = Pixel & 0x00FFFFFFu;
+                        }
+                    }
+                } break;
+
+                default:
+                    return false;
+            }
+
+            return true;
+        }
+
+        bool rotatePlane( const std::vector< uint32_t >& Src, int32_t Width, int32_t Height, tagRotation Rotation, std::vector< uint32_t >* pRetDst )
+        {
+            int32_t DstWidth = 0, DstHeight = 0;
+            RotatedSize( Rotation, Width, Height, &DstWidth, &DstHeight );
+            pRetDst->resize( Src.size() );
+
+            const tagSurface SrcSurface{ reinterpret_cast< uint8_t* >( const_cast< uint32_t* >( Src.data() ) ), Width, Height, ( ptrdiff_t )Width * 4 };
+            const tagSurface DstSurface{ reinterpret_cast< uint8_t* >( pRetDst->data() ), DstWidth, DstHeight, ( ptrdiff_t )DstWidth * 4 };
+            return RotateSurface( DstSurface, SrcSurface, Rotation );
+        }
+
+        // round( x / 255 ) for x <= 255 * 255, same arithmetic in the scalar and SIMD paths
+        inline uint32_t div255( uint32_t X )
+        {
+            X += 128;
+            return ( X + ( X >> 8 ) ) >> 8;
+        }
+
+        // straight alpha source over the surface, the source alpha channel counts as opaque coverage
+        inline uint32_t blendPixel( uint32_t Dst, uint32_t Src )
+        {
+            const uint32_t Alpha = Src >> 24;
+            const uint32_t InvAlpha = 255 - Alpha;
+            const uint32_t Opaque = Src | 0xFF000000u;
+
+            uint32_t Ret = 0;
+            for( int Shift = 0; Shift < 32; Shift += 8 )
+            {
+                const uint32_t Channel = div255( ( ( Opaque >> Shift ) & 0xFF ) * Alpha + ( ( Dst >> Shift ) & 0xFF ) * InvAlpha );
+                Ret |= Channel << Shift;
+            }
+            return Ret;
+        }
+
+        // clip the cursor rect against the surface, false when nothing is visible
+        bool clipCursor( const tagSurface& Dst, const tagCursorImage& Cursor, int32_t X, int32_t Y, tagPixelRect* pRetSrc )
+        {
+            if( Dst.Bits == nullptr || Cursor.Pixels.size() < ( size_t )Cursor.Width * Cursor.Height )
+                return false;
+            if( Cursor.Type != tagCursorShapeType_Color && Cursor.Mask.size() != Cursor.Pixels.size() )
+                return false;
+
+            pRetSrc->Left   = std::max( 0, -X );
+            pRetSrc->Top    = std::max( 0, -Y );
+            pRetSrc->Right  = std::min( Cursor.Width, Dst.Width - X );
+            pRetSrc->Bottom = std::min( Cursor.Height, Dst.Height - Y );
+            return !pRetSrc->IsEmpty();
+        }
+
+#ifdef NSKERNEL_CURSOR_SSE2
+        // 4 pixels of blendPixel
+        inline __m128i blend4( __m128i Dst, __m128i Src )
+        {
+            const __m128i Zero = _mm_setzero_si128();
+            const __m128i Max = _mm_set1_epi16( 255 );
+            const __m128i Half = _mm_set1_epi16( 128 );
+            const __m128i Opaque = _mm_or_si128( Src, _mm_set1_epi32( ( int )0xFF000000u ) );
+
+            __m128i Ret[ 2 ];
+            for( int Part = 0; Part < 2; ++Part )
+            {
+                const __m128i S = Part ? _mm_unpackhi_epi8( Src, Zero ) : _mm_unpacklo_epi8( Src, Zero );
+                const __m128i O = Part ? _mm_unpackhi_epi8( Opaque, Zero ) : _mm_unpacklo_epi8( Opaque, Zero );
+                const __m128i D = Part ? _mm_unpackhi_epi8( Dst, Zero ) : _mm_unpacklo_epi8( Dst, Zero );
+
+                // alpha of each pixel in all four of its lanes
+                const __m128i A = _mm_shufflehi_epi16( _mm_shufflelo_epi16( S, _MM_SHUFFLE( 3, 3, 3, 3 ) ), _MM_SHUFFLE( 3, 3, 3, 3 ) );
+                const __m128i InvA = _mm_sub_epi16( Max, A );
+
+                __m128i X = _mm_add_epi16( _mm_mullo_epi16( O, A ), _mm_mullo_epi16( D, InvA ) );
+                X = _mm_add_epi16( X, Half );
+                Ret[ Part ] = _mm_srli_epi16( _mm_add_epi16( X, _mm_srli_epi16( X, 8 ) ), 8 );
+            }
+
+            return _mm_packus_epi16( Ret[ 0 ], Ret[ 1 ] );
+        }
+#endif
+    }
+
+    uint64_t HashCursorShape( const tagCursorShape& Shape )
+    {
+        const size_t Size = Shape.Size();
+        uint64_t Hash = HASH_OFFSET ^ ( uint64_t )Size;
+        if( Shape.Bits == nullptr )
+            return Hash;
+
+        // FNV-1a over 64-bit words, the tail byte-wise
+        size_t Offset = 0;
+        for( ; Offset + 8 <= Size; Offset += 8 )
+        {
+            uint64_t Word;
+            memcpy( &Word, Shape.Bits + Offset, sizeof( Word ) );
+            Hash = ( Hash ^ Word ) * HASH_PRIME;
+        }
+        for( ; Offset < Size; ++Offset )
+            Hash = ( Hash ^ Shape.Bits[ Offset ] ) * HASH_PRIME;
+
+        // fold the high bits down, word steps only mix upwards
+        Hash ^= Hash >> 29;
+        return Hash;
+    }
+
+    bool BuildCursorImage( const tagCursorShape& Shape, tagRotation Rotation, tagCursorImage* pRetImage )
+    {
+        if( pRetImage == nullptr || Shape.Bits == nullptr || Rotation == tagRotation_Invalid )
+            return false;
+
+        if( Rotation == tagRotation_0 )
+            return expandShape( Shape, pRetImage );
+
+        tagCursorImage Upright;
+        if( !expandShape( Shape, &Upright ) )
+            return false;
+
+        pRetImage->Type = Upright.Type;
+        RotatedSize( Rotation, Upright.Width, Upright.Height, &pRetImage->Width, &pRetImage->Height );
+
+        if( !rotatePlane( Upright.Pixels, Upright.Width, Upright.Height, Rotation, &pRetImage->Pixels ) )
+            return false;
+
+        pRetImage->Mask.clear();
+        if( !Upright.Mask.empty() )
+            return rotatePlane( Upright.Mask, Upright.Width, Upright.Height, Rotation, &pRetImage->Mask );
+
+        return true;
+    }
+
+    void CompositeCursor( const tagSurface& Dst, const tagCursorImage& Cursor, int32_t X, int32_t Y )
+    {
+        tagPixelRect Src;
+        if( !clipCursor( Dst, Cursor, X, Y, &Src ) )
+            return;
+
+        const bool IsColor = Cursor.Type == tagCursorShapeType_Color;
+
+        for( int32_t y = Src.Top; y < Src.Bottom; ++y )
+        {
+            uint32_t* pDst = reinterpret_cast< uint32_t* >( Dst.Bits + ( ptrdiff_t )( Y + y ) * Dst.Pitch ) + X;
+            const uint32_t* pXor = Cursor.Pixels.data() + ( size_t )y * Cursor.Width;
+            const uint32_t* pAnd = IsColor ? nullptr : Cursor.Mask.data() + ( size_t )y * Cursor.Width;
+            int32_t x = Src.Left;
+
+#ifdef NSKERNEL_CURSOR_SSE2
+            for( ; x + 4 <= Src.Right; x += 4 )
+            {
+                const __m128i Screen = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pDst + x ) );
+                const __m128i Shape = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pXor + x ) );
+                __m128i Ret;
+
+                if( IsColor )
+                    Ret = blend4( Screen, Shape );
+                else
+                    Ret = _mm_xor_si128( _mm_and_si128( Screen, _mm_loadu_si128( reinterpret_cast< const __m128i* >( pAnd + x ) ) ), Shape );
+
+                _mm_storeu_si128( reinterpret_cast< __m128i* >( pDst + x ), Ret );
+            }
+#endif
+            for( ; x < Src.Right; ++x )
+                pDst[ x ] = IsColor ? blendPixel( pDst[ x ], pXor[ x ] ) : ( ( pDst[ x ] & pAnd[ x ] ) ^ pXor[ x ] );
+        }
+    }
+
+    void CompositeCursorReference( const tagSurface& Dst, const tagCursorImage& Cursor, int32_t X, int32_t Y )
+    {
+        tagPixelRect Src;
+        if( !clipCursor( Dst, Cursor, X, Y, &Src ) )
+            return;
+
+        for( int32_t y = Src.Top; y < Src.Bottom; ++y )
+        {
+            for( int32_t x = Src.Left; x < Src.Right; ++x )
+            {
+                uint32_t* pScreen = reinterpret_cast< uint32_t* >( Dst.Bits + ( ptrdiff_t )( Y + y ) * Dst.Pitch ) + X + x;
+                const size_t Index = ( size_t )y * Cursor.Width + x;
+
+                if( Cursor.Type == tagCursorShapeType_Color )
+                    *pScreen = blendPixel( *pScreen, Cursor.Pixels[ Index ] );
+                else
+                    *pScreen = ( *pScreen & Cursor.Mask[ Index ] ) ^ Cursor.Pixels[ Index ];
+            }
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// CCursorCache
+
+    CCursorCache::CCursorCache( size_t Capacity )
+        : m_capacity( Capacity > 0 ? Capacity : 1 ), m_hits( 0 ), m_misses( 0 )
+    {
+    }
+
+    const tagCursorImage* CCursorCache::Find( const tagCursorShape& Shape, tagRotation Rotation )
+    {
+        for( auto It = m_entries.begin(); It != m_entries.end(); ++It )
+        {
+            if( It->Hash == Shape.Hash && It->Type == Shape.Type && It->Width == Shape.Width &&
+                It->Height == Shape.Height && It->Pitch == Shape.Pitch && It->Rotation == Rotation )
+            {
+                if( It != m_entries.begin() )
+                    m_entries.splice( m_entries.begin(), m_entries, It );
+                ++m_hits;
+                return &m_entries.front().Image;
+            }
+        }
+
+        ++m_misses;
+
+        tagEntry Entry{ Shape.Hash, Shape.Type, Shape.Width, Shape.Height, Shape.Pitch, Rotation, tagCursorImage() };
+        if( !BuildCursorImage( Shape, Rotation, &Entry.Image ) )
+            return nullptr;
+
+        // drop the least recently used shape
+        if( m_entries.size() >= m_capacity )
+            m_entries.pop_back();
+
+        m_entries.push_front( std::move( Entry ) );
+        return &m_entries.front().Image;
+    }
+
+    void CCursorCache::Clear()
+    {
+        m_entries.clear();
+    }
+
+} // nsKernel
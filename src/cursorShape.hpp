@@ -0,0 +1,94 @@
+#ifndef CURSORSHAPE_HPP
+#define CURSORSHAPE_HPP
+
+#include "frameRotate.hpp"
+
+#include <list>
+
+namespace nsKernel
+{
+    // enum tagCursorShapeType_e : values of DXGI_OUTDUPL_POINTER_SHAPE_TYPE
+    typedef enum tagCursorShapeType_e
+    {
+        tagCursorShapeType_Monochrome   = 1,    // AND mask over XOR mask, 1bpp, Height covers both masks
+        tagCursorShapeType_Color        = 2,    // 32bpp BGRA with alpha
+        tagCursorShapeType_MaskedColor  = 4     // 32bpp, alpha byte is the XOR mask flag
+    } tagCursorShapeType;
+
+    // struct tagCursorShape_s : pointer shape as delivered by the duplication, not owned
+    typedef struct tagCursorShape_s
+    {
+        const uint8_t*                  Bits                = nullptr;
+        uint32_t                        Type                = 0;
+        int32_t                         Width               = 0;
+        int32_t                         Height              = 0;
+        int32_t                         Pitch               = 0;
+        uint64_t                        Hash                = 0;    // HashCursorShape, computed once per shape update
+
+        size_t                          Size() const        { return ( size_t )Pitch * ( size_t )( Height > 0 ? Height : 0 ); }
+    } tagCursorShape;
+
+    // struct tagCursorImage_s : processed 32bpp cursor, already rotated to the output orientation
+    //  color            : Pixels is straight alpha BGRA, blended over the surface
+    //  monochrome       : screen = ( screen & Mask ) ^ Pixels, AND mask bit clear -> Mask 0xFF000000 ( surface alpha kept )
+    //  masked color     : same form, mask byte 0x00 replaces the RGB, 0xFF XORs it
+    typedef struct tagCursorImage_s
+    {
+        uint32_t                        Type                = 0;
+        std::vector< uint32_t >         Pixels;
+        std::vector< uint32_t >         Mask;               // AND plane, empty for color shapes
+        int32_t                         Width               = 0;
+        int32_t                         Height              = 0;
+    } tagCursorImage;
+
+    // content hash of the shape bytes ( Pitch x Height )
+    uint64_t                            HashCursorShape( const tagCursorShape& Shape );
+    // expand the shape to 32bpp planes and rotate them out of place
+    bool                                BuildCursorImage( const tagCursorShape& Shape, tagRotation Rotation, tagCursorImage* pRetImage );
+
+    // draw Cursor with its top-left at ( X, Y ) of Dst, clipped to the surface; SSE2 where available
+    void                                CompositeCursor( const tagSurface& Dst, const tagCursorImage& Cursor, int32_t X, int32_t Y );
+    // one pixel at a time, reference for verification
+    void                                CompositeCursorReference( const tagSurface& Dst, const tagCursorImage& Cursor, int32_t X, int32_t Y );
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// CCursorCache
+    ///
+    /// Small LRU of processed cursor images keyed by shape hash, type, geometry and rotation.
+    /// The pointer only cycles through a handful of shapes ( arrow, I-beam, resize, busy ), so a shape
+    /// that is drawn again costs a key compare instead of mask expansion and rotation.
+
+    class CCursorCache
+    {
+    public:
+        explicit CCursorCache( size_t Capacity = 8 );
+
+        // processed image for Shape, built on a miss; valid until the next Find or Clear
+        const tagCursorImage*           Find( const tagCursorShape& Shape, tagRotation Rotation );
+        void                            Clear();
+
+        uint64_t                        Hits() const        { return m_hits; }
+        uint64_t                        Misses() const      { return m_misses; }
+
+    private:
+        // struct tagEntry_s
+        typedef struct tagEntry_s
+        {
+            uint64_t                    Hash;
+            uint32_t                    Type;
+            int32_t                     Width;
+            int32_t                     Height;
+            int32_t                     Pitch;
+            tagRotation                 Rotation;
+            tagCursorImage              Image;
+        } tagEntry;
+
+        size_t                          m_capacity;
+        std::list< tagEntry >           m_entries;          // most recently used first
+        uint64_t                        m_hits;
+        uint64_t                        m_misses;
+    };
+
+} // nsKernel
+
+#endif //CURSORSHAPE_HPP
@@ -0,0 +1,245 @@
+#include "desktopCanvas.hpp"
+#include "captureTrace.hpp"
+#include "pixelConvert.hpp"
+
+#include <cstring>
+#include <vector>
+
+namespace nsCapture
+{
+    CDesktopCanvas::CDesktopCanvas()
+        : m_pBits( nullptr )
+    {
+    }
+
+    bool CDesktopCanvas::Reset( const QVector< QRect >& OutputBounds )
+    {
+        QRect Bounds;
+        qint64 CoveredPixels = 0;
+        for( const auto& Rect : OutputBounds )
+        {
+            Bounds |= Rect;
+            CoveredPixels += ( qint64 )Rect.width() * Rect.height();
+        }
+
+        m_bounds = Bounds;
+        m_pBits = nullptr;
+
+        if( Bounds.isEmpty() )
+        {
+            m_image = QImage();
+            return false;
+        }
+
+        if( m_image.size() != Bounds.size() )
+            m_image = QImage( Bounds.size(), QImage::Format_ARGB32_Premultiplied );
+
+        if( m_image.isNull() )
+            return false;
+
+        // detach once here, workers only see the raw pointer
+        m_pBits = m_image.bits();
+
+        // outputs never overlap, so only a layout with holes ( mixed sizes, offsets ) needs clearing
+        if( CoveredPixels < ( qint64 )Bounds.width() * Bounds.height() )
+            m_image.fill( Qt::transparent );
+
+        return true;
+    }
+
+    QRect CDesktopCanvas::Bounds() const
+    {
+        return m_bounds;
+    }
+
+    const QImage& CDesktopCanvas::Image() const
+    {
+        return m_image;
+    }
+
+    QRect CDesktopCanvas::SliceRect( const QRect& OutputBounds ) const
+    {
+        return OutputBounds.translated( -m_bounds.topLeft() ).intersected( QRect( QPoint( 0, 0 ), m_bounds.size() ) );
+    }
+
+    QImage CDesktopCanvas::Slice( const QRect& OutputBounds ) const
+    {
+        const QRect Rect = SliceRect( OutputBounds );
+        if( m_pBits == nullptr || Rect.isEmpty() )
+            return QImage();
+
+        const qsizetype Pitch = m_image.bytesPerLine();
+        return QImage( m_pBits + Rect.top() * Pitch + Rect.left() * 4, Rect.width(), Rect.height(), Pitch, m_image.format() );
+    }
+
+    bool CDesktopCanvas::Blit( const QImage& Src, QImage* pDst )
+    {
+        if( pDst == nullptr || Src.isNull() || pDst->isNull() )
+            return false;
+
+        if( Src.depth() != 32 || pDst->depth() != 32 )
+            return false;
+
+        CTraceSpan Span( tagTraceStage_Compose );
+
+        const int Width  = qMin( Src.width(), pDst->width() );
+        const int Height = qMin( Src.height(), pDst->height() );
+        const size_t RowBytes = ( size_t )Width * 4;
+
+        uchar* pDstBits = pDst->bits();
+        const qsizetype DstPitch = pDst->bytesPerLine();
+        const uchar* pSrcBits = Src.constBits();
+        const qsizetype SrcPitch = Src.bytesPerLine();
+
+        for( int y = 0; y < Height; ++y )
+            memcpy( pDstBits + y * DstPitch, pSrcBits + y * SrcPitch, RowBytes );
+
+        return true;
+    }
+
+    QImage CDesktopCanvas::Convert( const QImage& Src, QImage::Format Format )
+    {
+        if( Src.isNull() || Src.format() == Format )
+            return Src;
+
+        const QImage::Format SrcFormat = Src.format();
+        const bool IsPremultiplied = SrcFormat == QImage::Format_ARGB32_Premultiplied;
+        if( !IsPremultiplied && SrcFormat != QImage::Format_ARGB32 && SrcFormat != QImage::Format_RGB32 )
+            return Src.convertToFormat( Format );
+
+        // row steps, straight BGRA between them
+        QVarLengthArray< nsKernel::tagPixelConversion, 3 > Steps;
+        const bool IsTargetPremultiplied = Format == QImage::Format_ARGB32_Premultiplied || Format == QImage::Format_RGBA8888_Premultiplied;
+        if( IsPremultiplied && !IsTargetPremultiplied )
+            Steps.append( nsKernel::tagPixelConversion_Unpremultiply );
+
+        switch( Format )
+        {
+            case QImage::Format_RGB32:
+                Steps.append( nsKernel::tagPixelConversion_Opaque );
+                break;
+            case QImage::Format_ARGB32:
+                break;
+            case QImage::Format_ARGB32_Premultiplied:
+                if( SrcFormat == QImage::Format_ARGB32 )
+                    Steps.append( nsKernel::tagPixelConversion_Premultiply );
+                break;
+            case QImage::Format_RGBA8888:
+                Steps.append( nsKernel::tagPixelConversion_SwapRedBlue );
+                break;
+            case QImage::Format_RGBA8888_Premultiplied:
+                if( SrcFormat == QImage::Format_ARGB32 )
+                    Steps.append( nsKernel::tagPixelConversion_Premultiply );
+                Steps.append( nsKernel::tagPixelConversion_SwapRedBlue );
+                break;
+            case QImage::Format_RGB888:
+                Steps.append( nsKernel::tagPixelConversion_ToRGB888 );
+                break;
+            case QImage::Format_Grayscale8:
+                Steps.append( nsKernel::tagPixelConversion_ToGray8 );
+                break;
+            default:
+                return Src.convertToFormat( Format );
+        }
+
+        // same bytes, only the format tag changes ( RGB32 -> ARGB32 / ARGB32_Premultiplied )
+        if( Steps.isEmpty() )
+        {
+            QImage Copy = Src.copy();
+            Copy.reinterpretAsFormat( Format );
+            return Copy;
+        }
+
+        QImage Dst( Src.size(), Format );
+        if( Dst.isNull() )
+            return QImage();
+        Dst.setDevicePixelRatio( Src.devicePixelRatio() );
+
+        const int Width = Src.width();
+        const nsKernel::tagCpuLevel Level = nsKernel::DetectCpuLevel();
+        std::vector< uchar > Row( Steps.size() > 1 ? ( size_t )Width * 4 : 0 );
+
+        for( int y = 0; y < Src.height(); ++y )
+        {
+            const uchar* pIn = Src.constScanLine( y );
+            for( int Step = 0; Step < Steps.size(); ++Step )
+            {
+                // the last step writes the scanline, earlier ones a 32bpp scratch row ( in place after the first )
+                uchar* pOut = Step + 1 == Steps.size() ? Dst.scanLine( y ) : Row.data();
+                nsKernel::PixelRowConverter( Steps[ Step ], Level )( pOut, pIn, Width );
+                pIn = pOut;
+            }
+        }
+
+        return Dst;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// CDesktopStrips
+
+    bool CDesktopStrips::Reset( const QVector< QRect >& OutputBounds, const QVector< QImage >& Frames )
+    {
+        m_sources.clear();
+        m_bounds = QRect();
+
+        qint64 CoveredPixels = 0;
+        for( const auto& Rect : OutputBounds )
+            m_bounds |= Rect;
+
+        for( int i = 0; i < OutputBounds.size() && i < Frames.size(); ++i )
+        {
+            const QImage& Frame = Frames.at( i );
+            if( Frame.isNull() || Frame.depth() != 32 )
+                continue;
+
+            tagSource Source;
+            Source.Rect = QRect( OutputBounds.at( i ).topLeft() - m_bounds.topLeft(), Frame.size() ).intersected( OutputBounds.at( i ).translated( -m_bounds.topLeft() ) );
+            Source.Frame = Frame;
+            if( Source.Rect.isEmpty() )
+                continue;
+
+            CoveredPixels += ( qint64 )Source.Rect.width() * Source.Rect.height();
+            m_sources.push_back( Source );
+        }
+
+        m_hasGaps = CoveredPixels < ( qint64 )m_bounds.width() * m_bounds.height();
+        return m_bounds.isEmpty() == false;
+    }
+
+    QRect CDesktopStrips::Bounds() const
+    {
+        return m_bounds;
+    }
+
+    bool CDesktopStrips::Fill( int FirstRow, QImage* pStrip ) const
+    {
+        if( pStrip == nullptr || pStrip->isNull() || pStrip->depth() != 32 || pStrip->width() != m_bounds.width() ||
+            FirstRow < 0 || FirstRow + pStrip->height() > m_bounds.height() )
+            return false;
+
+        CTraceSpan Span( tagTraceStage_Compose );
+
+        const QRect StripRect( 0, FirstRow, pStrip->width(), pStrip->height() );
+        if( m_hasGaps )
+            pStrip->fill( Qt::transparent );
+
+        uchar* pDstBits = pStrip->bits();
+        const qsizetype DstPitch = pStrip->bytesPerLine();
+        for( const auto& Source : m_sources )
+        {
+            const QRect Rect = Source.Rect.intersected( StripRect );
+            if( Rect.isEmpty() )
+                continue;
+
+            const size_t RowBytes = ( size_t )Rect.width() * 4;
+            for( int y = Rect.top(); y <= Rect.bottom(); ++y )
+            {
+                memcpy( pDstBits + ( y - FirstRow ) * DstPitch + Rect.left() * 4,
+                        Source.Frame.constScanLine( y - Source.Rect.top() ), RowBytes );
+            }
+        }
+
+        return true;
+    }
+
+} // nsCapture
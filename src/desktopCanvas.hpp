@@ -0,0 +1,77 @@
+#ifndef DESKTOPCANVAS_HPP
+#define DESKTOPCANVAS_HPP
+
+#include <QtCore>
+#include <QtGui>
+
+namespace nsCapture
+{
+    ///////////////////////////////////////////////////////////////////////////
+    /// CDesktopCanvas
+    ///
+    /// One preallocated virtual desktop image, origin at the top-left of the union of all outputs
+    /// ( outputs left / above the primary have negative coordinates ).
+    /// Slice() hands out non-owning views into the canvas, workers of different outputs write their
+    /// slices concurrently without further locking because slices of distinct outputs never overlap.
+
+    class CDesktopCanvas
+    {
+    public:
+        CDesktopCanvas();
+
+        // union of the output bounds ( virtual desktop coordinates ), allocates or reuses the canvas, gaps stay transparent
+        bool                            Reset( const QVector< QRect >& OutputBounds );
+
+        QRect                           Bounds() const;
+        const QImage&                   Image() const;
+
+        // output bounds in canvas coordinates, clipped to the canvas
+        QRect                           SliceRect( const QRect& OutputBounds ) const;
+        // writable view of SliceRect, valid while the canvas is neither Reset nor destroyed
+        QImage                          Slice( const QRect& OutputBounds ) const;
+
+        // copy Src into Dst at the top-left, clipped to the smaller size; 32bpp formats only
+        static bool                     Blit( const QImage& Src, QImage* pDst );
+        // Src in Format, converted row by row straight into the new image's scanlines by the SIMD pixel kernels;
+        // 32bpp BGRA sources ( RGB32, ARGB32, ARGB32_Premultiplied ) only, everything else goes through QImage::convertToFormat
+        static QImage                   Convert( const QImage& Src, QImage::Format Format );
+
+    private:
+        QImage                          m_image;
+        uchar*                          m_pBits;
+        QRect                           m_bounds;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// CDesktopStrips
+    ///
+    /// The same virtual desktop as CDesktopCanvas, composed a row strip at a time from the per-output frames
+    /// ( shared with the sessions' frame caches ) instead of into one image, for saves that encode as they go.
+
+    class CDesktopStrips
+    {
+    public:
+        // Frames[ i ] belongs to OutputBounds[ i ], null frames stay transparent
+        bool                            Reset( const QVector< QRect >& OutputBounds, const QVector< QImage >& Frames );
+
+        QRect                           Bounds() const;
+
+        // canvas rows [ FirstRow, FirstRow + pStrip->height() ) into pStrip, canvas wide and 32bpp
+        bool                            Fill( int FirstRow, QImage* pStrip ) const;
+
+    private:
+        // struct tagSource_s
+        typedef struct tagSource_s
+        {
+            QRect                       Rect;           // canvas coordinates, clipped to the frame
+            QImage                      Frame;
+        } tagSource;
+
+        QVector< tagSource >            m_sources;
+        QRect                           m_bounds;
+        bool                            m_hasGaps       = false;
+    };
+
+} // nsCapture
+
+#endif //DESKTOPCANVAS_HPP
@@ -1,7 +1,9 @@
 #include "dxgiMgr.hpp"
+#include "imageFile.hpp"
 
 #include <d2d1_1.h>
 #include <ShellScalingAPI.h>
+#include <cmath>
 // #include <qpa/qplatformscreen.h>
 
 #pragma comment( lib, "d3d11.lib" )
@@ -31,6 +33,75 @@ const UINT g_NumFeatureLevels = ARRAYSIZE( g_FeatureLevels );
 
 #define AUTOLOCK()                  ATL::CComCritSecLock<ATL::CComAutoCriticalSection> auto_lock((ATL::CComAutoCriticalSection&)(m_csLock))
 #define D3D_FEATURE_LEVEL_INVALID  ((D3D_FEATURE_LEVEL)0x0)
+#define DEFAULT_ACQUIRE_TIMEOUT_MS  500
+
+namespace
+{
+    // IDXGIOutputDuplication as a nsCapture::IDuplicationSource.
+    // Pointer updates are consumed here while the frame is held, including pointer-only frames the acquirer skips.
+    class CDXGIDuplicationSource : public nsCapture::IDuplicationSource
+    {
+    private:
+        IDXGIOutputDuplication*         m_pDuplication;
+        nsDXGI::tagMouseInfo*           m_pMouseInfo;
+        UINT                            m_uiMonitorIdx;
+        INT                             m_nOffsetX;
+        INT                             m_nOffsetY;
+        DXGI_OUTDUPL_FRAME_INFO         m_frameInfo;
+        CComPtr<IDXGIResource>          m_ipResource;
+        HRESULT                         m_hLastError;
+
+    public:
+        CDXGIDuplicationSource( IDXGIOutputDuplication* pDuplication, nsDXGI::tagMouseInfo* pMouseInfo, UINT uiMonitorIdx, INT nOffsetX, INT nOffsetY )
+            : m_pDuplication( pDuplication ), m_pMouseInfo( pMouseInfo ), m_uiMonitorIdx( uiMonitorIdx )
+            , m_nOffsetX( nOffsetX ), m_nOffsetY( nOffsetY ), m_hLastError( S_OK )
+        {
+            RtlZeroMemory( &m_frameInfo, sizeof( m_frameInfo ) );
+        }
+
+        ~CDXGIDuplicationSource()
+        {
+            if( nullptr != m_ipResource )
+            {
+                ReleaseFrame();
+            }
+        }
+
+        IDXGIResource*                  Resource() const { return m_ipResource; }
+        DXGI_OUTDUPL_FRAME_INFO*        FrameInfo() { return &m_frameInfo; }
+        HRESULT                         LastError() const { return m_hLastError; }
+
+        nsCapture::tagAcquireStatus AcquireNextFrame( uint32_t TimeoutMs, nsCapture::tagDuplicationFrameInfo* pRetFrameInfo ) override
+        {
+            m_ipResource = nullptr;
+            m_hLastError = m_pDuplication->AcquireNextFrame( TimeoutMs, &m_frameInfo, &m_ipResource );
+
+            if( m_hLastError == DXGI_ERROR_WAIT_TIMEOUT )
+                return nsCapture::tagAcquireStatus_Timeout;
+            if( m_hLastError == DXGI_ERROR_ACCESS_LOST )
+                return nsCapture::tagAcquireStatus_AccessLost;
+            if( FAILED( m_hLastError ) )
+                return nsCapture::tagAcquireStatus_Failed;
+
+            if( nullptr != m_pMouseInfo )
+            {
+                // pointer shape failures only cost the cursor, not the frame
+                nsDXGI::DXGICaptureHelper::GetMouse( m_pDuplication, m_pMouseInfo, &m_frameInfo, m_uiMonitorIdx, m_nOffsetX, m_nOffsetY );
+            }
+
+            pRetFrameInfo->LastPresentTime      = m_frameInfo.LastPresentTime.QuadPart;
+            pRetFrameInfo->LastMouseUpdateTime  = m_frameInfo.LastMouseUpdateTime.QuadPart;
+            pRetFrameInfo->AccumulatedFrames    = m_frameInfo.AccumulatedFrames;
+            return nsCapture::tagAcquireStatus_Ok;
+        }
+
+        void ReleaseFrame() override
+        {
+            m_ipResource = nullptr;
+            m_pDuplication->ReleaseFrame();
+        }
+    };
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 /// class DXGICaptureHelper
@@ -395,218 +466,114 @@ HRESULT nsDXGI::DXGICaptureHelper::GetMouse( IDXGIOutputDuplication* pOutputDupl
         delete[] PtrInfo->PtrShapeBuffer;
         PtrInfo->PtrShapeBuffer  = nullptr;
         PtrInfo->ShapeBufferSize = 0;
+        PtrInfo->ShapeHash       = 0;
         return hr;
     }
 
+    // hashed once per shape update, drawing looks the processed shape up by it
+    PtrInfo->ShapeHash = nsKernel::HashCursorShape( DXGICaptureHelper::ToCursorShape( PtrInfo ) );
+
     return S_OK;
 }
 
-HRESULT nsDXGI::DXGICaptureHelper::ProcessMouseMask( const tagMouseInfo* PtrInfo, const DXGI_OUTPUT_DESC* DesktopDesc, tagFrameBufferInfo* pBufferInfo )
+HRESULT nsDXGI::DXGICaptureHelper::ProcessMouseMask( const tagMouseInfo* PtrInfo, const DXGI_OUTPUT_DESC* DesktopDesc, nsKernel::CCursorCache* pCursorCache, tagCursorPlacement* pRetPlacement )
 {
     CHECK_POINTER_EX( PtrInfo, E_INVALIDARG );
     CHECK_POINTER_EX( DesktopDesc, E_INVALIDARG );
-    CHECK_POINTER_EX( pBufferInfo, E_INVALIDARG );
+    CHECK_POINTER_EX( pCursorCache, E_INVALIDARG );
+    CHECK_POINTER_EX( pRetPlacement, E_INVALIDARG );
+
+    pRetPlacement->Image = nullptr;
 
     if( !PtrInfo->Visible )
     {
         return S_FALSE;
     }
 
-    HRESULT hr            = S_OK;
     INT     DesktopWidth  = ( INT )( DesktopDesc->DesktopCoordinates.right - DesktopDesc->DesktopCoordinates.left );
     INT     DesktopHeight = ( INT )( DesktopDesc->DesktopCoordinates.bottom - DesktopDesc->DesktopCoordinates.top );
 
-    pBufferInfo->Bounds.X      = PtrInfo->Position.x;
-    pBufferInfo->Bounds.Y      = PtrInfo->Position.y;
-    pBufferInfo->Bounds.Width  = PtrInfo->ShapeInfo.Width;
-    pBufferInfo->Bounds.Height = ( PtrInfo->ShapeInfo.Type == DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME )
-                                     ? ( INT )( PtrInfo->ShapeInfo.Height / 2 )
-                                     : ( INT )PtrInfo->ShapeInfo.Height;
-    pBufferInfo->Pitch = pBufferInfo->Bounds.Width * 4;
-
-    switch( PtrInfo->ShapeInfo.Type )
+    // the pointer shape is turned against the output rotation
+    nsKernel::tagRotation Rotation = nsKernel::tagRotation_0;
+    switch( DesktopDesc->Rotation )
     {
-        case DXGI_OUTDUPL_POINTER_SHAPE_TYPE_COLOR:
-        {
-            // Resize mouseshape buffer (if necessary)
-            hr = DXGICaptureHelper::ResizeFrameBuffer( pBufferInfo, PtrInfo->ShapeBufferSize );
-            if( FAILED( hr ) )
-            {
-                return hr;
-            }
-
-            // use current mouseshape buffer
-            // Copy mouseshape buffer
-            memcpy_s( ( void* )pBufferInfo->Buffer, pBufferInfo->BufferSize, ( const void* )PtrInfo->PtrShapeBuffer, PtrInfo->ShapeBufferSize );
-            break;
-        }
-
-        case DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME:
-        {
-            // Resize mouseshape buffer (if necessary)
-            hr = DXGICaptureHelper::ResizeFrameBuffer( pBufferInfo, pBufferInfo->Bounds.Height * pBufferInfo->Pitch );
-            if( FAILED( hr ) )
-            {
-                return hr;
-            }
-
-            UINT* InitBuffer32 = reinterpret_cast< UINT* >( pBufferInfo->Buffer );
-
-            for( INT Row = 0; Row < pBufferInfo->Bounds.Height; ++Row )
-            {
-                // Set mask
-                BYTE Mask = 0x80;
-                for( INT Col = 0; Col < pBufferInfo->Bounds.Width; ++Col )
-                {
-                    BYTE XorMask = PtrInfo->PtrShapeBuffer[ ( Col / 8 ) + ( ( Row + ( PtrInfo->ShapeInfo.Height / 2 ) ) * ( PtrInfo->ShapeInfo.Pitch ) ) ] & Mask;
+        case DXGI_MODE_ROTATION_ROTATE90:   Rotation = nsKernel::tagRotation_270; break;
+        case DXGI_MODE_ROTATION_ROTATE180:  Rotation = nsKernel::tagRotation_180; break;
+        case DXGI_MODE_ROTATION_ROTATE270:  Rotation = nsKernel::tagRotation_90;  break;
+        default:                            break;
+    }
 
-                    // Set new pixel
-                    InitBuffer32[ ( Row * pBufferInfo->Bounds.Width ) + Col ] = ( XorMask ) ? 0xFFFFFFFF : 0x00000000;
+    // expanded and rotated once per distinct shape, a repeated shape is a lookup by its hash
+    const nsKernel::tagCursorImage* Image = pCursorCache->Find( DXGICaptureHelper::ToCursorShape( PtrInfo ), Rotation );
+    if( Image == nullptr )
+    {
+        return E_INVALIDARG;
+    }
 
-                    // Adjust mask
-                    if( Mask == 0x01 )
-                    {
-                        Mask = 0x80;
-                    }
-                    else
-                    {
-                        Mask = Mask >> 1;
-                    }
-                }
-            }
+    // shape bounds in source orientation
+    INT X      = PtrInfo->Position.x;
+    INT Y      = PtrInfo->Position.y;
+    INT Width  = ( INT )PtrInfo->ShapeInfo.Width;
+    INT Height = ( PtrInfo->ShapeInfo.Type == DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME )
+                     ? ( INT )( PtrInfo->ShapeInfo.Height / 2 )
+                     : ( INT )PtrInfo->ShapeInfo.Height;
 
+    switch( DesktopDesc->Rotation )
+    {
+        case DXGI_MODE_ROTATION_ROTATE90:
+            pRetPlacement->Bounds.X = Y;
+            pRetPlacement->Bounds.Y = DesktopWidth - ( X + Width );
             break;
-        }
-
-        case DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MASKED_COLOR:
-        {
-            // Resize mouseshape buffer (if necessary)
-            hr = DXGICaptureHelper::ResizeFrameBuffer( pBufferInfo, pBufferInfo->Bounds.Height * pBufferInfo->Pitch );
-            if( FAILED( hr ) )
-            {
-                return hr;
-            }
-
-            UINT* InitBuffer32  = reinterpret_cast< UINT* >( pBufferInfo->Buffer );
-            UINT* ShapeBuffer32 = reinterpret_cast< UINT* >( PtrInfo->PtrShapeBuffer );
-
-            for( INT Row = 0; Row < pBufferInfo->Bounds.Height; ++Row )
-            {
-                for( INT Col = 0; Col < pBufferInfo->Bounds.Width; ++Col )
-                {
-                    InitBuffer32[ ( Row * pBufferInfo->Bounds.Width ) + Col ] = ShapeBuffer32[ Col + ( Row * ( PtrInfo->ShapeInfo.Pitch / sizeof( UINT ) ) ) ] | 0xFF000000;
-                }
-            }
-
+        case DXGI_MODE_ROTATION_ROTATE180:
+            pRetPlacement->Bounds.X = DesktopWidth - ( X + Width );
+            pRetPlacement->Bounds.Y = DesktopHeight - ( Y + Height );
+            break;
+        case DXGI_MODE_ROTATION_ROTATE270:
+            pRetPlacement->Bounds.X = DesktopHeight - ( Y + Height );
+            pRetPlacement->Bounds.Y = X;
             break;
-        }
-
         default:
-            return E_INVALIDARG;
-
+            pRetPlacement->Bounds.X = X;
+            pRetPlacement->Bounds.Y = Y;
+            break;
     }
 
-    UINT* InitBuffer32 = reinterpret_cast< UINT* >( pBufferInfo->Buffer );
-    UINT  width        = ( UINT )pBufferInfo->Bounds.Width;
-    UINT  height       = ( UINT )pBufferInfo->Bounds.Height;
-
-    switch( DesktopDesc->Rotation )
-    {
-        case DXGI_MODE_ROTATION_ROTATE90:
-        {
-            // Rotate -90 or +270
-            for( UINT i = 0; i < width; i++ )
-            {
-                for( UINT j = 0; j < height; j++ )
-                {
-                    UINT I = j;
-                    UINT J = width - 1 - i;
-                    while( ( i * height + j ) > ( I * width + J ) )
-                    {
-                        UINT p     = I * width + J;
-                        UINT tmp_i = p / height;
-                        UINT tmp_j = p % height;
-                        I          = tmp_j;
-                        J          = width - 1 - tmp_i;
-                    }
-                    std::swap( *( InitBuffer32 + ( i * height + j ) ), *( InitBuffer32 + ( I * width + J ) ) );
-                }
-            }
+    pRetPlacement->Bounds.Width  = Image->Width;
+    pRetPlacement->Bounds.Height = Image->Height;
+    pRetPlacement->Image         = Image;
 
-            // translate bounds
-            std::swap( pBufferInfo->Bounds.Width, pBufferInfo->Bounds.Height );
-            INT nX                = pBufferInfo->Bounds.Y;
-            INT nY                = DesktopWidth - ( INT )( pBufferInfo->Bounds.X + pBufferInfo->Bounds.Height );
-            pBufferInfo->Bounds.X = nX;
-            pBufferInfo->Bounds.Y = nY;
-            pBufferInfo->Pitch    = pBufferInfo->Bounds.Width * 4;
-        } break;
-        case DXGI_MODE_ROTATION_ROTATE180:
-        {
-            // Rotate -180 or +180
-            if( height % 2 != 0 )
-            {
-                //If N is odd reverse the middle row in the matrix
-                UINT j = height >> 1;
-                for( UINT i = 0; i < ( width >> 1 ); i++ )
-                {
-                    std::swap( InitBuffer32[ j * width + i ], InitBuffer32[ j * width + width - i - 1 ] );
-                }
-            }
+    return S_OK;
+}
 
-            for( UINT j = 0; j < ( height >> 1 ); j++ )
-            {
-                for( UINT i = 0; i < width; i++ )
-                {
-                    std::swap( InitBuffer32[ j * width + i ], InitBuffer32[ ( height - j - 1 ) * width + width - i - 1 ] );
-                }
-            }
+nsKernel::tagCursorShape nsDXGI::DXGICaptureHelper::ToCursorShape( const tagMouseInfo* PtrInfo )
+{
+    nsKernel::tagCursorShape Shape;
+    if( nullptr == PtrInfo || nullptr == PtrInfo->PtrShapeBuffer )
+    {
+        return Shape;
+    }
 
-            // translate position
-            INT nX                = DesktopWidth - ( INT )( pBufferInfo->Bounds.X + pBufferInfo->Bounds.Width );
-            INT nY                = DesktopHeight - ( INT )( pBufferInfo->Bounds.Y + pBufferInfo->Bounds.Height );
-            pBufferInfo->Bounds.X = nX;
-            pBufferInfo->Bounds.Y = nY;
-        } break;
-        case DXGI_MODE_ROTATION_ROTATE270:
-        {
-            // Rotate -270 or +90
-            for( UINT i = 0; i < width; i++ )
-            {
-                for( UINT j = 0; j < height; j++ )
-                {
-                    UINT I = height - 1 - j;
-                    UINT J = i;
-                    while( ( i * height + j ) > ( I * width + J ) )
-                    {
-                        int p     = I * width + J;
-                        int tmp_i = p / height;
-                        int tmp_j = p % height;
-                        I         = height - 1 - tmp_j;
-                        J         = tmp_i;
-                    }
-                    std::swap( *( InitBuffer32 + ( i * height + j ) ), *( InitBuffer32 + ( I * width + J ) ) );
-                }
-            }
+    Shape.Bits   = PtrInfo->PtrShapeBuffer;
+    Shape.Type   = PtrInfo->ShapeInfo.Type;
+    Shape.Width  = ( int32_t )PtrInfo->ShapeInfo.Width;
+    Shape.Height = ( int32_t )PtrInfo->ShapeInfo.Height;
+    Shape.Pitch  = ( int32_t )PtrInfo->ShapeInfo.Pitch;
+    Shape.Hash   = PtrInfo->ShapeHash;
 
-            // translate bounds
-            std::swap( pBufferInfo->Bounds.Width, pBufferInfo->Bounds.Height );
-            INT nX                = DesktopHeight - ( pBufferInfo->Bounds.Y + pBufferInfo->Bounds.Width );
-            INT nY                = pBufferInfo->Bounds.X;
-            pBufferInfo->Bounds.X = nX;
-            pBufferInfo->Bounds.Y = nY;
-            pBufferInfo->Pitch    = pBufferInfo->Bounds.Width * 4;
-        } break;
+    // never read past what GetFramePointerShape delivered
+    if( Shape.Size() > PtrInfo->ShapeBufferSize )
+    {
+        Shape.Bits = nullptr;
     }
 
-    return S_OK;
+    return Shape;
 }
 
-HRESULT nsDXGI::DXGICaptureHelper::DrawMouse( tagMouseInfo* PtrInfo, const DXGI_OUTPUT_DESC* DesktopDesc, tagFrameBufferInfo* pTempMouseBuffer, ID3D11Texture2D* pSharedSurf )
+HRESULT nsDXGI::DXGICaptureHelper::DrawMouse( tagMouseInfo* PtrInfo, const DXGI_OUTPUT_DESC* DesktopDesc, nsKernel::CCursorCache* pCursorCache, ID3D11Texture2D* pSharedSurf )
 {
     CHECK_POINTER_EX( PtrInfo, E_INVALIDARG );
     CHECK_POINTER_EX( DesktopDesc, E_INVALIDARG );
-    CHECK_POINTER_EX( pTempMouseBuffer, E_INVALIDARG );
+    CHECK_POINTER_EX( pCursorCache, E_INVALIDARG );
     CHECK_POINTER_EX( pSharedSurf, E_INVALIDARG );
 
     HRESULT hr = S_OK;
@@ -614,105 +581,48 @@ HRESULT nsDXGI::DXGICaptureHelper::DrawMouse( tagMouseInfo* PtrInfo, const DXGI_
     D3D11_TEXTURE2D_DESC FullDesc;
     pSharedSurf->GetDesc( &FullDesc );
 
-    INT SurfWidth  = FullDesc.Width;
-    INT SurfHeight = FullDesc.Height;
-    INT SurfPitch  = FullDesc.Width * 4;
+    // QI for IDXGISurface
+    CComPtr<IDXGISurface> ipCopySurface;
+    hr = pSharedSurf->QueryInterface( __uuidof( IDXGISurface ), ( void** )&ipCopySurface );
+    CHECK_HR_RETURN( hr );
 
-    hr = DXGICaptureHelper::ProcessMouseMask( PtrInfo, DesktopDesc, pTempMouseBuffer );
-    if( FAILED( hr ) )
-    {
-        return hr;
-    }
+    // Map pixels
+    DXGI_MAPPED_RECT MappedSurface;
+    hr = ipCopySurface->Map( &MappedSurface, DXGI_MAP_READ | DXGI_MAP_WRITE );
+    CHECK_HR_RETURN( hr );
 
-    // Buffer used if necessary (in case of monochrome or masked pointer)
-    BYTE* InitBuffer = pTempMouseBuffer->Buffer;
+    hr = DrawMouseToBuffer( PtrInfo, DesktopDesc, pCursorCache, MappedSurface.pBits, MappedSurface.Pitch, FullDesc.Width, FullDesc.Height );
 
-    // Clipping adjusted coordinates / dimensions
-    INT PtrWidth  = ( INT )pTempMouseBuffer->Bounds.Width;
-    INT PtrHeight = ( INT )pTempMouseBuffer->Bounds.Height;
+    // Done with resource
+    ipCopySurface->Unmap();
 
-    INT PtrLeft  = ( INT )pTempMouseBuffer->Bounds.X;
-    INT PtrTop   = ( INT )pTempMouseBuffer->Bounds.Y;
-    INT PtrPitch = ( INT )pTempMouseBuffer->Pitch;
+    return hr;
+}
 
-    INT SrcLeft   = 0;
-    INT SrcTop    = 0;
-    INT SrcWidth  = PtrWidth;
-    INT SrcHeight = PtrHeight;
+HRESULT nsDXGI::DXGICaptureHelper::DrawMouseToBuffer( tagMouseInfo* PtrInfo, const DXGI_OUTPUT_DESC* DesktopDesc, nsKernel::CCursorCache* pCursorCache, BYTE* pSurfBits, INT SurfPitch, INT SurfWidth, INT SurfHeight, INT OriginX, INT OriginY )
+{
+    CHECK_POINTER_EX( PtrInfo, E_INVALIDARG );
+    CHECK_POINTER_EX( DesktopDesc, E_INVALIDARG );
+    CHECK_POINTER_EX( pCursorCache, E_INVALIDARG );
+    CHECK_POINTER_EX( pSurfBits, E_INVALIDARG );
 
-    if( PtrLeft < 0 )
-    {
-        // crop mouseshape left
-        SrcLeft = -PtrLeft;
-        // new mouse x position for drawing
-        PtrLeft = 0;
-    }
-    else if( PtrLeft + PtrWidth > SurfWidth )
-    {
-        // crop mouseshape width
-        SrcWidth = SurfWidth - PtrLeft;
-    }
+    HRESULT hr = S_OK;
 
-    if( PtrTop < 0 )
-    {
-        // crop mouseshape top
-        SrcTop = -PtrTop;
-        // new mouse y position for drawing
-        PtrTop = 0;
-    }
-    else if( PtrTop + PtrHeight > SurfHeight )
+    tagCursorPlacement placement;
+    hr = DXGICaptureHelper::ProcessMouseMask( PtrInfo, DesktopDesc, pCursorCache, &placement );
+    if( hr != S_OK )
     {
-        // crop mouseshape height
-        SrcHeight = SurfHeight - PtrTop;
+        // S_FALSE : pointer hidden, nothing to draw
+        return FAILED( hr ) ? hr : S_OK;
     }
 
-    // QI for IDXGISurface
-    CComPtr<IDXGISurface> ipCopySurface;
-    hr = pSharedSurf->QueryInterface( __uuidof( IDXGISurface ), ( void** )&ipCopySurface );
-    if( SUCCEEDED( hr ) )
-    {
-        // Map pixels
-        DXGI_MAPPED_RECT MappedSurface;
-        hr = ipCopySurface->Map( &MappedSurface, DXGI_MAP_READ | DXGI_MAP_WRITE );
-        if( SUCCEEDED( hr ) )
-        {
-            // 0xAARRGGBB
-            UINT* SrcBuffer32 = reinterpret_cast< UINT* >( InitBuffer );
-            UINT* DstBuffer32 = reinterpret_cast< UINT* >( MappedSurface.pBits ) + PtrTop * SurfWidth + PtrLeft;
-
-            // Alpha blending masks
-            const UINT AMask    = 0xFF000000;
-            const UINT RBMask   = 0x00FF00FF;
-            const UINT GMask    = 0x0000FF00;
-            const UINT AGMask   = AMask | GMask;
-            const UINT OneAlpha = 0x01000000;
-            UINT       uiPixel1;
-            UINT       uiPixel2;
-            UINT       uiAlpha;
-            UINT       uiNAlpha;
-            UINT       uiRedBlue;
-            UINT       uiAlphaGreen;
-
-            for( INT Row = SrcTop; Row < SrcHeight; ++Row )
-            {
-                for( INT Col = SrcLeft; Col < SrcWidth; ++Col )
-                {
-                    // Alpha blending
-                    uiPixel1     = DstBuffer32[ ( ( Row - SrcTop ) * SurfWidth ) + ( Col - SrcLeft ) ];
-                    uiPixel2     = SrcBuffer32[ ( Row * PtrWidth ) + Col ];
-                    uiAlpha      = ( uiPixel2 & AMask ) >> 24;
-                    uiNAlpha     = 255 - uiAlpha;
-                    uiRedBlue    = ( ( uiNAlpha * ( uiPixel1 & RBMask ) ) + ( uiAlpha * ( uiPixel2 & RBMask ) ) ) >> 8;
-                    uiAlphaGreen = ( uiNAlpha * ( ( uiPixel1 & AGMask ) >> 8 ) ) + ( uiAlpha * ( OneAlpha | ( ( uiPixel2 & GMask ) >> 8 ) ) );
-
-                    DstBuffer32[ ( ( Row - SrcTop ) * SurfWidth ) + ( Col - SrcLeft ) ] = ( ( uiRedBlue & RBMask ) | ( uiAlphaGreen & AGMask ) );
-                }
-            }
-        }
-
-        // Done with resource
-        hr = ipCopySurface->Unmap();
-    }
+    // alpha blend, AND / XOR or masked XOR by shape type, clipped to the surface
+    nsKernel::tagSurface surface;
+    surface.Bits    = pSurfBits;
+    surface.Width   = SurfWidth;
+    surface.Height  = SurfHeight;
+    surface.Pitch   = SurfPitch;
+    nsKernel::CompositeCursor( surface, *placement.Image, placement.Bounds.X - OriginX, placement.Bounds.Y - OriginY );
 
     return S_OK;
 }
@@ -764,6 +674,21 @@ HRESULT nsDXGI::DXGICaptureHelper::CreateBitmap( ID2D1RenderTarget* pRenderTarge
     return S_OK;
 }
 
+HRESULT nsDXGI::DXGICaptureHelper::CreateBitmapFromMemory( ID2D1RenderTarget* pRenderTarget, const BYTE* pBits, UINT uiPitch, UINT uiWidth, UINT uiHeight, ID2D1Bitmap** ppOutBitmap )
+{
+    CHECK_POINTER( ppOutBitmap );
+    *ppOutBitmap = nullptr;
+    CHECK_POINTER_EX( pRenderTarget, E_INVALIDARG );
+    CHECK_POINTER_EX( pBits, E_INVALIDARG );
+
+    return pRenderTarget->CreateBitmap(
+                                       D2D1::SizeU( uiWidth, uiHeight ),
+                                       ( const void* )pBits,
+                                       uiPitch,
+                                       D2D1::BitmapProperties( D2D1::PixelFormat( DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED ) ),
+                                       ppOutBitmap );
+}
+
 HRESULT nsDXGI::DXGICaptureHelper::GetContainerFormatByFileName( LPCWSTR lpcwFileName, GUID* pRetVal )
 {
     RESET_POINTER_EX( pRetVal, GUID_NULL );
@@ -798,6 +723,12 @@ HRESULT nsDXGI::DXGICaptureHelper::GetContainerFormatByFileName( LPCWSTR lpcwFil
     {
         RESET_POINTER_EX( pRetVal, GUID_ContainerFormatJpeg );
     }
+    else if( ( lstrcmpiW( lpcwExtension, L".qoi" ) == 0 ) ||
+             ( lstrcmpiW( lpcwExtension, L".raw" ) == 0 ) )
+    {
+        // no WIC container, written by nsCapture::WriteImage
+        return S_FALSE;
+    }
     else
     {
         return ERROR_MRM_INVALID_FILE_TYPE;
@@ -820,6 +751,11 @@ HRESULT nsDXGI::DXGICaptureHelper::SaveImageToFile( IWICImagingFactory* pWICImag
         return hr;
     }
 
+    if( hr == S_FALSE )
+    {
+        return WINCODEC_ERR_COMPONENTNOTFOUND;
+    }
+
     WICPixelFormatGUID             format = GUID_WICPixelFormatDontCare;
     CComPtr<IWICImagingFactory>    ipWICImagingFactory( pWICImagingFactory );
     CComPtr<IWICBitmapSource>      ipWICBitmapSource( pWICBitmapSource );
@@ -889,10 +825,23 @@ namespace nsDXGI
         : m_csLock()
         , m_bInitialized( FALSE )
         , m_lD3DFeatureLevel( D3D_FEATURE_LEVEL_INVALID )
+        , m_bMirrorValid( FALSE )
+        , m_llMirrorPresentTime( 0 )
+        , m_uiAcquireTimeoutMs( DEFAULT_ACQUIRE_TIMEOUT_MS )
+        , m_uiMaxStalenessMs( 0 )
+        , m_lastFrameReason( nsCapture::tagFrameReason_None )
+        , m_bRenderCurrent( FALSE )
+        , m_ullRenderedSerial( 0 )
+        , m_ullRenderGeneration( 0 )
+        , m_ullOutputGeneration( 0 )
+        , m_ullDirectFrames( 0 )
+        , m_ullRenderedFrames( 0 )
+        , m_ullOutputBytes( 0 )
+        , m_ullRotatedSerial( 0 )
+        , m_ullScaledSerial( 0 )
     {
         RtlZeroMemory( &m_rendererInfo, sizeof( m_rendererInfo ) );
         RtlZeroMemory( &m_mouseInfo, sizeof( m_mouseInfo ) );
-        RtlZeroMemory( &m_tempMouseBuffer, sizeof( m_tempMouseBuffer ) );
         RtlZeroMemory( &m_desktopOutputDesc, sizeof( m_desktopOutputDesc ) );
     }
 
@@ -925,6 +874,10 @@ namespace nsDXGI
         }
         ipDxgiDevice = nullptr;
 
+        // keep the factory, IsCurrent() tells when the enumeration below became stale
+        m_ipDxgiFactory = nullptr;
+        ipDxgiAdapter->GetParent( IID_PPV_ARGS( &m_ipDxgiFactory ) );
+
         CComPtr<IDXGIOutput> ipDxgiOutput;
         for( UINT i = 0; SUCCEEDED( hr ); ++i )
         {
@@ -1160,6 +1113,8 @@ namespace nsDXGI
 
             m_ipDxgiOutputDuplication = ipDxgiOutputDuplication;
             m_ipCopyTexture2D = ipCopyTexture2D;
+            m_frameCache.Reset( QSize( rendererInfo.SrcBounds.Width, rendererInfo.SrcBounds.Height ) );
+            m_bRenderCurrent = FALSE;
 
             m_ipD2D1Device = ipD2D1Device;
             m_ipD2D1Factory = ipD2D1Factory;
@@ -1175,6 +1130,18 @@ namespace nsDXGI
     {
         m_ipDxgiOutputDuplication = nullptr;
         m_ipCopyTexture2D = nullptr;
+        m_ipMirrorTexture2D = nullptr;
+        m_bMirrorValid = FALSE;
+        m_lastFrameReason = nsCapture::tagFrameReason_None;
+
+        m_frameCache.Invalidate();
+        m_metadataBuffer.clear();
+        m_bRenderCurrent = FALSE;
+        m_lastOutputImage = QImage();
+        m_rotatedImage = QImage();
+        m_ullRotatedSerial = 0;
+        m_scaledImage = QImage();
+        m_ullScaledSerial = 0;
 
         m_ipD2D1Device = nullptr;
         m_ipD2D1Factory = nullptr;
@@ -1193,123 +1160,471 @@ namespace nsDXGI
         }
         RtlZeroMemory( &m_mouseInfo, sizeof( m_mouseInfo ) );
 
-        // clear temp temp buffer
-        if( m_tempMouseBuffer.Buffer != nullptr )
-        {
-            delete[] m_tempMouseBuffer.Buffer;
-            m_tempMouseBuffer.Buffer = nullptr;
-        }
-        RtlZeroMemory( &m_tempMouseBuffer, sizeof( m_tempMouseBuffer ) );
+        // processed cursor shapes
+        m_cursorCache.Clear();
 
         // clear desktop output desc
         RtlZeroMemory( &m_desktopOutputDesc, sizeof( m_desktopOutputDesc ) );
     }
 
-    HRESULT CDXGICapture::captureFrame( BOOL* pRetIsTimeout, UINT* pRetRenderDuration )
+    HRESULT CDXGICapture::collectFrameRects( const DXGI_OUTDUPL_FRAME_INFO* pFrameInfo, nsKernel::tagFrameDelta* pRetDelta )
     {
-        AUTOLOCK();
-        HRESULT hRet = S_OK;
+        CHECK_POINTER( pRetDelta );
+        pRetDelta->Moves.clear();
+        pRetDelta->Dirty.clear();
+        CHECK_POINTER_EX( pFrameInfo, E_INVALIDARG );
 
-        do
+        // no metadata for this present, the caller copies the whole image
+        if( pFrameInfo->TotalMetadataBufferSize == 0 )
         {
-            if( nullptr != pRetIsTimeout )
-                *pRetIsTimeout = FALSE;
+            return S_FALSE;
+        }
 
-            if( nullptr != pRetRenderDuration )
-                *pRetRenderDuration = 0xFFFFFFFF;
+        if( m_metadataBuffer.size() < pFrameInfo->TotalMetadataBufferSize )
+        {
+            m_metadataBuffer.resize( pFrameInfo->TotalMetadataBufferSize );
+        }
 
-            if( !m_bInitialized )
-            {
-                hRet = D2DERR_NOT_INITIALIZED;
-                break;
-            }
-            if( nullptr == ( m_ipDxgiOutputDuplication ) )
-            {
-                hRet = E_INVALIDARG;
-                break;
-            }
+        HRESULT hr = S_OK;
+        UINT uiBufferSize = ( UINT )m_metadataBuffer.size();
+        UINT uiMoveBytes = 0;
+        UINT uiDirtyBytes = 0;
 
-            hRet = DXGICaptureHelper::IsRendererInfoValid( &m_rendererInfo );
-            if( FAILED( hRet ) )
-                break;
+        DXGI_OUTDUPL_MOVE_RECT* pMoveRects = reinterpret_cast< DXGI_OUTDUPL_MOVE_RECT* >( m_metadataBuffer.data() );
+        hr = m_ipDxgiOutputDuplication->GetFrameMoveRects( uiBufferSize, pMoveRects, &uiMoveBytes );
+        CHECK_HR_RETURN( hr );
 
-            DXGI_OUTDUPL_FRAME_INFO     FrameInfo;
-            CComPtr<IDXGIResource>      ipDesktopResource;
-            CComPtr<ID3D11Texture2D>    ipAcquiredDesktopImage;
-            CComPtr<ID2D1Bitmap>        ipD2D1SourceBitmap;
+        RECT* pDirtyRects = reinterpret_cast< RECT* >( m_metadataBuffer.data() + uiMoveBytes );
+        hr = m_ipDxgiOutputDuplication->GetFrameDirtyRects( uiBufferSize - uiMoveBytes, pDirtyRects, &uiDirtyBytes );
+        CHECK_HR_RETURN( hr );
 
-            std::chrono::high_resolution_clock::time_point startTick;
-            if( nullptr != pRetRenderDuration )
-            {
-                startTick = std::chrono::high_resolution_clock::now();
-            }
+        const UINT uiMoveCount = uiMoveBytes / sizeof( DXGI_OUTDUPL_MOVE_RECT );
+        const UINT uiDirtyCount = uiDirtyBytes / sizeof( RECT );
+        pRetDelta->Moves.reserve( uiMoveCount );
+        pRetDelta->Dirty.reserve( uiDirtyCount );
+
+        // moves are replayed inside the CPU copy, they cost no readback
+        for( UINT i = 0; i < uiMoveCount; ++i )
+        {
+            const DXGI_OUTDUPL_MOVE_RECT& move = pMoveRects[ i ];
+            nsKernel::tagMoveRect moveRect;
+            moveRect.SourceX                = move.SourcePoint.x;
+            moveRect.SourceY                = move.SourcePoint.y;
+            moveRect.Destination.Left       = move.DestinationRect.left;
+            moveRect.Destination.Top        = move.DestinationRect.top;
+            moveRect.Destination.Right      = move.DestinationRect.right;
+            moveRect.Destination.Bottom     = move.DestinationRect.bottom;
+            pRetDelta->Moves.push_back( moveRect );
+        }
+
+        for( UINT i = 0; i < uiDirtyCount; ++i )
+        {
+            const RECT& rcDirty = pDirtyRects[ i ];
+            pRetDelta->Dirty.push_back( nsKernel::tagPixelRect{ rcDirty.left, rcDirty.top, rcDirty.right, rcDirty.bottom } );
+        }
+
+        return S_OK;
+    }
+
+    HRESULT CDXGICapture::refreshFrameCache( UINT uiTimeoutMs, nsCapture::tagFrameReason* pRetReason )
+    {
+        CHECK_POINTER( pRetReason );
+        *pRetReason = nsCapture::tagFrameReason_None;
+
+        AUTOLOCK();
+        if( !m_bInitialized )
+        {
+            return D2DERR_NOT_INITIALIZED;
+        }
+        CHECK_POINTER_EX( m_ipDxgiOutputDuplication, E_INVALIDARG );
+        CHECK_POINTER_EX( m_ipCopyTexture2D, E_INVALIDARG );
 
-            while( true )
+        HRESULT hRet = S_OK;
+        const BOOL bHasCache = m_frameCache.IsValid() ? TRUE : FALSE;
+        // a region read left the last present on the GPU, a static desktop is served from there
+        const BOOL bHasMirror = ( !bHasCache && m_bMirrorValid ) ? TRUE : FALSE;
+
+        CDXGIDuplicationSource source( m_ipDxgiOutputDuplication,
+                                       m_rendererInfo.ShowCursor ? &m_mouseInfo : nullptr,
+                                       ( UINT )m_rendererInfo.MonitorIdx,
+                                       m_desktopOutputDesc.DesktopCoordinates.left,
+                                       m_desktopOutputDesc.DesktopCoordinates.top );
+        nsCapture::CFrameAcquirer acquirer( &source );
+        nsCapture::CTraceSpan acquireSpan( nsCapture::tagTraceStage_Acquire );
+        const nsCapture::tagAcquireResult acquired = acquirer.Acquire( std::chrono::milliseconds( uiTimeoutMs ), bHasCache || bHasMirror );
+        acquireSpan.End();
+        *pRetReason = acquired.Reason;
+
+        switch( acquired.Reason )
+        {
+            case nsCapture::tagFrameReason_Fresh:
             {
-                // Get new frame
-                m_ipDxgiOutputDuplication->ReleaseFrame();
-                Sleep( 50 );
-                hRet = m_ipDxgiOutputDuplication->AcquireNextFrame( 1000, &FrameInfo, &ipDesktopResource );
-                if( FAILED( hRet ) )
+                // QI for ID3D11Texture2D
+                CComPtr<ID3D11Texture2D> ipAcquiredDesktopImage;
+                hRet = source.Resource()->QueryInterface( IID_PPV_ARGS( &ipAcquiredDesktopImage ) );
+                if( FAILED( hRet ) || nullptr == ipAcquiredDesktopImage )
+                {
+                    // release frame
+                    source.ReleaseFrame();
+                    return FAILED( hRet ) ? hRet : E_OUTOFMEMORY;
+                }
+
+                // move / dirty rects are only valid while the frame is held
+                nsKernel::tagFrameDelta frameDelta;
+                std::vector< nsKernel::tagPixelRect > vecPlanned;
+                BOOL bIsFull = TRUE;
+                if( bHasCache )
+                {
+                    hRet = collectFrameRects( source.FrameInfo(), &frameDelta );
+                    bIsFull = ( FAILED( hRet ) || hRet == S_FALSE ) ? TRUE : FALSE;
+                }
+
+                nsCapture::CTraceSpan copySpan( nsCapture::tagTraceStage_GpuCopy );
+                if( bIsFull )
+                {
+                    m_ipD3D11DeviceContext->CopyResource( m_ipCopyTexture2D, ipAcquiredDesktopImage );
+                }
+                else
                 {
-                    if( hRet != DXGI_ERROR_WAIT_TIMEOUT )
+                    // only the coalesced dirty rects are read back, the cache reads exactly the same rects
+                    vecPlanned = m_frameCache.Plan( frameDelta );
+                    for( const auto& rc : vecPlanned )
                     {
-                        if( ipDesktopResource )
-                        {
-                            ipDesktopResource.Release();
-                        }
+                        D3D11_BOX box;
+                        box.left    = ( UINT )rc.Left;
+                        box.top     = ( UINT )rc.Top;
+                        box.front   = 0;
+                        box.right   = ( UINT )rc.Right;
+                        box.bottom  = ( UINT )rc.Bottom;
+                        box.back    = 1;
+                        m_ipD3D11DeviceContext->CopySubresourceRegion( m_ipCopyTexture2D, 0, box.left, box.top, 0, ipAcquiredDesktopImage, 0, &box );
                     }
-                    continue;
                 }
+                ipAcquiredDesktopImage = nullptr;
+                copySpan.End();
 
-                if( FrameInfo.LastPresentTime.QuadPart )
-                    break;
+                // release frame
+                source.ReleaseFrame();
 
-            }
+                // Map waits for the copies queued above, the span covers that wait and the cache update
+                nsCapture::CTraceSpan mapSpan( nsCapture::tagTraceStage_Map );
+                D3D11_MAPPED_SUBRESOURCE mapped;
+                hRet = m_ipD3D11DeviceContext->Map( m_ipCopyTexture2D, 0, D3D11_MAP_READ, 0, &mapped );
+                if( FAILED( hRet ) )
+                {
+                    m_frameCache.Invalidate();
+                    return hRet;
+                }
 
-            // QI for ID3D11Texture2D
-            hRet = ipDesktopResource->QueryInterface( IID_PPV_ARGS( &ipAcquiredDesktopImage ) );
-            ipDesktopResource = nullptr;
-            CHECK_HR_RETURN( hRet );
+                const qint64 llPresentTime = source.FrameInfo()->LastPresentTime.QuadPart;
+                if( bIsFull )
+                    m_frameCache.Store( static_cast< const uchar* >( mapped.pData ), ( int )mapped.RowPitch, llPresentTime );
+                else
+                    m_frameCache.Update( frameDelta, vecPlanned, static_cast< const uchar* >( mapped.pData ), ( int )mapped.RowPitch, llPresentTime );
 
-            if( nullptr == ipAcquiredDesktopImage )
-            {
-                // release frame
-                m_ipDxgiOutputDuplication->ReleaseFrame();
-                return E_OUTOFMEMORY;
-            }
+                m_ipD3D11DeviceContext->Unmap( m_ipCopyTexture2D, 0 );
+                m_frameCache.RecordMiss();
+                m_bMirrorValid = FALSE;
+            } break;
 
-            // Copy needed full part of desktop image
-            m_ipD3D11DeviceContext->CopyResource( m_ipCopyTexture2D, ipAcquiredDesktopImage );
-            if( m_rendererInfo.ShowCursor )
+            case nsCapture::tagFrameReason_Cached:
             {
-                hRet = DXGICaptureHelper::GetMouse( m_ipDxgiOutputDuplication, &m_mouseInfo, &FrameInfo, ( UINT )m_rendererInfo.MonitorIdx, m_desktopOutputDesc.DesktopCoordinates.left, m_desktopOutputDesc.DesktopCoordinates.top );
-                if( SUCCEEDED( hRet ) && m_mouseInfo.Visible )
+                if( !bHasMirror )
                 {
-                    hRet = DXGICaptureHelper::DrawMouse( &m_mouseInfo, &m_desktopOutputDesc, &m_tempMouseBuffer, m_ipCopyTexture2D );
+                    // static desktop, the cached image is still current
+                    m_frameCache.MarkVerified();
+                    m_frameCache.RecordHit();
+                    break;
                 }
 
-                if( FAILED( hRet ) )
+                // static desktop after region reads : the mirrored present becomes the cached frame
                 {
-                    // release frame
-                    m_ipDxgiOutputDuplication->ReleaseFrame();
-                    return hRet;
+                    nsCapture::CTraceSpan copySpan( nsCapture::tagTraceStage_GpuCopy );
+                    m_ipD3D11DeviceContext->CopyResource( m_ipCopyTexture2D, m_ipMirrorTexture2D );
                 }
-            }
 
-            // release frame
-            hRet = m_ipDxgiOutputDuplication->ReleaseFrame();
-            CHECK_HR_RETURN( hRet );
+                nsCapture::CTraceSpan mapSpan( nsCapture::tagTraceStage_Map );
+                D3D11_MAPPED_SUBRESOURCE mapped;
+                hRet = m_ipD3D11DeviceContext->Map( m_ipCopyTexture2D, 0, D3D11_MAP_READ, 0, &mapped );
+                CHECK_HR_RETURN( hRet );
 
-            // create D2D1 source bitmap
-            hRet = DXGICaptureHelper::CreateBitmap( m_ipD2D1RenderTarget, m_ipCopyTexture2D, &ipD2D1SourceBitmap );
-            CHECK_HR_RETURN( hRet );
+                m_frameCache.Store( static_cast< const uchar* >( mapped.pData ), ( int )mapped.RowPitch, m_llMirrorPresentTime );
+                m_ipD3D11DeviceContext->Unmap( m_ipCopyTexture2D, 0 );
+                m_frameCache.RecordMiss();
+                m_bMirrorValid = FALSE;
+            } break;
 
-            D2D1_RECT_F rcSource = D2D1::RectF( ( FLOAT )m_rendererInfo.SrcBounds.X,
-                                                ( FLOAT )m_rendererInfo.SrcBounds.Y,
-                                                ( FLOAT )( m_rendererInfo.SrcBounds.X + m_rendererInfo.SrcBounds.Width ),
-                                                ( FLOAT )( m_rendererInfo.SrcBounds.Y + m_rendererInfo.SrcBounds.Height ) );
-            D2D1_RECT_F rcTarget = D2D1::RectF( ( FLOAT )m_rendererInfo.DstBounds.X,
+            case nsCapture::tagFrameReason_Timeout:
+                return S_FALSE;
+
+            case nsCapture::tagFrameReason_AccessLost:
+                m_frameCache.Invalidate();
+                m_bMirrorValid = FALSE;
+                return DXGI_ERROR_ACCESS_LOST;
+
+            default:
+                return FAILED( source.LastError() ) ? source.LastError() : E_FAIL;
+        }
+
+        return S_OK;
+    }
+
+    HRESULT CDXGICapture::readRegion( const nsKernel::tagPixelRect& rcRegion, BYTE* pDstBits, UINT uiDstPitch, nsCapture::tagFrameReason* pRetReason )
+    {
+        CHECK_POINTER( pRetReason );
+        *pRetReason = nsCapture::tagFrameReason_None;
+        CHECK_POINTER( pDstBits );
+
+        AUTOLOCK();
+        if( !m_bInitialized )
+        {
+            return D2DERR_NOT_INITIALIZED;
+        }
+        CHECK_POINTER_EX( m_ipDxgiOutputDuplication, E_INVALIDARG );
+        CHECK_POINTER_EX( m_ipCopyTexture2D, E_INVALIDARG );
+
+        HRESULT hRet = S_OK;
+        if( nullptr == m_ipMirrorTexture2D )
+        {
+            // layout of the staging texture, without CPU access
+            D3D11_TEXTURE2D_DESC desc;
+            m_ipCopyTexture2D->GetDesc( &desc );
+            desc.CPUAccessFlags = 0;
+            desc.Usage = D3D11_USAGE_DEFAULT;
+
+            hRet = m_ipD3D11Device->CreateTexture2D( &desc, NULL, &m_ipMirrorTexture2D );
+            CHECK_HR_RETURN( hRet );
+            m_bMirrorValid = FALSE;
+        }
+
+        CDXGIDuplicationSource source( m_ipDxgiOutputDuplication,
+                                       m_rendererInfo.ShowCursor ? &m_mouseInfo : nullptr,
+                                       ( UINT )m_rendererInfo.MonitorIdx,
+                                       m_desktopOutputDesc.DesktopCoordinates.left,
+                                       m_desktopOutputDesc.DesktopCoordinates.top );
+        nsCapture::CFrameAcquirer acquirer( &source );
+        nsCapture::CTraceSpan acquireSpan( nsCapture::tagTraceStage_Acquire );
+        const nsCapture::tagAcquireResult acquired = acquirer.Acquire( std::chrono::milliseconds( m_bMirrorValid ? 0 : m_uiAcquireTimeoutMs ), m_bMirrorValid != FALSE );
+        acquireSpan.End();
+        *pRetReason = acquired.Reason;
+
+        switch( acquired.Reason )
+        {
+            case nsCapture::tagFrameReason_Fresh:
+            {
+                CComPtr<ID3D11Texture2D> ipAcquiredDesktopImage;
+                hRet = source.Resource()->QueryInterface( IID_PPV_ARGS( &ipAcquiredDesktopImage ) );
+                if( FAILED( hRet ) || nullptr == ipAcquiredDesktopImage )
+                {
+                    // release frame
+                    source.ReleaseFrame();
+                    return FAILED( hRet ) ? hRet : E_OUTOFMEMORY;
+                }
+
+                // the whole present stays on the GPU ( no dirty rects without a cache ), a later full capture reads it from there
+                nsCapture::CTraceSpan copySpan( nsCapture::tagTraceStage_GpuCopy );
+                m_ipD3D11DeviceContext->CopyResource( m_ipMirrorTexture2D, ipAcquiredDesktopImage );
+                ipAcquiredDesktopImage = nullptr;
+                copySpan.End();
+
+                // release frame
+                source.ReleaseFrame();
+
+                m_bMirrorValid = TRUE;
+                m_llMirrorPresentTime = source.FrameInfo()->LastPresentTime.QuadPart;
+                m_frameCache.RecordMiss();
+            } break;
+
+            case nsCapture::tagFrameReason_Cached:
+                m_frameCache.RecordHit();
+                break;
+
+            case nsCapture::tagFrameReason_Timeout:
+                return S_FALSE;
+
+            case nsCapture::tagFrameReason_AccessLost:
+                m_frameCache.Invalidate();
+                m_bMirrorValid = FALSE;
+                return DXGI_ERROR_ACCESS_LOST;
+
+            default:
+                return FAILED( source.LastError() ) ? source.LastError() : E_FAIL;
+        }
+
+        // only the region crosses to the CPU
+        D3D11_BOX box;
+        box.left    = ( UINT )rcRegion.Left;
+        box.top     = ( UINT )rcRegion.Top;
+        box.front   = 0;
+        box.right   = ( UINT )rcRegion.Right;
+        box.bottom  = ( UINT )rcRegion.Bottom;
+        box.back    = 1;
+        {
+            nsCapture::CTraceSpan copySpan( nsCapture::tagTraceStage_GpuCopy );
+            m_ipD3D11DeviceContext->CopySubresourceRegion( m_ipCopyTexture2D, 0, box.left, box.top, 0, m_ipMirrorTexture2D, 0, &box );
+        }
+
+        nsCapture::CTraceSpan mapSpan( nsCapture::tagTraceStage_Map );
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        hRet = m_ipD3D11DeviceContext->Map( m_ipCopyTexture2D, 0, D3D11_MAP_READ, 0, &mapped );
+        CHECK_HR_RETURN( hRet );
+
+        const size_t cbRow = ( size_t )( rcRegion.Right - rcRegion.Left ) * 4;
+        const BYTE* pSrcBits = static_cast< const BYTE* >( mapped.pData ) + ( size_t )rcRegion.Top * mapped.RowPitch + ( size_t )rcRegion.Left * 4;
+        for( int32_t y = rcRegion.Top; y < rcRegion.Bottom; ++y )
+        {
+            memcpy( pDstBits, pSrcBits, cbRow );
+            pDstBits += uiDstPitch;
+            pSrcBits += mapped.RowPitch;
+        }
+
+        m_ipD3D11DeviceContext->Unmap( m_ipCopyTexture2D, 0 );
+        m_ullOutputBytes += ( quint64 )cbRow * ( rcRegion.Bottom - rcRegion.Top );
+        return S_OK;
+    }
+
+    HRESULT CDXGICapture::captureFrame( BOOL* pRetIsTimeout, UINT* pRetRenderDuration, QImage* pRetDirectFrame, BOOL* pRetCursorPending )
+    {
+        AUTOLOCK();
+        HRESULT hRet = S_OK;
+
+        do
+        {
+            if( nullptr != pRetIsTimeout )
+                *pRetIsTimeout = FALSE;
+
+            if( nullptr != pRetRenderDuration )
+                *pRetRenderDuration = 0xFFFFFFFF;
+
+            if( nullptr != pRetCursorPending )
+                *pRetCursorPending = FALSE;
+
+            if( !m_bInitialized )
+            {
+                hRet = D2DERR_NOT_INITIALIZED;
+                break;
+            }
+            if( nullptr == ( m_ipDxgiOutputDuplication ) )
+            {
+                hRet = E_INVALIDARG;
+                break;
+            }
+
+            hRet = DXGICaptureHelper::IsRendererInfoValid( &m_rendererInfo );
+            if( FAILED( hRet ) )
+                break;
+
+            CComPtr<ID2D1Bitmap>        ipD2D1SourceBitmap;
+
+            std::chrono::steady_clock::time_point startTick;
+            if( nullptr != pRetRenderDuration )
+            {
+                startTick = std::chrono::steady_clock::now();
+            }
+
+            nsCapture::tagFrameReason reason = nsCapture::tagFrameReason_None;
+            if( m_frameCache.IsWithinStaleness( ( int )m_uiMaxStalenessMs ) )
+            {
+                // checked recently enough, the duplication is not touched at all
+                reason = nsCapture::tagFrameReason_Cached;
+                m_frameCache.RecordHit();
+            }
+            else
+            {
+                // the cache holds every present up to now, so only a full miss has to wait for one
+                hRet = refreshFrameCache( ( m_frameCache.IsValid() || m_bMirrorValid ) ? 0 : m_uiAcquireTimeoutMs, &reason );
+            }
+            m_lastFrameReason = reason;
+
+            if( FAILED( hRet ) )
+            {
+                return hRet;
+            }
+            if( reason == nsCapture::tagFrameReason_Timeout )
+            {
+                if( nullptr != pRetIsTimeout )
+                {
+                    *pRetIsTimeout = TRUE;
+                }
+                return S_FALSE;
+            }
+
+            const BOOL bDrawCursor = ( m_rendererInfo.ShowCursor && m_mouseInfo.Visible ) ? TRUE : FALSE;
+            const nsKernel::tagRotation rotation = nullptr != pRetDirectFrame ? directRotation() : nsKernel::tagRotation_Invalid;
+            nsKernel::tagRotation scaledRotation = nsKernel::tagRotation_Invalid;
+            nsKernel::tagPixelRect scaledTarget;
+            if( nullptr != pRetDirectFrame && rotation == nsKernel::tagRotation_Invalid && !scaledPlacement( &scaledRotation, &scaledTarget ) )
+            {
+                scaledRotation = nsKernel::tagRotation_Invalid;
+            }
+
+            if( rotation == nsKernel::tagRotation_0 )
+            {
+                // identity output : the cached frame already is the final image, the caller composes the cursor
+                *pRetDirectFrame = m_frameCache.Image();
+                RESET_POINTER_EX( pRetCursorPending, bDrawCursor );
+                ++m_ullDirectFrames;
+            }
+            else if( rotation != nsKernel::tagRotation_Invalid )
+            {
+                // quarter turns at unit scale : CPU rotation of the cached frame, the cursor goes in before rotating
+                hRet = rotateFrame( rotation, bDrawCursor );
+                CHECK_HR_RETURN( hRet );
+
+                *pRetDirectFrame = m_rotatedImage;
+                ++m_ullDirectFrames;
+            }
+            else if( scaledRotation != nsKernel::tagRotation_Invalid )
+            {
+                // zoom, stretch and letterboxed outputs : CPU resampling instead of LINEAR DrawBitmap
+                hRet = scaleFrame( scaledRotation, scaledTarget, bDrawCursor );
+                CHECK_HR_RETURN( hRet );
+
+                *pRetDirectFrame = m_scaledImage;
+                ++m_ullDirectFrames;
+            }
+
+            if( rotation != nsKernel::tagRotation_Invalid || scaledRotation != nsKernel::tagRotation_Invalid )
+            {
+                if( nullptr != pRetRenderDuration )
+                {
+                    *pRetRenderDuration = ( UINT )std::chrono::duration_cast< std::chrono::milliseconds >( std::chrono::steady_clock::now() - startTick ).count();
+                }
+                return S_OK;
+            }
+
+            // render target already holds this exact image
+            if( !bDrawCursor && m_bRenderCurrent && m_ullRenderedSerial == m_frameCache.Serial() )
+            {
+                if( nullptr != pRetRenderDuration )
+                {
+                    *pRetRenderDuration = ( UINT )std::chrono::duration_cast< std::chrono::milliseconds >( std::chrono::steady_clock::now() - startTick ).count();
+                }
+                return S_OK;
+            }
+
+            nsCapture::CTraceSpan renderSpan( nsCapture::tagTraceStage_Render );
+
+            // the cursor goes on a detached copy, the cached image stays clean
+            QImage frameImage = m_frameCache.Image();
+            if( bDrawCursor )
+            {
+                m_ullOutputBytes += ( quint64 )frameImage.sizeInBytes();
+                hRet = composeCursor( frameImage.bits(), ( INT )frameImage.bytesPerLine(), frameImage.width(), frameImage.height() );
+                CHECK_HR_RETURN( hRet );
+            }
+
+            // create D2D1 source bitmap
+            hRet = DXGICaptureHelper::CreateBitmapFromMemory( m_ipD2D1RenderTarget, frameImage.constBits(), ( UINT )frameImage.bytesPerLine(),
+                                                              ( UINT )frameImage.width(), ( UINT )frameImage.height(), &ipD2D1SourceBitmap );
+            CHECK_HR_RETURN( hRet );
+            m_ullOutputBytes += ( quint64 )frameImage.sizeInBytes();
+
+            D2D1_RECT_F rcSource = D2D1::RectF( ( FLOAT )m_rendererInfo.SrcBounds.X,
+                                                ( FLOAT )m_rendererInfo.SrcBounds.Y,
+                                                ( FLOAT )( m_rendererInfo.SrcBounds.X + m_rendererInfo.SrcBounds.Width ),
+                                                ( FLOAT )( m_rendererInfo.SrcBounds.Y + m_rendererInfo.SrcBounds.Height ) );
+            D2D1_RECT_F rcTarget = D2D1::RectF( ( FLOAT )m_rendererInfo.DstBounds.X,
                                                 ( FLOAT )m_rendererInfo.DstBounds.Y,
                                                 ( FLOAT )( m_rendererInfo.DstBounds.X + m_rendererInfo.DstBounds.Width ),
                                                 ( FLOAT )( m_rendererInfo.DstBounds.Y + m_rendererInfo.DstBounds.Height ) );
@@ -1340,13 +1655,19 @@ namespace nsDXGI
             hRet = m_ipD2D1RenderTarget->EndDraw();
             if( FAILED( hRet ) )
             {
+                m_bRenderCurrent = FALSE;
                 return hRet;
             }
 
+            m_bRenderCurrent = bDrawCursor ? FALSE : TRUE;
+            m_ullRenderedSerial = m_frameCache.Serial();
+            ++m_ullRenderGeneration;
+            ++m_ullRenderedFrames;
+
             // calculate render time without save
             if( nullptr != pRetRenderDuration )
             {
-                *pRetRenderDuration = ( UINT )( ( std::chrono::high_resolution_clock::now() - startTick ).count() / 10000 );
+                *pRetRenderDuration = ( UINT )std::chrono::duration_cast< std::chrono::milliseconds >( std::chrono::steady_clock::now() - startTick ).count();
             }
 
             hRet = S_OK;
@@ -1356,11 +1677,206 @@ namespace nsDXGI
         return hRet;
     }
 
+    nsKernel::tagRotation CDXGICapture::directRotation() const
+    {
+        if( m_rendererInfo.ScaleX != 1.0f || m_rendererInfo.ScaleY != 1.0f )
+            return nsKernel::tagRotation_Invalid;
+
+        const nsKernel::tagRotation rotation = nsKernel::RotationFromDegrees( m_rendererInfo.RotationDegrees );
+        if( rotation == nsKernel::tagRotation_Invalid )
+            return nsKernel::tagRotation_Invalid;
+
+        const QSize frameSize = m_frameCache.Size();
+        if( frameSize.width() != m_rendererInfo.SrcBounds.Width || frameSize.height() != m_rendererInfo.SrcBounds.Height )
+            return nsKernel::tagRotation_Invalid;
+
+        // the rotated frame must fill the output exactly, anything else needs the render target ( letterbox, offset )
+        int32_t iWidth = 0, iHeight = 0;
+        nsKernel::RotatedSize( rotation, frameSize.width(), frameSize.height(), &iWidth, &iHeight );
+        if( ( INT )m_rendererInfo.OutputSize.Width != iWidth || ( INT )m_rendererInfo.OutputSize.Height != iHeight )
+            return nsKernel::tagRotation_Invalid;
+
+        if( rotation == nsKernel::tagRotation_0 && ( m_rendererInfo.DstBounds.X != 0 || m_rendererInfo.DstBounds.Y != 0 ) )
+            return nsKernel::tagRotation_Invalid;
+
+        return rotation;
+    }
+
+    HRESULT CDXGICapture::rotateFrame( nsKernel::tagRotation rotation, BOOL bDrawCursor )
+    {
+        // rotated image of this exact cache state is still current
+        if( !bDrawCursor && !m_rotatedImage.isNull() && m_ullRotatedSerial == m_frameCache.Serial() )
+            return S_OK;
+
+        nsCapture::CTraceSpan renderSpan( nsCapture::tagTraceStage_Render );
+        QImage source = m_frameCache.Image();
+        if( bDrawCursor )
+        {
+            m_ullOutputBytes += ( quint64 )source.sizeInBytes();
+            HRESULT hRet = composeCursor( source.bits(), ( INT )source.bytesPerLine(), source.width(), source.height() );
+            CHECK_HR_RETURN( hRet );
+        }
+
+        int32_t iWidth = 0, iHeight = 0;
+        nsKernel::RotatedSize( rotation, source.width(), source.height(), &iWidth, &iHeight );
+
+        // an image still referenced by a consumer is replaced, not detached ( detaching would copy the old pixels )
+        if( m_rotatedImage.size() != QSize( iWidth, iHeight ) || !m_rotatedImage.isDetached() )
+            m_rotatedImage = QImage( iWidth, iHeight, QImage::Format_ARGB32_Premultiplied );
+        if( m_rotatedImage.isNull() )
+            return E_OUTOFMEMORY;
+
+        nsKernel::tagSurface src;
+        src.Bits    = const_cast< uint8_t* >( source.constBits() );
+        src.Width   = source.width();
+        src.Height  = source.height();
+        src.Pitch   = source.bytesPerLine();
+
+        nsKernel::tagSurface dst;
+        dst.Bits    = m_rotatedImage.bits();
+        dst.Width   = m_rotatedImage.width();
+        dst.Height  = m_rotatedImage.height();
+        dst.Pitch   = m_rotatedImage.bytesPerLine();
+
+        if( !nsKernel::RotateSurface( dst, src, rotation ) )
+            return E_FAIL;
+
+        m_ullOutputBytes += ( quint64 )m_rotatedImage.sizeInBytes();
+        m_ullRotatedSerial = bDrawCursor ? 0 : m_frameCache.Serial();
+        return S_OK;
+    }
+
+    BOOL CDXGICapture::scaledPlacement( nsKernel::tagRotation* pRetRotation, nsKernel::tagPixelRect* pRetTarget ) const
+    {
+        const nsKernel::tagRotation rotation = nsKernel::RotationFromDegrees( m_rendererInfo.RotationDegrees );
+        if( rotation == nsKernel::tagRotation_Invalid || m_rendererInfo.ScaleX <= 0.0f || m_rendererInfo.ScaleY <= 0.0f )
+            return FALSE;
+
+        // DrawBitmap takes the whole cached frame, a cropped source still goes through the render target
+        const QSize frameSize = m_frameCache.Size();
+        if( frameSize.width() != m_rendererInfo.SrcBounds.Width || frameSize.height() != m_rendererInfo.SrcBounds.Height )
+            return FALSE;
+        if( m_rendererInfo.DstBounds.Width <= 0 || m_rendererInfo.DstBounds.Height <= 0 )
+            return FALSE;
+
+        // centre of DstBounds relative to the output centre, through the same rotation and scale as the D2D transform
+        const FLOAT fCenterX = m_rendererInfo.OutputSize.Width / 2.0f;
+        const FLOAT fCenterY = m_rendererInfo.OutputSize.Height / 2.0f;
+        const FLOAT fOffsetX = m_rendererInfo.DstBounds.X + m_rendererInfo.DstBounds.Width / 2.0f - fCenterX;
+        const FLOAT fOffsetY = m_rendererInfo.DstBounds.Y + m_rendererInfo.DstBounds.Height / 2.0f - fCenterY;
+
+        FLOAT fTurnedX = fOffsetX, fTurnedY = fOffsetY;
+        switch( rotation )
+        {
+            case nsKernel::tagRotation_90:  fTurnedX = -fOffsetY;   fTurnedY = fOffsetX;    break;
+            case nsKernel::tagRotation_180: fTurnedX = -fOffsetX;   fTurnedY = -fOffsetY;   break;
+            case nsKernel::tagRotation_270: fTurnedX = fOffsetY;    fTurnedY = -fOffsetX;   break;
+            default:                                                                        break;
+        }
+
+        int32_t iWidth = 0, iHeight = 0;
+        nsKernel::RotatedSize( rotation, m_rendererInfo.DstBounds.Width, m_rendererInfo.DstBounds.Height, &iWidth, &iHeight );
+
+        const FLOAT fMidX = fCenterX + fTurnedX * m_rendererInfo.ScaleX;
+        const FLOAT fMidY = fCenterY + fTurnedY * m_rendererInfo.ScaleY;
+        const FLOAT fHalfWidth = iWidth * m_rendererInfo.ScaleX / 2.0f;
+        const FLOAT fHalfHeight = iHeight * m_rendererInfo.ScaleY / 2.0f;
+
+        // edges snap to whole pixels, D2D would blend the partial edge pixel into the black background
+        pRetTarget->Left    = ( int32_t )std::lround( fMidX - fHalfWidth );
+        pRetTarget->Top     = ( int32_t )std::lround( fMidY - fHalfHeight );
+        pRetTarget->Right   = ( int32_t )std::lround( fMidX + fHalfWidth );
+        pRetTarget->Bottom  = ( int32_t )std::lround( fMidY + fHalfHeight );
+        if( pRetTarget->IsEmpty() )
+            return FALSE;
+
+        *pRetRotation = rotation;
+        return TRUE;
+    }
+
+    HRESULT CDXGICapture::scaleFrame( nsKernel::tagRotation rotation, const nsKernel::tagPixelRect& target, BOOL bDrawCursor )
+    {
+        // scaled image of this exact cache state is still current ( placement only changes through SetConfig, which resets the device )
+        if( !bDrawCursor && !m_scaledImage.isNull() && m_ullScaledSerial == m_frameCache.Serial() )
+            return S_OK;
+
+        nsCapture::CTraceSpan renderSpan( nsCapture::tagTraceStage_Render );
+        HRESULT hRet = S_OK;
+        QImage source;
+        if( rotation != nsKernel::tagRotation_0 )
+        {
+            hRet = rotateFrame( rotation, bDrawCursor );
+            CHECK_HR_RETURN( hRet );
+            source = m_rotatedImage;
+        }
+        else
+        {
+            source = m_frameCache.Image();
+            if( bDrawCursor )
+            {
+                m_ullOutputBytes += ( quint64 )source.sizeInBytes();
+                hRet = composeCursor( source.bits(), ( INT )source.bytesPerLine(), source.width(), source.height() );
+                CHECK_HR_RETURN( hRet );
+            }
+        }
+
+        const QSize outputSize( ( int )m_rendererInfo.OutputSize.Width, ( int )m_rendererInfo.OutputSize.Height );
+        if( m_scaledImage.size() != outputSize || !m_scaledImage.isDetached() )
+            m_scaledImage = QImage( outputSize, QImage::Format_ARGB32_Premultiplied );
+        if( m_scaledImage.isNull() )
+            return E_OUTOFMEMORY;
+
+        // same background as the render target clear
+        if( target.Left > 0 || target.Top > 0 || target.Right < outputSize.width() || target.Bottom < outputSize.height() )
+            m_scaledImage.fill( 0xFF000000u );
+
+        nsKernel::tagSurface src;
+        src.Bits    = const_cast< uint8_t* >( source.constBits() );
+        src.Width   = source.width();
+        src.Height  = source.height();
+        src.Pitch   = source.bytesPerLine();
+
+        nsKernel::tagSurface dst;
+        dst.Bits    = m_scaledImage.bits();
+        dst.Width   = m_scaledImage.width();
+        dst.Height  = m_scaledImage.height();
+        dst.Pitch   = m_scaledImage.bytesPerLine();
+
+        if( !nsKernel::ResampleSurface( dst, target, src, nsKernel::tagResampleFilter_Auto ) )
+            return E_FAIL;
+
+        m_ullOutputBytes += ( quint64 )m_scaledImage.sizeInBytes();
+        m_ullScaledSerial = bDrawCursor ? 0 : m_frameCache.Serial();
+        return S_OK;
+    }
+
+    HRESULT CDXGICapture::composeCursor( BYTE* pBits, INT iPitch, INT iWidth, INT iHeight, INT iOriginX, INT iOriginY )
+    {
+        if( !m_rendererInfo.ShowCursor || !m_mouseInfo.Visible )
+            return S_OK;
+
+        nsCapture::CTraceSpan cursorSpan( nsCapture::tagTraceStage_Cursor );
+        return DXGICaptureHelper::DrawMouseToBuffer( &m_mouseInfo, &m_desktopOutputDesc, &m_cursorCache, pBits, iPitch, iWidth, iHeight, iOriginX, iOriginY );
+    }
+
     QPixmap CDXGICapture::convertWICBitmapToQPixmap( IWICImagingFactory* pWICImagingFactory, IWICBitmapSource* pWICBitmapSource )
     {
-        if( !pWICBitmapSource )
+        QImage image = convertWICBitmapToQImage( pWICImagingFactory, pWICBitmapSource );
+        if( image.isNull() )
             return QPixmap();
 
+        // 최적화: 메모리 복사를 최소화하기 위해 QPixmap::fromImage()를 사용하여
+        // 변환 과정에서 추가 복사 없이 직접 QPixmap 생성
+        return QPixmap::fromImage( std::move( image ) );
+    }
+
+    QImage CDXGICapture::convertWICBitmapToQImage( IWICImagingFactory* pWICImagingFactory, IWICBitmapSource* pWICBitmapSource )
+    {
+        if( !pWICBitmapSource )
+            return QImage();
+
+        nsCapture::CTraceSpan renderSpan( nsCapture::tagTraceStage_Render );
+
         // 비트맵 크기와 포맷 정보 가져오기
         UINT width = 0, height = 0;
         pWICBitmapSource->GetSize( &width, &height );
@@ -1368,87 +1884,82 @@ namespace nsDXGI
         WICPixelFormatGUID pixelFormat;
         pWICBitmapSource->GetPixelFormat( &pixelFormat );
 
-        // 최적화: QImage 객체를 직접 생성하고 해당 버퍼로 바로 복사
-        // QImage가 자체적으로 메모리를 할당하고 관리함
+        // 출력은 항상 premultiplied BGRA ( 렌더 타겟 포맷 32bppPBGRA 와 동일 )
         QImage image( width, height, QImage::Format_ARGB32_Premultiplied );
 
         if( image.isNull() )
-            return QPixmap();
+            return QImage();
+
+        const UINT stride = ( UINT )image.bytesPerLine();
+        BYTE* pBits = static_cast< BYTE* >( image.bits() );
 
-        // QImage 버퍼에 직접 복사
-        UINT stride = width * 4; // 32bpp = 4 bytes per pixel
+        // 32bpp 포맷은 QImage 버퍼에 직접 복사한 뒤 제자리 변환
+        nsKernel::tagPixelConversion conversions[ 2 ];
+        int conversionCount = 0;
+        BOOL bIsDirect = TRUE;
 
-        // 최적화: 만약 이미 BGRA 형식이라면 변환 없이 직접 복사
-        if( IsEqualGUID( pixelFormat, GUID_WICPixelFormat32bppBGRA ) )
+        if( IsEqualGUID( pixelFormat, GUID_WICPixelFormat32bppPBGRA ) )
         {
-            // 직접 QImage 버퍼로 복사 (convertToFormat을 피함)
-            HRESULT hr = pWICBitmapSource->CopyPixels(
-                nullptr,
-                image.bytesPerLine(),
-                image.bytesPerLine() * height,
-                static_cast< BYTE* >( image.bits() )
-            );
+            // 변환 불필요
+        }
+        else if( IsEqualGUID( pixelFormat, GUID_WICPixelFormat32bppBGRA ) )
+        {
+            conversions[ conversionCount++ ] = nsKernel::tagPixelConversion_Premultiply;
+        }
+        else if( IsEqualGUID( pixelFormat, GUID_WICPixelFormat32bppBGR ) )
+        {
+            conversions[ conversionCount++ ] = nsKernel::tagPixelConversion_Opaque;
+        }
+        else if( IsEqualGUID( pixelFormat, GUID_WICPixelFormat32bppPRGBA ) )
+        {
+            conversions[ conversionCount++ ] = nsKernel::tagPixelConversion_SwapRedBlue;
+        }
+        else if( IsEqualGUID( pixelFormat, GUID_WICPixelFormat32bppRGBA ) )
+        {
+            conversions[ conversionCount++ ] = nsKernel::tagPixelConversion_SwapRedBlue;
+            conversions[ conversionCount++ ] = nsKernel::tagPixelConversion_Premultiply;
+        }
+        else
+        {
+            bIsDirect = FALSE;
+        }
 
+        HRESULT hr = S_OK;
+        if( bIsDirect )
+        {
+            hr = pWICBitmapSource->CopyPixels( nullptr, stride, stride * height, pBits );
             if( FAILED( hr ) )
-                return QPixmap();
+                return QImage();
+
+            for( int idx = 0; idx < conversionCount; ++idx )
+                nsKernel::ConvertPixels( conversions[ idx ], pBits, stride, pBits, stride, ( int32_t )width, ( int32_t )height );
         }
         else
         {
-            // BGRA로 변환이 필요한 경우
-            IWICImagingFactory* pFactory = nullptr;
-            IWICFormatConverter* pConverter = nullptr;
-
-            HRESULT hr = CoCreateInstance(
-                CLSID_WICImagingFactory,
-                nullptr,
-                CLSCTX_INPROC_SERVER,
-                IID_IWICImagingFactory,
-                ( LPVOID* )&pFactory
-            );
+            // 그 외 포맷 ( 24bpp, 64bpp, 팔레트 등 ) 은 이미 가지고 있는 WIC 팩토리의 변환기 사용, 캡처마다 CoCreateInstance 하지 않음
+            if( !pWICImagingFactory )
+                return QImage();
 
+            CComPtr<IWICFormatConverter> ipConverter;
+            hr = pWICImagingFactory->CreateFormatConverter( &ipConverter );
             if( SUCCEEDED( hr ) )
             {
-                hr = pFactory->CreateFormatConverter( &pConverter );
-                if( SUCCEEDED( hr ) )
-                {
-                    hr = pConverter->Initialize(
-                        pWICBitmapSource,
-                        GUID_WICPixelFormat32bppBGRA,
-                        WICBitmapDitherTypeNone,
-                        nullptr,
-                        0.0f,
-                        WICBitmapPaletteTypeCustom
-                    );
-
-                    if( SUCCEEDED( hr ) )
-                    {
-                        // 변환된 데이터를 QImage 버퍼로 직접 복사
-                        hr = pConverter->CopyPixels(
-                            nullptr,
-                            image.bytesPerLine(),
-                            image.bytesPerLine() * height,
-                            static_cast< BYTE* >( image.bits() )
-                        );
-                    }
-                }
-
-                if( pConverter ) pConverter->Release();
-                if( pFactory ) pFactory->Release();
-
-                if( FAILED( hr ) )
-                    return QPixmap();
+                hr = ipConverter->Initialize( pWICBitmapSource,
+                                              GUID_WICPixelFormat32bppPBGRA,
+                                              WICBitmapDitherTypeNone,
+                                              nullptr,
+                                              0.0f,
+                                              WICBitmapPaletteTypeCustom );
             }
+            if( SUCCEEDED( hr ) )
+            {
+                hr = ipConverter->CopyPixels( nullptr, stride, stride * height, pBits );
+            }
+            if( FAILED( hr ) )
+                return QImage();
         }
 
-        // 최적화: rgbSwapped()를 사용하면 추가 메모리 할당이 발생하므로,
-        // BGRA -> RGBA 변환은 Qt의 Format_ARGB32로 해석하여 처리
-        // (Qt에서는 ARGB32 포맷이지만 바이트 순서가 실제로는 BGRA와 일치함)
-
-        // 최적화: 메모리 복사를 최소화하기 위해 QPixmap::fromImage()를 사용하여
-        // 변환 과정에서 추가 복사 없이 직접 QPixmap 생성
-        QPixmap pixmap = QPixmap::fromImage( std::move( image ) );
-
-        return pixmap;
+        return image;
     }
 
     HRESULT CDXGICapture::Initialize()
@@ -1534,6 +2045,7 @@ namespace nsDXGI
 
         m_ipD3D11Device = nullptr;
         m_ipD3D11DeviceContext = nullptr;
+        m_ipDxgiFactory = nullptr;
         m_lD3DFeatureLevel = D3D_FEATURE_LEVEL_INVALID;
 
         freeMonitorInfos();
@@ -1582,6 +2094,85 @@ namespace nsDXGI
         return this->SetConfig( &config );
     }
 
+    HRESULT CDXGICapture::SetShowCursor( BOOL bShowCursor )
+    {
+        AUTOLOCK();
+        if( !m_bInitialized )
+        {
+            return D2DERR_NOT_INITIALIZED;
+        }
+
+        // cursor drawing does not depend on any device resource, no need to rebuild
+        m_config.ShowCursor = bShowCursor;
+        m_rendererInfo.ShowCursor = bShowCursor;
+        return S_OK;
+    }
+
+    HRESULT CDXGICapture::SetAcquireTimeout( UINT uiTimeoutMs )
+    {
+        AUTOLOCK();
+        m_uiAcquireTimeoutMs = uiTimeoutMs;
+        return S_OK;
+    }
+
+    HRESULT CDXGICapture::SetMaxStaleness( UINT uiMaxStalenessMs )
+    {
+        AUTOLOCK();
+        m_uiMaxStalenessMs = uiMaxStalenessMs;
+        return S_OK;
+    }
+
+    HRESULT CDXGICapture::RefreshCache( UINT uiTimeoutMs )
+    {
+        AUTOLOCK();
+        nsCapture::tagFrameReason reason = nsCapture::tagFrameReason_None;
+        HRESULT hr = refreshFrameCache( uiTimeoutMs, &reason );
+        if( SUCCEEDED( hr ) && reason != nsCapture::tagFrameReason_Timeout )
+        {
+            m_lastFrameReason = reason;
+        }
+        return hr;
+    }
+
+    nsCapture::tagFrameCacheStats CDXGICapture::GetCacheStats() const
+    {
+        AUTOLOCK();
+        nsCapture::tagFrameCacheStats stats = m_frameCache.Stats();
+        stats.DirectFrames      = m_ullDirectFrames;
+        stats.RenderedFrames    = m_ullRenderedFrames;
+        stats.OutputBytes       = m_ullOutputBytes;
+        return stats;
+    }
+
+    nsCapture::tagFrameReason CDXGICapture::GetLastFrameReason() const
+    {
+        AUTOLOCK();
+        return m_lastFrameReason;
+    }
+
+    HRESULT CDXGICapture::ReloadMonitorInfos()
+    {
+        AUTOLOCK();
+        if( !m_bInitialized )
+        {
+            return D2DERR_NOT_INITIALIZED;
+        }
+
+        freeMonitorInfos();
+        return loadMonitorInfos( m_ipD3D11Device );
+    }
+
+    BOOL CDXGICapture::IsTopologyCurrent() const
+    {
+        AUTOLOCK();
+        if( !m_bInitialized || nullptr == m_ipDxgiFactory )
+        {
+            return FALSE;
+        }
+
+        return m_ipDxgiFactory->IsCurrent();
+    }
+
     BOOL CDXGICapture::IsInitialized() const
     {
         AUTOLOCK();
@@ -1676,138 +2267,443 @@ namespace nsDXGI
             return hr;
         }
 
-        DXGI_OUTDUPL_FRAME_INFO     FrameInfo;
-        CComPtr<IDXGIResource>      ipDesktopResource;
-        CComPtr<ID3D11Texture2D>    ipAcquiredDesktopImage;
-        CComPtr<ID2D1Bitmap>        ipD2D1SourceBitmap;
+        // qoi / raw : the image CaptureToImage hands out, encoded by the kernels instead of a WIC encoder
+        if( hr == S_FALSE )
+        {
+            const QString filePath = QString::fromWCharArray( lpcwOutputFileName );
+            QImage image;
+            hr = CaptureToImage( &image, pRetIsTimeout, pRetRenderDuration );
+            if( FAILED( hr ) || hr == S_FALSE )
+            {
+                return hr;
+            }
 
-        std::chrono::high_resolution_clock::time_point startTick;
-        if( nullptr != pRetRenderDuration )
+            QSaveFile file( filePath );
+            if( !file.open( QIODevice::WriteOnly ) )
+            {
+                return HRESULT_FROM_WIN32( ERROR_OPEN_FAILED );
+            }
+
+            nsCapture::CTraceSpan encodeSpan( nsCapture::tagTraceStage_Encode );
+            if( !nsCapture::WriteImage( &file, image, QFileInfo( filePath ).suffix().toLower().toLatin1(), -1 ) )
+            {
+                file.cancelWriting();
+                return HRESULT_FROM_WIN32( ERROR_WRITE_FAULT );
+            }
+            encodeSpan.End();
+
+            return file.commit() ? S_OK : HRESULT_FROM_WIN32( ERROR_WRITE_FAULT );
+        }
+
+        // same acquisition and render path as CaptureToPixmap
+        hr = captureFrame( pRetIsTimeout, pRetRenderDuration );
+        if( FAILED( hr ) || hr == S_FALSE )
         {
-            startTick = std::chrono::high_resolution_clock::now();
+            return hr;
         }
 
-        // Get new frame
-        hr = m_ipDxgiOutputDuplication->AcquireNextFrame( 1000, &FrameInfo, &ipDesktopResource );
-        if( hr == DXGI_ERROR_WAIT_TIMEOUT )
+        hr = DXGICaptureHelper::SaveImageToFile( m_ipWICImageFactory, m_ipWICOutputBitmap, lpcwOutputFileName );
+        if( FAILED( hr ) )
         {
-            if( nullptr != pRetIsTimeout )
+            return hr;
+        }
+
+        return S_OK;
+    } // CaptureToFile
+
+    QPixmap CDXGICapture::CaptureToPixmap( LPCWSTR lpcwOutputFileName, BOOL* pRetIsTimeout, UINT* pRetRenderDuration )
+    {
+        QPixmap Pixmap;
+
+        do
+        {
+            QImage image;
+            HRESULT hRet = CaptureToImage( &image, pRetIsTimeout, pRetRenderDuration );
+            if( FAILED( hRet ) || hRet == S_FALSE )
+                break;
+
+            Pixmap = QPixmap::fromImage( std::move( image ) );
+
+        } while( false );
+
+        return Pixmap;
+    }
+
+    HRESULT CDXGICapture::CaptureToImage( QImage* pRetImage, BOOL* pRetIsTimeout, UINT* pRetRenderDuration )
+    {
+        CHECK_POINTER( pRetImage );
+        AUTOLOCK();
+
+        QImage directFrame;
+        BOOL bCursorPending = FALSE;
+        HRESULT hRet = captureFrame( pRetIsTimeout, pRetRenderDuration, &directFrame, &bCursorPending );
+        if( FAILED( hRet ) || hRet == S_FALSE )
+        {
+            return hRet;
+        }
+
+        if( !directFrame.isNull() )
+        {
+            // shares the cached ( or rotated ) frame, only a pending cursor costs a copy ( bits() detaches )
+            if( bCursorPending )
             {
-                *pRetIsTimeout = TRUE;
+                m_ullOutputBytes += ( quint64 )directFrame.sizeInBytes();
+                hRet = composeCursor( directFrame.bits(), ( INT )directFrame.bytesPerLine(), directFrame.width(), directFrame.height() );
+                CHECK_HR_RETURN( hRet );
             }
-            return S_FALSE;
+
+            *pRetImage = std::move( directFrame );
+            return S_OK;
         }
-        else if( FAILED( hr ) )
+
+        // nothing was rendered since the last conversion, hand out the same ( shared ) image
+        if( m_ullOutputGeneration != m_ullRenderGeneration || m_lastOutputImage.isNull() )
         {
-            return hr;
+            m_lastOutputImage = convertWICBitmapToQImage( m_ipWICImageFactory, m_ipWICOutputBitmap );
+            m_ullOutputGeneration = m_ullRenderGeneration;
+            m_ullOutputBytes += ( quint64 )m_lastOutputImage.sizeInBytes();
         }
 
-        // QI for ID3D11Texture2D
-        hr = ipDesktopResource->QueryInterface( IID_PPV_ARGS( &ipAcquiredDesktopImage ) );
-        ipDesktopResource = nullptr;
-        CHECK_HR_RETURN( hr );
-
-        if( nullptr == ipAcquiredDesktopImage )
+        *pRetImage = m_lastOutputImage;
+        if( pRetImage->isNull() )
         {
-            // release frame
-            m_ipDxgiOutputDuplication->ReleaseFrame();
             return E_OUTOFMEMORY;
         }
 
-        // Copy needed full part of desktop image
-        m_ipD3D11DeviceContext->CopyResource( m_ipCopyTexture2D, ipAcquiredDesktopImage );
+        return S_OK;
+    }
+
+    HRESULT CDXGICapture::CaptureToBuffer( BYTE* pDstBits, UINT uiDstPitch, UINT uiDstWidth, UINT uiDstHeight, BOOL* pRetIsTimeout )
+    {
+        CHECK_POINTER( pDstBits );
+        AUTOLOCK();
+
+        QImage directFrame;
+        BOOL bCursorPending = FALSE;
+        HRESULT hRet = captureFrame( pRetIsTimeout, NULL, &directFrame, &bCursorPending );
+        if( FAILED( hRet ) || hRet == S_FALSE )
+        {
+            return hRet;
+        }
 
-        if( m_rendererInfo.ShowCursor )
+        if( !directFrame.isNull() )
         {
-            hr = DXGICaptureHelper::GetMouse( m_ipDxgiOutputDuplication, &m_mouseInfo, &FrameInfo, ( UINT )m_rendererInfo.MonitorIdx, m_desktopOutputDesc.DesktopCoordinates.left, m_desktopOutputDesc.DesktopCoordinates.top );
-            if( SUCCEEDED( hr ) && m_mouseInfo.Visible )
+            // one stride-aware copy from the cached ( or rotated ) frame, a pending cursor is drawn straight into the target
+            QImage target( pDstBits, ( int )uiDstWidth, ( int )uiDstHeight, ( qsizetype )uiDstPitch, QImage::Format_ARGB32_Premultiplied );
+            if( !nsCapture::CDesktopCanvas::Blit( directFrame, &target ) )
             {
-                hr = DXGICaptureHelper::DrawMouse( &m_mouseInfo, &m_desktopOutputDesc, &m_tempMouseBuffer, m_ipCopyTexture2D );
+                return E_FAIL;
             }
 
-            if( FAILED( hr ) )
-            {
-                // release frame
-                m_ipDxgiOutputDuplication->ReleaseFrame();
-                return hr;
-            }
+            const INT iWidth  = qMin( directFrame.width(), ( int )uiDstWidth );
+            const INT iHeight = qMin( directFrame.height(), ( int )uiDstHeight );
+            m_ullOutputBytes += ( quint64 )iWidth * iHeight * 4;
+            return bCursorPending ? composeCursor( pDstBits, ( INT )uiDstPitch, iWidth, iHeight ) : S_OK;
         }
 
-        // release frame
-        hr = m_ipDxgiOutputDuplication->ReleaseFrame();
-        CHECK_HR_RETURN( hr );
+        UINT uiWidth = 0, uiHeight = 0;
+        hRet = m_ipWICOutputBitmap->GetSize( &uiWidth, &uiHeight );
+        CHECK_HR_RETURN( hRet );
 
-        // create D2D1 source bitmap
-        hr = DXGICaptureHelper::CreateBitmap( m_ipD2D1RenderTarget, m_ipCopyTexture2D, &ipD2D1SourceBitmap );
-        CHECK_HR_RETURN( hr );
+        // the render target bitmap is already 32bpp PBGRA, same layout as QImage::Format_ARGB32_Premultiplied
+        WICRect rcCopy = { 0, 0, ( INT )qMin( uiWidth, uiDstWidth ), ( INT )qMin( uiHeight, uiDstHeight ) };
+        m_ullOutputBytes += ( quint64 )rcCopy.Width * rcCopy.Height * 4;
+        return m_ipWICOutputBitmap->CopyPixels( &rcCopy, uiDstPitch, uiDstPitch * ( UINT )rcCopy.Height, pDstBits );
+    }
 
-        D2D1_RECT_F rcSource = D2D1::RectF( ( FLOAT )m_rendererInfo.SrcBounds.X,
-                                            ( FLOAT )m_rendererInfo.SrcBounds.Y,
-                                            ( FLOAT )( m_rendererInfo.SrcBounds.X + m_rendererInfo.SrcBounds.Width ),
-                                            ( FLOAT )( m_rendererInfo.SrcBounds.Y + m_rendererInfo.SrcBounds.Height ) );
-        D2D1_RECT_F rcTarget = D2D1::RectF( ( FLOAT )m_rendererInfo.DstBounds.X,
-                                            ( FLOAT )m_rendererInfo.DstBounds.Y,
-                                            ( FLOAT )( m_rendererInfo.DstBounds.X + m_rendererInfo.DstBounds.Width ),
-                                            ( FLOAT )( m_rendererInfo.DstBounds.Y + m_rendererInfo.DstBounds.Height ) );
-        D2D1_POINT_2F ptTransformCenter = D2D1::Point2F( m_rendererInfo.OutputSize.Width / 2.0f, m_rendererInfo.OutputSize.Height / 2.0f );
-
-        // Apply the rotation transform to the render target.
-        D2D1::Matrix3x2F rotate = D2D1::Matrix3x2F::Rotation(
-            m_rendererInfo.RotationDegrees,
-            ptTransformCenter
-        );
-
-        D2D1::Matrix3x2F scale = D2D1::Matrix3x2F::Scale(
-            D2D1::SizeF( m_rendererInfo.ScaleX, m_rendererInfo.ScaleY ),
-            ptTransformCenter
-        );
-
-        // Priority: first rotate, after scale...
-        m_ipD2D1RenderTarget->SetTransform( rotate * scale );
-
-        m_ipD2D1RenderTarget->BeginDraw();
-        // clear background color
-        m_ipD2D1RenderTarget->Clear( D2D1::ColorF( D2D1::ColorF::Black, 1.0f ) );
-        m_ipD2D1RenderTarget->DrawBitmap( ipD2D1SourceBitmap, rcTarget, 1.0f, D2D1_BITMAP_INTERPOLATION_MODE_LINEAR, rcSource );
-        // Reset transform
-        //m_ipD2D1RenderTarget->SetTransform(D2D1::Matrix3x2F::Identity());
-        // Logo draw sample
-        //m_ipD2D1RenderTarget->DrawBitmap(ipBmpLogo, D2D1::RectF(0, 0, 2 * 200, 2 * 46));
-        hr = m_ipD2D1RenderTarget->EndDraw();
-        if( FAILED( hr ) )
+    HRESULT CDXGICapture::CaptureRegionToBuffer( const RECT& rcRegion, BYTE* pDstBits, UINT uiDstPitch, BOOL* pRetIsTimeout )
+    {
+        CHECK_POINTER( pDstBits );
+        RESET_POINTER_EX( pRetIsTimeout, FALSE );
+        AUTOLOCK();
+
+        if( !m_bInitialized )
         {
-            return hr;
+            return D2DERR_NOT_INITIALIZED;
         }
 
-        // calculate render time without save
-        if( nullptr != pRetRenderDuration )
+        // the region is cut from the frame in source orientation, other outputs go through the whole image
+        if( directRotation() != nsKernel::tagRotation_0 )
         {
-            *pRetRenderDuration = ( UINT )( ( std::chrono::high_resolution_clock::now() - startTick ).count() / 10000 );
+            return E_NOTIMPL;
         }
 
-        hr = DXGICaptureHelper::SaveImageToFile( m_ipWICImageFactory, m_ipWICOutputBitmap, lpcwOutputFileName );
-        if( FAILED( hr ) )
+        const QSize frameSize = m_frameCache.Size();
+        if( rcRegion.left < 0 || rcRegion.top < 0 || rcRegion.right > frameSize.width() || rcRegion.bottom > frameSize.height() ||
+            rcRegion.right <= rcRegion.left || rcRegion.bottom <= rcRegion.top )
         {
-            return hr;
+            return E_INVALIDARG;
         }
 
-        return S_OK;
-    } // CaptureToFile
+        const nsKernel::tagPixelRect rc{ ( int32_t )rcRegion.left, ( int32_t )rcRegion.top, ( int32_t )rcRegion.right, ( int32_t )rcRegion.bottom };
+        const INT iWidth  = rc.Right - rc.Left;
+        const INT iHeight = rc.Bottom - rc.Top;
 
-    QPixmap CDXGICapture::CaptureToPixmap( LPCWSTR lpcwOutputFileName, BOOL* pRetIsTimeout, UINT* pRetRenderDuration )
+        if( m_frameCache.IsValid() )
+        {
+            // warm : the usual incremental refresh, then only the region rows of the cached frame
+            QImage directFrame;
+            BOOL bCursorPending = FALSE;
+            HRESULT hRet = captureFrame( pRetIsTimeout, NULL, &directFrame, &bCursorPending );
+            if( FAILED( hRet ) || hRet == S_FALSE )
+            {
+                return hRet;
+            }
+
+            const QImage region( directFrame.constBits() + ( qsizetype )rc.Top * directFrame.bytesPerLine() + ( qsizetype )rc.Left * 4,
+                                 iWidth, iHeight, directFrame.bytesPerLine(), directFrame.format() );
+            QImage target( pDstBits, iWidth, iHeight, ( qsizetype )uiDstPitch, QImage::Format_ARGB32_Premultiplied );
+            if( !nsCapture::CDesktopCanvas::Blit( region, &target ) )
+            {
+                return E_FAIL;
+            }
+
+            m_ullOutputBytes += ( quint64 )iWidth * iHeight * 4;
+            return bCursorPending ? composeCursor( pDstBits, ( INT )uiDstPitch, iWidth, iHeight, rc.Left, rc.Top ) : S_OK;
+        }
+
+        // cold : the cache is not filled for a region, only the region is read back
+        nsCapture::tagFrameReason reason = nsCapture::tagFrameReason_None;
+        HRESULT hRet = readRegion( rc, pDstBits, uiDstPitch, &reason );
+        m_lastFrameReason = reason;
+
+        if( FAILED( hRet ) )
+        {
+            return hRet;
+        }
+        if( hRet == S_FALSE )
+        {
+            RESET_POINTER_EX( pRetIsTimeout, TRUE );
+            return S_FALSE;
+        }
+
+        ++m_ullDirectFrames;
+        return composeCursor( pDstBits, ( INT )uiDstPitch, iWidth, iHeight, rc.Left, rc.Top );
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+    /// class CDXGICaptureBackend
+    //
+
+    namespace
     {
-        QPixmap Pixmap;
+        // capture workers are plain threads, WIC needs COM on each of them
+        class CComThreadScope
+        {
+        public:
+            CComThreadScope() : m_hr( CoInitializeEx( NULL, COINIT_MULTITHREADED ) ) {}
+            ~CComThreadScope()
+            {
+                // RPC_E_CHANGED_MODE : the thread already has an apartment ( GUI thread ), nothing to undo
+                if( SUCCEEDED( m_hr ) )
+                    CoUninitialize();
+            }
 
-        do
+        private:
+            HRESULT                     m_hr;
+        };
+
+        class CDXGICaptureSession : public nsCapture::ICaptureSession
         {
-            HRESULT hRet = captureFrame( pRetIsTimeout, pRetRenderDuration );
-            if( FAILED( hRet ) )
-                break;
+        private:
+            nsCapture::tagOutputInfo    m_output;
+            CDXGICapture                m_capture;
+            BOOL                        m_bShowCursor;
+
+        public:
+            explicit CDXGICaptureSession( const nsCapture::tagOutputInfo& Output )
+                : m_output( Output ), m_bShowCursor( FALSE )
+            {
+            }
 
-            Pixmap = convertWICBitmapToQPixmap( m_ipWICImageFactory, m_ipWICOutputBitmap );
+            HRESULT Open()
+            {
+                CComThreadScope comScope;
+                HRESULT hr = m_capture.Initialize();
+                CHECK_HR_RETURN( hr );
+
+                const auto Info = m_capture.FindDublicatorMonitorInfo( m_output.Idx );
+                CHECK_POINTER_EX( Info, E_INVALIDARG );
+
+                tagScreenCaptureFilterConfig config;
+                config.MonitorIdx           = m_output.Idx;
+                config.ShowCursor           = m_bShowCursor;
+                config.RotationMode         = tagFrameRotationMode_Auto;
+                config.OutputSize.Width     = Info->Bounds.Width;
+                config.OutputSize.Height    = Info->Bounds.Height;
+                config.SizeMode             = tagFrameSizeMode_AutoSize;
+                return m_capture.SetConfig( config );
+            }
 
-        } while( false );
+            const nsCapture::tagOutputInfo& Output() const override
+            {
+                return m_output;
+            }
 
-        return Pixmap;
+            nsCapture::tagCaptureStatus Capture( const nsCapture::tagCaptureRequest& Request, QImage* pRetImage, nsCapture::tagFrameReason* pRetReason ) override
+            {
+                RESET_POINTER_EX( pRetReason, nsCapture::tagFrameReason_None );
+
+                CComThreadScope comScope;
+                if( !applyRequest( Request ) )
+                    return nsCapture::tagCaptureStatus_Failed;
+
+                BOOL bIsTimeout = FALSE;
+                HRESULT hr = m_capture.CaptureToImage( pRetImage, &bIsTimeout );
+                RESET_POINTER_EX( pRetReason, m_capture.GetLastFrameReason() );
+
+                return convertResult( hr, bIsTimeout );
+            }
+
+            nsCapture::tagCaptureStatus CaptureInto( const nsCapture::tagCaptureRequest& Request, QImage* pTarget, nsCapture::tagFrameReason* pRetReason ) override
+            {
+                RESET_POINTER_EX( pRetReason, nsCapture::tagFrameReason_None );
+                if( nullptr == pTarget || pTarget->isNull() || pTarget->depth() != 32 )
+                    return nsCapture::tagCaptureStatus_Failed;
+
+                CComThreadScope comScope;
+                if( !applyRequest( Request ) )
+                    return nsCapture::tagCaptureStatus_Failed;
+
+                BOOL bIsTimeout = FALSE;
+                HRESULT hr = m_capture.CaptureToBuffer( pTarget->bits(), ( UINT )pTarget->bytesPerLine(), ( UINT )pTarget->width(), ( UINT )pTarget->height(), &bIsTimeout );
+                RESET_POINTER_EX( pRetReason, m_capture.GetLastFrameReason() );
+
+                return convertResult( hr, bIsTimeout );
+            }
+
+            nsCapture::tagCaptureStatus CaptureRect( const nsCapture::tagCaptureRequest& Request, const QRect& Rect, QImage* pTarget, nsCapture::tagFrameReason* pRetReason ) override
+            {
+                RESET_POINTER_EX( pRetReason, nsCapture::tagFrameReason_None );
+                if( nullptr == pTarget || pTarget->isNull() || pTarget->depth() != 32 || pTarget->size() != Rect.size() )
+                    return nsCapture::tagCaptureStatus_Failed;
+
+                CComThreadScope comScope;
+                if( !applyRequest( Request ) )
+                    return nsCapture::tagCaptureStatus_Failed;
+
+                const RECT rcRegion = { Rect.left(), Rect.top(), Rect.left() + Rect.width(), Rect.top() + Rect.height() };
+                BOOL bIsTimeout = FALSE;
+                HRESULT hr = m_capture.CaptureRegionToBuffer( rcRegion, pTarget->bits(), ( UINT )pTarget->bytesPerLine(), &bIsTimeout );
+
+                // rotated or scaled output, the region is cut from the finished image
+                if( hr == E_NOTIMPL )
+                    return ICaptureSession::CaptureRect( Request, Rect, pTarget, pRetReason );
+
+                RESET_POINTER_EX( pRetReason, m_capture.GetLastFrameReason() );
+                return convertResult( hr, bIsTimeout );
+            }
+
+            nsCapture::tagCaptureStatus Refresh( int TimeoutMs ) override
+            {
+                HRESULT hr = m_capture.RefreshCache( ( UINT )qMax( 0, TimeoutMs ) );
+                return convertResult( hr, FALSE );
+            }
+
+            nsCapture::tagFrameCacheStats CacheStats() const override
+            {
+                return m_capture.GetCacheStats();
+            }
+
+        private:
+            bool applyRequest( const nsCapture::tagCaptureRequest& Request )
+            {
+                m_capture.SetAcquireTimeout( ( UINT )qMax( 0, Request.TimeoutMs ) );
+                m_capture.SetMaxStaleness( ( UINT )qMax( 0, Request.MaxStalenessMs ) );
+
+                const BOOL bShowCursor = Request.IncludeCursor ? TRUE : FALSE;
+                if( bShowCursor != m_bShowCursor )
+                {
+                    if( FAILED( m_capture.SetShowCursor( bShowCursor ) ) )
+                        return false;
+                    m_bShowCursor = bShowCursor;
+                }
+
+                return true;
+            }
+
+            static nsCapture::tagCaptureStatus convertResult( HRESULT hr, BOOL bIsTimeout )
+            {
+                if( hr == DXGI_ERROR_ACCESS_LOST || hr == DXGI_ERROR_INVALID_CALL || hr == DXGI_ERROR_DEVICE_REMOVED )
+                    return nsCapture::tagCaptureStatus_AccessLost;
+                if( FAILED( hr ) )
+                    return nsCapture::tagCaptureStatus_Failed;
+                if( bIsTimeout || hr == S_FALSE )
+                    return nsCapture::tagCaptureStatus_Timeout;
+
+                return nsCapture::tagCaptureStatus_Ok;
+            }
+        };
+    }
+
+    CDXGICaptureBackend::CDXGICaptureBackend()
+    {
+    }
+
+    QString CDXGICaptureBackend::Name() const
+    {
+        return QStringLiteral( "dxgi" );
+    }
+
+    bool CDXGICaptureBackend::IsTopologyCurrent()
+    {
+        return m_probe.IsTopologyCurrent() != FALSE;
+    }
+
+    bool CDXGICaptureBackend::EnumerateOutputs( QVector< nsCapture::tagOutputInfo >* pRetOutputs )
+    {
+        if( nullptr == pRetOutputs )
+            return false;
+
+        HRESULT hr = S_OK;
+
+        // stale factory : recreate the device, otherwise only the output descriptions are reloaded ( mode change )
+        if( !m_probe.IsTopologyCurrent() )
+        {
+            m_probe.Terminate();
+            hr = m_probe.Initialize();
+        }
+        else
+        {
+            hr = m_probe.ReloadMonitorInfos();
+        }
+
+        if( FAILED( hr ) )
+            return false;
+
+        pRetOutputs->clear();
+        for( int idx = 0; idx < m_probe.GetDublicatorMonitorInfoCount(); ++idx )
+        {
+            const auto Info = m_probe.GetDublicatorMonitorInfo( idx );
+            if( nullptr == Info )
+                continue;
+
+            pRetOutputs->push_back( ConvertMonitorInfoToOutputInfo( Info ) );
+        }
+
+        return true;
+    }
+
+    std::unique_ptr< nsCapture::ICaptureSession > CDXGICaptureBackend::OpenSession( const nsCapture::tagOutputInfo& Output )
+    {
+        auto Session = std::make_unique< CDXGICaptureSession >( Output );
+        if( FAILED( Session->Open() ) )
+            return nullptr;
+
+        return Session;
+    }
+
+    nsCapture::tagOutputInfo CDXGICaptureBackend::ConvertMonitorInfoToOutputInfo( const tagDublicatorMonitorInfo* pInfo )
+    {
+        nsCapture::tagOutputInfo Output;
+        if( nullptr == pInfo )
+            return Output;
+
+        Output.Idx              = pInfo->Idx;
+        Output.Name             = QString::fromWCharArray( pInfo->DisplayName );
+        Output.Bounds           = QRect( pInfo->Bounds.X, pInfo->Bounds.Y, pInfo->Bounds.Width, pInfo->Bounds.Height );
+        Output.RotationDegrees  = pInfo->RotationDegrees;
+        Output.Handle           = ( quintptr )pInfo->Handle;
+        return Output;
     }
 }
@@ -16,6 +16,15 @@
 #include <wincodec.h>
 #include <QtWidgets>
 
+#include "captureService.hpp"
+#include "captureTrace.hpp"
+#include "cursorShape.hpp"
+#include "frameAcquirer.hpp"
+#include "frameCache.hpp"
+#include "frameResample.hpp"
+#include "frameRotate.hpp"
+#include "pixelConvert.hpp"
+
 // macros
 #define RESET_POINTER_EX(p, v)      if (nullptr != (p)) { *(p) = (v); }
 #define RESET_POINTER(p)            RESET_POINTER_EX(p, nullptr)
@@ -57,6 +66,7 @@ namespace nsDXGI
         bool Visible;
         UINT WhoUpdatedPositionLast;
         LARGE_INTEGER LastTimeStamp;
+        UINT64 ShapeHash;               // nsKernel::HashCursorShape of PtrShapeBuffer
     } tagMouseInfo;
 
     // struct tagFrameSize_s
@@ -85,6 +95,13 @@ namespace nsDXGI
         INT                                  Pitch;
     } tagFrameBufferInfo;
 
+    // struct tagCursorPlacement_s : processed pointer shape ( owned by the cursor cache ) and its bounds on the surface
+    typedef struct tagCursorPlacement_s
+    {
+        const nsKernel::tagCursorImage*      Image;
+        tagFrameBounds                       Bounds;
+    } tagCursorPlacement;
+
     // struct tagDublicatorMonitorInfo_s
     typedef struct tagDublicatorMonitorInfo_s
     {
@@ -139,11 +156,17 @@ public:
     // GetMouse
     static COM_DECLSPEC_NOTHROW HRESULT GetMouse( _In_ IDXGIOutputDuplication* pOutputDuplication, _Inout_ tagMouseInfo* PtrInfo, _In_ DXGI_OUTDUPL_FRAME_INFO* FrameInfo, UINT MonitorIdx, INT OffsetX, INT OffsetY );
     // ProcessMouseMask
-    static COM_DECLSPEC_NOTHROW HRESULT ProcessMouseMask( _In_ const tagMouseInfo* PtrInfo, _In_ const DXGI_OUTPUT_DESC* DesktopDesc, _Inout_ tagFrameBufferInfo* pBufferInfo );
+    static COM_DECLSPEC_NOTHROW HRESULT ProcessMouseMask( _In_ const tagMouseInfo* PtrInfo, _In_ const DXGI_OUTPUT_DESC* DesktopDesc, _Inout_ nsKernel::CCursorCache* pCursorCache, _Out_ tagCursorPlacement* pRetPlacement );
+    // pointer shape of PtrInfo as kernel input, no copy
+    static COM_DECLSPEC_NOTHROW nsKernel::tagCursorShape ToCursorShape( _In_ const tagMouseInfo* PtrInfo );
 
     // Draw mouse provided in buffer to backbuffer
-    static COM_DECLSPEC_NOTHROW HRESULT DrawMouse( _In_ tagMouseInfo* PtrInfo, _In_ const DXGI_OUTPUT_DESC* DesktopDesc, _Inout_ tagFrameBufferInfo* pTempMouseBuffer, _Inout_ ID3D11Texture2D* pSharedSurf );
+    static COM_DECLSPEC_NOTHROW HRESULT DrawMouse( _In_ tagMouseInfo* PtrInfo, _In_ const DXGI_OUTPUT_DESC* DesktopDesc, _Inout_ nsKernel::CCursorCache* pCursorCache, _Inout_ ID3D11Texture2D* pSharedSurf );
+    // Draw mouse into a CPU side 32bpp surface whose top-left is at ( OriginX, OriginY ) of the output
+    static COM_DECLSPEC_NOTHROW HRESULT DrawMouseToBuffer( _In_ tagMouseInfo* PtrInfo, _In_ const DXGI_OUTPUT_DESC* DesktopDesc, _Inout_ nsKernel::CCursorCache* pCursorCache, _Inout_ BYTE* pSurfBits, _In_ INT SurfPitch, _In_ INT SurfWidth, _In_ INT SurfHeight, _In_ INT OriginX = 0, _In_ INT OriginY = 0 );
     static COM_DECLSPEC_NOTHROW HRESULT CreateBitmap( _In_ ID2D1RenderTarget* pRenderTarget, _In_ ID3D11Texture2D* pSourceTexture, _Outptr_ ID2D1Bitmap** ppOutBitmap );
+    static COM_DECLSPEC_NOTHROW HRESULT CreateBitmapFromMemory( _In_ ID2D1RenderTarget* pRenderTarget, _In_ const BYTE* pBits, _In_ UINT uiPitch, _In_ UINT uiWidth, _In_ UINT uiHeight, _Outptr_ ID2D1Bitmap** ppOutBitmap );
+    // S_FALSE and GUID_NULL for the formats without a WIC container ( .qoi, .raw ), see nsCapture::WriteImage
     static COM_DECLSPEC_NOTHROW HRESULT GetContainerFormatByFileName( _In_ LPCWSTR lpcwFileName, _Out_opt_ GUID* pRetVal = NULL );
     static COM_DECLSPEC_NOTHROW HRESULT SaveImageToFile( _In_ IWICImagingFactory* pWICImagingFactory, _In_ IWICBitmapSource* pWICBitmapSource, _In_ LPCWSTR lpcwFileName );
 
@@ -159,15 +182,37 @@ private:
     tagRendererInfo                 m_rendererInfo;
 
     tagMouseInfo                    m_mouseInfo;
-    tagFrameBufferInfo              m_tempMouseBuffer;
+    nsKernel::CCursorCache          m_cursorCache;              // processed pointer shapes by hash and rotation
     DXGI_OUTPUT_DESC                m_desktopOutputDesc;
 
     D3D_FEATURE_LEVEL               m_lD3DFeatureLevel;
     CComPtr<ID3D11Device>           m_ipD3D11Device;
     CComPtr<ID3D11DeviceContext>    m_ipD3D11DeviceContext;
+    CComPtr<IDXGIFactory1>          m_ipDxgiFactory;
 
     CComPtr<IDXGIOutputDuplication> m_ipDxgiOutputDuplication;
-    CComPtr<ID3D11Texture2D>        m_ipCopyTexture2D;
+    CComPtr<ID3D11Texture2D>        m_ipCopyTexture2D;          // staging mirror of the desktop image, without cursor
+    CComPtr<ID3D11Texture2D>        m_ipMirrorTexture2D;        // GPU copy of the last present while m_frameCache is cold ( region reads ), created on demand
+    BOOL                            m_bMirrorValid;
+    qint64                          m_llMirrorPresentTime;
+    UINT                            m_uiAcquireTimeoutMs;
+    UINT                            m_uiMaxStalenessMs;
+    nsCapture::tagFrameReason       m_lastFrameReason;
+
+    nsCapture::CFrameCache          m_frameCache;               // CPU copy of the staging texture, refreshed from dirty rects
+    std::vector<BYTE>               m_metadataBuffer;
+    BOOL                            m_bRenderCurrent;           // render target holds m_frameCache without cursor
+    quint64                         m_ullRenderedSerial;
+    quint64                         m_ullRenderGeneration;
+    QImage                          m_lastOutputImage;
+    quint64                         m_ullOutputGeneration;
+    quint64                         m_ullDirectFrames;          // outputs produced on the CPU from m_frameCache, no render target
+    quint64                         m_ullRenderedFrames;
+    quint64                         m_ullOutputBytes;           // written after the frame cache to produce output images
+    QImage                          m_rotatedImage;             // CPU rotated m_frameCache for quarter turn outputs
+    quint64                         m_ullRotatedSerial;         // cache serial in m_rotatedImage, 0 = none or cursor drawn
+    QImage                          m_scaledImage;              // CPU resampled output for scaled, letterboxed or offset placements
+    quint64                         m_ullScaledSerial;          // cache serial in m_scaledImage, 0 = none or cursor drawn
 
     CComPtr<ID2D1Device>            m_ipD2D1Device;
     CComPtr<ID2D1Factory>           m_ipD2D1Factory;
@@ -183,17 +228,36 @@ public:
     HRESULT                         Terminate();
     HRESULT                         SetConfig( const tagScreenCaptureFilterConfig* pConfig );
     HRESULT                         SetConfig( const tagScreenCaptureFilterConfig& config );
+    HRESULT                         SetShowCursor( BOOL bShowCursor );
+    // deadline for waiting on a new desktop present, the last frame is reused after it expires
+    HRESULT                         SetAcquireTimeout( UINT uiTimeoutMs );
+    // a cached frame checked within this bound is served without touching the duplication, 0 = always check
+    HRESULT                         SetMaxStaleness( UINT uiMaxStalenessMs );
+    // pull a newer present into the frame cache if there is one, no rendering
+    HRESULT                         RefreshCache( UINT uiTimeoutMs );
+    nsCapture::tagFrameCacheStats   GetCacheStats() const;
+    HRESULT                         ReloadMonitorInfos();
 
     BOOL                            IsInitialized() const;
     D3D_FEATURE_LEVEL               GetD3DFeatureLevel() const;
+    // FALSE when adapters or outputs changed after Initialize
+    BOOL                            IsTopologyCurrent() const;
+    nsCapture::tagFrameReason       GetLastFrameReason() const;
 
     int                             GetDublicatorMonitorInfoCount() const;
     const tagDublicatorMonitorInfo* GetDublicatorMonitorInfo( int index ) const;
     const tagDublicatorMonitorInfo* FindDublicatorMonitorInfo( int monitorIdx ) const;
 
 
+    // pRetRenderDuration : milliseconds spent in captureFrame, per stage timings come from nsCapture::CCaptureTrace
     HRESULT                         CaptureToFile( _In_ LPCWSTR lpcwOutputFileName, _Out_opt_ BOOL* pRetIsTimeout = NULL, _Out_opt_ UINT* pRetRenderDuration = NULL );
     QPixmap                         CaptureToPixmap( _In_ LPCWSTR lpcwOutputFileName, _Out_opt_ BOOL* pRetIsTimeout = NULL, _Out_opt_ UINT* pRetRenderDuration = NULL );
+    HRESULT                         CaptureToImage( _Out_ QImage* pRetImage, _Out_opt_ BOOL* pRetIsTimeout = NULL, _Out_opt_ UINT* pRetRenderDuration = NULL );
+    // render into caller memory ( 32bpp PBGRA ), clipped to the output size
+    HRESULT                         CaptureToBuffer( _Out_ BYTE* pDstBits, _In_ UINT uiDstPitch, _In_ UINT uiDstWidth, _In_ UINT uiDstHeight, _Out_opt_ BOOL* pRetIsTimeout = NULL );
+    // only rcRegion of an identity output ( output coordinates ) into caller memory, E_NOTIMPL for rotated or scaled outputs;
+    // a warm cache is refreshed as usual and read partially, a cold one is not filled, only the region is read back from the GPU
+    HRESULT                         CaptureRegionToBuffer( _In_ const RECT& rcRegion, _Out_ BYTE* pDstBits, _In_ UINT uiDstPitch, _Out_opt_ BOOL* pRetIsTimeout = NULL );
 
 private:
     HRESULT                         loadMonitorInfos( ID3D11Device* pDevice );
@@ -202,8 +266,43 @@ private:
     HRESULT                         createDeviceResource( const tagScreenCaptureFilterConfig* pConfig, const tagDublicatorMonitorInfo* pSelectedMonitorInfo );
     void                            terminateDeviceResource();
 
-    HRESULT                         captureFrame( _Out_opt_ BOOL* pRetIsTimeout = NULL, _Out_opt_ UINT* pRetRenderDuration = NULL );
+    HRESULT                         refreshFrameCache( UINT uiTimeoutMs, _Out_ nsCapture::tagFrameReason* pRetReason );
+    // cold cache : keep the last present in m_ipMirrorTexture2D and read back only rcRegion through the staging texture
+    HRESULT                         readRegion( const nsKernel::tagPixelRect& rcRegion, _Out_ BYTE* pDstBits, _In_ UINT uiDstPitch, _Out_ nsCapture::tagFrameReason* pRetReason );
+    HRESULT                         collectFrameRects( const DXGI_OUTDUPL_FRAME_INFO* pFrameInfo, _Out_ nsKernel::tagFrameDelta* pRetDelta );
+    // with pRetDirectFrame, outputs at a quarter turn skip the render target and return the final frame there,
+    // identity frames come without cursor and set *pRetCursorPending when the caller has to draw it
+    HRESULT                         captureFrame( _Out_opt_ BOOL* pRetIsTimeout = NULL, _Out_opt_ UINT* pRetRenderDuration = NULL, _Out_opt_ QImage* pRetDirectFrame = NULL, _Out_opt_ BOOL* pRetCursorPending = NULL );
+    // rotation when the output is the cached frame turned by a multiple of 90 degrees at unit scale, otherwise tagRotation_Invalid
+    nsKernel::tagRotation           directRotation() const;
+    // rotate m_frameCache into m_rotatedImage, reused while the cache is unchanged and no cursor is drawn
+    HRESULT                         rotateFrame( nsKernel::tagRotation rotation, BOOL bDrawCursor );
+    // where the render target transform puts the cached frame ( rotate, then scale about the output centre ), FALSE when it is not a quarter turn
+    BOOL                            scaledPlacement( _Out_ nsKernel::tagRotation* pRetRotation, _Out_ nsKernel::tagPixelRect* pRetTarget ) const;
+    // resample m_frameCache ( rotated first for quarter turns ) onto target of a black m_scaledImage, reused like rotateFrame
+    HRESULT                         scaleFrame( nsKernel::tagRotation rotation, const nsKernel::tagPixelRect& target, BOOL bDrawCursor );
+    // draw the cursor into a 32bpp surface placed at ( iOriginX, iOriginY ) of the output, no-op while hidden
+    HRESULT                         composeCursor( _Inout_ BYTE* pBits, _In_ INT iPitch, _In_ INT iWidth, _In_ INT iHeight, _In_ INT iOriginX = 0, _In_ INT iOriginY = 0 );
     QPixmap                         convertWICBitmapToQPixmap( IWICImagingFactory* pWICImagingFactory, IWICBitmapSource* pWICBitmapSource );
+    QImage                          convertWICBitmapToQImage( IWICImagingFactory* pWICImagingFactory, IWICBitmapSource* pWICBitmapSource );
+};
+
+// class CDXGICaptureBackend
+// nsCapture backend over desktop duplication, every session owns its own CDXGICapture ( device, duplication, render target )
+class CDXGICaptureBackend : public nsCapture::ICaptureBackend
+{
+private:
+    CDXGICapture                    m_probe;        // device used only for output enumeration and topology checks
+
+public:
+    CDXGICaptureBackend();
+
+    QString                         Name() const override;
+    bool                            IsTopologyCurrent() override;
+    bool                            EnumerateOutputs( QVector< nsCapture::tagOutputInfo >* pRetOutputs ) override;
+    std::unique_ptr< nsCapture::ICaptureSession > OpenSession( const nsCapture::tagOutputInfo& Output ) override;
+
+    static nsCapture::tagOutputInfo ConvertMonitorInfoToOutputInfo( const tagDublicatorMonitorInfo* pInfo );
 };
 
 } // nsDXGI
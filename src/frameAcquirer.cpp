@@ -0,0 +1,208 @@
+#include "frameAcquirer.hpp"
+
+namespace nsCapture
+{
+    const char* FrameReasonToString( tagFrameReason Reason )
+    {
+        switch( Reason )
+        {
+            case tagFrameReason_Fresh:      return "fresh";
+            case tagFrameReason_Cached:     return "cached";
+            case tagFrameReason_Timeout:    return "timeout";
+            case tagFrameReason_AccessLost: return "access-lost";
+            case tagFrameReason_Failed:     return "failed";
+            default:                        return "none";
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// class CFrameAcquirer
+    //
+
+    CFrameAcquirer::CFrameAcquirer( IDuplicationSource* pSource, ClockFn Clock )
+        : m_pSource( pSource ), m_clock( Clock ? std::move( Clock ) : ClockFn( &AcquireClock::now ) )
+    {
+    }
+
+    tagAcquireResult CFrameAcquirer::Acquire( std::chrono::milliseconds Timeout, bool HasCachedFrame )
+    {
+        return Acquire( m_clock() + Timeout, HasCachedFrame );
+    }
+
+    tagAcquireResult CFrameAcquirer::Acquire( AcquireClock::time_point Deadline, bool HasCachedFrame )
+    {
+        tagAcquireResult Result;
+
+        if( nullptr == m_pSource )
+        {
+            Result.Reason = tagFrameReason_Failed;
+            return Result;
+        }
+
+        while( true )
+        {
+            const auto Now = m_clock();
+
+            // round up, a sub-millisecond remainder still gets one wait
+            int64_t RemainingMs = 0;
+            if( Deadline > Now )
+            {
+                const auto Remaining = std::chrono::duration_cast< std::chrono::microseconds >( Deadline - Now ).count();
+                RemainingMs = ( Remaining + 999 ) / 1000;
+            }
+
+            // the first attempt always happens, with a zero timeout it only picks up a pending present
+            if( RemainingMs == 0 && Result.Attempts > 0 )
+                break;
+
+            ++Result.Attempts;
+
+            tagDuplicationFrameInfo FrameInfo;
+            const auto Status = m_pSource->AcquireNextFrame( ( uint32_t )RemainingMs, &FrameInfo );
+
+            if( Status == tagAcquireStatus_Ok )
+            {
+                if( FrameInfo.LastPresentTime != 0 )
+                {
+                    Result.Reason = tagFrameReason_Fresh;
+                    Result.FrameInfo = FrameInfo;
+                    return Result;
+                }
+
+                // pointer-only update, the desktop image did not change
+                m_pSource->ReleaseFrame();
+                ++Result.SkippedUpdates;
+                continue;
+            }
+
+            if( Status == tagAcquireStatus_Timeout )
+                break;
+
+            Result.Reason = ( Status == tagAcquireStatus_AccessLost ) ? tagFrameReason_AccessLost : tagFrameReason_Failed;
+            return Result;
+        }
+
+        Result.Reason = HasCachedFrame ? tagFrameReason_Cached : tagFrameReason_Timeout;
+        return Result;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// class CScriptedDuplicationSource
+    //
+
+    CScriptedDuplicationSource::CScriptedDuplicationSource()
+        : m_elapsedInStep( 0 )
+        , m_now( AcquireClock::now() )
+        , m_isFrameHeld( false )
+        , m_acquireCalls( 0 )
+        , m_releaseCalls( 0 )
+        , m_presents( 0 )
+    {
+    }
+
+    void CScriptedDuplicationSource::Push( tagScriptEvent Event, uint32_t DelayMs, uint32_t Repeat )
+    {
+        if( Repeat == 0 )
+            return;
+
+        m_script.push_back( tagScriptStep{ Event, DelayMs, Repeat } );
+    }
+
+    void CScriptedDuplicationSource::Clear()
+    {
+        m_script.clear();
+        m_elapsedInStep = 0;
+    }
+
+    bool CScriptedDuplicationSource::IsScriptDone() const
+    {
+        return m_script.empty();
+    }
+
+    AcquireClock::time_point CScriptedDuplicationSource::Now() const
+    {
+        return m_now;
+    }
+
+    void CScriptedDuplicationSource::Advance( std::chrono::milliseconds Delta )
+    {
+        m_now += Delta;
+    }
+
+    CFrameAcquirer::ClockFn CScriptedDuplicationSource::Clock()
+    {
+        return [this]() { return m_now; };
+    }
+
+    tagAcquireStatus CScriptedDuplicationSource::AcquireNextFrame( uint32_t TimeoutMs, tagDuplicationFrameInfo* pRetFrameInfo )
+    {
+        ++m_acquireCalls;
+
+        // same contract as DXGI : the previous frame must be released first ( DXGI_ERROR_INVALID_CALL )
+        if( m_isFrameHeld || nullptr == pRetFrameInfo )
+            return tagAcquireStatus_Failed;
+
+        *pRetFrameInfo = tagDuplicationFrameInfo();
+        uint32_t Budget = TimeoutMs;
+
+        while( !m_script.empty() )
+        {
+            auto& Step = m_script.front();
+            const uint32_t Wait = Step.DelayMs - m_elapsedInStep;
+
+            if( Wait > Budget )
+            {
+                m_elapsedInStep += Budget;
+                Advance( std::chrono::milliseconds( Budget ) );
+                return tagAcquireStatus_Timeout;
+            }
+
+            Advance( std::chrono::milliseconds( Wait ) );
+            Budget -= Wait;
+            m_elapsedInStep = 0;
+
+            const auto Event = Step.Event;
+            if( --Step.Repeat == 0 )
+                m_script.pop_front();
+
+            const int64_t Ticks = std::chrono::duration_cast< std::chrono::microseconds >( m_now.time_since_epoch() ).count();
+
+            switch( Event )
+            {
+                case tagScriptEvent_Present:
+                    m_isFrameHeld = true;
+                    ++m_presents;
+                    pRetFrameInfo->LastPresentTime = Ticks;
+                    pRetFrameInfo->AccumulatedFrames = 1;
+                    return tagAcquireStatus_Ok;
+
+                case tagScriptEvent_MouseOnly:
+                    m_isFrameHeld = true;
+                    pRetFrameInfo->LastMouseUpdateTime = Ticks;
+                    return tagAcquireStatus_Ok;
+
+                case tagScriptEvent_AccessLost:
+                    return tagAcquireStatus_AccessLost;
+
+                case tagScriptEvent_Failed:
+                    return tagAcquireStatus_Failed;
+
+                default: // tagScriptEvent_Idle
+                    break;
+            }
+        }
+
+        // script exhausted : static desktop
+        Advance( std::chrono::milliseconds( Budget ) );
+        return tagAcquireStatus_Timeout;
+    }
+
+    void CScriptedDuplicationSource::ReleaseFrame()
+    {
+        if( m_isFrameHeld )
+            ++m_releaseCalls;
+
+        m_isFrameHeld = false;
+    }
+
+} // nsCapture
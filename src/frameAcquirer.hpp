@@ -0,0 +1,144 @@
+#ifndef FRAMEACQUIRER_HPP
+#define FRAMEACQUIRER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+namespace nsCapture
+{
+    typedef std::chrono::steady_clock           AcquireClock;
+
+    // enum tagAcquireStatus_e : result of a single AcquireNextFrame call
+    typedef enum tagAcquireStatus_e : uint32_t
+    {
+        tagAcquireStatus_Ok             = 0x0,
+        tagAcquireStatus_Timeout        = 0x1,
+        tagAcquireStatus_AccessLost     = 0x2,
+        tagAcquireStatus_Failed         = 0x3,
+    } tagAcquireStatus;
+
+    // enum tagFrameReason_e : why a capture returned the frame it returned
+    typedef enum tagFrameReason_e : uint32_t
+    {
+        tagFrameReason_None             = 0x0,
+        tagFrameReason_Fresh            = 0x1,      // a new desktop present was acquired
+        tagFrameReason_Cached           = 0x2,      // no present before the deadline, last frame reused
+        tagFrameReason_Timeout          = 0x3,      // no present before the deadline and nothing cached
+        tagFrameReason_AccessLost       = 0x4,
+        tagFrameReason_Failed           = 0x5,
+    } tagFrameReason;
+
+    const char*                         FrameReasonToString( tagFrameReason Reason );
+
+    // struct tagDuplicationFrameInfo_s : portable subset of DXGI_OUTDUPL_FRAME_INFO
+    typedef struct tagDuplicationFrameInfo_s
+    {
+        int64_t                         LastPresentTime     = 0;
+        int64_t                         LastMouseUpdateTime = 0;
+        uint32_t                        AccumulatedFrames   = 0;
+    } tagDuplicationFrameInfo;
+
+    // Minimal view of IDXGIOutputDuplication. A successful AcquireNextFrame must be paired with ReleaseFrame.
+    class IDuplicationSource
+    {
+    public:
+        virtual ~IDuplicationSource() = default;
+
+        virtual tagAcquireStatus        AcquireNextFrame( uint32_t TimeoutMs, tagDuplicationFrameInfo* pRetFrameInfo ) = 0;
+        virtual void                    ReleaseFrame() = 0;
+    };
+
+    // struct tagAcquireResult_s
+    typedef struct tagAcquireResult_s
+    {
+        tagFrameReason                  Reason              = tagFrameReason_None;
+        tagDuplicationFrameInfo         FrameInfo;
+        uint32_t                        Attempts            = 0;    // AcquireNextFrame calls
+        uint32_t                        SkippedUpdates      = 0;    // pointer-only updates released while waiting
+
+        bool                            IsFrameHeld() const { return Reason == tagFrameReason_Fresh; }
+    } tagAcquireResult;
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// CFrameAcquirer
+    ///
+    /// Waits for a desktop present until an explicit deadline. The wait happens inside AcquireNextFrame,
+    /// there is no fixed sleep: the call returns as soon as a present arrives or the deadline passes.
+    /// On Fresh the frame is still held and the caller must ReleaseFrame() after copying it.
+
+    class CFrameAcquirer
+    {
+    public:
+        typedef std::function< AcquireClock::time_point() >  ClockFn;
+
+        explicit CFrameAcquirer( IDuplicationSource* pSource, ClockFn Clock = nullptr );
+
+        tagAcquireResult                Acquire( AcquireClock::time_point Deadline, bool HasCachedFrame );
+        tagAcquireResult                Acquire( std::chrono::milliseconds Timeout, bool HasCachedFrame );
+
+    private:
+        IDuplicationSource*             m_pSource;
+        ClockFn                         m_clock;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// CScriptedDuplicationSource
+    ///
+    /// Fake duplication driven by a script and a virtual clock, nothing here really sleeps.
+    /// Used by the synthetic backend to reproduce static screens, bursts and access-lost sequences.
+
+    class CScriptedDuplicationSource : public IDuplicationSource
+    {
+    public:
+        // enum tagScriptEvent_e
+        typedef enum tagScriptEvent_e : uint32_t
+        {
+            tagScriptEvent_Present      = 0x0,
+            tagScriptEvent_MouseOnly    = 0x1,
+            tagScriptEvent_AccessLost   = 0x2,
+            tagScriptEvent_Failed       = 0x3,
+            tagScriptEvent_Idle         = 0x4,      // quiet period, nothing is delivered
+        } tagScriptEvent;
+
+        // struct tagScriptStep_s : Event is delivered DelayMs after the previous step, Repeat times
+        typedef struct tagScriptStep_s
+        {
+            tagScriptEvent              Event;
+            uint32_t                    DelayMs;
+            uint32_t                    Repeat;
+        } tagScriptStep;
+
+        CScriptedDuplicationSource();
+
+        // after the script runs out the source behaves like a static desktop ( every wait times out )
+        void                            Push( tagScriptEvent Event, uint32_t DelayMs = 0, uint32_t Repeat = 1 );
+        void                            Clear();
+        bool                            IsScriptDone() const;
+
+        AcquireClock::time_point        Now() const;
+        void                            Advance( std::chrono::milliseconds Delta );
+        CFrameAcquirer::ClockFn         Clock();
+
+        uint64_t                        AcquireCalls() const { return m_acquireCalls; }
+        uint64_t                        ReleaseCalls() const { return m_releaseCalls; }
+        uint64_t                        Presents() const { return m_presents; }
+        bool                            IsFrameHeld() const { return m_isFrameHeld; }
+
+        tagAcquireStatus                AcquireNextFrame( uint32_t TimeoutMs, tagDuplicationFrameInfo* pRetFrameInfo ) override;
+        void                            ReleaseFrame() override;
+
+    private:
+        std::deque< tagScriptStep >     m_script;
+        uint32_t                        m_elapsedInStep;
+        AcquireClock::time_point        m_now;
+        bool                            m_isFrameHeld;
+        uint64_t                        m_acquireCalls;
+        uint64_t                        m_releaseCalls;
+        uint64_t                        m_presents;
+    };
+
+} // nsCapture
+
+#endif //FRAMEACQUIRER_HPP
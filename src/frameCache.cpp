@@ -0,0 +1,185 @@
+#include "frameCache.hpp"
+
+#include <cstring>
+
+namespace nsCapture
+{
+    tagFrameCacheStats_s& tagFrameCacheStats_s::operator+=( const tagFrameCacheStats_s& Rhs )
+    {
+        Hits                += Rhs.Hits;
+        Misses              += Rhs.Misses;
+        FullRefreshes       += Rhs.FullRefreshes;
+        PartialRefreshes    += Rhs.PartialRefreshes;
+        BytesCopied         += Rhs.BytesCopied;
+        BytesMoved          += Rhs.BytesMoved;
+        FullFrameBytes      += Rhs.FullFrameBytes;
+        DirectFrames        += Rhs.DirectFrames;
+        RenderedFrames      += Rhs.RenderedFrames;
+        OutputBytes         += Rhs.OutputBytes;
+        return *this;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// class CFrameCache
+    //
+
+    CFrameCache::CFrameCache()
+        : m_isValid( false ), m_serial( 0 ), m_presentTime( 0 )
+    {
+    }
+
+    void CFrameCache::Reset( const QSize& Size )
+    {
+        if( m_image.size() != Size )
+            m_image = QImage( Size, QImage::Format_ARGB32_Premultiplied );
+
+        Invalidate();
+    }
+
+    void CFrameCache::Invalidate()
+    {
+        m_isValid = false;
+        m_presentTime = 0;
+        m_engine.Detach();
+        m_verifiedAt = Clock::time_point();
+    }
+
+    bool CFrameCache::IsValid() const
+    {
+        return m_isValid && !m_image.isNull();
+    }
+
+    QSize CFrameCache::Size() const
+    {
+        return m_image.size();
+    }
+
+    const QImage& CFrameCache::Image() const
+    {
+        return m_image;
+    }
+
+    QImage& CFrameCache::MutableImage()
+    {
+        return m_image;
+    }
+
+    quint64 CFrameCache::Serial() const
+    {
+        return m_serial;
+    }
+
+    qint64 CFrameCache::PresentTime() const
+    {
+        return m_presentTime;
+    }
+
+    void CFrameCache::Store( const uchar* pBits, int Pitch, qint64 PresentTime )
+    {
+        if( pBits == nullptr || m_image.isNull() )
+            return;
+
+        const auto Before = m_engine.Stats();
+        m_engine.Attach( surface() );
+        m_engine.Store( pBits, Pitch );
+        record( Before, PresentTime, true );
+    }
+
+    std::vector< nsKernel::tagPixelRect > CFrameCache::Plan( const nsKernel::tagFrameDelta& Delta ) const
+    {
+        std::vector< nsKernel::tagPixelRect > Planned( Delta.Dirty );
+        nsKernel::CoalesceRects( &Planned, m_image.width(), m_image.height() );
+        return Planned;
+    }
+
+    void CFrameCache::Update( const nsKernel::tagFrameDelta& Delta, const std::vector< nsKernel::tagPixelRect >& Planned,
+                              const uchar* pBits, int Pitch, qint64 PresentTime )
+    {
+        if( pBits == nullptr || m_image.isNull() )
+            return;
+
+        // moves need the previous image, without one only a full copy is correct
+        if( !m_isValid )
+        {
+            Store( pBits, Pitch, PresentTime );
+            return;
+        }
+
+        const auto Before = m_engine.Stats();
+        m_engine.Attach( surface() );
+        m_engine.Apply( Delta, Planned, pBits, Pitch );
+        record( Before, PresentTime, false );
+    }
+
+    void CFrameCache::Commit( qint64 PresentTime, bool IsFull, quint64 BytesCopied )
+    {
+        if( IsFull )
+            ++m_stats.FullRefreshes;
+        else
+            ++m_stats.PartialRefreshes;
+
+        m_stats.BytesCopied += BytesCopied;
+        m_stats.FullFrameBytes += ( quint64 )m_image.sizeInBytes();
+        m_isValid = true;
+        m_presentTime = PresentTime;
+        ++m_serial;
+        MarkVerified();
+    }
+
+    const std::vector< nsKernel::tagPixelRect >& CFrameCache::ChangedRects() const
+    {
+        return m_engine.ChangedRects();
+    }
+
+    nsKernel::tagSurface CFrameCache::surface()
+    {
+        // bits() detaches when a snapshot is still referenced elsewhere, so attach right before every refresh
+        nsKernel::tagSurface Surface;
+        Surface.Bits    = m_image.bits();
+        Surface.Width   = m_image.width();
+        Surface.Height  = m_image.height();
+        Surface.Pitch   = m_image.bytesPerLine();
+        return Surface;
+    }
+
+    void CFrameCache::record( const nsKernel::tagIncrementalStats& Before, qint64 PresentTime, bool IsFull )
+    {
+        const auto& After = m_engine.Stats();
+        m_stats.BytesMoved += After.BytesMoved - Before.BytesMoved;
+        Commit( PresentTime, IsFull, After.BytesCopied - Before.BytesCopied );
+    }
+
+    void CFrameCache::MarkVerified()
+    {
+        m_verifiedAt = Clock::now();
+    }
+
+    bool CFrameCache::IsWithinStaleness( int MaxStalenessMs ) const
+    {
+        if( !IsValid() || MaxStalenessMs <= 0 )
+            return false;
+
+        return AgeUs() <= ( qint64 )MaxStalenessMs * 1000;
+    }
+
+    qint64 CFrameCache::AgeUs() const
+    {
+        return std::chrono::duration_cast< std::chrono::microseconds >( Clock::now() - m_verifiedAt ).count();
+    }
+
+    void CFrameCache::RecordHit()
+    {
+        ++m_stats.Hits;
+    }
+
+    void CFrameCache::RecordMiss()
+    {
+        ++m_stats.Misses;
+    }
+
+    const tagFrameCacheStats& CFrameCache::Stats() const
+    {
+        return m_stats;
+    }
+
+} // nsCapture
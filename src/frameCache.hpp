@@ -0,0 +1,94 @@
+#ifndef FRAMECACHE_HPP
+#define FRAMECACHE_HPP
+
+#include <QtCore>
+#include <QtGui>
+
+#include <chrono>
+
+#include "incrementalFrame.hpp"
+
+namespace nsCapture
+{
+    // struct tagFrameCacheStats_s
+    typedef struct tagFrameCacheStats_s
+    {
+        quint64                 Hits                = 0;    // served from memory, no newer present
+        quint64                 Misses              = 0;    // had to pull pixels from the source
+        quint64                 FullRefreshes       = 0;
+        quint64                 PartialRefreshes    = 0;
+        quint64                 BytesCopied         = 0;    // read from the source frame
+        quint64                 BytesMoved          = 0;    // move rects applied inside the cache
+        quint64                 FullFrameBytes      = 0;    // cost of copying every refresh in full
+        quint64                 DirectFrames        = 0;    // output images produced without a render target
+        quint64                 RenderedFrames      = 0;    // output images drawn through the render target ( scaling, letterbox )
+        quint64                 OutputBytes         = 0;    // copied after the cache to produce output images
+
+        tagFrameCacheStats_s&   operator+=( const tagFrameCacheStats_s& Rhs );
+    } tagFrameCacheStats;
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// CFrameCache
+    ///
+    /// Last known good desktop image of one output ( BGRA, source orientation, no cursor ).
+    /// Refreshed through nsKernel::CIncrementalFrame from the move / dirty rectangles of a newer present;
+    /// consumers get an implicitly shared snapshot, so a refresh never changes an image already handed out.
+    /// Not thread-safe, the owning session serializes access.
+
+    class CFrameCache
+    {
+    public:
+        typedef std::chrono::steady_clock   Clock;
+
+        CFrameCache();
+
+        // allocate for the output size, the cache is invalid until the first Store
+        void                            Reset( const QSize& Size );
+        void                            Invalidate();
+
+        bool                            IsValid() const;
+        QSize                           Size() const;
+        const QImage&                   Image() const;
+        QImage&                         MutableImage();
+        // changes whenever cached pixels change
+        quint64                         Serial() const;
+        qint64                          PresentTime() const;
+
+        // whole frame
+        void                            Store( const uchar* pBits, int Pitch, qint64 PresentTime );
+        // rects that Update() will read for Delta ( clipped, coalesced ), fetch at least these from the source
+        std::vector< nsKernel::tagPixelRect > Plan( const nsKernel::tagFrameDelta& Delta ) const;
+        // moves of Delta, then the Planned rects; pBits addresses the full source frame
+        void                            Update( const nsKernel::tagFrameDelta& Delta, const std::vector< nsKernel::tagPixelRect >& Planned,
+                                                const uchar* pBits, int Pitch, qint64 PresentTime );
+        // pixels were written through MutableImage()
+        void                            Commit( qint64 PresentTime, bool IsFull, quint64 BytesCopied );
+        // pixels changed by the last refresh, in image coordinates ( change detection )
+        const std::vector< nsKernel::tagPixelRect >& ChangedRects() const;
+
+        // the source was checked and has nothing newer than the cached image
+        void                            MarkVerified();
+        // true while the last check is not older than MaxStalenessMs
+        bool                            IsWithinStaleness( int MaxStalenessMs ) const;
+        qint64                          AgeUs() const;
+
+        void                            RecordHit();
+        void                            RecordMiss();
+        const tagFrameCacheStats&       Stats() const;
+
+    private:
+        nsKernel::tagSurface            surface();
+        void                            record( const nsKernel::tagIncrementalStats& Before, qint64 PresentTime, bool IsFull );
+
+        nsKernel::CIncrementalFrame     m_engine;
+        QImage                          m_image;
+        bool                            m_isValid;
+        quint64                         m_serial;
+        qint64                          m_presentTime;
+        Clock::time_point               m_verifiedAt;
+        tagFrameCacheStats              m_stats;
+    };
+
+} // nsCapture
+
+#endif //FRAMECACHE_HPP
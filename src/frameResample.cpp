@@ -0,0 +1,411 @@
+#include "frameResample.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define NSKERNEL_RESAMPLE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace nsKernel
+{
+    namespace
+    {
+        const uint32_t                  BYTES_PER_PIXEL         = 4;
+        // weights are 2.14 fixed point, a tap pair fits one _mm_madd_epi16 lane and a full sum stays well inside int32
+        const int32_t                   WEIGHT_BITS             = 14;
+        const int32_t                   WEIGHT_ONE              = 1 << WEIGHT_BITS;
+        const int32_t                   WEIGHT_ROUND            = 1 << ( WEIGHT_BITS - 1 );
+        // below this many output rows per worker a thread costs more than it saves
+        const int32_t                   MIN_ROWS_PER_WORKER     = 16;
+        // source and target both under this many pixels stay on the calling thread
+        const int64_t                   MIN_PARALLEL_PIXELS     = 512 * 512;
+        const double                    PI                      = 3.14159265358979323846;
+
+        // struct tagAxis_s : contributors of every visible output index along one axis
+        typedef struct tagAxis_s
+        {
+            std::vector< int32_t >      Start;              // first source index
+            std::vector< int32_t >      Count;              // taps
+            std::vector< size_t >       Offset;             // into Weights
+            std::vector< int16_t >      Weights;            // sum to WEIGHT_ONE per output index
+        } tagAxis;
+
+        double filterSupport( tagResampleFilter Filter )
+        {
+            switch( Filter )
+            {
+                case tagResampleFilter_Box:         return 0.5;
+                case tagResampleFilter_Lanczos3:    return 3.0;
+                default:                            return 1.0;
+            }
+        }
+
+        double sinc( double X )
+        {
+            if( X == 0.0 )
+                return 1.0;
+            X *= PI;
+            return std::sin( X ) / X;
+        }
+
+        double filterWeight( tagResampleFilter Filter, double X )
+        {
+            switch( Filter )
+            {
+                case tagResampleFilter_Box:
+                    return ( X >= -0.5 && X < 0.5 ) ? 1.0 : 0.0;
+                case tagResampleFilter_Lanczos3:
+                    return ( X > -3.0 && X < 3.0 ) ? sinc( X ) * sinc( X / 3.0 ) : 0.0;
+                default:
+                    X = std::fabs( X );
+                    return X < 1.0 ? 1.0 - X : 0.0;
+            }
+        }
+
+        // output indices [ Begin, End ) of a TargetSize long run covering SrcSize source pixels
+        void buildAxis( int32_t SrcSize, int32_t TargetSize, int32_t Begin, int32_t End, tagResampleFilter Filter, tagAxis* pRetAxis )
+        {
+            const double Ratio = ( double )SrcSize / TargetSize;
+            // on downscales the filter is stretched over the source, every source pixel lands in some output
+            const double FilterScale = std::max( 1.0, Ratio );
+            const double Support = filterSupport( Filter ) * FilterScale;
+
+            const size_t OutCount = ( size_t )( End - Begin );
+            pRetAxis->Start.resize( OutCount );
+            pRetAxis->Count.resize( OutCount );
+            pRetAxis->Offset.resize( OutCount );
+            pRetAxis->Weights.clear();
+            pRetAxis->Weights.reserve( OutCount * ( size_t )( std::ceil( Support ) * 2 + 1 ) );
+
+            std::vector< double > Taps;
+            std::vector< int32_t > Fixed;
+
+            for( int32_t i = Begin; i < End; ++i )
+            {
+                const double Center = ( i + 0.5 ) * Ratio;
+                int32_t First = std::max( 0, ( int32_t )std::floor( Center - Support + 0.5 ) );
+                int32_t Last  = std::min( SrcSize, ( int32_t )std::floor( Center + Support + 0.5 ) );
+
+                Taps.clear();
+                double Total = 0.0;
+                for( int32_t x = First; x < Last; ++x )
+                {
+                    const double Weight = filterWeight( Filter, ( x + 0.5 - Center ) / FilterScale );
+                    Taps.push_back( Weight );
+                    Total += Weight;
+                }
+
+                // trim zero taps at both ends ( box edges, triangle end points )
+                size_t Lo = 0, Hi = Taps.size();
+                while( Lo < Hi && Taps[ Lo ] == 0.0 )
+                    ++Lo;
+                while( Hi > Lo && Taps[ Hi - 1 ] == 0.0 )
+                    --Hi;
+
+                if( Lo == Hi || Total == 0.0 )
+                {
+                    // degenerate : nearest source pixel
+                    First = std::min( SrcSize - 1, std::max( 0, ( int32_t )Center ) );
+                    Taps.assign( 1, 1.0 );
+                    Total = 1.0;
+                    Lo = 0;
+                    Hi = 1;
+                }
+                else
+                {
+                    First += ( int32_t )Lo;
+                }
+
+                // round to fixed point, the rounding error goes to the largest tap so the sum is exactly WEIGHT_ONE
+                Fixed.clear();
+                int32_t Sum = 0;
+                size_t Largest = 0;
+                for( size_t k = Lo; k < Hi; ++k )
+                {
+                    const int32_t Weight = ( int32_t )std::lround( Taps[ k ] / Total * WEIGHT_ONE );
+                    if( std::fabs( Taps[ k ] ) > std::fabs( Taps[ Lo + Largest ] ) )
+                        Largest = k - Lo;
+                    Fixed.push_back( Weight );
+                    Sum += Weight;
+                }
+                Fixed[ Largest ] += WEIGHT_ONE - Sum;
+
+                const size_t Index = ( size_t )( i - Begin );
+                pRetAxis->Start[ Index ]  = First;
+                pRetAxis->Count[ Index ]  = ( int32_t )Fixed.size();
+                pRetAxis->Offset[ Index ] = pRetAxis->Weights.size();
+                for( const auto Weight : Fixed )
+                    pRetAxis->Weights.push_back( ( int16_t )Weight );
+            }
+        }
+
+        inline uint8_t toByte( int32_t Acc )
+        {
+            Acc >>= WEIGHT_BITS;
+            return ( uint8_t )( Acc < 0 ? 0 : ( Acc > 255 ? 255 : Acc ) );
+        }
+
+        // Lanczos lobes can push a colour above its alpha, which is not a valid premultiplied pixel
+        inline void clampPremultiplied( uint8_t* pPixel )
+        {
+            for( int c = 0; c < 3; ++c )
+                pPixel[ c ] = std::min( pPixel[ c ], pPixel[ 3 ] );
+        }
+
+        void horizontalPixel( uint8_t* pDst, const uint8_t* pSrc, const int16_t* pWeights, int32_t Count )
+        {
+            int32_t Acc[ 4 ] = { WEIGHT_ROUND, WEIGHT_ROUND, WEIGHT_ROUND, WEIGHT_ROUND };
+            for( int32_t k = 0; k < Count; ++k )
+            {
+                for( int c = 0; c < 4; ++c )
+                    Acc[ c ] += pWeights[ k ] * pSrc[ k * BYTES_PER_PIXEL + c ];
+            }
+            for( int c = 0; c < 4; ++c )
+                pDst[ c ] = toByte( Acc[ c ] );
+        }
+
+        void verticalPixel( uint8_t* pDst, const uint8_t* pSrc, ptrdiff_t SrcPitch, const int16_t* pWeights, int32_t Count, bool IsClamped )
+        {
+            int32_t Acc[ 4 ] = { WEIGHT_ROUND, WEIGHT_ROUND, WEIGHT_ROUND, WEIGHT_ROUND };
+            for( int32_t k = 0; k < Count; ++k )
+            {
+                for( int c = 0; c < 4; ++c )
+                    Acc[ c ] += pWeights[ k ] * pSrc[ k * SrcPitch + c ];
+            }
+            for( int c = 0; c < 4; ++c )
+                pDst[ c ] = toByte( Acc[ c ] );
+            if( IsClamped )
+                clampPremultiplied( pDst );
+        }
+
+#ifdef NSKERNEL_RESAMPLE_SSE2
+        // ( w0, w1 ) in every 32 bit lane, pairs up with interleaved channels of two taps
+        inline __m128i pairWeights( int16_t W0, int16_t W1 )
+        {
+            return _mm_set1_epi32( ( int32_t )( ( uint32_t )( uint16_t )W0 | ( ( uint32_t )( uint16_t )W1 << 16 ) ) );
+        }
+
+        inline __m128i load32( const uint8_t* p )
+        {
+            int32_t Value;
+            memcpy( &Value, p, sizeof( Value ) );
+            return _mm_cvtsi32_si128( Value );
+        }
+
+        // four 32 bit sums to 8 bit channels, same saturation as toByte
+        inline __m128i packSums( __m128i Lo, __m128i Hi )
+        {
+            const __m128i Words = _mm_packs_epi32( _mm_srai_epi32( Lo, WEIGHT_BITS ), _mm_srai_epi32( Hi, WEIGHT_BITS ) );
+            return _mm_packus_epi16( Words, Words );
+        }
+
+        inline __m128i clampPremultiplied4( __m128i Pixels )
+        {
+            __m128i Alpha = _mm_srli_epi32( Pixels, 24 );
+            Alpha = _mm_or_si128( Alpha, _mm_slli_epi32( Alpha, 8 ) );
+            Alpha = _mm_or_si128( Alpha, _mm_slli_epi32( Alpha, 16 ) );
+            return _mm_min_epu8( Pixels, Alpha );
+        }
+#endif
+
+        void horizontalRow( uint8_t* pDst, const uint8_t* pSrc, const tagAxis& Axis, bool IsScalar )
+        {
+            const size_t Width = Axis.Start.size();
+
+            for( size_t i = 0; i < Width; ++i )
+            {
+                const uint8_t* pTaps = pSrc + ( size_t )Axis.Start[ i ] * BYTES_PER_PIXEL;
+                const int16_t* pWeights = Axis.Weights.data() + Axis.Offset[ i ];
+                const int32_t Count = Axis.Count[ i ];
+
+#ifdef NSKERNEL_RESAMPLE_SSE2
+                if( !IsScalar )
+                {
+                    const __m128i Zero = _mm_setzero_si128();
+                    __m128i Acc = _mm_set1_epi32( WEIGHT_ROUND );
+                    int32_t k = 0;
+
+                    for( ; k + 2 <= Count; k += 2 )
+                    {
+                        // b0 g0 r0 a0 b1 g1 r1 a1 -> b0 b1 g0 g1 r0 r1 a0 a1, one madd lane per channel
+                        const __m128i Pixels = _mm_unpacklo_epi8( _mm_loadl_epi64( reinterpret_cast< const __m128i* >( pTaps + k * BYTES_PER_PIXEL ) ), Zero );
+                        const __m128i Pairs = _mm_unpacklo_epi16( Pixels, _mm_srli_si128( Pixels, 8 ) );
+                        Acc = _mm_add_epi32( Acc, _mm_madd_epi16( Pairs, pairWeights( pWeights[ k ], pWeights[ k + 1 ] ) ) );
+                    }
+                    if( k < Count )
+                    {
+                        const __m128i Pixel = _mm_unpacklo_epi16( _mm_unpacklo_epi8( load32( pTaps + k * BYTES_PER_PIXEL ), Zero ), Zero );
+                        Acc = _mm_add_epi32( Acc, _mm_madd_epi16( Pixel, pairWeights( pWeights[ k ], 0 ) ) );
+                    }
+
+                    const int32_t Value = _mm_cvtsi128_si32( packSums( Acc, Acc ) );
+                    memcpy( pDst + i * BYTES_PER_PIXEL, &Value, sizeof( Value ) );
+                    continue;
+                }
+#endif
+                horizontalPixel( pDst + i * BYTES_PER_PIXEL, pTaps, pWeights, Count );
+            }
+        }
+
+        // pSrc points at the first contributing row
+        void verticalRow( uint8_t* pDst, const uint8_t* pSrc, ptrdiff_t SrcPitch, int32_t Width, const int16_t* pWeights, int32_t Count, bool IsClamped, bool IsScalar )
+        {
+            int32_t x = 0;
+
+#ifdef NSKERNEL_RESAMPLE_SSE2
+            if( !IsScalar )
+            {
+                const __m128i Zero = _mm_setzero_si128();
+
+                for( ; x + 4 <= Width; x += 4 )
+                {
+                    __m128i Acc0 = _mm_set1_epi32( WEIGHT_ROUND ), Acc1 = Acc0, Acc2 = Acc0, Acc3 = Acc0;
+                    const uint8_t* pColumn = pSrc + ( size_t )x * BYTES_PER_PIXEL;
+
+                    for( int32_t k = 0; k < Count; k += 2 )
+                    {
+                        const bool IsPair = k + 1 < Count;
+                        const __m128i Row0 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pColumn + k * SrcPitch ) );
+                        const __m128i Row1 = IsPair ? _mm_loadu_si128( reinterpret_cast< const __m128i* >( pColumn + ( k + 1 ) * SrcPitch ) ) : Zero;
+                        const __m128i Weights = pairWeights( pWeights[ k ], IsPair ? pWeights[ k + 1 ] : 0 );
+
+                        // channels of the two rows side by side, pixels 0 1 in Lo, 2 3 in Hi
+                        const __m128i Lo = _mm_unpacklo_epi8( Row0, Row1 );
+                        const __m128i Hi = _mm_unpackhi_epi8( Row0, Row1 );
+                        Acc0 = _mm_add_epi32( Acc0, _mm_madd_epi16( _mm_unpacklo_epi8( Lo, Zero ), Weights ) );
+                        Acc1 = _mm_add_epi32( Acc1, _mm_madd_epi16( _mm_unpackhi_epi8( Lo, Zero ), Weights ) );
+                        Acc2 = _mm_add_epi32( Acc2, _mm_madd_epi16( _mm_unpacklo_epi8( Hi, Zero ), Weights ) );
+                        Acc3 = _mm_add_epi32( Acc3, _mm_madd_epi16( _mm_unpackhi_epi8( Hi, Zero ), Weights ) );
+                    }
+
+                    const __m128i Words01 = _mm_packs_epi32( _mm_srai_epi32( Acc0, WEIGHT_BITS ), _mm_srai_epi32( Acc1, WEIGHT_BITS ) );
+                    const __m128i Words23 = _mm_packs_epi32( _mm_srai_epi32( Acc2, WEIGHT_BITS ), _mm_srai_epi32( Acc3, WEIGHT_BITS ) );
+                    __m128i Pixels = _mm_packus_epi16( Words01, Words23 );
+                    if( IsClamped )
+                        Pixels = clampPremultiplied4( Pixels );
+                    _mm_storeu_si128( reinterpret_cast< __m128i* >( pDst + ( size_t )x * BYTES_PER_PIXEL ), Pixels );
+                }
+            }
+#endif
+            for( ; x < Width; ++x )
+                verticalPixel( pDst + ( size_t )x * BYTES_PER_PIXEL, pSrc + ( size_t )x * BYTES_PER_PIXEL, SrcPitch, pWeights, Count, IsClamped );
+        }
+
+        // struct tagJob_s : one resample call, shared read-only by the workers
+        typedef struct tagJob_s
+        {
+            tagSurface                  Dst;
+            tagSurface                  Src;
+            tagPixelRect                Visible;            // Dst pixels written
+            tagAxis                     Horz;
+            tagAxis                     Vert;
+            bool                        IsClamped;
+            bool                        IsScalar;
+        } tagJob;
+
+        // visible rows [ RowBegin, RowEnd ), relative to Visible.Top
+        void resampleRows( const tagJob& Job, int32_t RowBegin, int32_t RowEnd )
+        {
+            if( RowBegin >= RowEnd )
+                return;
+
+            // source rows this band reads, filtered horizontally once into a private buffer
+            int32_t SrcTop = Job.Vert.Start[ RowBegin ];
+            int32_t SrcBottom = SrcTop;
+            for( int32_t i = RowBegin; i < RowEnd; ++i )
+            {
+                SrcTop = std::min( SrcTop, Job.Vert.Start[ i ] );
+                SrcBottom = std::max( SrcBottom, Job.Vert.Start[ i ] + Job.Vert.Count[ i ] );
+            }
+
+            const int32_t Width = Job.Visible.Width();
+            const ptrdiff_t TempPitch = ( ptrdiff_t )Width * BYTES_PER_PIXEL;
+            std::vector< uint8_t > Temp( ( size_t )( SrcBottom - SrcTop ) * ( size_t )TempPitch );
+
+            for( int32_t y = SrcTop; y < SrcBottom; ++y )
+                horizontalRow( Temp.data() + ( y - SrcTop ) * TempPitch, Job.Src.Bits + y * Job.Src.Pitch, Job.Horz, Job.IsScalar );
+
+            for( int32_t i = RowBegin; i < RowEnd; ++i )
+            {
+                uint8_t* pDst = Job.Dst.Bits + ( Job.Visible.Top + i ) * Job.Dst.Pitch + ( ptrdiff_t )Job.Visible.Left * BYTES_PER_PIXEL;
+                const uint8_t* pSrc = Temp.data() + ( Job.Vert.Start[ i ] - SrcTop ) * TempPitch;
+                verticalRow( pDst, pSrc, TempPitch, Width, Job.Vert.Weights.data() + Job.Vert.Offset[ i ], Job.Vert.Count[ i ], Job.IsClamped, Job.IsScalar );
+            }
+        }
+
+        bool prepareJob( const tagSurface& Dst, const tagPixelRect& Target, const tagSurface& Src, tagResampleFilter Filter, bool IsScalar, tagJob* pRetJob )
+        {
+            if( Dst.Bits == nullptr || Src.Bits == nullptr || Dst.Bits == Src.Bits )
+                return false;
+            if( Src.Width <= 0 || Src.Height <= 0 || Target.IsEmpty() )
+                return false;
+
+            pRetJob->Dst = Dst;
+            pRetJob->Src = Src;
+            pRetJob->Visible.Left   = std::max( Target.Left, 0 );
+            pRetJob->Visible.Top    = std::max( Target.Top, 0 );
+            pRetJob->Visible.Right  = std::min( Target.Right, Dst.Width );
+            pRetJob->Visible.Bottom = std::min( Target.Bottom, Dst.Height );
+            if( pRetJob->Visible.IsEmpty() )
+                return true;
+
+            if( Filter == tagResampleFilter_Auto )
+                Filter = ChooseResampleFilter( Src.Width, Src.Height, Target.Width(), Target.Height() );
+
+            buildAxis( Src.Width, Target.Width(), pRetJob->Visible.Left - Target.Left, pRetJob->Visible.Right - Target.Left, Filter, &pRetJob->Horz );
+            buildAxis( Src.Height, Target.Height(), pRetJob->Visible.Top - Target.Top, pRetJob->Visible.Bottom - Target.Top, Filter, &pRetJob->Vert );
+            pRetJob->IsClamped = Filter == tagResampleFilter_Lanczos3;
+            pRetJob->IsScalar = IsScalar;
+            return true;
+        }
+    }
+
+    tagResampleFilter ChooseResampleFilter( int32_t SrcWidth, int32_t SrcHeight, int32_t DstWidth, int32_t DstHeight )
+    {
+        if( SrcWidth >= DstWidth * 2 && SrcHeight >= DstHeight * 2 )
+            return tagResampleFilter_Box;
+        return tagResampleFilter_Bilinear;
+    }
+
+    bool ResampleSurface( const tagSurface& Dst, const tagPixelRect& Target, const tagSurface& Src, tagResampleFilter Filter, uint32_t Threads )
+    {
+        tagJob Job;
+        if( !prepareJob( Dst, Target, Src, Filter, false, &Job ) )
+            return false;
+        if( Job.Visible.IsEmpty() )
+            return true;
+
+        const int32_t Rows = Job.Visible.Height();
+        int32_t Workers = ( int32_t )( Threads != 0 ? Threads : std::thread::hardware_concurrency() );
+        Workers = std::max( 1, std::min( Workers, Rows / MIN_ROWS_PER_WORKER ) );
+        if( ( int64_t )Src.Width * Src.Height < MIN_PARALLEL_PIXELS && Job.Visible.Area() < MIN_PARALLEL_PIXELS )
+            Workers = 1;
+
+        // bands of output rows, each worker filters the source rows it needs on its own ( a few shared rows at the seams )
+        std::vector< std::thread > Pool;
+        for( int32_t w = 1; w < Workers; ++w )
+            Pool.emplace_back( resampleRows, std::cref( Job ), ( int32_t )( ( int64_t )Rows * w / Workers ), ( int32_t )( ( int64_t )Rows * ( w + 1 ) / Workers ) );
+
+        resampleRows( Job, 0, ( int32_t )( Rows / Workers ) );
+
+        for( auto& Worker : Pool )
+            Worker.join();
+
+        return true;
+    }
+
+    bool ResampleSurfaceReference( const tagSurface& Dst, const tagPixelRect& Target, const tagSurface& Src, tagResampleFilter Filter )
+    {
+        tagJob Job;
+        if( !prepareJob( Dst, Target, Src, Filter, true, &Job ) )
+            return false;
+
+        resampleRows( Job, 0, Job.Visible.Height() );
+        return true;
+    }
+
+} // nsKernel
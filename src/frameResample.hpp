@@ -0,0 +1,29 @@
+#ifndef FRAMERESAMPLE_HPP
+#define FRAMERESAMPLE_HPP
+
+#include "incrementalFrame.hpp"
+
+namespace nsKernel
+{
+    // enum tagResampleFilter_e : separable filters, widened by the scale factor on downscales
+    typedef enum tagResampleFilter_e
+    {
+        tagResampleFilter_Auto      = 0,    // ChooseResampleFilter
+        tagResampleFilter_Bilinear,         // triangle, the D2D LINEAR look for moderate scales
+        tagResampleFilter_Box,              // area average, half the taps of Bilinear on large downscales
+        tagResampleFilter_Lanczos3          // sharpest, rings on hard edges
+    } tagResampleFilter;
+
+    // Box from a 2x downscale on ( either axis ), Bilinear otherwise
+    tagResampleFilter                   ChooseResampleFilter( int32_t SrcWidth, int32_t SrcHeight, int32_t DstWidth, int32_t DstHeight );
+
+    // scale all of Src onto Target, given in Dst coordinates; Target may reach outside Dst, only the visible part is written
+    // 32bpp premultiplied, 14 bit fixed point weights, horizontal pass then vertical pass, SSE2 where available
+    // output rows are split over Threads workers ( 0 = hardware concurrency ), small targets stay on the calling thread
+    bool                                ResampleSurface( const tagSurface& Dst, const tagPixelRect& Target, const tagSurface& Src, tagResampleFilter Filter, uint32_t Threads = 0 );
+    // same weights, scalar and single threaded, reference for verification
+    bool                                ResampleSurfaceReference( const tagSurface& Dst, const tagPixelRect& Target, const tagSurface& Src, tagResampleFilter Filter );
+
+} // nsKernel
+
+#endif //FRAMERESAMPLE_HPP
@@ -0,0 +1,209 @@
+#include "frameRotate.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define NSKERNEL_ROTATE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace nsKernel
+{
+    namespace
+    {
+        const uint32_t                  BYTES_PER_PIXEL         = 4;
+        // 64 x 64 pixels : one source and one destination tile ( 16 KB each ) stay in L1 / L2 while a tile is transposed,
+        // a straight column walk of a portrait 4K frame would touch a new cache line ( and page ) per pixel
+        const int32_t                   ROTATE_TILE             = 64;
+
+        inline uint32_t* pixelAt( const tagSurface& Surface, int32_t X, int32_t Y )
+        {
+            return reinterpret_cast< uint32_t* >( Surface.Bits + Y * Surface.Pitch + ( ptrdiff_t )X * BYTES_PER_PIXEL );
+        }
+
+        // destination of source pixel ( X, Y )
+        inline uint32_t* mapPixel( const tagSurface& Dst, const tagSurface& Src, tagRotation Rotation, int32_t X, int32_t Y )
+        {
+            switch( Rotation )
+            {
+                case tagRotation_90:    return pixelAt( Dst, Src.Height - 1 - Y, X );
+                case tagRotation_180:   return pixelAt( Dst, Src.Width - 1 - X, Src.Height - 1 - Y );
+                case tagRotation_270:   return pixelAt( Dst, Y, Src.Width - 1 - X );
+                default:                return pixelAt( Dst, X, Y );
+            }
+        }
+
+        bool isValidPair( const tagSurface& Dst, const tagSurface& Src, tagRotation Rotation )
+        {
+            if( Dst.Bits == nullptr || Src.Bits == nullptr || Dst.Bits == Src.Bits )
+                return false;
+            if( Rotation == tagRotation_Invalid || Src.Width <= 0 || Src.Height <= 0 )
+                return false;
+
+            int32_t Width = 0, Height = 0;
+            RotatedSize( Rotation, Src.Width, Src.Height, &Width, &Height );
+            return Dst.Width == Width && Dst.Height == Height;
+        }
+
+        // 4x4 block at pSrc, column j of the block becomes the row at pDst + j * DstStep ( reversed with IsReversed )
+        inline void transposeBlock( const uint8_t* pSrc, ptrdiff_t SrcPitch, uint8_t* pDst, ptrdiff_t DstStep, bool IsReversed )
+        {
+#ifdef NSKERNEL_ROTATE_SSE2
+            const __m128i R0 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pSrc ) );
+            const __m128i R1 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pSrc + SrcPitch ) );
+            const __m128i R2 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pSrc + SrcPitch * 2 ) );
+            const __m128i R3 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pSrc + SrcPitch * 3 ) );
+
+            const __m128i T0 = _mm_unpacklo_epi32( R0, R1 );
+            const __m128i T1 = _mm_unpacklo_epi32( R2, R3 );
+            const __m128i T2 = _mm_unpackhi_epi32( R0, R1 );
+            const __m128i T3 = _mm_unpackhi_epi32( R2, R3 );
+
+            __m128i C[ 4 ] = {
+                _mm_unpacklo_epi64( T0, T1 ),
+                _mm_unpackhi_epi64( T0, T1 ),
+                _mm_unpacklo_epi64( T2, T3 ),
+                _mm_unpackhi_epi64( T2, T3 )
+            };
+
+            for( int j = 0; j < 4; ++j )
+            {
+                if( IsReversed )
+                    C[ j ] = _mm_shuffle_epi32( C[ j ], _MM_SHUFFLE( 0, 1, 2, 3 ) );
+                _mm_storeu_si128( reinterpret_cast< __m128i* >( pDst + DstStep * j ), C[ j ] );
+            }
+#else
+            for( int j = 0; j < 4; ++j )
+            {
+                auto Line = reinterpret_cast< uint32_t* >( pDst + DstStep * j );
+                for( int k = 0; k < 4; ++k )
+                {
+                    uint32_t Pixel;
+                    memcpy( &Pixel, pSrc + SrcPitch * k + j * BYTES_PER_PIXEL, sizeof( Pixel ) );
+                    Line[ IsReversed ? 3 - k : k ] = Pixel;
+                }
+            }
+#endif
+        }
+
+        void rotateQuarter( const tagSurface& Dst, const tagSurface& Src, tagRotation Rotation )
+        {
+            const bool IsClockwise = Rotation == tagRotation_90;
+
+            for( int32_t TileY = 0; TileY < Src.Height; TileY += ROTATE_TILE )
+            {
+                const int32_t EndY = std::min( TileY + ROTATE_TILE, Src.Height );
+                const int32_t BlockEndY = TileY + ( ( EndY - TileY ) & ~3 );
+
+                for( int32_t TileX = 0; TileX < Src.Width; TileX += ROTATE_TILE )
+                {
+                    const int32_t EndX = std::min( TileX + ROTATE_TILE, Src.Width );
+                    const int32_t BlockEndX = TileX + ( ( EndX - TileX ) & ~3 );
+
+                    // source columns outside : every destination row of the tile is written front to back
+                    for( int32_t x = TileX; x < BlockEndX; x += 4 )
+                    {
+                        for( int32_t y = TileY; y < BlockEndY; y += 4 )
+                        {
+                            const uint8_t* pSrc = Src.Bits + y * Src.Pitch + ( ptrdiff_t )x * BYTES_PER_PIXEL;
+
+                            // 90 : source column x + j is destination row x + j, read bottom-up
+                            // 270 : source column x + j is destination row Width - 1 - x - j, read top-down
+                            if( IsClockwise )
+                                transposeBlock( pSrc, Src.Pitch, reinterpret_cast< uint8_t* >( pixelAt( Dst, Src.Height - 4 - y, x ) ), Dst.Pitch, true );
+                            else
+                                transposeBlock( pSrc, Src.Pitch, reinterpret_cast< uint8_t* >( pixelAt( Dst, y, Src.Width - 1 - x ) ), -Dst.Pitch, false );
+                        }
+                    }
+
+                    // ragged right / bottom edges of the tile
+                    for( int32_t y = TileY; y < EndY; ++y )
+                    {
+                        for( int32_t x = y < BlockEndY ? BlockEndX : TileX; x < EndX; ++x )
+                            *mapPixel( Dst, Src, Rotation, x, y ) = *pixelAt( Src, x, y );
+                    }
+                }
+            }
+        }
+
+        void rotateHalf( const tagSurface& Dst, const tagSurface& Src )
+        {
+            // rows stream in order, only the pixels within a row are reversed
+            for( int32_t y = 0; y < Src.Height; ++y )
+            {
+                const uint32_t* pSrc = pixelAt( Src, 0, y );
+                uint32_t* pDst = pixelAt( Dst, 0, Src.Height - 1 - y );
+                int32_t x = 0;
+
+#ifdef NSKERNEL_ROTATE_SSE2
+                for( ; x + 4 <= Src.Width; x += 4 )
+                {
+                    const __m128i Pixels = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pSrc + x ) );
+                    _mm_storeu_si128( reinterpret_cast< __m128i* >( pDst + Src.Width - 4 - x ), _mm_shuffle_epi32( Pixels, _MM_SHUFFLE( 0, 1, 2, 3 ) ) );
+                }
+#endif
+                for( ; x < Src.Width; ++x )
+                    pDst[ Src.Width - 1 - x ] = pSrc[ x ];
+            }
+        }
+    }
+
+    tagRotation RotationFromDegrees( float Degrees )
+    {
+        const float Turns = Degrees / 90.0f;
+        const float Rounded = std::round( Turns );
+        if( std::fabs( Turns - Rounded ) > 1e-4f )
+            return tagRotation_Invalid;
+
+        const int Quarter = ( ( int )Rounded % 4 + 4 ) % 4;
+        return ( tagRotation )Quarter;
+    }
+
+    void RotatedSize( tagRotation Rotation, int32_t Width, int32_t Height, int32_t* pRetWidth, int32_t* pRetHeight )
+    {
+        const bool IsSwapped = Rotation == tagRotation_90 || Rotation == tagRotation_270;
+        if( pRetWidth != nullptr )
+            *pRetWidth = IsSwapped ? Height : Width;
+        if( pRetHeight != nullptr )
+            *pRetHeight = IsSwapped ? Width : Height;
+    }
+
+    bool RotateSurface( const tagSurface& Dst, const tagSurface& Src, tagRotation Rotation )
+    {
+        if( !isValidPair( Dst, Src, Rotation ) )
+            return false;
+
+        switch( Rotation )
+        {
+            case tagRotation_0:
+                for( int32_t y = 0; y < Src.Height; ++y )
+                    memcpy( Dst.Bits + y * Dst.Pitch, Src.Bits + y * Src.Pitch, ( size_t )Src.Width * BYTES_PER_PIXEL );
+                break;
+            case tagRotation_180:
+                rotateHalf( Dst, Src );
+                break;
+            default:
+                rotateQuarter( Dst, Src, Rotation );
+                break;
+        }
+
+        return true;
+    }
+
+    bool RotateSurfaceReference( const tagSurface& Dst, const tagSurface& Src, tagRotation Rotation )
+    {
+        if( !isValidPair( Dst, Src, Rotation ) )
+            return false;
+
+        for( int32_t y = 0; y < Src.Height; ++y )
+        {
+            for( int32_t x = 0; x < Src.Width; ++x )
+                *mapPixel( Dst, Src, Rotation, x, y ) = *pixelAt( Src, x, y );
+        }
+
+        return true;
+    }
+
+} // nsKernel
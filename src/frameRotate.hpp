@@ -0,0 +1,31 @@
+#ifndef FRAMEROTATE_HPP
+#define FRAMEROTATE_HPP
+
+#include "incrementalFrame.hpp"
+
+namespace nsKernel
+{
+    // enum tagRotation_e : clockwise quarter turns, same direction as D2D1::Matrix3x2F::Rotation
+    typedef enum tagRotation_e
+    {
+        tagRotation_Invalid = -1,
+        tagRotation_0       = 0,
+        tagRotation_90,
+        tagRotation_180,
+        tagRotation_270
+    } tagRotation;
+
+    // 0 / 90 / 180 / 270 ( any multiple of 90 ), everything else is tagRotation_Invalid
+    tagRotation                         RotationFromDegrees( float Degrees );
+    // size of a Width x Height surface after Rotation
+    void                                RotatedSize( tagRotation Rotation, int32_t Width, int32_t Height, int32_t* pRetWidth, int32_t* pRetHeight );
+
+    // rotate 32bpp Src into Dst, Dst must have the rotated size and must not alias Src
+    // quarter turns walk the surfaces in cache sized tiles of 4x4 in-register transposes
+    bool                                RotateSurface( const tagSurface& Dst, const tagSurface& Src, tagRotation Rotation );
+    // one pixel at a time, reference for verification
+    bool                                RotateSurfaceReference( const tagSurface& Dst, const tagSurface& Src, tagRotation Rotation );
+
+} // nsKernel
+
+#endif //FRAMEROTATE_HPP
@@ -0,0 +1,137 @@
+#include "globalHotkey.hpp"
+
+#ifdef Q_OS_WIN
+#include <Windows.h>
+#endif
+
+namespace
+{
+    // RegisterHotKey 식별자, 응용 프로그램 범위 0x0000 ~ 0xBFFF
+    int nextHotkeyId()
+    {
+        static QAtomicInt NextId( 0x5300 );
+        return NextId.fetchAndAddRelaxed( 1 );
+    }
+
+#ifdef Q_OS_WIN
+    UINT toVirtualKey( Qt::Key Key )
+    {
+        if( ( Key >= Qt::Key_A && Key <= Qt::Key_Z ) || ( Key >= Qt::Key_0 && Key <= Qt::Key_9 ) )
+            return ( UINT )Key;
+
+        if( Key >= Qt::Key_F1 && Key <= Qt::Key_F24 )
+            return VK_F1 + ( UINT )( Key - Qt::Key_F1 );
+
+        switch( Key )
+        {
+            case Qt::Key_Print:         return VK_SNAPSHOT;
+            case Qt::Key_Pause:         return VK_PAUSE;
+            case Qt::Key_Insert:        return VK_INSERT;
+            case Qt::Key_Delete:        return VK_DELETE;
+            case Qt::Key_Home:          return VK_HOME;
+            case Qt::Key_End:           return VK_END;
+            case Qt::Key_PageUp:        return VK_PRIOR;
+            case Qt::Key_PageDown:      return VK_NEXT;
+            case Qt::Key_Space:         return VK_SPACE;
+            case Qt::Key_Escape:        return VK_ESCAPE;
+            case Qt::Key_ScrollLock:    return VK_SCROLL;
+            default:                    return 0;
+        }
+    }
+#endif
+}
+
+QGlobalHotkey::QGlobalHotkey( QObject* Parent )
+    : QObject( Parent ), hotkeyId( nextHotkeyId() ), isRegistered( false )
+{
+    QCoreApplication::instance()->installNativeEventFilter( this );
+}
+
+QGlobalHotkey::~QGlobalHotkey()
+{
+    Unregister();
+
+    if( QCoreApplication::instance() != nullptr )
+        QCoreApplication::instance()->removeNativeEventFilter( this );
+}
+
+bool QGlobalHotkey::Register( const QKeySequence& Sequence )
+{
+    Unregister();
+    sequence = Sequence;
+
+    if( Sequence.isEmpty() )
+        return false;
+
+#ifdef Q_OS_WIN
+    const auto Combination = Sequence[ 0 ];
+    const auto Modifiers = Combination.keyboardModifiers();
+    const UINT VirtualKey = toVirtualKey( Combination.key() );
+    if( VirtualKey == 0 )
+    {
+        qWarning() << "[HOTKEY] unsupported key" << Sequence.toString();
+        return false;
+    }
+
+    UINT Mods = MOD_NOREPEAT;
+    if( Modifiers & Qt::ControlModifier )
+        Mods |= MOD_CONTROL;
+    if( Modifiers & Qt::ShiftModifier )
+        Mods |= MOD_SHIFT;
+    if( Modifiers & Qt::AltModifier )
+        Mods |= MOD_ALT;
+    if( Modifiers & Qt::MetaModifier )
+        Mods |= MOD_WIN;
+
+    // 창 없이 스레드 메시지 큐로 WM_HOTKEY 수신
+    isRegistered = ::RegisterHotKey( nullptr, hotkeyId, Mods, VirtualKey ) != FALSE;
+    if( isRegistered == false )
+        qWarning() << "[HOTKEY] RegisterHotKey failed" << Sequence.toString() << ::GetLastError();
+#else
+    qWarning() << "[HOTKEY] global hotkeys are not supported on this platform" << Sequence.toString();
+#endif
+
+    return isRegistered;
+}
+
+void QGlobalHotkey::Unregister()
+{
+    if( isRegistered == false )
+        return;
+
+#ifdef Q_OS_WIN
+    ::UnregisterHotKey( nullptr, hotkeyId );
+#endif
+    isRegistered = false;
+}
+
+bool QGlobalHotkey::IsRegistered() const
+{
+    return isRegistered;
+}
+
+QKeySequence QGlobalHotkey::Sequence() const
+{
+    return sequence;
+}
+
+bool QGlobalHotkey::nativeEventFilter( const QByteArray& EventType, void* Message, qintptr* Result )
+{
+    Q_UNUSED( Result );
+
+#ifdef Q_OS_WIN
+    if( isRegistered == false || EventType != "windows_generic_MSG" )
+        return false;
+
+    const MSG* Msg = static_cast< const MSG* >( Message );
+    if( Msg->message != WM_HOTKEY || ( int )Msg->wParam != hotkeyId )
+        return false;
+
+    Q_EMIT sigActivated( Clock::now() );
+    return true;
+#else
+    Q_UNUSED( EventType );
+    Q_UNUSED( Message );
+    return false;
+#endif
+}
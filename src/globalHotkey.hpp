@@ -0,0 +1,37 @@
+#ifndef GLOBALHOTKEY_HPP
+#define GLOBALHOTKEY_HPP
+
+#include <QtCore>
+#include <QtGui>
+
+#include <chrono>
+
+// 시스템 전역 단축키 ( Windows RegisterHotKey ), 그 외 플랫폼에서는 등록 실패
+class QGlobalHotkey : public QObject, public QAbstractNativeEventFilter
+{
+    Q_OBJECT
+public:
+    typedef std::chrono::steady_clock   Clock;
+
+    explicit QGlobalHotkey( QObject* Parent = nullptr );
+    ~QGlobalHotkey() override;
+
+    // 수정자 + 키 하나 ( 예: Ctrl+Shift+S ), 이전 등록은 해제
+    bool                                Register( const QKeySequence& Sequence );
+    void                                Unregister();
+    bool                                IsRegistered() const;
+    QKeySequence                        Sequence() const;
+
+    bool                                nativeEventFilter( const QByteArray& EventType, void* Message, qintptr* Result ) override;
+
+Q_SIGNALS:
+    // Pressed : WM_HOTKEY 를 받은 시각, 핫키 -> 화면 표시 지연 측정용
+    void                                sigActivated( QGlobalHotkey::Clock::time_point Pressed );
+
+private:
+    QKeySequence                        sequence;
+    int                                 hotkeyId;
+    bool                                isRegistered;
+};
+
+#endif //GLOBALHOTKEY_HPP
@@ -0,0 +1,397 @@
+#include "headlessCapture.hpp"
+
+#include <QtGui>
+
+#include <cstdio>
+
+#ifdef Q_OS_WIN
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "captureService.hpp"
+#include "imageFile.hpp"
+#include "syntheticBackend.hpp"
+
+namespace nsCapture
+{
+    namespace
+    {
+        typedef std::chrono::steady_clock   Clock;
+
+        // struct tagHeadlessOptions_s
+        typedef struct tagHeadlessOptions_s
+        {
+            enum { TARGET_ALL, TARGET_MONITOR, TARGET_RECT };
+
+            int                         Target          = TARGET_ALL;
+            int                         MonitorIdx      = -1;
+            QRect                       Rect;                       // virtual desktop coordinates, physical pixels
+            QString                     OutputPath      = QStringLiteral( "-" );
+            QByteArray                  Format;                     // empty = from the file suffix
+            int                         Quality         = -1;       // -1 = encoder default
+            bool                        IsList          = false;
+            bool                        IsVerbose       = false;
+            bool                        HasSyntheticLayout = false;
+            QVector< QRect >            SyntheticLayout;
+            tagCaptureRequest           Request;
+        } tagHeadlessOptions;
+
+        void printError( const QString& Message )
+        {
+            fprintf( stderr, "%s\n", qPrintable( Message ) );
+        }
+
+        qint64 elapsedUs( Clock::time_point Begin )
+        {
+            return std::chrono::duration_cast< std::chrono::microseconds >( Clock::now() - Begin ).count();
+        }
+
+        // "x,y,w,h" or the layout form "WxH+X+Y"
+        bool parseRect( const QString& Text, QRect* pRetRect )
+        {
+            const auto Parts = Text.split( ',' );
+            if( Parts.size() == 4 )
+            {
+                int Values[ 4 ] = {};
+                for( int idx = 0; idx < 4; ++idx )
+                {
+                    bool IsOk = false;
+                    Values[ idx ] = Parts[ idx ].trimmed().toInt( &IsOk );
+                    if( IsOk == false )
+                        return false;
+                }
+
+                *pRetRect = QRect( Values[ 0 ], Values[ 1 ], Values[ 2 ], Values[ 3 ] );
+                return pRetRect->isEmpty() == false;
+            }
+
+            const auto Layout = CSyntheticBackend::ParseLayout( Text );
+            if( Layout.size() != 1 || Layout.front().isEmpty() )
+                return false;
+
+            *pRetRect = Layout.front();
+            return true;
+        }
+
+        bool parseOptions( const QStringList& Arguments, tagHeadlessOptions* pRetOptions )
+        {
+            QCommandLineParser Parser;
+            Parser.setApplicationDescription( QStringLiteral( "Headless screen capture" ) );
+            const auto HelpOption = Parser.addHelpOption();
+
+            const QCommandLineOption HeadlessOption( QStringLiteral( "headless" ), QStringLiteral( "Capture without any UI and exit." ) );
+            const QCommandLineOption AllOption( { QStringLiteral( "a" ), QStringLiteral( "all" ) }, QStringLiteral( "Every monitor as one virtual desktop image ( default )." ) );
+            const QCommandLineOption MonitorOption( { QStringLiteral( "m" ), QStringLiteral( "monitor" ) }, QStringLiteral( "Monitor index, see --list." ), QStringLiteral( "index" ) );
+            const QCommandLineOption RectOption( { QStringLiteral( "r" ), QStringLiteral( "rect" ) }, QStringLiteral( "Virtual desktop rectangle in physical pixels, x,y,w,h or WxH+X+Y." ), QStringLiteral( "rect" ) );
+            const QCommandLineOption OutputOption( { QStringLiteral( "o" ), QStringLiteral( "output" ) }, QStringLiteral( "Image file, - for stdout ( default )." ), QStringLiteral( "path" ) );
+            const QCommandLineOption FormatOption( { QStringLiteral( "f" ), QStringLiteral( "format" ) }, QStringLiteral( "Image format ( png, qoi, raw, jpg, bmp, ... ), default from the file suffix, png for stdout." ), QStringLiteral( "format" ) );
+            const QCommandLineOption QualityOption( { QStringLiteral( "q" ), QStringLiteral( "quality" ) }, QStringLiteral( "Encoder quality 0 - 100." ), QStringLiteral( "quality" ) );
+            const QCommandLineOption CursorOption( { QStringLiteral( "c" ), QStringLiteral( "cursor" ) }, QStringLiteral( "Include the mouse cursor." ) );
+            const QCommandLineOption TimeoutOption( { QStringLiteral( "t" ), QStringLiteral( "timeout" ) }, QStringLiteral( "Milliseconds to wait for a desktop present ( default 500 )." ), QStringLiteral( "ms" ) );
+            const QCommandLineOption SyntheticOption( QStringLiteral( "synthetic" ), QStringLiteral( "Synthetic frame source with the monitor layout WxH+X+Y;..." ), QStringLiteral( "layout" ) );
+            const QCommandLineOption ListOption( QStringLiteral( "list" ), QStringLiteral( "Print the monitors and exit." ) );
+            const QCommandLineOption VerboseOption( { QStringLiteral( "v" ), QStringLiteral( "verbose" ) }, QStringLiteral( "Timings on stderr." ) );
+
+            Parser.addOptions( { HeadlessOption, AllOption, MonitorOption, RectOption, OutputOption, FormatOption, QualityOption,
+                                 CursorOption, TimeoutOption, SyntheticOption, ListOption, VerboseOption } );
+
+            if( Parser.parse( Arguments ) == false )
+            {
+                printError( Parser.errorText() );
+                return false;
+            }
+
+            if( Parser.isSet( HelpOption ) )
+                Parser.showHelp( tagHeadlessExit_Ok );
+
+            if( Parser.positionalArguments().isEmpty() == false )
+            {
+                printError( QStringLiteral( "unexpected argument: %1" ).arg( Parser.positionalArguments().front() ) );
+                return false;
+            }
+
+            auto& Options = *pRetOptions;
+            if( ( int )Parser.isSet( AllOption ) + ( int )Parser.isSet( MonitorOption ) + ( int )Parser.isSet( RectOption ) > 1 )
+            {
+                printError( QStringLiteral( "--all, --monitor and --rect are exclusive" ) );
+                return false;
+            }
+
+            bool IsOk = true;
+            if( Parser.isSet( MonitorOption ) )
+            {
+                Options.Target = tagHeadlessOptions::TARGET_MONITOR;
+                Options.MonitorIdx = Parser.value( MonitorOption ).toInt( &IsOk );
+                if( IsOk == false || Options.MonitorIdx < 0 )
+                {
+                    printError( QStringLiteral( "invalid monitor index: %1" ).arg( Parser.value( MonitorOption ) ) );
+                    return false;
+                }
+            }
+
+            if( Parser.isSet( RectOption ) )
+            {
+                Options.Target = tagHeadlessOptions::TARGET_RECT;
+                if( parseRect( Parser.value( RectOption ), &Options.Rect ) == false )
+                {
+                    printError( QStringLiteral( "invalid rectangle: %1" ).arg( Parser.value( RectOption ) ) );
+                    return false;
+                }
+            }
+
+            if( Parser.isSet( OutputOption ) )
+                Options.OutputPath = Parser.value( OutputOption );
+
+            if( Parser.isSet( FormatOption ) )
+                Options.Format = Parser.value( FormatOption ).toLower().toLatin1();
+            else if( Options.OutputPath == QLatin1String( "-" ) )
+                Options.Format = "png";
+            else
+                Options.Format = QFileInfo( Options.OutputPath ).suffix().toLower().toLatin1();
+
+            if( Options.Format.isEmpty() )
+            {
+                printError( QStringLiteral( "no image format for %1, use --format" ).arg( Options.OutputPath ) );
+                return false;
+            }
+
+            if( IsSupportedImageFormat( Options.Format ) == false )
+            {
+                printError( QStringLiteral( "unsupported image format: %1" ).arg( QString::fromLatin1( Options.Format ) ) );
+                return false;
+            }
+
+            if( Parser.isSet( QualityOption ) )
+            {
+                Options.Quality = Parser.value( QualityOption ).toInt( &IsOk );
+                if( IsOk == false || Options.Quality < 0 || Options.Quality > 100 )
+                {
+                    printError( QStringLiteral( "invalid quality: %1" ).arg( Parser.value( QualityOption ) ) );
+                    return false;
+                }
+            }
+
+            if( Parser.isSet( TimeoutOption ) )
+            {
+                Options.Request.TimeoutMs = Parser.value( TimeoutOption ).toInt( &IsOk );
+                if( IsOk == false || Options.Request.TimeoutMs < 0 )
+                {
+                    printError( QStringLiteral( "invalid timeout: %1" ).arg( Parser.value( TimeoutOption ) ) );
+                    return false;
+                }
+            }
+
+            if( Parser.isSet( SyntheticOption ) )
+            {
+                Options.HasSyntheticLayout = true;
+                Options.SyntheticLayout = CSyntheticBackend::ParseLayout( Parser.value( SyntheticOption ) );
+                if( Options.SyntheticLayout.isEmpty() )
+                {
+                    printError( QStringLiteral( "invalid layout: %1" ).arg( Parser.value( SyntheticOption ) ) );
+                    return false;
+                }
+            }
+
+            Options.Request.IncludeCursor = Parser.isSet( CursorOption );
+            Options.IsList = Parser.isSet( ListOption );
+            Options.IsVerbose = Parser.isSet( VerboseOption );
+            return true;
+        }
+
+        // exit code of a multi output capture, every output taking part must have been captured
+        tagHeadlessExit outcomeOf( tagCaptureStatus Status )
+        {
+            switch( Status )
+            {
+                case tagCaptureStatus_Ok:           return tagHeadlessExit_Ok;
+                case tagCaptureStatus_NoOutput:     return tagHeadlessExit_NoOutput;
+                case tagCaptureStatus_Timeout:      return tagHeadlessExit_Timeout;
+                default:                            return tagHeadlessExit_CaptureFailed;
+            }
+        }
+
+        // the whole desktop comes back as per-output frames in pRetStrips, composed while it is written; the rest in pRetImage
+        tagHeadlessExit capture( CCaptureService& Service, const tagHeadlessOptions& Options, QImage* pRetImage, CDesktopStrips* pRetStrips )
+        {
+            const auto Outputs = Service.Outputs();
+            if( Outputs.isEmpty() )
+            {
+                printError( QStringLiteral( "no monitor" ) );
+                return tagHeadlessExit_NoOutput;
+            }
+
+            switch( Options.Target )
+            {
+                case tagHeadlessOptions::TARGET_MONITOR: {
+                    const auto Status = Service.CaptureOutput( Options.MonitorIdx, Options.Request, pRetImage );
+                    switch( Status )
+                    {
+                        case tagCaptureStatus_Ok:           return tagHeadlessExit_Ok;
+                        case tagCaptureStatus_NoOutput:
+                            printError( QStringLiteral( "no monitor %1, %2 available" ).arg( Options.MonitorIdx ).arg( Outputs.size() ) );
+                            return tagHeadlessExit_NoOutput;
+                        case tagCaptureStatus_Timeout:      return tagHeadlessExit_Timeout;
+                        default:                            return tagHeadlessExit_CaptureFailed;
+                    }
+                }
+
+                case tagHeadlessOptions::TARGET_RECT: {
+                    int Covered = 0;
+                    for( const auto& Output : Outputs )
+                        Covered += Options.Rect.intersects( Output.Bounds ) ? 1 : 0;
+
+                    if( Covered == 0 )
+                    {
+                        printError( QStringLiteral( "rectangle outside every monitor" ) );
+                        return tagHeadlessExit_NoOutput;
+                    }
+
+                    tagCaptureStatus Status = tagCaptureStatus_Failed;
+                    *pRetImage = Service.CaptureRegion( Options.Rect, Options.Request, nullptr, &Status );
+                    return outcomeOf( Status );
+                }
+
+                default: {
+                    QVector< int > OutputIdxs;
+                    QVector< QRect > Bounds;
+                    for( const auto& Output : Outputs )
+                    {
+                        OutputIdxs.push_back( Output.Idx );
+                        Bounds.push_back( Output.Bounds );
+                    }
+
+                    // failed outputs stay transparent, as in CaptureAll
+                    QVector< QImage > Frames;
+                    tagCaptureStatus Status = tagCaptureStatus_Failed;
+                    Service.CaptureOutputs( OutputIdxs, Options.Request, &Frames, nullptr, &Status );
+                    if( Status != tagCaptureStatus_Ok )
+                        return outcomeOf( Status );
+                    return pRetStrips->Reset( Bounds, Frames ) ? tagHeadlessExit_Ok : tagHeadlessExit_CaptureFailed;
+                }
+            }
+        }
+
+        // Image, or the desktop of Strips when it is null
+        tagHeadlessExit write( const QImage& Image, const CDesktopStrips& Strips, const tagHeadlessOptions& Options )
+        {
+            QFile File;
+            bool IsOpened = false;
+
+            if( Options.OutputPath == QLatin1String( "-" ) )
+            {
+#ifdef Q_OS_WIN
+                // no CRLF translation of the encoded bytes
+                _setmode( _fileno( stdout ), _O_BINARY );
+#endif
+                IsOpened = File.open( stdout, QIODevice::WriteOnly );
+            }
+            else
+            {
+                File.setFileName( Options.OutputPath );
+                IsOpened = File.open( QIODevice::WriteOnly | QIODevice::Truncate );
+            }
+
+            if( IsOpened == false )
+            {
+                printError( QStringLiteral( "cannot open %1: %2" ).arg( Options.OutputPath, File.errorString() ) );
+                return tagHeadlessExit_WriteFailed;
+            }
+
+            CTraceSpan Span( tagTraceStage_Encode );
+            QString ErrorText;
+            const auto produce = [&Strips]( int FirstRow, QImage* pStrip ) {
+                return Strips.Fill( FirstRow, pStrip );
+            };
+
+            const bool IsWritten = Image.isNull() ? WriteImageStrips( &File, Strips.Bounds().size(), QImage::Format_ARGB32_Premultiplied, Options.Format, Options.Quality,
+                                                                      produce, 0, nullptr, &ErrorText )
+                                                  : WriteImage( &File, Image, Options.Format, Options.Quality, nullptr, &ErrorText );
+            if( IsWritten == false )
+            {
+                printError( QStringLiteral( "cannot write %1: %2" ).arg( Options.OutputPath, ErrorText ) );
+                return tagHeadlessExit_WriteFailed;
+            }
+
+            if( File.flush() == false )
+            {
+                printError( QStringLiteral( "cannot write %1: %2" ).arg( Options.OutputPath, File.errorString() ) );
+                return tagHeadlessExit_WriteFailed;
+            }
+
+            return tagHeadlessExit_Ok;
+        }
+    }
+
+    bool IsHeadlessCommandLine( int argc, char* argv[] )
+    {
+        for( int i = 1; i < argc; ++i )
+        {
+            if( qstrcmp( argv[ i ], "--headless" ) == 0 )
+                return true;
+        }
+
+        return false;
+    }
+
+    int RunHeadlessCapture( int argc, char* argv[] )
+    {
+        const auto StartTick = Clock::now();
+        QCoreApplication App( argc, argv );
+
+        tagHeadlessOptions Options;
+        if( parseOptions( QCoreApplication::arguments(), &Options ) == false )
+            return tagHeadlessExit_Usage;
+
+        std::unique_ptr< ICaptureBackend > Backend;
+        if( Options.HasSyntheticLayout )
+            Backend = std::make_unique< CSyntheticBackend >( Options.SyntheticLayout );
+        else
+            Backend = CreateDefaultBackend();
+
+        // no background refresh, the single capture is cold by design
+        CCaptureService Service( std::move( Backend ) );
+
+        if( Options.IsList )
+        {
+            for( const auto& Output : Service.Outputs() )
+            {
+                fprintf( stdout, "%d\t%dx%d%+d%+d\t%d\t%s\n", Output.Idx, Output.Bounds.width(), Output.Bounds.height(),
+                         Output.Bounds.x(), Output.Bounds.y(), Output.RotationDegrees, qPrintable( Output.Name ) );
+            }
+            return tagHeadlessExit_Ok;
+        }
+
+        const auto CaptureTick = Clock::now();
+        QImage Image;
+        CDesktopStrips Strips;
+        auto Ret = capture( Service, Options, &Image, &Strips );
+        const auto CaptureUs = elapsedUs( CaptureTick );
+        if( Ret != tagHeadlessExit_Ok )
+        {
+            if( Ret == tagHeadlessExit_Timeout )
+                printError( QStringLiteral( "no desktop present within %1 ms" ).arg( Options.Request.TimeoutMs ) );
+            else if( Ret == tagHeadlessExit_CaptureFailed )
+                printError( QStringLiteral( "capture failed" ) );
+            return Ret;
+        }
+
+        const auto WriteTick = Clock::now();
+        Ret = write( Image, Strips, Options );
+        const auto WriteUs = elapsedUs( WriteTick );
+
+        if( Options.IsVerbose )
+        {
+            const QSize Size = Image.isNull() ? Strips.Bounds().size() : Image.size();
+            printError( QStringLiteral( "backend %1, %2x%3 %4, capture %5 us, encode %6 us, total %7 us" )
+                        .arg( Service.BackendName() ).arg( Size.width() ).arg( Size.height() ).arg( QString::fromLatin1( Options.Format ) )
+                        .arg( CaptureUs ).arg( WriteUs ).arg( elapsedUs( StartTick ) ) );
+            if( CCaptureTrace::IsEnabled() )
+                printError( CCaptureTrace::Instance().FormatStats() );
+        }
+
+        CCaptureTrace::Instance().Flush();
+        return Ret;
+    }
+
+} // nsCapture
@@ -0,0 +1,35 @@
+#ifndef HEADLESSCAPTURE_HPP
+#define HEADLESSCAPTURE_HPP
+
+#include <QtCore>
+
+namespace nsCapture
+{
+    // enum tagHeadlessExit_e : process exit codes of the headless capture
+    typedef enum tagHeadlessExit_e
+    {
+        tagHeadlessExit_Ok              = 0,
+        tagHeadlessExit_Usage           = 1,        // unknown option, malformed value, unsupported format
+        tagHeadlessExit_NoOutput        = 2,        // monitor index out of range, rectangle outside every monitor
+        tagHeadlessExit_Timeout         = 3,        // no desktop present within --timeout
+        tagHeadlessExit_CaptureFailed   = 4,        // backend error, lost access to the output
+        tagHeadlessExit_WriteFailed     = 5,        // encoder or file / stdout error
+    } tagHeadlessExit;
+
+    // true when argv asks for the headless capture ( --headless )
+    bool                                IsHeadlessCommandLine( int argc, char* argv[] );
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// RunHeadlessCapture
+    ///
+    /// Captures one monitor, every monitor or a rectangle of the virtual desktop and writes it to a file or
+    /// stdout, then returns a tagHeadlessExit code. Only a QCoreApplication is created: no widget, no
+    /// ElaWidgetTools and no platform plugin, so it runs the same under QT_QPA_PLATFORM=offscreen or without
+    /// a display. --synthetic forces the synthetic frame source with the given monitor layout.
+    /// Must be called before any other Q*Application exists.
+
+    int                                 RunHeadlessCapture( int argc, char* argv[] );
+
+} // nsCapture
+
+#endif //HEADLESSCAPTURE_HPP
@@ -0,0 +1,387 @@
+#include "imageCodec.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace nsKernel
+{
+    namespace
+    {
+        const uint8_t                   QOI_MAGIC[ 4 ]          = { 'q', 'o', 'i', 'f' };
+        const size_t                    QOI_HEADER_BYTES        = 14;
+        const uint8_t                   QOI_END[ 8 ]            = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+        const uint8_t                   QOI_OP_INDEX            = 0x00;     // 00xxxxxx
+        const uint8_t                   QOI_OP_DIFF             = 0x40;     // 01xxxxxx
+        const uint8_t                   QOI_OP_LUMA             = 0x80;     // 10xxxxxx
+        const uint8_t                   QOI_OP_RUN              = 0xC0;     // 11xxxxxx
+        const uint8_t                   QOI_OP_RGB              = 0xFE;
+        const uint8_t                   QOI_OP_RGBA             = 0xFF;
+        const uint8_t                   QOI_MASK                = 0xC0;
+        const int32_t                   QOI_MAX_RUN             = 62;
+
+        const uint8_t                   RAW_MAGIC[ 8 ]          = { 'S', 'N', 'I', 'P', 'R', 'A', 'W', 0 };
+
+        // encoded bytes handed to Write at a time
+        const size_t                    WRITE_BYTES             = 1 << 20;
+
+        inline void storeBigEndian( uint8_t* p, uint32_t Value )
+        {
+            p[ 0 ] = ( uint8_t )( Value >> 24 );
+            p[ 1 ] = ( uint8_t )( Value >> 16 );
+            p[ 2 ] = ( uint8_t )( Value >> 8 );
+            p[ 3 ] = ( uint8_t )Value;
+        }
+
+        inline uint32_t loadBigEndian( const uint8_t* p )
+        {
+            return ( uint32_t )p[ 0 ] << 24 | ( uint32_t )p[ 1 ] << 16 | ( uint32_t )p[ 2 ] << 8 | p[ 3 ];
+        }
+
+        // pixels are BGRA as loaded from memory on little endian : b = bits 0 ~ 7, g, r, a = bits 24 ~ 31
+        inline uint32_t qoiHash( uint32_t Pixel )
+        {
+            const uint32_t b = Pixel & 0xFF, g = ( Pixel >> 8 ) & 0xFF, r = ( Pixel >> 16 ) & 0xFF, a = Pixel >> 24;
+            return ( r * 3 + g * 5 + b * 7 + a * 11 ) & 63;
+        }
+    }
+
+    CQoiStreamEncoder::CQoiStreamEncoder( int32_t Width, int32_t Height, tagPixelSource Source, ImageWriteFn Write )
+        : m_width( Width ), m_height( Height ), m_nextRow( 0 ), m_source( Source ), m_write( std::move( Write ) ),
+          m_unpremultiply( nullptr ), m_outBytes( 0 ), m_index(), m_prior( 0xFF000000u ), m_run( 0 ), m_isFailed( false )
+    {
+        m_isFailed = Width <= 0 || Height <= 0 || Source >= tagPixelSource_Count || !m_write;
+        if( m_isFailed )
+            return;
+
+        if( Source == tagPixelSource_BGRAPremultiplied )
+        {
+            m_straight.resize( ( size_t )Width * 4 );
+            m_unpremultiply = PixelRowConverter( tagPixelConversion_Unpremultiply, DetectCpuLevel() );
+        }
+
+        // a row can grow to 5 bytes per pixel, flushed before that could overflow
+        m_out.resize( WRITE_BYTES + ( size_t )Width * 5 + QOI_HEADER_BYTES + sizeof( QOI_END ) );
+
+        uint8_t* pOut = m_out.data();
+        memcpy( pOut, QOI_MAGIC, 4 );
+        storeBigEndian( pOut + 4, ( uint32_t )Width );
+        storeBigEndian( pOut + 8, ( uint32_t )Height );
+        pOut[ 12 ] = Source == tagPixelSource_BGRX ? 3 : 4;
+        pOut[ 13 ] = 0;
+        m_outBytes = QOI_HEADER_BYTES;
+    }
+
+    bool CQoiStreamEncoder::WriteRows( const tagSurface& Rows )
+    {
+        if( m_isFailed || Rows.Bits == nullptr || Rows.Width != m_width || Rows.Height < 0 || Rows.Height > m_height - m_nextRow )
+            return fail();
+
+        const size_t Width = ( size_t )m_width;
+        const uint32_t AlphaMask = m_source == tagPixelSource_BGRX ? 0xFF000000u : 0u;
+        uint32_t Prior = m_prior;
+        int32_t Run = m_run;
+
+        for( int32_t y = 0; y < Rows.Height; ++y )
+        {
+            const uint8_t* pRow = Rows.Bits + Rows.Pitch * y;
+            if( m_straight.empty() == false )
+            {
+                m_unpremultiply( m_straight.data(), pRow, m_width );
+                pRow = m_straight.data();
+            }
+
+            uint8_t* pOut = m_out.data() + m_outBytes;
+            for( size_t x = 0; x < Width; ++x )
+            {
+                uint32_t Pixel;
+                memcpy( &Pixel, pRow + x * 4, sizeof( Pixel ) );
+                Pixel |= AlphaMask;
+
+                if( Pixel == Prior )
+                {
+                    if( ++Run == QOI_MAX_RUN )
+                    {
+                        *pOut++ = ( uint8_t )( QOI_OP_RUN | ( Run - 1 ) );
+                        Run = 0;
+                    }
+                    continue;
+                }
+
+                if( Run > 0 )
+                {
+                    *pOut++ = ( uint8_t )( QOI_OP_RUN | ( Run - 1 ) );
+                    Run = 0;
+                }
+
+                const uint32_t Hash = qoiHash( Pixel );
+                if( m_index[ Hash ] == Pixel )
+                {
+                    *pOut++ = ( uint8_t )( QOI_OP_INDEX | Hash );
+                }
+                else
+                {
+                    m_index[ Hash ] = Pixel;
+
+                    if( ( Pixel >> 24 ) == ( Prior >> 24 ) )
+                    {
+                        const int8_t dr = ( int8_t )( ( Pixel >> 16 ) - ( Prior >> 16 ) );
+                        const int8_t dg = ( int8_t )( ( Pixel >> 8 ) - ( Prior >> 8 ) );
+                        const int8_t db = ( int8_t )( Pixel - Prior );
+                        const int8_t dr_dg = ( int8_t )( dr - dg );
+                        const int8_t db_dg = ( int8_t )( db - dg );
+
+                        if( dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1 )
+                        {
+                            *pOut++ = ( uint8_t )( QOI_OP_DIFF | ( dr + 2 ) << 4 | ( dg + 2 ) << 2 | ( db + 2 ) );
+                        }
+                        else if( dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7 )
+                        {
+                            *pOut++ = ( uint8_t )( QOI_OP_LUMA | ( dg + 32 ) );
+                            *pOut++ = ( uint8_t )( ( dr_dg + 8 ) << 4 | ( db_dg + 8 ) );
+                        }
+                        else
+                        {
+                            pOut[ 0 ] = QOI_OP_RGB;
+                            pOut[ 1 ] = ( uint8_t )( Pixel >> 16 );
+                            pOut[ 2 ] = ( uint8_t )( Pixel >> 8 );
+                            pOut[ 3 ] = ( uint8_t )Pixel;
+                            pOut += 4;
+                        }
+                    }
+                    else
+                    {
+                        pOut[ 0 ] = QOI_OP_RGBA;
+                        pOut[ 1 ] = ( uint8_t )( Pixel >> 16 );
+                        pOut[ 2 ] = ( uint8_t )( Pixel >> 8 );
+                        pOut[ 3 ] = ( uint8_t )Pixel;
+                        pOut[ 4 ] = ( uint8_t )( Pixel >> 24 );
+                        pOut += 5;
+                    }
+                }
+
+                Prior = Pixel;
+            }
+
+            m_outBytes = ( size_t )( pOut - m_out.data() );
+            if( m_outBytes >= WRITE_BYTES && flush() == false )
+                return false;
+        }
+
+        m_prior = Prior;
+        m_run = Run;
+        m_nextRow += Rows.Height;
+        return true;
+    }
+
+    bool CQoiStreamEncoder::Finish()
+    {
+        if( m_isFailed || m_nextRow != m_height )
+            return fail();
+
+        uint8_t* pOut = m_out.data() + m_outBytes;
+        if( m_run > 0 )
+            *pOut++ = ( uint8_t )( QOI_OP_RUN | ( m_run - 1 ) );
+        m_run = 0;
+
+        memcpy( pOut, QOI_END, sizeof( QOI_END ) );
+        m_outBytes = ( size_t )( pOut - m_out.data() ) + sizeof( QOI_END );
+        return flush();
+    }
+
+    bool CQoiStreamEncoder::flush()
+    {
+        if( m_outBytes > 0 && !m_write( m_out.data(), m_outBytes ) )
+            m_isFailed = true;
+        m_outBytes = 0;
+        return m_isFailed == false;
+    }
+
+    bool EncodeQoi( const tagSurface& Src, tagPixelSource Source, const ImageWriteFn& Write )
+    {
+        if( Src.Bits == nullptr )
+            return false;
+
+        CQoiStreamEncoder Encoder( Src.Width, Src.Height, Source, Write );
+        return Encoder.WriteRows( Src ) && Encoder.Finish();
+    }
+
+    bool ReadQoiHeader( const uint8_t* pData, size_t Size, tagQoiHeader* pHeader )
+    {
+        if( pData == nullptr || pHeader == nullptr || Size < QOI_HEADER_BYTES + sizeof( QOI_END ) || memcmp( pData, QOI_MAGIC, 4 ) != 0 )
+            return false;
+
+        const uint32_t Width = loadBigEndian( pData + 4 );
+        const uint32_t Height = loadBigEndian( pData + 8 );
+        if( Width == 0 || Height == 0 || Width > 0x7FFFFFFFu || Height > 0x7FFFFFFFu || ( pData[ 12 ] != 3 && pData[ 12 ] != 4 ) || pData[ 13 ] > 1 )
+            return false;
+
+        pHeader->Width      = ( int32_t )Width;
+        pHeader->Height     = ( int32_t )Height;
+        pHeader->Channels   = pData[ 12 ];
+        pHeader->Colorspace = pData[ 13 ];
+        return true;
+    }
+
+    bool DecodeQoi( const uint8_t* pData, size_t Size, const tagSurface& Dst )
+    {
+        tagQoiHeader Header;
+        if( !ReadQoiHeader( pData, Size, &Header ) || Dst.Bits == nullptr || Dst.Width != Header.Width || Dst.Height != Header.Height )
+            return false;
+
+        const uint32_t AlphaMask = Header.Channels == 3 ? 0xFF000000u : 0u;
+        const uint8_t* p = pData + QOI_HEADER_BYTES;
+        const uint8_t* pEnd = pData + Size - sizeof( QOI_END );
+
+        uint32_t Index[ 64 ] = {};
+        uint32_t Pixel = 0xFF000000u;
+        int32_t Run = 0;
+
+        for( int32_t y = 0; y < Dst.Height; ++y )
+        {
+            uint8_t* pRow = Dst.Bits + Dst.Pitch * y;
+            for( int32_t x = 0; x < Dst.Width; ++x )
+            {
+                if( Run > 0 )
+                {
+                    --Run;
+                }
+                else
+                {
+                    if( p >= pEnd )
+                        return false;
+
+                    const uint8_t Op = *p++;
+                    if( Op == QOI_OP_RGB )
+                    {
+                        if( pEnd - p < 3 )
+                            return false;
+                        Pixel = ( Pixel & 0xFF000000u ) | ( uint32_t )p[ 0 ] << 16 | ( uint32_t )p[ 1 ] << 8 | p[ 2 ];
+                        p += 3;
+                    }
+                    else if( Op == QOI_OP_RGBA )
+                    {
+                        if( pEnd - p < 4 )
+                            return false;
+                        Pixel = ( uint32_t )p[ 3 ] << 24 | ( uint32_t )p[ 0 ] << 16 | ( uint32_t )p[ 1 ] << 8 | p[ 2 ];
+                        p += 4;
+                    }
+                    else if( ( Op & QOI_MASK ) == QOI_OP_INDEX )
+                    {
+                        Pixel = Index[ Op ];
+                    }
+                    else if( ( Op & QOI_MASK ) == QOI_OP_DIFF )
+                    {
+                        const uint32_t r = ( ( Pixel >> 16 ) + ( ( Op >> 4 ) & 3 ) - 2 ) & 0xFF;
+                        const uint32_t g = ( ( Pixel >> 8 ) + ( ( Op >> 2 ) & 3 ) - 2 ) & 0xFF;
+                        const uint32_t b = ( Pixel + ( Op & 3 ) - 2 ) & 0xFF;
+                        Pixel = ( Pixel & 0xFF000000u ) | r << 16 | g << 8 | b;
+                    }
+                    else if( ( Op & QOI_MASK ) == QOI_OP_LUMA )
+                    {
+                        if( p >= pEnd )
+                            return false;
+                        const int32_t dg = ( Op & 0x3F ) - 32;
+                        const int32_t dr = dg + ( *p >> 4 ) - 8;
+                        const int32_t db = dg + ( *p & 0x0F ) - 8;
+                        ++p;
+                        const uint32_t r = ( uint32_t )( ( int32_t )( Pixel >> 16 ) + dr ) & 0xFF;
+                        const uint32_t g = ( uint32_t )( ( int32_t )( Pixel >> 8 ) + dg ) & 0xFF;
+                        const uint32_t b = ( uint32_t )( ( int32_t )Pixel + db ) & 0xFF;
+                        Pixel = ( Pixel & 0xFF000000u ) | r << 16 | g << 8 | b;
+                    }
+                    else
+                    {
+                        Run = Op & 0x3F;
+                    }
+
+                    Index[ qoiHash( Pixel ) ] = Pixel;
+                }
+
+                const uint32_t Out = Pixel | AlphaMask;
+                memcpy( pRow + ( size_t )x * 4, &Out, sizeof( Out ) );
+            }
+        }
+
+        return true;
+    }
+
+    CRawStreamWriter::CRawStreamWriter( int32_t Width, int32_t Height, tagPixelSource Source, ImageWriteFn Write )
+        : m_width( Width ), m_height( Height ), m_nextRow( 0 ), m_source( Source ), m_write( std::move( Write ) ), m_isHeaderWritten( false ), m_isFailed( false )
+    {
+        m_isFailed = Width <= 0 || Height <= 0 || Source >= tagPixelSource_Count || !m_write;
+    }
+
+    bool CRawStreamWriter::WriteRows( const tagSurface& Rows )
+    {
+        if( m_isFailed || Rows.Bits == nullptr || Rows.Width != m_width || Rows.Height < 0 || Rows.Height > m_height - m_nextRow )
+            return fail();
+
+        // the header goes out with the first rows
+        if( m_isHeaderWritten == false )
+        {
+            tagRawHeader Header;
+            memcpy( Header.Magic, RAW_MAGIC, sizeof( Header.Magic ) );
+            Header.Width        = ( uint32_t )m_width;
+            Header.Height       = ( uint32_t )m_height;
+            Header.Pitch        = ( uint32_t )m_width * 4;
+            Header.Layout       = ( uint32_t )m_source;
+            Header.DataBytes    = ( uint64_t )Header.Pitch * Header.Height;
+
+            if( !m_write( reinterpret_cast< const uint8_t* >( &Header ), sizeof( Header ) ) )
+                return fail();
+            m_isHeaderWritten = true;
+        }
+
+        // packed rows : large writes straight from the strip, otherwise row by row
+        const size_t RowBytes = ( size_t )m_width * 4;
+        const int32_t RowsPerWrite = Rows.Pitch == ( ptrdiff_t )RowBytes ? ( int32_t )std::max< size_t >( 1, WRITE_BYTES * 4 / RowBytes ) : 1;
+        for( int32_t y = 0; y < Rows.Height; y += RowsPerWrite )
+        {
+            const int32_t Count = std::min( RowsPerWrite, Rows.Height - y );
+            if( !m_write( Rows.Bits + Rows.Pitch * y, RowBytes * Count ) )
+                return fail();
+        }
+
+        m_nextRow += Rows.Height;
+        return true;
+    }
+
+    bool CRawStreamWriter::Finish()
+    {
+        if( m_isFailed || m_nextRow != m_height )
+            return fail();
+        return true;
+    }
+
+    bool WriteRawImage( const tagSurface& Src, tagPixelSource Source, const ImageWriteFn& Write )
+    {
+        if( Src.Bits == nullptr )
+            return false;
+
+        CRawStreamWriter Writer( Src.Width, Src.Height, Source, Write );
+        return Writer.WriteRows( Src ) && Writer.Finish();
+    }
+
+    bool ReadRawHeader( const uint8_t* pData, size_t Size, tagRawHeader* pHeader )
+    {
+        if( pData == nullptr || pHeader == nullptr || Size < sizeof( tagRawHeader ) )
+            return false;
+
+        tagRawHeader Header;
+        memcpy( &Header, pData, sizeof( Header ) );
+        if( memcmp( Header.Magic, RAW_MAGIC, sizeof( Header.Magic ) ) != 0 || Header.Version != RAW_VERSION ||
+            Header.HeaderBytes < sizeof( tagRawHeader ) || Header.Layout >= tagPixelSource_Count ||
+            Header.Width == 0 || Header.Height == 0 || Header.Width > 0x1FFFFFFFu || Header.Pitch < Header.Width * 4 )
+            return false;
+
+        if( Header.DataBytes != ( uint64_t )Header.Pitch * Header.Height || ( uint64_t )Header.HeaderBytes + Header.DataBytes > Size )
+            return false;
+
+        *pHeader = Header;
+        return true;
+    }
+
+} // nsKernel
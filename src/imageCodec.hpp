@@ -0,0 +1,135 @@
+#ifndef IMAGECODEC_HPP
+#define IMAGECODEC_HPP
+
+#include "incrementalFrame.hpp"
+#include "pixelConvert.hpp"
+
+#include <functional>
+#include <vector>
+
+namespace nsKernel
+{
+    // enum tagPixelSource_e : 32bpp capture rows handed to the encoders, byte order as in memory
+    typedef enum tagPixelSource_e
+    {
+        tagPixelSource_BGRX         = 0,    // alpha ignored ( QImage::Format_RGB32 )
+        tagPixelSource_BGRA,                // straight alpha ( QImage::Format_ARGB32 )
+        tagPixelSource_BGRAPremultiplied,   // premultiplied alpha ( QImage::Format_ARGB32_Premultiplied ), the capture canvas
+        tagPixelSource_Count
+    } tagPixelSource;
+
+    // receives an encoded file front to back, false stops the encode
+    typedef std::function< bool( const uint8_t* pData, size_t Size ) > ImageWriteFn;
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// streaming : the encoders take the image as row strips, top to bottom, and hand the encoded bytes to Write
+    /// as soon as they are complete, so a save never needs the whole image in one buffer. The one call functions
+    /// ( EncodeQoi, WriteRawImage, EncodePng ) are a single strip of the whole surface.
+
+    class CImageStreamEncoder
+    {
+    public:
+        virtual ~CImageStreamEncoder() = default;
+
+        // the next Rows.Height rows, Rows.Width must be the image width; the rows are not referenced after the call
+        virtual bool                    WriteRows( const tagSurface& Rows ) = 0;
+        // after the last row, false when rows are missing or an earlier call failed
+        virtual bool                    Finish() = 0;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// QOI ( qoiformat.org ) : lossless, one pass, no entropy coder; several times faster than PNG for about
+    /// 1.5 ~ 2x the size on desktop content. BGRX is written with 3 channels, the alpha sources with 4
+    /// ( premultiplied is unpremultiplied first, QOI stores straight alpha )
+
+    // struct tagQoiHeader_s
+    typedef struct tagQoiHeader_s
+    {
+        int32_t                         Width           = 0;
+        int32_t                         Height          = 0;
+        int32_t                         Channels        = 0;    // 3 = RGB, 4 = RGBA
+        int32_t                         Colorspace      = 0;    // 0 = sRGB with linear alpha, 1 = all linear
+    } tagQoiHeader;
+
+    class CQoiStreamEncoder : public CImageStreamEncoder
+    {
+    public:
+        CQoiStreamEncoder( int32_t Width, int32_t Height, tagPixelSource Source, ImageWriteFn Write );
+
+        bool                            WriteRows( const tagSurface& Rows ) override;
+        bool                            Finish() override;
+
+    private:
+        bool                            flush();
+        bool                            fail()              { m_isFailed = true; return false; }
+
+        int32_t                         m_width;
+        int32_t                         m_height;
+        int32_t                         m_nextRow;
+        tagPixelSource                  m_source;
+        ImageWriteFn                    m_write;
+        PixelRowFn                      m_unpremultiply;
+        std::vector< uint8_t >          m_straight;         // unpremultiplied row
+        std::vector< uint8_t >          m_out;              // encoded bytes not yet written
+        size_t                          m_outBytes;
+        uint32_t                        m_index[ 64 ];
+        uint32_t                        m_prior;
+        int32_t                         m_run;
+        bool                            m_isFailed;
+    };
+
+    bool                                EncodeQoi( const tagSurface& Src, tagPixelSource Source, const ImageWriteFn& Write );
+    bool                                ReadQoiHeader( const uint8_t* pData, size_t Size, tagQoiHeader* pHeader );
+    // into a Width x Height BGRA surface, straight alpha ( 0xFF for 3 channels ); false on a truncated or malformed stream
+    bool                                DecodeQoi( const uint8_t* pData, size_t Size, const tagSurface& Dst );
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// raw : the capture rows as they are in memory behind a 64 byte little endian header, the pixel data starts
+    /// 64 byte aligned and packed ( Pitch = Width * 4 ), so a mapped file is a ready surface
+
+    const uint32_t                      RAW_HEADER_BYTES        = 64;
+    const uint32_t                      RAW_VERSION             = 1;
+
+    // struct tagRawHeader_s : file layout, 64 bytes
+    typedef struct tagRawHeader_s
+    {
+        uint8_t                         Magic[ 8 ];                     // "SNIPRAW\0"
+        uint32_t                        Version         = RAW_VERSION;
+        uint32_t                        HeaderBytes     = RAW_HEADER_BYTES; // offset of the pixel data
+        uint32_t                        Width           = 0;
+        uint32_t                        Height          = 0;
+        uint32_t                        Pitch           = 0;
+        uint32_t                        Layout          = tagPixelSource_BGRAPremultiplied;    // tagPixelSource
+        uint64_t                        DataBytes       = 0;            // Pitch * Height
+        uint8_t                         Reserved[ 24 ]  = {};
+    } tagRawHeader;
+
+    static_assert( sizeof( tagRawHeader ) == RAW_HEADER_BYTES, "raw header is 64 bytes" );
+
+    class CRawStreamWriter : public CImageStreamEncoder
+    {
+    public:
+        CRawStreamWriter( int32_t Width, int32_t Height, tagPixelSource Source, ImageWriteFn Write );
+
+        bool                            WriteRows( const tagSurface& Rows ) override;
+        bool                            Finish() override;
+
+    private:
+        bool                            fail()              { m_isFailed = true; return false; }
+
+        int32_t                         m_width;
+        int32_t                         m_height;
+        int32_t                         m_nextRow;
+        tagPixelSource                  m_source;
+        ImageWriteFn                    m_write;
+        bool                            m_isHeaderWritten;
+        bool                            m_isFailed;
+    };
+
+    bool                                WriteRawImage( const tagSurface& Src, tagPixelSource Source, const ImageWriteFn& Write );
+    // checks the header against Size, pixels are at pData + HeaderBytes
+    bool                                ReadRawHeader( const uint8_t* pData, size_t Size, tagRawHeader* pHeader );
+
+} // nsKernel
+
+#endif //IMAGECODEC_HPP
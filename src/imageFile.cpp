@@ -0,0 +1,293 @@
+#include "imageFile.hpp"
+
+#include "imageCodec.hpp"
+#ifdef SNIPPINGTOOL_HAVE_ZLIB
+#include "pngEncoder.hpp"
+#endif
+
+#include <memory>
+
+namespace nsCapture
+{
+    namespace
+    {
+        // rows produced per strip by WriteImageStrips
+        const qint64                    STRIP_BYTES             = 4 * 1024 * 1024;
+
+        // kernel layout of the 32bpp formats
+        bool pixelSourceOf( QImage::Format Format, nsKernel::tagPixelSource* pRetSource )
+        {
+            switch( Format )
+            {
+                case QImage::Format_RGB32:
+                    *pRetSource = nsKernel::tagPixelSource_BGRX;
+                    return true;
+                case QImage::Format_ARGB32:
+                    *pRetSource = nsKernel::tagPixelSource_BGRA;
+                    return true;
+                case QImage::Format_ARGB32_Premultiplied:
+                    *pRetSource = nsKernel::tagPixelSource_BGRAPremultiplied;
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        // 32bpp view of Image for the kernels, other formats are converted once
+        QImage sourceImage( const QImage& Image, nsKernel::tagPixelSource* pRetSource )
+        {
+            if( pixelSourceOf( Image.format(), pRetSource ) )
+                return Image;
+
+            const bool HasAlpha = Image.hasAlphaChannel();
+            *pRetSource = HasAlpha ? nsKernel::tagPixelSource_BGRA : nsKernel::tagPixelSource_BGRX;
+            return Image.convertToFormat( HasAlpha ? QImage::Format_ARGB32 : QImage::Format_RGB32 );
+        }
+
+        QImage::Format imageFormatOf( nsKernel::tagPixelSource Source )
+        {
+            switch( Source )
+            {
+                case nsKernel::tagPixelSource_BGRX:     return QImage::Format_RGB32;
+                case nsKernel::tagPixelSource_BGRA:     return QImage::Format_ARGB32;
+                default:                                return QImage::Format_ARGB32_Premultiplied;
+            }
+        }
+
+        std::unique_ptr< nsKernel::CImageStreamEncoder > createEncoder( const QByteArray& Format, int Quality, const QSize& Size, nsKernel::tagPixelSource Source, nsKernel::ImageWriteFn Write )
+        {
+            if( Format == "qoi" )
+                return std::make_unique< nsKernel::CQoiStreamEncoder >( Size.width(), Size.height(), Source, std::move( Write ) );
+            if( Format == "raw" )
+                return std::make_unique< nsKernel::CRawStreamWriter >( Size.width(), Size.height(), Source, std::move( Write ) );
+
+#ifdef SNIPPINGTOOL_HAVE_ZLIB
+            // same mapping as Qt's PNG writer : 0 = level 9, 100 = stored, -1 = zlib default
+            nsKernel::tagPngOptions Options;
+            if( Quality >= 0 )
+                Options.Level = ( 100 - qMin( Quality, 100 ) ) * 9 / 91;
+            return std::make_unique< nsKernel::CPngStreamEncoder >( Size.width(), Size.height(), Source, Options, std::move( Write ) );
+#else
+            Q_UNUSED( Quality );
+            return nullptr;
+#endif
+        }
+
+        // Feed hands the rows to the encoder, Finish and the error report are done here
+        bool writeNative( QIODevice* Device, const QSize& Size, nsKernel::tagPixelSource Source, const QByteArray& Format, int Quality,
+                          const std::function< bool( nsKernel::CImageStreamEncoder* ) >& Feed,
+                          QImageWriter::ImageWriterError* pRetError, QString* pRetErrorText )
+        {
+            bool IsDeviceError = false;
+            const nsKernel::ImageWriteFn Write = [Device, &IsDeviceError]( const uint8_t* pData, size_t Size ) {
+                IsDeviceError = Device->write( reinterpret_cast< const char* >( pData ), ( qint64 )Size ) != ( qint64 )Size;
+                return IsDeviceError == false;
+            };
+
+            const auto Encoder = createEncoder( Format, Quality, Size, Source, Write );
+            const bool IsSuccess = Encoder != nullptr && Feed( Encoder.get() ) && Encoder->Finish();
+
+            if( IsSuccess == false )
+            {
+                if( pRetError != nullptr )
+                    *pRetError = IsDeviceError ? QImageWriter::DeviceError : QImageWriter::UnknownError;
+                if( pRetErrorText != nullptr )
+                    *pRetErrorText = IsDeviceError ? Device->errorString() : QStringLiteral( "%1 encoding failed" ).arg( QString::fromLatin1( Format ) );
+            }
+            return IsSuccess;
+        }
+    }
+
+    bool IsNativeImageFormat( const QByteArray& Format )
+    {
+#ifdef SNIPPINGTOOL_HAVE_ZLIB
+        if( Format == "png" )
+            return true;
+#endif
+        return Format == "qoi" || Format == "raw";
+    }
+
+    QList< QByteArray > SupportedImageFormats()
+    {
+        auto Formats = QImageWriter::supportedImageFormats();
+        for( const QByteArray Native : { QByteArray( "qoi" ), QByteArray( "raw" ) } )
+        {
+            if( Formats.contains( Native ) == false )
+                Formats.append( Native );
+        }
+
+        std::sort( Formats.begin(), Formats.end() );
+        return Formats;
+    }
+
+    bool IsSupportedImageFormat( const QByteArray& Format )
+    {
+        return IsNativeImageFormat( Format ) || QImageWriter::supportedImageFormats().contains( Format );
+    }
+
+    bool WriteImage( QIODevice* Device, const QImage& Image, const QByteArray& Format, int Quality, QImageWriter::ImageWriterError* pRetError, QString* pRetErrorText )
+    {
+        if( Device == nullptr || Image.isNull() )
+        {
+            if( pRetError != nullptr )
+                *pRetError = Device == nullptr ? QImageWriter::DeviceError : QImageWriter::InvalidImageError;
+            if( pRetErrorText != nullptr )
+                *pRetErrorText = Device == nullptr ? QStringLiteral( "no device" ) : QStringLiteral( "empty image" );
+            return false;
+        }
+
+        if( IsNativeImageFormat( Format ) )
+        {
+            nsKernel::tagPixelSource Source = nsKernel::tagPixelSource_BGRAPremultiplied;
+            const QImage View = sourceImage( Image, &Source );
+            const nsKernel::tagSurface Src{ const_cast< uint8_t* >( View.constBits() ), View.width(), View.height(), ( ptrdiff_t )View.bytesPerLine() };
+
+            return writeNative( Device, View.size(), Source, Format, Quality, [&Src]( nsKernel::CImageStreamEncoder* pEncoder ) {
+                return pEncoder->WriteRows( Src );
+            }, pRetError, pRetErrorText );
+        }
+
+        QImageWriter Writer( Device, Format );
+        Writer.setQuality( Quality );
+        if( Writer.write( Image ) )
+            return true;
+
+        if( pRetError != nullptr )
+            *pRetError = Writer.error();
+        if( pRetErrorText != nullptr )
+            *pRetErrorText = Writer.errorString();
+        return false;
+    }
+
+    bool WriteImageStrips( QIODevice* Device, const QSize& Size, QImage::Format PixelFormat, const QByteArray& Format, int Quality,
+                           const ImageStripFn& Produce, int StripRows, QImageWriter::ImageWriterError* pRetError, QString* pRetErrorText )
+    {
+        nsKernel::tagPixelSource Source = nsKernel::tagPixelSource_BGRAPremultiplied;
+        if( Device == nullptr || Size.isEmpty() || !Produce || pixelSourceOf( PixelFormat, &Source ) == false )
+        {
+            if( pRetError != nullptr )
+                *pRetError = Device == nullptr ? QImageWriter::DeviceError : QImageWriter::InvalidImageError;
+            if( pRetErrorText != nullptr )
+                *pRetErrorText = Device == nullptr ? QStringLiteral( "no device" ) : QStringLiteral( "empty image" );
+            return false;
+        }
+
+        if( IsNativeImageFormat( Format ) == false )
+        {
+            // QImageWriter needs the whole image, produced as one strip
+            QImage Image( Size, PixelFormat );
+            if( Image.isNull() || Produce( 0, &Image ) == false )
+            {
+                if( pRetError != nullptr )
+                    *pRetError = QImageWriter::InvalidImageError;
+                if( pRetErrorText != nullptr )
+                    *pRetErrorText = QStringLiteral( "image not available" );
+                return false;
+            }
+            return WriteImage( Device, Image, Format, Quality, pRetError, pRetErrorText );
+        }
+
+        if( StripRows <= 0 )
+            StripRows = ( int )qBound< qint64 >( 1, STRIP_BYTES / ( ( qint64 )Size.width() * 4 ), Size.height() );
+
+        // one strip reused top to bottom, the encoder is done with it when WriteRows returns
+        QImage Strip( Size.width(), qMin( StripRows, Size.height() ), PixelFormat );
+        if( Strip.isNull() )
+        {
+            if( pRetError != nullptr )
+                *pRetError = QImageWriter::UnknownError;
+            if( pRetErrorText != nullptr )
+                *pRetErrorText = QStringLiteral( "out of memory" );
+            return false;
+        }
+
+        return writeNative( Device, Size, Source, Format, Quality, [&]( nsKernel::CImageStreamEncoder* pEncoder ) {
+            for( int FirstRow = 0; FirstRow < Size.height(); FirstRow += Strip.height() )
+            {
+                if( Size.height() - FirstRow < Strip.height() )
+                    Strip = Strip.copy( 0, 0, Size.width(), Size.height() - FirstRow );
+
+                if( Produce( FirstRow, &Strip ) == false )
+                    return false;
+
+                const nsKernel::tagSurface Rows{ Strip.bits(), Strip.width(), Strip.height(), ( ptrdiff_t )Strip.bytesPerLine() };
+                if( pEncoder->WriteRows( Rows ) == false )
+                    return false;
+            }
+            return true;
+        }, pRetError, pRetErrorText );
+    }
+
+    QImage ReadImage( const QString& FilePath, QString* pRetErrorText )
+    {
+        QImage Image;
+        QString ErrorText;
+        const QByteArray Suffix = QFileInfo( FilePath ).suffix().toLower().toLatin1();
+
+        do
+        {
+            if( Suffix != "qoi" && Suffix != "raw" )
+            {
+                QImageReader Reader( FilePath );
+                Image = Reader.read();
+                if( Image.isNull() )
+                    ErrorText = Reader.errorString();
+                break;
+            }
+
+            auto File = std::make_unique< QFile >( FilePath );
+            if( File->open( QIODevice::ReadOnly ) == false )
+            {
+                ErrorText = File->errorString();
+                break;
+            }
+
+            const qint64 Size = File->size();
+            const uchar* pData = Size > 0 ? File->map( 0, Size ) : nullptr;
+            if( pData == nullptr )
+            {
+                ErrorText = File->errorString();
+                break;
+            }
+
+            if( Suffix == "raw" )
+            {
+                nsKernel::tagRawHeader Header;
+                if( nsKernel::ReadRawHeader( pData, ( size_t )Size, &Header ) == false )
+                {
+                    ErrorText = QStringLiteral( "not a raw capture file" );
+                    break;
+                }
+
+                // the pixels stay in the mapping, the file closes with the last copy of the image
+                QFile* pFile = File.release();
+                Image = QImage( pData + Header.HeaderBytes, ( int )Header.Width, ( int )Header.Height, ( qsizetype )Header.Pitch,
+                                imageFormatOf( ( nsKernel::tagPixelSource )Header.Layout ),
+                                []( void* pInfo ) { delete static_cast< QFile* >( pInfo ); }, pFile );
+                break;
+            }
+
+            nsKernel::tagQoiHeader Header;
+            if( nsKernel::ReadQoiHeader( pData, ( size_t )Size, &Header ) == false )
+            {
+                ErrorText = QStringLiteral( "not a QOI file" );
+                break;
+            }
+
+            Image = QImage( Header.Width, Header.Height, Header.Channels == 3 ? QImage::Format_RGB32 : QImage::Format_ARGB32 );
+            const nsKernel::tagSurface Dst{ Image.bits(), Image.width(), Image.height(), ( ptrdiff_t )Image.bytesPerLine() };
+            if( Image.isNull() || nsKernel::DecodeQoi( pData, ( size_t )Size, Dst ) == false )
+            {
+                Image = QImage();
+                ErrorText = QStringLiteral( "corrupt QOI file" );
+                break;
+            }
+
+        } while( false );
+
+        if( pRetErrorText != nullptr )
+            *pRetErrorText = ErrorText;
+        return Image;
+    }
+
+} // nsCapture
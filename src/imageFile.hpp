@@ -0,0 +1,44 @@
+#ifndef IMAGEFILE_HPP
+#define IMAGEFILE_HPP
+
+#include <QtCore>
+#include <QtGui>
+
+#include <functional>
+
+namespace nsCapture
+{
+    ///////////////////////////////////////////////////////////////////////////
+    /// image files of the save paths ( save dialog, CaptureToFile, headless )
+    ///
+    /// qoi and raw are written by the kernels ( imageCodec.hpp ), png as well when built with zlib
+    /// ( row-block parallel deflate ), every other format goes through QImageWriter.
+    /// The kernel formats also take the image as row strips ( WriteImageStrips ) and write each one as it comes.
+    /// Format names are lower case, as QImageWriter::supportedImageFormats() reports them.
+
+    // written without QImageWriter
+    bool                                IsNativeImageFormat( const QByteArray& Format );
+    // QImageWriter formats plus qoi and raw, sorted
+    QList< QByteArray >                 SupportedImageFormats();
+    bool                                IsSupportedImageFormat( const QByteArray& Format );
+
+    // Quality as QImageWriter::setQuality ( -1 = encoder default, png : 0 = smallest ~ 100 = stored, ignored by qoi and raw )
+    bool                                WriteImage( QIODevice* Device, const QImage& Image, const QByteArray& Format, int Quality,
+                                                    QImageWriter::ImageWriterError* pRetError = nullptr, QString* pRetErrorText = nullptr );
+
+    // rows [ FirstRow, FirstRow + pStrip->height() ) of the image into pStrip, false stops the write
+    typedef std::function< bool( int FirstRow, QImage* pStrip ) > ImageStripFn;
+
+    // a Size image of 32bpp PixelFormat produced a strip of StripRows rows at a time ( 0 = about 4 MB ); native formats
+    // encode and write every strip before the next is produced, so only one strip is held. Other formats get the whole image
+    bool                                WriteImageStrips( QIODevice* Device, const QSize& Size, QImage::Format PixelFormat, const QByteArray& Format, int Quality,
+                                                          const ImageStripFn& Produce, int StripRows = 0,
+                                                          QImageWriter::ImageWriterError* pRetError = nullptr, QString* pRetErrorText = nullptr );
+
+    // qoi decoded by the kernel, raw mapped from the file without a copy ( the image keeps the file open ),
+    // the rest through QImageReader; null image on failure
+    QImage                              ReadImage( const QString& FilePath, QString* pRetErrorText = nullptr );
+
+} // nsCapture
+
+#endif //IMAGEFILE_HPP
@@ -0,0 +1,106 @@
+#include "imagePyramid.hpp"
+#include "captureTrace.hpp"
+#include "desktopCanvas.hpp"
+#include "frameResample.hpp"
+
+namespace nsCapture
+{
+    namespace
+    {
+        nsKernel::tagSurface surfaceOf( const QImage& Image )
+        {
+            return nsKernel::tagSurface{ const_cast< uint8_t* >( Image.constBits() ), Image.width(), Image.height(), ( ptrdiff_t )Image.bytesPerLine() };
+        }
+
+        // Src scaled to Size, every pixel of Dst written
+        QImage resample( const QImage& Src, const QSize& Size, nsKernel::tagResampleFilter Filter )
+        {
+            QImage Dst( Size, Src.format() );
+            if( Dst.isNull() )
+                return QImage();
+
+            const nsKernel::tagPixelRect Target{ 0, 0, Size.width(), Size.height() };
+            if( nsKernel::ResampleSurface( surfaceOf( Dst ), Target, surfaceOf( Src ), Filter ) == false )
+                return QImage();
+            return Dst;
+        }
+    }
+
+    bool CImagePyramid::Reset( const QImage& Image, int MinEdge )
+    {
+        m_levels.clear();
+        if( Image.isNull() )
+            return false;
+
+        CTraceSpan Span( tagTraceStage_Preview );
+
+        // RGB32 is opaque premultiplied already, the kernels take it as is
+        QImage Base = Image;
+        if( Base.format() != QImage::Format_ARGB32_Premultiplied && Base.format() != QImage::Format_RGB32 )
+            Base = CDesktopCanvas::Convert( Base, QImage::Format_ARGB32_Premultiplied );
+        if( Base.isNull() )
+            return false;
+
+        m_levels.push_back( Base );
+        for( ;; )
+        {
+            const QImage& Last = m_levels.constLast();
+            if( qMax( Last.width(), Last.height() ) / 2 < qMax( MinEdge, 1 ) )
+                break;
+
+            const QImage Half = resample( Last, QSize( qMax( 1, ( Last.width() + 1 ) / 2 ), qMax( 1, ( Last.height() + 1 ) / 2 ) ), nsKernel::tagResampleFilter_Box );
+            if( Half.isNull() )
+                break;
+            m_levels.push_back( Half );
+        }
+
+        return true;
+    }
+
+    void CImagePyramid::Clear()
+    {
+        m_levels.clear();
+    }
+
+    const QImage& CImagePyramid::Level( int Idx ) const
+    {
+        static const QImage Null;
+        return Idx >= 0 && Idx < m_levels.size() ? m_levels.at( Idx ) : Null;
+    }
+
+    QSize CImagePyramid::FittedSize( const QSize& Bounds ) const
+    {
+        if( m_levels.isEmpty() )
+            return QSize();
+
+        QSize Size = m_levels.constFirst().size().scaled( Bounds, Qt::KeepAspectRatio );
+        return Size.expandedTo( QSize( 1, 1 ) );
+    }
+
+    int CImagePyramid::LevelFor( const QSize& Size ) const
+    {
+        int Idx = 0;
+        while( Idx + 1 < m_levels.size() && m_levels.at( Idx + 1 ).width() >= Size.width() && m_levels.at( Idx + 1 ).height() >= Size.height() )
+            ++Idx;
+        return Idx;
+    }
+
+    QImage CImagePyramid::Scaled( const QSize& Bounds, bool IsSmooth ) const
+    {
+        if( m_levels.isEmpty() || Bounds.isEmpty() )
+            return QImage();
+
+        CTraceSpan Span( tagTraceStage_Preview );
+
+        const QSize Size = FittedSize( Bounds );
+        const QImage& Source = m_levels.at( LevelFor( Size ) );
+        if( Source.size() == Size )
+            return Source;
+
+        if( IsSmooth == false )
+            return Source.scaled( Size, Qt::IgnoreAspectRatio, Qt::FastTransformation );
+
+        return resample( Source, Size, nsKernel::tagResampleFilter_Auto );
+    }
+
+} // nsCapture
@@ -0,0 +1,42 @@
+#ifndef IMAGEPYRAMID_HPP
+#define IMAGEPYRAMID_HPP
+
+#include <QtCore>
+#include <QtGui>
+
+namespace nsCapture
+{
+    ///////////////////////////////////////////////////////////////////////////
+    /// CImagePyramid
+    ///
+    /// Half resolution levels of one image ( 2x2 box average by the resample kernel ), built once per capture so
+    /// that a view of any size is scaled from the nearest level at least as large instead of the full image.
+    /// Level 0 shares the source, every level is 32bpp with premultiplied ( or opaque ) alpha.
+
+    class CImagePyramid
+    {
+    public:
+        // levels down to MinEdge on the longer side, false for a null image
+        bool                            Reset( const QImage& Image, int MinEdge = 256 );
+        void                            Clear();
+
+        bool                            IsEmpty() const     { return m_levels.isEmpty(); }
+        int                             LevelCount() const  { return m_levels.size(); }
+        const QImage&                   Level( int Idx ) const;
+
+        // the source fitted into Bounds ( Qt::KeepAspectRatio ), never empty for a non-empty pyramid
+        QSize                           FittedSize( const QSize& Bounds ) const;
+        // smallest level still covering Size on both axes, 0 for an upscale
+        int                             LevelFor( const QSize& Size ) const;
+
+        // the source fitted into Bounds from LevelFor : IsSmooth resamples ( bilinear, at most 2x down ),
+        // otherwise nearest neighbour for a first frame while the size is still changing
+        QImage                          Scaled( const QSize& Bounds, bool IsSmooth ) const;
+
+    private:
+        QVector< QImage >               m_levels;
+    };
+
+} // nsCapture
+
+#endif //IMAGEPYRAMID_HPP
@@ -0,0 +1,367 @@
+#include "incrementalFrame.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+namespace nsKernel
+{
+    namespace
+    {
+        const uint32_t                  BYTES_PER_PIXEL         = 4;
+
+        tagPixelRect intersectRect( const tagPixelRect& Lhs, const tagPixelRect& Rhs )
+        {
+            tagPixelRect Ret;
+            Ret.Left    = std::max( Lhs.Left, Rhs.Left );
+            Ret.Top     = std::max( Lhs.Top, Rhs.Top );
+            Ret.Right   = std::min( Lhs.Right, Rhs.Right );
+            Ret.Bottom  = std::min( Lhs.Bottom, Rhs.Bottom );
+            return Ret.IsEmpty() ? tagPixelRect() : Ret;
+        }
+
+        tagPixelRect unionRect( const tagPixelRect& Lhs, const tagPixelRect& Rhs )
+        {
+            tagPixelRect Ret;
+            Ret.Left    = std::min( Lhs.Left, Rhs.Left );
+            Ret.Top     = std::min( Lhs.Top, Rhs.Top );
+            Ret.Right   = std::max( Lhs.Right, Rhs.Right );
+            Ret.Bottom  = std::max( Lhs.Bottom, Rhs.Bottom );
+            return Ret;
+        }
+
+        // Rect minus Hole as up to four non-overlapping bands
+        void subtractRect( const tagPixelRect& Rect, const tagPixelRect& Hole, std::vector< tagPixelRect >* pRetPieces )
+        {
+            const tagPixelRect Cut = intersectRect( Rect, Hole );
+            if( Cut.IsEmpty() )
+            {
+                pRetPieces->push_back( Rect );
+                return;
+            }
+
+            if( Rect.Top < Cut.Top )
+                pRetPieces->push_back( tagPixelRect{ Rect.Left, Rect.Top, Rect.Right, Cut.Top } );
+            if( Cut.Bottom < Rect.Bottom )
+                pRetPieces->push_back( tagPixelRect{ Rect.Left, Cut.Bottom, Rect.Right, Rect.Bottom } );
+            if( Rect.Left < Cut.Left )
+                pRetPieces->push_back( tagPixelRect{ Rect.Left, Cut.Top, Cut.Left, Cut.Bottom } );
+            if( Cut.Right < Rect.Right )
+                pRetPieces->push_back( tagPixelRect{ Cut.Right, Cut.Top, Rect.Right, Cut.Bottom } );
+        }
+
+        tagPixelRect clipRect( const tagPixelRect& Rect, int32_t Width, int32_t Height )
+        {
+            return intersectRect( Rect, tagPixelRect{ 0, 0, Width, Height } );
+        }
+    }
+
+    bool operator==( const tagPixelRect& Lhs, const tagPixelRect& Rhs )
+    {
+        return Lhs.Left == Rhs.Left && Lhs.Top == Rhs.Top && Lhs.Right == Rhs.Right && Lhs.Bottom == Rhs.Bottom;
+    }
+
+    tagIncrementalStats_s& tagIncrementalStats_s::operator+=( const tagIncrementalStats_s& Rhs )
+    {
+        Frames          += Rhs.Frames;
+        RectsIn         += Rhs.RectsIn;
+        RectsOut        += Rhs.RectsOut;
+        BytesCopied     += Rhs.BytesCopied;
+        BytesMoved      += Rhs.BytesMoved;
+        FullFrameBytes  += Rhs.FullFrameBytes;
+        return *this;
+    }
+
+    void CoalesceRects( std::vector< tagPixelRect >* pRects, int32_t Width, int32_t Height )
+    {
+        if( pRects == nullptr )
+            return;
+
+        auto& Rects = *pRects;
+
+        size_t Count = 0;
+        for( const auto& Rect : Rects )
+        {
+            const tagPixelRect Clipped = clipRect( Rect, Width, Height );
+            if( !Clipped.IsEmpty() )
+                Rects[ Count++ ] = Clipped;
+        }
+        Rects.resize( Count );
+
+        // merge while the bounding box is mostly covered ( waste < 25% )
+        bool IsMerged = true;
+        while( IsMerged && Rects.size() > 1 )
+        {
+            IsMerged = false;
+
+            for( size_t i = 0; i < Rects.size() && !IsMerged; ++i )
+            {
+                for( size_t j = i + 1; j < Rects.size(); ++j )
+                {
+                    const tagPixelRect Union = unionRect( Rects[ i ], Rects[ j ] );
+                    const int64_t Covered = Rects[ i ].Area() + Rects[ j ].Area() - intersectRect( Rects[ i ], Rects[ j ] ).Area();
+                    if( ( Union.Area() - Covered ) * 4 > Union.Area() )
+                        continue;
+
+                    Rects[ i ] = Union;
+                    Rects.erase( Rects.begin() + ( ptrdiff_t )j );
+                    IsMerged = true;
+                    break;
+                }
+            }
+        }
+
+        const int64_t FrameArea = ( int64_t )Width * Height;
+        int64_t Total = 0;
+        for( const auto& Rect : Rects )
+            Total += Rect.Area();
+
+        // one contiguous copy beats many short rows once most of the frame changed
+        if( FrameArea > 0 && Total * 4 >= FrameArea * 3 )
+        {
+            Rects.assign( 1, tagPixelRect{ 0, 0, Width, Height } );
+            return;
+        }
+
+        // what is left may still overlap, cut later rects so that every byte is copied once
+        for( size_t i = 0; i < Rects.size(); ++i )
+        {
+            for( size_t j = i + 1; j < Rects.size(); )
+            {
+                if( intersectRect( Rects[ i ], Rects[ j ] ).IsEmpty() )
+                {
+                    ++j;
+                    continue;
+                }
+
+                std::vector< tagPixelRect > Pieces;
+                subtractRect( Rects[ j ], Rects[ i ], &Pieces );
+                Rects.erase( Rects.begin() + ( ptrdiff_t )j );
+                Rects.insert( Rects.begin() + ( ptrdiff_t )j, Pieces.begin(), Pieces.end() );
+                j += Pieces.size();
+            }
+        }
+    }
+
+    uint64_t CopyRect( const tagSurface& Dst, const uint8_t* pSrc, ptrdiff_t SrcPitch, const tagPixelRect& Rect )
+    {
+        const tagPixelRect Clipped = clipRect( Rect, Dst.Width, Dst.Height );
+        if( Dst.Bits == nullptr || pSrc == nullptr || Clipped.IsEmpty() )
+            return 0;
+
+        const size_t RowBytes = ( size_t )Clipped.Width() * BYTES_PER_PIXEL;
+        const ptrdiff_t Offset = ( ptrdiff_t )Clipped.Left * BYTES_PER_PIXEL;
+
+        // full-width rects of a tightly packed pair are one block
+        if( RowBytes == ( size_t )Dst.Pitch && SrcPitch == Dst.Pitch )
+        {
+            memcpy( Dst.Bits + Clipped.Top * Dst.Pitch, pSrc + Clipped.Top * SrcPitch, RowBytes * Clipped.Height() );
+            return RowBytes * Clipped.Height();
+        }
+
+        for( int32_t y = Clipped.Top; y < Clipped.Bottom; ++y )
+            memcpy( Dst.Bits + y * Dst.Pitch + Offset, pSrc + y * SrcPitch + Offset, RowBytes );
+
+        return RowBytes * Clipped.Height();
+    }
+
+    uint64_t MoveRect( const tagSurface& Dst, const tagMoveRect& Move )
+    {
+        if( Dst.Bits == nullptr )
+            return 0;
+
+        // clip destination and source together
+        const int32_t Dx = Move.Destination.Left - Move.SourceX;
+        const int32_t Dy = Move.Destination.Top - Move.SourceY;
+        tagPixelRect Target = clipRect( Move.Destination, Dst.Width, Dst.Height );
+        tagPixelRect Source{ Target.Left - Dx, Target.Top - Dy, Target.Right - Dx, Target.Bottom - Dy };
+        Source = clipRect( Source, Dst.Width, Dst.Height );
+        Target = tagPixelRect{ Source.Left + Dx, Source.Top + Dy, Source.Right + Dx, Source.Bottom + Dy };
+
+        if( Target.IsEmpty() || ( Dx == 0 && Dy == 0 ) )
+            return 0;
+
+        const size_t RowBytes = ( size_t )Target.Width() * BYTES_PER_PIXEL;
+
+        // rows moving down are walked bottom-up, memmove covers the horizontal overlap
+        if( Dy > 0 )
+        {
+            for( int32_t y = Target.Height() - 1; y >= 0; --y )
+                memmove( Dst.Bits + ( Target.Top + y ) * Dst.Pitch + Target.Left * BYTES_PER_PIXEL,
+                         Dst.Bits + ( Source.Top + y ) * Dst.Pitch + Source.Left * BYTES_PER_PIXEL, RowBytes );
+        }
+        else
+        {
+            for( int32_t y = 0; y < Target.Height(); ++y )
+                memmove( Dst.Bits + ( Target.Top + y ) * Dst.Pitch + Target.Left * BYTES_PER_PIXEL,
+                         Dst.Bits + ( Source.Top + y ) * Dst.Pitch + Source.Left * BYTES_PER_PIXEL, RowBytes );
+        }
+
+        return RowBytes * Target.Height();
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// class CIncrementalFrame
+    //
+
+    CIncrementalFrame::CIncrementalFrame()
+    {
+    }
+
+    void CIncrementalFrame::Reset( int32_t Width, int32_t Height )
+    {
+        Width = std::max( Width, 0 );
+        Height = std::max( Height, 0 );
+
+        m_storage.assign( ( size_t )Width * Height * BYTES_PER_PIXEL, 0 );
+        m_surface.Bits      = m_storage.empty() ? nullptr : m_storage.data();
+        m_surface.Width     = Width;
+        m_surface.Height    = Height;
+        m_surface.Pitch     = ( ptrdiff_t )Width * BYTES_PER_PIXEL;
+        m_changed.clear();
+    }
+
+    void CIncrementalFrame::Attach( const tagSurface& Surface )
+    {
+        m_storage.clear();
+        m_storage.shrink_to_fit();
+        m_surface = Surface;
+        m_changed.clear();
+    }
+
+    void CIncrementalFrame::Detach()
+    {
+        m_storage.clear();
+        m_surface = tagSurface();
+        m_changed.clear();
+    }
+
+    std::vector< tagPixelRect > CIncrementalFrame::Plan( const tagFrameDelta& Delta ) const
+    {
+        std::vector< tagPixelRect > Planned( Delta.Dirty );
+        CoalesceRects( &Planned, m_surface.Width, m_surface.Height );
+        return Planned;
+    }
+
+    void CIncrementalFrame::Apply( const tagFrameDelta& Delta, const std::vector< tagPixelRect >& Planned, const uint8_t* pSrc, ptrdiff_t SrcPitch )
+    {
+        m_changed.clear();
+
+        for( const auto& Move : Delta.Moves )
+        {
+            const uint64_t Bytes = MoveRect( m_surface, Move );
+            if( Bytes == 0 )
+                continue;
+
+            m_stats.BytesMoved += Bytes;
+            m_changed.push_back( clipRect( Move.Destination, m_surface.Width, m_surface.Height ) );
+        }
+
+        for( const auto& Rect : Planned )
+        {
+            m_stats.BytesCopied += CopyRect( m_surface, pSrc, SrcPitch, Rect );
+            m_changed.push_back( Rect );
+        }
+
+        ++m_stats.Frames;
+        m_stats.RectsIn += Delta.Dirty.size();
+        m_stats.RectsOut += Planned.size();
+        m_stats.FullFrameBytes += ( uint64_t )m_surface.Width * m_surface.Height * BYTES_PER_PIXEL;
+    }
+
+    void CIncrementalFrame::Apply( const tagFrameDelta& Delta, const uint8_t* pSrc, ptrdiff_t SrcPitch )
+    {
+        Apply( Delta, Plan( Delta ), pSrc, SrcPitch );
+    }
+
+    void CIncrementalFrame::Store( const uint8_t* pSrc, ptrdiff_t SrcPitch )
+    {
+        const tagPixelRect Full{ 0, 0, m_surface.Width, m_surface.Height };
+
+        m_changed.assign( 1, Full );
+        m_stats.BytesCopied += CopyRect( m_surface, pSrc, SrcPitch, Full );
+
+        ++m_stats.Frames;
+        ++m_stats.RectsIn;
+        ++m_stats.RectsOut;
+        m_stats.FullFrameBytes += ( uint64_t )m_surface.Width * m_surface.Height * BYTES_PER_PIXEL;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// Rect stream
+    //
+
+    bool ReadRectStream( std::istream& Stream, std::vector< tagFrameDelta >* pRetFrames )
+    {
+        if( pRetFrames == nullptr )
+            return false;
+
+        std::string Line;
+        while( std::getline( Stream, Line ) )
+        {
+            if( Line.empty() || Line[ 0 ] == '#' )
+                continue;
+
+            std::istringstream Tokens( Line );
+            tagFrameDelta Frame;
+            std::string Tag;
+
+            while( Tokens >> Tag )
+            {
+                if( Tag == "-" )
+                {
+                    continue;
+                }
+                else if( Tag == "M" )
+                {
+                    tagMoveRect Move;
+                    if( !( Tokens >> Move.SourceX >> Move.SourceY >> Move.Destination.Left >> Move.Destination.Top >> Move.Destination.Right >> Move.Destination.Bottom ) )
+                        return false;
+                    Frame.Moves.push_back( Move );
+                }
+                else if( Tag == "D" )
+                {
+                    tagPixelRect Rect;
+                    if( !( Tokens >> Rect.Left >> Rect.Top >> Rect.Right >> Rect.Bottom ) )
+                        return false;
+                    Frame.Dirty.push_back( Rect );
+                }
+                else
+                {
+                    return false;
+                }
+            }
+
+            pRetFrames->push_back( std::move( Frame ) );
+        }
+
+        return true;
+    }
+
+    void WriteRectStream( std::ostream& Stream, const tagFrameDelta& Frame )
+    {
+        const char* Separator = "";
+        for( const auto& Move : Frame.Moves )
+        {
+            Stream << Separator << "M " << Move.SourceX << ' ' << Move.SourceY << ' '
+                << Move.Destination.Left << ' ' << Move.Destination.Top << ' ' << Move.Destination.Right << ' ' << Move.Destination.Bottom;
+            Separator = " ";
+        }
+
+        for( const auto& Rect : Frame.Dirty )
+        {
+            Stream << Separator << "D " << Rect.Left << ' ' << Rect.Top << ' ' << Rect.Right << ' ' << Rect.Bottom;
+            Separator = " ";
+        }
+
+        // present without metadata
+        if( Frame.Moves.empty() && Frame.Dirty.empty() )
+            Stream << '-';
+
+        Stream << '\n';
+    }
+
+} // nsKernel
@@ -0,0 +1,128 @@
+#ifndef INCREMENTALFRAME_HPP
+#define INCREMENTALFRAME_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+namespace nsKernel
+{
+    // struct tagPixelRect_s : RECT layout, right / bottom exclusive
+    typedef struct tagPixelRect_s
+    {
+        int32_t                         Left                = 0;
+        int32_t                         Top                 = 0;
+        int32_t                         Right               = 0;
+        int32_t                         Bottom              = 0;
+
+        int32_t                         Width() const       { return Right - Left; }
+        int32_t                         Height() const      { return Bottom - Top; }
+        bool                            IsEmpty() const     { return Right <= Left || Bottom <= Top; }
+        int64_t                         Area() const        { return IsEmpty() ? 0 : ( int64_t )Width() * Height(); }
+    } tagPixelRect;
+
+    bool                                operator==( const tagPixelRect& Lhs, const tagPixelRect& Rhs );
+
+    // struct tagMoveRect_s : DXGI_OUTDUPL_MOVE_RECT, Destination content comes from ( SourceX, SourceY ) of the previous frame
+    typedef struct tagMoveRect_s
+    {
+        int32_t                         SourceX             = 0;
+        int32_t                         SourceY             = 0;
+        tagPixelRect                    Destination;
+    } tagMoveRect;
+
+    // struct tagFrameDelta_s : metadata of one present, moves are applied before dirty rects
+    typedef struct tagFrameDelta_s
+    {
+        std::vector< tagMoveRect >      Moves;
+        std::vector< tagPixelRect >     Dirty;
+    } tagFrameDelta;
+
+    // struct tagSurface_s : 32bpp surface, not owned
+    typedef struct tagSurface_s
+    {
+        uint8_t*                        Bits                = nullptr;
+        int32_t                         Width               = 0;
+        int32_t                         Height              = 0;
+        ptrdiff_t                       Pitch               = 0;
+    } tagSurface;
+
+    // struct tagIncrementalStats_s
+    typedef struct tagIncrementalStats_s
+    {
+        uint64_t                        Frames              = 0;
+        uint64_t                        RectsIn             = 0;    // dirty rects as reported
+        uint64_t                        RectsOut            = 0;    // after clipping and coalescing
+        uint64_t                        BytesCopied         = 0;    // read from the source frame
+        uint64_t                        BytesMoved          = 0;    // moved inside the surface
+        uint64_t                        FullFrameBytes      = 0;    // what full copies of the same frames would have cost
+
+        tagIncrementalStats_s&          operator+=( const tagIncrementalStats_s& Rhs );
+    } tagIncrementalStats;
+
+    // clip to the surface, drop empty rects and merge overlapping or close rects while the merged box
+    // wastes less than a quarter of its area; a result covering most of the frame collapses to one rect
+    void                                CoalesceRects( std::vector< tagPixelRect >* pRects, int32_t Width, int32_t Height );
+
+    // copy Rect of pSrc ( same geometry as Dst ) into Dst, returns bytes copied
+    uint64_t                            CopyRect( const tagSurface& Dst, const uint8_t* pSrc, ptrdiff_t SrcPitch, const tagPixelRect& Rect );
+    // apply a move inside Dst, overlapping source / destination is handled; returns bytes moved
+    uint64_t                            MoveRect( const tagSurface& Dst, const tagMoveRect& Move );
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// CIncrementalFrame
+    ///
+    /// Keeps a persistent BGRA surface equal to the latest desktop image by applying the move and dirty
+    /// rectangles of every present. Plan() returns the coalesced rectangles that must be fetched from
+    /// the source ( GPU readback on DXGI ); Apply() moves, then copies exactly those rectangles.
+    /// The rectangles changed by the last Apply() are kept for change detection.
+
+    class CIncrementalFrame
+    {
+    public:
+        CIncrementalFrame();
+
+        // own a Width x Height surface
+        void                            Reset( int32_t Width, int32_t Height );
+        // work on caller memory ( e.g. a QImage ), the surface is not owned
+        void                            Attach( const tagSurface& Surface );
+        void                            Detach();
+
+        const tagSurface&               Surface() const     { return m_surface; }
+
+        // dirty rects of Delta, clipped and coalesced
+        std::vector< tagPixelRect >     Plan( const tagFrameDelta& Delta ) const;
+        // moves of Delta, then Planned rects from pSrc ( the full new frame, only Planned areas are read )
+        void                            Apply( const tagFrameDelta& Delta, const std::vector< tagPixelRect >& Planned, const uint8_t* pSrc, ptrdiff_t SrcPitch );
+        void                            Apply( const tagFrameDelta& Delta, const uint8_t* pSrc, ptrdiff_t SrcPitch );
+        // whole frame
+        void                            Store( const uint8_t* pSrc, ptrdiff_t SrcPitch );
+
+        // rects whose pixels changed in the last Apply / Store ( move destinations included )
+        const std::vector< tagPixelRect >& ChangedRects() const { return m_changed; }
+
+        const tagIncrementalStats&      Stats() const       { return m_stats; }
+        void                            ResetStats()        { m_stats = tagIncrementalStats(); }
+
+    private:
+        std::vector< uint8_t >          m_storage;
+        tagSurface                      m_surface;
+        std::vector< tagPixelRect >     m_changed;
+        tagIncrementalStats             m_stats;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// Rect stream
+    ///
+    /// Text recording of frame metadata, one present per line:
+    ///     M sx sy l t r b  ...  D l t r b  ...
+    /// A present without metadata is written as "-", lines starting with '#' are comments.
+    /// Used to replay real DXGI sessions on any platform.
+
+    bool                                ReadRectStream( std::istream& Stream, std::vector< tagFrameDelta >* pRetFrames );
+    void                                WriteRectStream( std::ostream& Stream, const tagFrameDelta& Frame );
+
+} // nsKernel
+
+#endif //INCREMENTALFRAME_HPP
@@ -5,10 +5,17 @@
 #include <Windows.h>
 #endif
 
+#include "captureTrace.hpp"
+#include "headlessCapture.hpp"
 #include "snippingTool.hpp"
+#include "snippingTray.hpp"
 
 int main( int argc, char* argv[] )
 {
+    // --headless : 위젯 / ElaWidgetTools 초기화 없이 캡처하여 파일 또는 stdout 으로 저장 후 종료
+    if( nsCapture::IsHeadlessCommandLine( argc, argv ) )
+        return nsCapture::RunHeadlessCapture( argc, argv );
+
     SetEnvironmentVariableW( L"QT_ENABLE_HIGHDPI_SCALING", L"1" );
 
     QCoreApplication::setAttribute( Qt::AA_EnableHighDpiScaling, true );
@@ -20,9 +27,24 @@ int main( int argc, char* argv[] )
 
     QSnippingTool Tool;
     Tool.SetDisplayAffinity( WDA_EXCLUDEFROMCAPTURE );
-    Tool.show();
 
-    return app.exec();
+    // --tray : 창 없이 트레이에 상주, 전역 단축키로 캡처
+    std::unique_ptr< QSnippingTray > Tray;
+    if( QCoreApplication::arguments().contains( QStringLiteral( "--tray" ) ) )
+    {
+        Tray = std::make_unique< QSnippingTray >( &Tool );
+        Tray->Show();
+    }
+    else
+    {
+        Tool.show();
+    }
+
+    const int Ret = app.exec();
+
+    // SNIPPINGTOOL_TRACE 에 파일 경로를 지정한 경우 Chrome trace_event JSON 저장
+    nsCapture::CCaptureTrace::Instance().Flush();
+    return Ret;
 }
 
 // int main(int argc, char* argv[])
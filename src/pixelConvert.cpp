@@ -0,0 +1,466 @@
+#include "pixelConvert.hpp"
+
+#include <cstring>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define NSKERNEL_CONVERT_SSE2
+#include <emmintrin.h>
+// SSSE3 is compiled per function and only called after the CPU check, no global compiler flag
+#if defined( _MSC_VER )
+#define NSKERNEL_CONVERT_SSSE3
+#define NSKERNEL_TARGET_SSSE3
+#include <intrin.h>
+#include <tmmintrin.h>
+#elif defined( __GNUC__ )
+#define NSKERNEL_CONVERT_SSSE3
+#define NSKERNEL_TARGET_SSSE3           __attribute__(( target( "ssse3" ) ))
+#include <tmmintrin.h>
+#endif
+#endif
+
+namespace nsKernel
+{
+    namespace
+    {
+        const uint32_t                  BYTES_PER_PIXEL         = 4;
+
+        // BT.601 luma in 8 bit fixed point, weights sum to 256 so white stays 255
+        const uint32_t                  LUMA_R                  = 77;
+        const uint32_t                  LUMA_G                  = 150;
+        const uint32_t                  LUMA_B                  = 29;
+
+        inline uint32_t loadPixel( const uint8_t* p )
+        {
+            uint32_t Pixel;
+            memcpy( &Pixel, p, sizeof( Pixel ) );
+            return Pixel;
+        }
+
+        inline void storePixel( uint8_t* p, uint32_t Pixel )
+        {
+            memcpy( p, &Pixel, sizeof( Pixel ) );
+        }
+
+        // x / 255 rounded, exact for x <= 255 * 255
+        inline uint32_t div255( uint32_t X )
+        {
+            X += 128;
+            return ( X + ( X >> 8 ) ) >> 8;
+        }
+
+        // ceil( 255 * 65536 / a ) : ( c * r + 0x8000 ) >> 16 equals the rounded c * 255 / a for every c and a ( checked in the bench )
+        struct tagUnpremultiplyTable
+        {
+            uint32_t                    Reciprocal[ 256 ];
+            // the reciprocal split in 16 bit halves, repeated in the B G R lanes of one pixel ( alpha lane 0 )
+            uint64_t                    LanesLow[ 256 ];
+            uint64_t                    LanesHigh[ 256 ];
+
+            tagUnpremultiplyTable()
+            {
+                Reciprocal[ 0 ] = 0;
+                for( uint32_t a = 1; a < 256; ++a )
+                    Reciprocal[ a ] = ( 255u * 65536u + a - 1 ) / a;
+
+                for( uint32_t a = 0; a < 256; ++a )
+                {
+                    LanesLow[ a ] = ( uint64_t )( Reciprocal[ a ] & 0xFFFFu ) * 0x0000000100010001ull;
+                    LanesHigh[ a ] = ( uint64_t )( Reciprocal[ a ] >> 16 ) * 0x0000000100010001ull;
+                }
+            }
+        };
+
+        const tagUnpremultiplyTable&    unpremultiplyTable()
+        {
+            static const tagUnpremultiplyTable Table;
+            return Table;
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        /// scalar
+
+        void swapRedBlueScalar( uint8_t* pDst, const uint8_t* pSrc, int32_t Width )
+        {
+            for( int32_t x = 0; x < Width; ++x )
+            {
+                const uint32_t Pixel = loadPixel( pSrc + x * BYTES_PER_PIXEL );
+                storePixel( pDst + x * BYTES_PER_PIXEL, ( Pixel & 0xFF00FF00u ) | ( ( Pixel >> 16 ) & 0xFFu ) | ( ( Pixel & 0xFFu ) << 16 ) );
+            }
+        }
+
+        void premultiplyScalar( uint8_t* pDst, const uint8_t* pSrc, int32_t Width )
+        {
+            for( int32_t x = 0; x < Width; ++x )
+            {
+                const uint8_t* p = pSrc + x * BYTES_PER_PIXEL;
+                const uint32_t Alpha = p[ 3 ];
+                uint8_t Pixel[ 4 ] = { ( uint8_t )div255( p[ 0 ] * Alpha ), ( uint8_t )div255( p[ 1 ] * Alpha ), ( uint8_t )div255( p[ 2 ] * Alpha ), ( uint8_t )Alpha };
+                memcpy( pDst + x * BYTES_PER_PIXEL, Pixel, sizeof( Pixel ) );
+            }
+        }
+
+        inline uint32_t unpremultiplyPixel( uint32_t Pixel, const uint32_t* pReciprocal )
+        {
+            const uint32_t Alpha = Pixel >> 24;
+            if( Alpha == 0xFF )
+                return Pixel;
+
+            const uint32_t Scale = pReciprocal[ Alpha ];
+            uint32_t Result = Pixel & 0xFF000000u;
+            for( int c = 0; c < 3; ++c )
+            {
+                uint32_t Channel = ( ( ( Pixel >> ( c * 8 ) ) & 0xFFu ) * Scale + 0x8000u ) >> 16;
+                if( Channel > 255 )
+                    Channel = 255;
+                Result |= Channel << ( c * 8 );
+            }
+            return Result;
+        }
+
+        void unpremultiplyScalar( uint8_t* pDst, const uint8_t* pSrc, int32_t Width )
+        {
+            const uint32_t* pReciprocal = unpremultiplyTable().Reciprocal;
+            for( int32_t x = 0; x < Width; ++x )
+                storePixel( pDst + x * BYTES_PER_PIXEL, unpremultiplyPixel( loadPixel( pSrc + x * BYTES_PER_PIXEL ), pReciprocal ) );
+        }
+
+        void opaqueScalar( uint8_t* pDst, const uint8_t* pSrc, int32_t Width )
+        {
+            for( int32_t x = 0; x < Width; ++x )
+                storePixel( pDst + x * BYTES_PER_PIXEL, loadPixel( pSrc + x * BYTES_PER_PIXEL ) | 0xFF000000u );
+        }
+
+        void toRGB888Scalar( uint8_t* pDst, const uint8_t* pSrc, int32_t Width )
+        {
+            for( int32_t x = 0; x < Width; ++x )
+            {
+                const uint8_t* p = pSrc + x * BYTES_PER_PIXEL;
+                pDst[ x * 3 + 0 ] = p[ 2 ];
+                pDst[ x * 3 + 1 ] = p[ 1 ];
+                pDst[ x * 3 + 2 ] = p[ 0 ];
+            }
+        }
+
+        void toGray8Scalar( uint8_t* pDst, const uint8_t* pSrc, int32_t Width )
+        {
+            for( int32_t x = 0; x < Width; ++x )
+            {
+                const uint8_t* p = pSrc + x * BYTES_PER_PIXEL;
+                pDst[ x ] = ( uint8_t )( ( p[ 2 ] * LUMA_R + p[ 1 ] * LUMA_G + p[ 0 ] * LUMA_B + 128 ) >> 8 );
+            }
+        }
+
+#ifdef NSKERNEL_CONVERT_SSE2
+        ///////////////////////////////////////////////////////////////////////
+        /// SSE2
+
+        inline __m128i load4( const uint8_t* p )            { return _mm_loadu_si128( reinterpret_cast< const __m128i* >( p ) ); }
+        inline void store4( uint8_t* p, __m128i Pixels )    { _mm_storeu_si128( reinterpret_cast< __m128i* >( p ), Pixels ); }
+
+        void swapRedBlueSSE2( uint8_t* pDst, const uint8_t* pSrc, int32_t Width )
+        {
+            const __m128i MaskAG = _mm_set1_epi32( ( int32_t )0xFF00FF00u );
+            int32_t x = 0;
+            for( ; x + 4 <= Width; x += 4 )
+            {
+                const __m128i Pixels = load4( pSrc + x * BYTES_PER_PIXEL );
+                // B and R are the low bytes of the two 16 bit halves of every pixel, swap the halves
+                __m128i RB = _mm_andnot_si128( MaskAG, Pixels );
+                RB = _mm_shufflehi_epi16( _mm_shufflelo_epi16( RB, _MM_SHUFFLE( 2, 3, 0, 1 ) ), _MM_SHUFFLE( 2, 3, 0, 1 ) );
+                store4( pDst + x * BYTES_PER_PIXEL, _mm_or_si128( _mm_and_si128( Pixels, MaskAG ), RB ) );
+            }
+            swapRedBlueScalar( pDst + x * BYTES_PER_PIXEL, pSrc + x * BYTES_PER_PIXEL, Width - x );
+        }
+
+        // two pixels widened to 16 bit lanes, multiplied by their own alpha and divided by 255
+        inline __m128i premultiply2( __m128i Wide )
+        {
+            __m128i Alpha = _mm_shufflelo_epi16( Wide, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+            Alpha = _mm_shufflehi_epi16( Alpha, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+            __m128i X = _mm_add_epi16( _mm_mullo_epi16( Wide, Alpha ), _mm_set1_epi16( 128 ) );
+            return _mm_srli_epi16( _mm_add_epi16( X, _mm_srli_epi16( X, 8 ) ), 8 );
+        }
+
+        void premultiplySSE2( uint8_t* pDst, const uint8_t* pSrc, int32_t Width )
+        {
+            const __m128i Zero = _mm_setzero_si128();
+            const __m128i MaskA = _mm_set1_epi32( ( int32_t )0xFF000000u );
+            int32_t x = 0;
+            for( ; x + 4 <= Width; x += 4 )
+            {
+                const __m128i Pixels = load4( pSrc + x * BYTES_PER_PIXEL );
+                const __m128i Color = _mm_packus_epi16( premultiply2( _mm_unpacklo_epi8( Pixels, Zero ) ), premultiply2( _mm_unpackhi_epi8( Pixels, Zero ) ) );
+                // alpha * alpha / 255 is not alpha, the original byte goes back in
+                store4( pDst + x * BYTES_PER_PIXEL, _mm_or_si128( _mm_andnot_si128( MaskA, Color ), _mm_and_si128( Pixels, MaskA ) ) );
+            }
+            premultiplyScalar( pDst + x * BYTES_PER_PIXEL, pSrc + x * BYTES_PER_PIXEL, Width - x );
+        }
+
+        // reciprocal lanes of two pixels
+        inline __m128i loadLanes2( const uint64_t* pLanes, uint32_t Alpha0, uint32_t Alpha1 )
+        {
+            return _mm_unpacklo_epi64( _mm_loadl_epi64( reinterpret_cast< const __m128i* >( pLanes + Alpha0 ) ),
+                                       _mm_loadl_epi64( reinterpret_cast< const __m128i* >( pLanes + Alpha1 ) ) );
+        }
+
+        // two pixels widened to 16 bit lanes : min( 255, ( c * r + 0x8000 ) >> 16 ) with r = High * 65536 + Low,
+        // c * r + 0x8000 >> 16 = c * High + mulhi( c, Low ) + carry of the rounding bit, every term fits 16 bits
+        inline __m128i unpremultiply2( __m128i Wide, __m128i Low, __m128i High )
+        {
+            const __m128i Product = _mm_mullo_epi16( Wide, Low );
+            __m128i X = _mm_add_epi16( _mm_mullo_epi16( Wide, High ), _mm_mulhi_epu16( Wide, Low ) );
+            X = _mm_add_epi16( X, _mm_srli_epi16( Product, 15 ) );
+            // unsigned min with 255, packus alone would read results above 32767 as negative
+            return _mm_sub_epi16( X, _mm_subs_epu16( X, _mm_set1_epi16( 255 ) ) );
+        }
+
+        void unpremultiplySSE2( uint8_t* pDst, const uint8_t* pSrc, int32_t Width )
+        {
+            // desktop frames are opaque almost everywhere : four pixels at a time pass through or clear,
+            // groups with partial alpha multiply by their reciprocals in 16 bit lanes
+            const __m128i MaskA = _mm_set1_epi32( ( int32_t )0xFF000000u );
+            const __m128i Zero = _mm_setzero_si128();
+            const tagUnpremultiplyTable& Table = unpremultiplyTable();
+            int32_t x = 0;
+            for( ; x + 4 <= Width; x += 4 )
+            {
+                const uint8_t* p = pSrc + x * BYTES_PER_PIXEL;
+                const __m128i Pixels = load4( p );
+                const __m128i Alpha = _mm_and_si128( Pixels, MaskA );
+                if( _mm_movemask_epi8( _mm_cmpeq_epi32( Alpha, MaskA ) ) == 0xFFFF )
+                {
+                    store4( pDst + x * BYTES_PER_PIXEL, Pixels );
+                    continue;
+                }
+                if( _mm_movemask_epi8( _mm_cmpeq_epi32( Alpha, Zero ) ) == 0xFFFF )
+                {
+                    store4( pDst + x * BYTES_PER_PIXEL, Zero );
+                    continue;
+                }
+
+                const __m128i Lo = unpremultiply2( _mm_unpacklo_epi8( Pixels, Zero ),
+                                                   loadLanes2( Table.LanesLow, p[ 3 ], p[ 7 ] ), loadLanes2( Table.LanesHigh, p[ 3 ], p[ 7 ] ) );
+                const __m128i Hi = unpremultiply2( _mm_unpackhi_epi8( Pixels, Zero ),
+                                                   loadLanes2( Table.LanesLow, p[ 11 ], p[ 15 ] ), loadLanes2( Table.LanesHigh, p[ 11 ], p[ 15 ] ) );
+                // the alpha lanes multiplied by zero, the original byte goes back in
+                store4( pDst + x * BYTES_PER_PIXEL, _mm_or_si128( _mm_packus_epi16( Lo, Hi ), Alpha ) );
+            }
+            unpremultiplyScalar( pDst + x * BYTES_PER_PIXEL, pSrc + x * BYTES_PER_PIXEL, Width - x );
+        }
+
+        void opaqueSSE2( uint8_t* pDst, const uint8_t* pSrc, int32_t Width )
+        {
+            const __m128i MaskA = _mm_set1_epi32( ( int32_t )0xFF000000u );
+            int32_t x = 0;
+            for( ; x + 4 <= Width; x += 4 )
+                store4( pDst + x * BYTES_PER_PIXEL, _mm_or_si128( load4( pSrc + x * BYTES_PER_PIXEL ), MaskA ) );
+            opaqueScalar( pDst + x * BYTES_PER_PIXEL, pSrc + x * BYTES_PER_PIXEL, Width - x );
+        }
+
+        // luma of four pixels as 32 bit lanes
+        inline __m128i luma4( __m128i Pixels )
+        {
+            const __m128i Zero = _mm_setzero_si128();
+            const __m128i Weights = _mm_setr_epi16( LUMA_B, LUMA_G, LUMA_R, 0, LUMA_B, LUMA_G, LUMA_R, 0 );
+            // per pixel : ( b * 29 + g * 150, r * 77 ) in neighbouring lanes
+            const __m128i Lo = _mm_madd_epi16( _mm_unpacklo_epi8( Pixels, Zero ), Weights );
+            const __m128i Hi = _mm_madd_epi16( _mm_unpackhi_epi8( Pixels, Zero ), Weights );
+            const __m128i Even = _mm_castps_si128( _mm_shuffle_ps( _mm_castsi128_ps( Lo ), _mm_castsi128_ps( Hi ), _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+            const __m128i Odd = _mm_castps_si128( _mm_shuffle_ps( _mm_castsi128_ps( Lo ), _mm_castsi128_ps( Hi ), _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+            return _mm_srli_epi32( _mm_add_epi32( _mm_add_epi32( Even, Odd ), _mm_set1_epi32( 128 ) ), 8 );
+        }
+
+        void toGray8SSE2( uint8_t* pDst, const uint8_t* pSrc, int32_t Width )
+        {
+            int32_t x = 0;
+            for( ; x + 16 <= Width; x += 16 )
+            {
+                const uint8_t* p = pSrc + x * BYTES_PER_PIXEL;
+                const __m128i Words0 = _mm_packs_epi32( luma4( load4( p ) ), luma4( load4( p + 16 ) ) );
+                const __m128i Words1 = _mm_packs_epi32( luma4( load4( p + 32 ) ), luma4( load4( p + 48 ) ) );
+                _mm_storeu_si128( reinterpret_cast< __m128i* >( pDst + x ), _mm_packus_epi16( Words0, Words1 ) );
+            }
+            toGray8Scalar( pDst + x, pSrc + x * BYTES_PER_PIXEL, Width - x );
+        }
+#endif
+
+#ifdef NSKERNEL_CONVERT_SSSE3
+        ///////////////////////////////////////////////////////////////////////
+        /// SSSE3
+
+        NSKERNEL_TARGET_SSSE3 void swapRedBlueSSSE3( uint8_t* pDst, const uint8_t* pSrc, int32_t Width )
+        {
+            const __m128i Shuffle = _mm_setr_epi8( 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15 );
+            int32_t x = 0;
+            for( ; x + 4 <= Width; x += 4 )
+                store4( pDst + x * BYTES_PER_PIXEL, _mm_shuffle_epi8( load4( pSrc + x * BYTES_PER_PIXEL ), Shuffle ) );
+            swapRedBlueScalar( pDst + x * BYTES_PER_PIXEL, pSrc + x * BYTES_PER_PIXEL, Width - x );
+        }
+
+        NSKERNEL_TARGET_SSSE3 void toRGB888SSSE3( uint8_t* pDst, const uint8_t* pSrc, int32_t Width )
+        {
+            const __m128i Shuffle = _mm_setr_epi8( 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1 );
+            int32_t x = 0;
+            // 12 bytes per four pixels, stored 16 wide : the 4 spare bytes are overwritten by the next group,
+            // so the last full store must still end inside the row
+            for( ; x + 6 <= Width; x += 4 )
+                _mm_storeu_si128( reinterpret_cast< __m128i* >( pDst + x * 3 ), _mm_shuffle_epi8( load4( pSrc + x * BYTES_PER_PIXEL ), Shuffle ) );
+            toRGB888Scalar( pDst + x * 3, pSrc + x * BYTES_PER_PIXEL, Width - x );
+        }
+#endif
+
+        // struct tagRowTable_s : one converter per tagPixelConversion
+        typedef struct tagRowTable_s
+        {
+            PixelRowFn                  Rows[ tagPixelConversion_Count ];
+        } tagRowTable;
+
+        const tagRowTable SCALAR_ROWS = { { swapRedBlueScalar, premultiplyScalar, unpremultiplyScalar, opaqueScalar, toRGB888Scalar, toGray8Scalar } };
+#ifdef NSKERNEL_CONVERT_SSE2
+        const tagRowTable SSE2_ROWS = { { swapRedBlueSSE2, premultiplySSE2, unpremultiplySSE2, opaqueSSE2, toRGB888Scalar, toGray8SSE2 } };
+#endif
+#ifdef NSKERNEL_CONVERT_SSSE3
+        const tagRowTable SSSE3_ROWS = { { swapRedBlueSSSE3, premultiplySSE2, unpremultiplySSE2, opaqueSSE2, toRGB888SSSE3, toGray8SSE2 } };
+#endif
+
+        bool cpuHasSSSE3()
+        {
+#if defined( NSKERNEL_CONVERT_SSSE3 ) && defined( _MSC_VER )
+            int Registers[ 4 ] = {};
+            __cpuid( Registers, 1 );
+            return ( Registers[ 2 ] & ( 1 << 9 ) ) != 0;
+#elif defined( NSKERNEL_CONVERT_SSSE3 )
+            return __builtin_cpu_supports( "ssse3" ) != 0;
+#else
+            return false;
+#endif
+        }
+
+        // per pixel formulas, unpremultiply by exact division
+        void referencePixel( tagPixelConversion Conversion, uint8_t* pDst, const uint8_t* p )
+        {
+            switch( Conversion )
+            {
+                case tagPixelConversion_SwapRedBlue:
+                    pDst[ 0 ] = p[ 2 ]; pDst[ 1 ] = p[ 1 ]; pDst[ 2 ] = p[ 0 ]; pDst[ 3 ] = p[ 3 ];
+                    break;
+                case tagPixelConversion_Premultiply:
+                    for( int c = 0; c < 3; ++c )
+                        pDst[ c ] = ( uint8_t )( ( p[ c ] * p[ 3 ] + 127 ) / 255 );
+                    pDst[ 3 ] = p[ 3 ];
+                    break;
+                case tagPixelConversion_Unpremultiply:
+                {
+                    const uint32_t Alpha = p[ 3 ];
+                    for( int c = 0; c < 3; ++c )
+                    {
+                        const uint32_t Channel = Alpha == 0 ? 0 : ( p[ c ] * 255u + Alpha / 2 ) / Alpha;
+                        pDst[ c ] = ( uint8_t )( Channel > 255 ? 255 : Channel );
+                    }
+                    pDst[ 3 ] = ( uint8_t )Alpha;
+                } break;
+                case tagPixelConversion_Opaque:
+                    pDst[ 0 ] = p[ 0 ]; pDst[ 1 ] = p[ 1 ]; pDst[ 2 ] = p[ 2 ]; pDst[ 3 ] = 0xFF;
+                    break;
+                case tagPixelConversion_ToRGB888:
+                    pDst[ 0 ] = p[ 2 ]; pDst[ 1 ] = p[ 1 ]; pDst[ 2 ] = p[ 0 ];
+                    break;
+                case tagPixelConversion_ToGray8:
+                    pDst[ 0 ] = ( uint8_t )( ( p[ 2 ] * LUMA_R + p[ 1 ] * LUMA_G + p[ 0 ] * LUMA_B + 128 ) >> 8 );
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        bool isValidCall( tagPixelConversion Conversion, uint8_t* pDst, const uint8_t* pSrc, int32_t Width, int32_t Height )
+        {
+            return Conversion >= 0 && Conversion < tagPixelConversion_Count && pDst != nullptr && pSrc != nullptr && Width >= 0 && Height >= 0;
+        }
+    }
+
+    int32_t ConvertedPixelSize( tagPixelConversion Conversion )
+    {
+        switch( Conversion )
+        {
+            case tagPixelConversion_ToRGB888:   return 3;
+            case tagPixelConversion_ToGray8:    return 1;
+            default:                            return 4;
+        }
+    }
+
+    tagCpuLevel DetectCpuLevel()
+    {
+        static const tagCpuLevel Level = []()
+        {
+#ifdef NSKERNEL_CONVERT_SSE2
+            return cpuHasSSSE3() ? tagCpuLevel_SSSE3 : tagCpuLevel_SSE2;
+#else
+            return tagCpuLevel_Scalar;
+#endif
+        }();
+        return Level;
+    }
+
+    const char* CpuLevelName( tagCpuLevel Level )
+    {
+        switch( Level )
+        {
+            case tagCpuLevel_SSE2:      return "sse2";
+            case tagCpuLevel_SSSE3:     return "ssse3";
+            default:                    return "scalar";
+        }
+    }
+
+    PixelRowFn PixelRowConverter( tagPixelConversion Conversion, tagCpuLevel Level )
+    {
+        if( Conversion < 0 || Conversion >= tagPixelConversion_Count )
+            return nullptr;
+
+        if( Level > DetectCpuLevel() )
+            Level = DetectCpuLevel();
+
+        switch( Level )
+        {
+#ifdef NSKERNEL_CONVERT_SSSE3
+            case tagCpuLevel_SSSE3:     return SSSE3_ROWS.Rows[ Conversion ];
+#endif
+#ifdef NSKERNEL_CONVERT_SSE2
+            case tagCpuLevel_SSE2:      return SSE2_ROWS.Rows[ Conversion ];
+#endif
+            default:                    return SCALAR_ROWS.Rows[ Conversion ];
+        }
+    }
+
+    bool ConvertPixels( tagPixelConversion Conversion, uint8_t* pDst, ptrdiff_t DstPitch, const uint8_t* pSrc, ptrdiff_t SrcPitch, int32_t Width, int32_t Height )
+    {
+        if( !isValidCall( Conversion, pDst, pSrc, Width, Height ) )
+            return false;
+
+        const PixelRowFn Row = PixelRowConverter( Conversion, DetectCpuLevel() );
+        for( int32_t y = 0; y < Height; ++y )
+            Row( pDst + y * DstPitch, pSrc + y * SrcPitch, Width );
+
+        return true;
+    }
+
+    bool ConvertPixelsReference( tagPixelConversion Conversion, uint8_t* pDst, ptrdiff_t DstPitch, const uint8_t* pSrc, ptrdiff_t SrcPitch, int32_t Width, int32_t Height )
+    {
+        if( !isValidCall( Conversion, pDst, pSrc, Width, Height ) )
+            return false;
+
+        const int32_t DstSize = ConvertedPixelSize( Conversion );
+        for( int32_t y = 0; y < Height; ++y )
+        {
+            for( int32_t x = 0; x < Width; ++x )
+            {
+                uint8_t Pixel[ 4 ];
+                referencePixel( Conversion, Pixel, pSrc + y * SrcPitch + x * BYTES_PER_PIXEL );
+                memcpy( pDst + y * DstPitch + x * DstSize, Pixel, ( size_t )DstSize );
+            }
+        }
+
+        return true;
+    }
+
+} // nsKernel
@@ -0,0 +1,46 @@
+#ifndef PIXELCONVERT_HPP
+#define PIXELCONVERT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nsKernel
+{
+    // enum tagPixelConversion_e : 32bpp sources, byte order as in memory ( BGRA = QImage::Format_ARGB32 on little endian )
+    typedef enum tagPixelConversion_e
+    {
+        tagPixelConversion_SwapRedBlue  = 0,    // BGRA <-> RGBA, premultiplied or not
+        tagPixelConversion_Premultiply,         // straight -> premultiplied, either channel order
+        tagPixelConversion_Unpremultiply,       // premultiplied -> straight, alpha 0 -> all zero
+        tagPixelConversion_Opaque,              // alpha forced to 0xFF ( BGRX sources )
+        tagPixelConversion_ToRGB888,            // BGRA -> R G B bytes, alpha dropped as is
+        tagPixelConversion_ToGray8,             // BGRA -> BT.601 luma byte, alpha ignored
+        tagPixelConversion_Count
+    } tagPixelConversion;
+
+    // enum tagCpuLevel_e : instruction set tiers of the row converters
+    typedef enum tagCpuLevel_e
+    {
+        tagCpuLevel_Scalar  = 0,
+        tagCpuLevel_SSE2,
+        tagCpuLevel_SSSE3                       // byte shuffles ( swap, RGB888 ), the rest as SSE2
+    } tagCpuLevel;
+
+    typedef void ( *PixelRowFn )( uint8_t* pDst, const uint8_t* pSrc, int32_t Width );
+
+    // bytes per pixel written by Conversion
+    int32_t                             ConvertedPixelSize( tagPixelConversion Conversion );
+    // best tier of this build on this CPU, detected once
+    tagCpuLevel                         DetectCpuLevel();
+    const char*                         CpuLevelName( tagCpuLevel Level );
+    // row converter of Level, lowered to what the build and the CPU support
+    PixelRowFn                          PixelRowConverter( tagPixelConversion Conversion, tagCpuLevel Level );
+
+    // Width x Height with independent pitches at DetectCpuLevel(); the 32bpp conversions may run in place ( pDst == pSrc )
+    bool                                ConvertPixels( tagPixelConversion Conversion, uint8_t* pDst, ptrdiff_t DstPitch, const uint8_t* pSrc, ptrdiff_t SrcPitch, int32_t Width, int32_t Height );
+    // one pixel at a time with exact division, reference for verification
+    bool                                ConvertPixelsReference( tagPixelConversion Conversion, uint8_t* pDst, ptrdiff_t DstPitch, const uint8_t* pSrc, ptrdiff_t SrcPitch, int32_t Width, int32_t Height );
+
+} // nsKernel
+
+#endif //PIXELCONVERT_HPP
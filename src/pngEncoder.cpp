@@ -0,0 +1,727 @@
+#include "pngEncoder.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <zlib.h>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define NSKERNEL_PNG_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace nsKernel
+{
+    namespace
+    {
+        const uint8_t                   PNG_SIGNATURE[ 8 ]      = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+        // pigz uses 128 KB, rows are cut whole so blocks come out a bit larger
+        const size_t                    BLOCK_BYTES             = 256 * 1024;
+        // deflate window, the dictionary each block is primed with
+        const size_t                    WINDOW_BYTES            = 32 * 1024;
+        // zero bytes in front of every row buffer : the left neighbours of the first pixel, and room for unaligned loads
+        const size_t                    ROW_LEAD                = 16;
+        // finished blocks waiting for the writer, per worker
+        const size_t                    BLOCKS_AHEAD            = 2;
+
+        // enum tagPngFilter_e : PNG filter type byte
+        typedef enum tagPngFilter_e
+        {
+            tagPngFilter_None   = 0,
+            tagPngFilter_Sub,
+            tagPngFilter_Up,
+            tagPngFilter_Average,
+            tagPngFilter_Paeth,
+            tagPngFilter_Count
+        } tagPngFilter;
+
+        // filtered row into pDst, returns the sum of the bytes taken as signed magnitudes
+        typedef uint64_t ( *FilterRowFn )( tagPngFilter Filter, uint8_t* pDst, const uint8_t* pRow, const uint8_t* pPrior, size_t RowBytes, size_t Bpp );
+
+        inline void storeBigEndian( uint8_t* p, uint32_t Value )
+        {
+            p[ 0 ] = ( uint8_t )( Value >> 24 );
+            p[ 1 ] = ( uint8_t )( Value >> 16 );
+            p[ 2 ] = ( uint8_t )( Value >> 8 );
+            p[ 3 ] = ( uint8_t )Value;
+        }
+
+        inline uint8_t paethPredictor( int32_t a, int32_t b, int32_t c )
+        {
+            const int32_t pa = abs( b - c );
+            const int32_t pb = abs( a - c );
+            const int32_t pc = abs( a + b - 2 * c );
+            if( pa <= pb && pa <= pc )
+                return ( uint8_t )a;
+            return ( uint8_t )( pb <= pc ? b : c );
+        }
+
+        inline uint32_t signedMagnitude( uint8_t Value )
+        {
+            return Value < 128 ? Value : 256u - Value;
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        /// scalar
+
+        // bytes [ Begin, RowBytes ), pRow[ -Bpp ] and pPrior[ -Bpp ] are readable zeros at the row start
+        uint64_t filterTailScalar( tagPngFilter Filter, uint8_t* pDst, const uint8_t* pRow, const uint8_t* pPrior, size_t Begin, size_t RowBytes, size_t Bpp )
+        {
+            uint64_t Sum = 0;
+            for( size_t x = Begin; x < RowBytes; ++x )
+            {
+                const uint8_t a = pRow[ ( ptrdiff_t )x - ( ptrdiff_t )Bpp ];
+                const uint8_t b = pPrior[ x ];
+                const uint8_t c = pPrior[ ( ptrdiff_t )x - ( ptrdiff_t )Bpp ];
+
+                uint8_t Value = pRow[ x ];
+                switch( Filter )
+                {
+                    case tagPngFilter_Sub:      Value = ( uint8_t )( Value - a ); break;
+                    case tagPngFilter_Up:       Value = ( uint8_t )( Value - b ); break;
+                    case tagPngFilter_Average:  Value = ( uint8_t )( Value - ( ( a + b ) >> 1 ) ); break;
+                    case tagPngFilter_Paeth:    Value = ( uint8_t )( Value - paethPredictor( a, b, c ) ); break;
+                    default:                    break;
+                }
+
+                pDst[ x ] = Value;
+                Sum += signedMagnitude( Value );
+            }
+            return Sum;
+        }
+
+        uint64_t filterRowScalar( tagPngFilter Filter, uint8_t* pDst, const uint8_t* pRow, const uint8_t* pPrior, size_t RowBytes, size_t Bpp )
+        {
+            return filterTailScalar( Filter, pDst, pRow, pPrior, 0, RowBytes, Bpp );
+        }
+
+#ifdef NSKERNEL_PNG_SSE2
+        ///////////////////////////////////////////////////////////////////////
+        /// SSE2, 16 bytes per step, the tail through the scalar loop
+
+        inline __m128i absEpi16( __m128i Value )
+        {
+            return _mm_max_epi16( Value, _mm_sub_epi16( _mm_setzero_si128(), Value ) );
+        }
+
+        inline __m128i selectBytes( __m128i Mask, __m128i IfSet, __m128i IfClear )
+        {
+            return _mm_or_si128( _mm_and_si128( Mask, IfSet ), _mm_andnot_si128( Mask, IfClear ) );
+        }
+
+        // 8 predictors in 16 bit lanes, same tie order as paethPredictor
+        inline __m128i paethEpi16( __m128i a, __m128i b, __m128i c )
+        {
+            const __m128i pa = absEpi16( _mm_sub_epi16( b, c ) );
+            const __m128i pb = absEpi16( _mm_sub_epi16( a, c ) );
+            const __m128i pc = absEpi16( _mm_add_epi16( _mm_sub_epi16( b, c ), _mm_sub_epi16( a, c ) ) );
+            const __m128i Smallest = _mm_min_epi16( pa, _mm_min_epi16( pb, pc ) );
+
+            __m128i Predictor = selectBytes( _mm_cmpeq_epi16( pb, Smallest ), b, c );
+            return selectBytes( _mm_cmpeq_epi16( pa, Smallest ), a, Predictor );
+        }
+
+        uint64_t filterRowSSE2( tagPngFilter Filter, uint8_t* pDst, const uint8_t* pRow, const uint8_t* pPrior, size_t RowBytes, size_t Bpp )
+        {
+            const __m128i Zero = _mm_setzero_si128();
+            const __m128i One = _mm_set1_epi8( 1 );
+            __m128i Sum = _mm_setzero_si128();
+
+            size_t x = 0;
+            for( ; x + 16 <= RowBytes; x += 16 )
+            {
+                const __m128i Raw = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pRow + x ) );
+                const __m128i a = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pRow + x - Bpp ) );
+                const __m128i b = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pPrior + x ) );
+
+                __m128i Value = Raw;
+                switch( Filter )
+                {
+                    case tagPngFilter_Sub:
+                        Value = _mm_sub_epi8( Raw, a );
+                        break;
+                    case tagPngFilter_Up:
+                        Value = _mm_sub_epi8( Raw, b );
+                        break;
+                    case tagPngFilter_Average:
+                        // avg_epu8 rounds up, the filter floors
+                        Value = _mm_sub_epi8( Raw, _mm_sub_epi8( _mm_avg_epu8( a, b ), _mm_and_si128( _mm_xor_si128( a, b ), One ) ) );
+                        break;
+                    case tagPngFilter_Paeth:
+                    {
+                        const __m128i c = _mm_loadu_si128( reinterpret_cast< const __m128i* >( pPrior + x - Bpp ) );
+                        const __m128i Low = paethEpi16( _mm_unpacklo_epi8( a, Zero ), _mm_unpacklo_epi8( b, Zero ), _mm_unpacklo_epi8( c, Zero ) );
+                        const __m128i High = paethEpi16( _mm_unpackhi_epi8( a, Zero ), _mm_unpackhi_epi8( b, Zero ), _mm_unpackhi_epi8( c, Zero ) );
+                        Value = _mm_sub_epi8( Raw, _mm_packus_epi16( Low, High ) );
+                        break;
+                    }
+                    default:
+                        break;
+                }
+
+                _mm_storeu_si128( reinterpret_cast< __m128i* >( pDst + x ), Value );
+                // min( v, -v ) is the signed magnitude, 0x80 stays 128
+                Sum = _mm_add_epi64( Sum, _mm_sad_epu8( _mm_min_epu8( Value, _mm_sub_epi8( Zero, Value ) ), Zero ) );
+            }
+
+            uint64_t Lanes[ 2 ];
+            _mm_storeu_si128( reinterpret_cast< __m128i* >( Lanes ), Sum );
+            return Lanes[ 0 ] + Lanes[ 1 ] + filterTailScalar( Filter, pDst, pRow, pPrior, x, RowBytes, Bpp );
+        }
+#endif
+
+        // struct tagEncodeJob_s : shared, read only while the workers run
+        typedef struct tagEncodeJob_s
+        {
+            int32_t                     Width           = 0;
+            int32_t                     Height          = 0;
+            PixelRowFn                  Convert         = nullptr;
+            PixelRowFn                  ConvertSecond   = nullptr;  // in place after Convert, may be null
+            FilterRowFn                 FilterRow       = nullptr;
+            size_t                      Bpp             = 0;
+            size_t                      RowBytes        = 0;        // without the filter type byte
+            int32_t                     WindowRows      = 0;        // rows filtered again in front of a block for its dictionary
+            int32_t                     BlockRows       = 0;
+            size_t                      BlockCount      = 0;
+            int32_t                     Level           = 6;
+        } tagEncodeJob;
+
+        // struct tagBlockRows_s : 32bpp source rows of one block
+        typedef struct tagBlockRows_s
+        {
+            size_t                      Index           = 0;
+            int32_t                     Begin           = 0;
+            int32_t                     End             = 0;
+            const uint8_t*              Rows            = nullptr;  // row Begin, in the caller's strip or in Owned
+            ptrdiff_t                   Pitch           = 0;
+            std::vector< uint8_t >      Owned;                      // packed copy when the block spans strips
+            std::vector< uint8_t >      Context;                    // packed rows [ ContextBegin, Begin ) : window and its prior row
+            int32_t                     ContextBegin    = 0;
+        } tagBlockRows;
+
+        // struct tagEncodedBlock_s : one IDAT chunk ready to write
+        typedef struct tagEncodedBlock_s
+        {
+            std::vector< uint8_t >      Chunk;                      // length, type, data, crc
+            uint32_t                    Adler           = 1;        // of the filtered bytes of this block
+            size_t                      FilteredBytes   = 0;
+            bool                        IsReady         = false;
+            bool                        IsSuccess       = false;
+        } tagEncodedBlock;
+
+        const uint8_t* sourceRow( const tagBlockRows& Block, int32_t y, int32_t Width )
+        {
+            if( y >= Block.Begin )
+                return Block.Rows + Block.Pitch * ( y - Block.Begin );
+            return Block.Context.data() + ( size_t )( y - Block.ContextBegin ) * Width * 4;
+        }
+
+        // per worker state, reused from block to block
+        class CBlockEncoder
+        {
+        public:
+            explicit CBlockEncoder( const tagEncodeJob& Job )
+                : m_job( Job ), m_block( nullptr ), m_isStreamReady( false )
+            {
+                const size_t Stride = ROW_LEAD + Job.RowBytes + 16;
+                m_rows.assign( Stride * 2, 0 );
+                m_candidates.assign( ( Job.RowBytes + 16 ) * tagPngFilter_Count, 0 );
+                memset( &m_stream, 0, sizeof( m_stream ) );
+            }
+
+            ~CBlockEncoder()
+            {
+                if( m_isStreamReady )
+                    deflateEnd( &m_stream );
+            }
+
+            CBlockEncoder( const CBlockEncoder& ) = delete;
+            CBlockEncoder& operator=( const CBlockEncoder& ) = delete;
+
+            bool Encode( const tagBlockRows& Block, tagEncodedBlock* pBlock )
+            {
+                const bool IsLast = Block.Index + 1 == m_job.BlockCount;
+                m_block = &Block;
+
+                // the window before this block, filtered again here so that blocks do not wait on each other
+                filterRows( std::max( 0, Block.Begin - m_job.WindowRows ), Block.Begin, &m_window );
+                filterRows( Block.Begin, Block.End, &m_filtered );
+                m_block = nullptr;
+
+                if( m_isStreamReady == false )
+                {
+                    // raw deflate, Z_FILTERED as libpng does for filtered rows
+                    if( deflateInit2( &m_stream, m_job.Level, Z_DEFLATED, -15, 8, Z_FILTERED ) != Z_OK )
+                        return false;
+                    m_isStreamReady = true;
+                }
+                else if( deflateReset( &m_stream ) != Z_OK )
+                    return false;
+
+                if( m_window.empty() == false )
+                {
+                    const size_t Size = std::min( m_window.size(), WINDOW_BYTES );
+                    if( deflateSetDictionary( &m_stream, m_window.data() + m_window.size() - Size, ( uInt )Size ) != Z_OK )
+                        return false;
+                }
+
+                // chunk header, the zlib header in front of the first block, sync flush marker and crc at the end
+                const size_t Header = 8 + ( Block.Index == 0 ? 2 : 0 );
+                pBlock->Chunk.resize( Header + deflateBound( &m_stream, ( uLong )m_filtered.size() ) + 16 );
+                if( Block.Index == 0 )
+                {
+                    // CMF : deflate, 32 KB window; FLG : level hint, check bits
+                    const uint8_t Cmf = 0x78;
+                    uint8_t Flg = ( uint8_t )( ( m_job.Level < 2 ? 0 : m_job.Level < 6 ? 1 : m_job.Level == 6 ? 2 : 3 ) << 6 );
+                    Flg = ( uint8_t )( Flg + ( 31 - ( ( Cmf << 8 ) | Flg ) % 31 ) % 31 );
+                    pBlock->Chunk[ 8 ] = Cmf;
+                    pBlock->Chunk[ 9 ] = Flg;
+                }
+
+                m_stream.next_in = m_filtered.data();
+                m_stream.avail_in = ( uInt )m_filtered.size();
+                size_t Written = Header;
+                int Ret = Z_OK;
+                do
+                {
+                    if( Written + 16 > pBlock->Chunk.size() )
+                        pBlock->Chunk.resize( pBlock->Chunk.size() * 2 );
+
+                    m_stream.next_out = pBlock->Chunk.data() + Written;
+                    m_stream.avail_out = ( uInt )( pBlock->Chunk.size() - 4 - Written );
+                    Ret = deflate( &m_stream, IsLast ? Z_FINISH : Z_SYNC_FLUSH );
+                    if( Ret == Z_STREAM_ERROR )
+                        return false;
+                    Written = ( size_t )( m_stream.next_out - pBlock->Chunk.data() );
+
+                } while( IsLast ? Ret != Z_STREAM_END : ( m_stream.avail_in != 0 || m_stream.avail_out == 0 ) );
+
+                const size_t DataBytes = Written - 8;
+                pBlock->Chunk.resize( Written + 4 );
+                storeBigEndian( pBlock->Chunk.data(), ( uint32_t )DataBytes );
+                memcpy( pBlock->Chunk.data() + 4, "IDAT", 4 );
+                storeBigEndian( pBlock->Chunk.data() + Written, ( uint32_t )crc32( 0, pBlock->Chunk.data() + 4, ( uInt )( DataBytes + 4 ) ) );
+
+                pBlock->Adler = ( uint32_t )adler32( 1, m_filtered.data(), ( uInt )m_filtered.size() );
+                pBlock->FilteredBytes = m_filtered.size();
+                return true;
+            }
+
+        private:
+            uint8_t* rowAt( size_t Slot )
+            {
+                return m_rows.data() + ( ROW_LEAD + m_job.RowBytes + 16 ) * Slot + ROW_LEAD;
+            }
+
+            void convertRow( int32_t y, uint8_t* pRow )
+            {
+                const uint8_t* pSrc = sourceRow( *m_block, y, m_job.Width );
+                m_job.Convert( pRow, pSrc, m_job.Width );
+                if( m_job.ConvertSecond != nullptr )
+                    m_job.ConvertSecond( pRow, pRow, m_job.Width );
+            }
+
+            // filter type byte and filtered bytes of rows [ Begin, End ) into pOut
+            void filterRows( int32_t Begin, int32_t End, std::vector< uint8_t >* pOut )
+            {
+                pOut->resize( ( size_t )std::max( 0, End - Begin ) * ( m_job.RowBytes + 1 ) );
+                if( Begin >= End )
+                    return;
+
+                uint8_t* pPrior = rowAt( 0 );
+                uint8_t* pRow = rowAt( 1 );
+                if( Begin > 0 )
+                    convertRow( Begin - 1, pPrior );
+                else
+                    memset( pPrior, 0, m_job.RowBytes );
+
+                const size_t CandidateStride = m_job.RowBytes + 16;
+                uint8_t* pOutRow = pOut->data();
+                for( int32_t y = Begin; y < End; ++y )
+                {
+                    convertRow( y, pRow );
+
+                    // smallest sum wins, ties to the lower filter type
+                    size_t Best = 0;
+                    uint64_t BestSum = UINT64_MAX;
+                    for( size_t Filter = 0; Filter < tagPngFilter_Count; ++Filter )
+                    {
+                        const uint64_t Sum = m_job.FilterRow( ( tagPngFilter )Filter, m_candidates.data() + CandidateStride * Filter, pRow, pPrior, m_job.RowBytes, m_job.Bpp );
+                        if( Sum < BestSum )
+                        {
+                            Best = Filter;
+                            BestSum = Sum;
+                        }
+                    }
+
+                    pOutRow[ 0 ] = ( uint8_t )Best;
+                    memcpy( pOutRow + 1, m_candidates.data() + CandidateStride * Best, m_job.RowBytes );
+                    pOutRow += m_job.RowBytes + 1;
+
+                    std::swap( pPrior, pRow );
+                }
+            }
+
+            const tagEncodeJob&         m_job;
+            const tagBlockRows*         m_block;                    // during Encode
+            std::vector< uint8_t >      m_rows;                     // prior and current row, each behind ROW_LEAD zeros
+            std::vector< uint8_t >      m_candidates;               // one filtered row per filter type
+            std::vector< uint8_t >      m_window;
+            std::vector< uint8_t >      m_filtered;
+            z_stream                    m_stream;
+            bool                        m_isStreamReady;
+        };
+
+        bool writeChunk( const ImageWriteFn& Write, const char* Type, const uint8_t* pData, uint32_t Size )
+        {
+            std::vector< uint8_t > Chunk( 12 + ( size_t )Size );
+            storeBigEndian( Chunk.data(), Size );
+            memcpy( Chunk.data() + 4, Type, 4 );
+            if( Size > 0 )
+                memcpy( Chunk.data() + 8, pData, Size );
+            storeBigEndian( Chunk.data() + 8 + Size, ( uint32_t )crc32( 0, Chunk.data() + 4, Size + 4 ) );
+            return Write( Chunk.data(), Chunk.size() );
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// CPngStreamEncoder::CStream
+    ///
+    /// Rows are cut into blocks as they arrive. Blocks go to the workers in order, the calling thread writes the
+    /// finished ones in order and never runs more than Window blocks ahead of the writer.
+
+    class CPngStreamEncoder::CStream
+    {
+    public:
+        CStream( const tagEncodeJob& Job, int32_t Workers, ImageWriteFn Write )
+            : m_job( Job ), m_write( std::move( Write ) ), m_window( ( size_t )Workers * BLOCKS_AHEAD ), m_nextRow( 0 ), m_nextIndex( 0 ),
+              m_pendingRows( 0 ), m_contextBegin( 0 ), m_adler( 1 ), m_isHeaderWritten( false ), m_isFailed( false ), m_nextWrite( 0 ), m_isStopping( false )
+        {
+            if( Workers == 1 )
+            {
+                m_inline = std::make_unique< CBlockEncoder >( m_job );
+                return;
+            }
+
+            m_slots.resize( m_window );
+            for( int32_t w = 0; w < Workers; ++w )
+                m_pool.emplace_back( &CStream::workerProc, this );
+        }
+
+        ~CStream()
+        {
+            stopPool();
+        }
+
+        bool WriteRows( const tagSurface& Rows )
+        {
+            if( m_isFailed || Rows.Bits == nullptr || Rows.Width != m_job.Width || Rows.Height < 0 || Rows.Height > m_job.Height - m_nextRow )
+                return fail();
+
+            if( m_isHeaderWritten == false )
+            {
+                // signature and IHDR : 8 bit, colour type 2 ( RGB ) or 6 ( RGBA ), no interlace
+                uint8_t Header[ 13 ];
+                storeBigEndian( Header, ( uint32_t )m_job.Width );
+                storeBigEndian( Header + 4, ( uint32_t )m_job.Height );
+                Header[ 8 ]     = 8;
+                Header[ 9 ]     = m_job.Bpp == 3 ? 2 : 6;
+                Header[ 10 ]    = 0;
+                Header[ 11 ]    = 0;
+                Header[ 12 ]    = 0;
+
+                if( !m_write( PNG_SIGNATURE, sizeof( PNG_SIGNATURE ) ) || !writeChunk( m_write, "IHDR", Header, sizeof( Header ) ) )
+                    return fail();
+                m_isHeaderWritten = true;
+            }
+
+            const size_t SourceRowBytes = ( size_t )m_job.Width * 4;
+            size_t BorrowedEnd = 0;
+
+            for( int32_t y = 0; y < Rows.Height; )
+            {
+                const int32_t Begin = m_nextRow - m_pendingRows;
+                const int32_t End = std::min( m_job.Height, Begin + m_job.BlockRows );
+                const int32_t Needed = End - m_nextRow;
+                const int32_t Count = std::min( Needed, Rows.Height - y );
+
+                tagBlockRows Block;
+                if( m_pendingRows == 0 && Count == Needed )
+                {
+                    // the whole block is in this strip, read in place
+                    Block.Rows = Rows.Bits + Rows.Pitch * y;
+                    Block.Pitch = Rows.Pitch;
+                    BorrowedEnd = m_nextIndex + 1;
+                }
+                else
+                {
+                    m_pending.resize( ( size_t )m_job.BlockRows * SourceRowBytes );
+                    for( int32_t Row = 0; Row < Count; ++Row )
+                        memcpy( m_pending.data() + ( size_t )( m_pendingRows + Row ) * SourceRowBytes, Rows.Bits + Rows.Pitch * ( y + Row ), SourceRowBytes );
+                    m_pendingRows += Count;
+
+                    if( Count < Needed )
+                    {
+                        m_nextRow += Count;
+                        break;
+                    }
+
+                    Block.Owned.swap( m_pending );
+                    Block.Rows = Block.Owned.data();
+                    Block.Pitch = ( ptrdiff_t )SourceRowBytes;
+                    m_pendingRows = 0;
+                }
+
+                y += Count;
+                m_nextRow += Count;
+
+                Block.Index = m_nextIndex++;
+                Block.Begin = Begin;
+                Block.End = End;
+                Block.Context = m_context;
+                Block.ContextBegin = m_contextBegin;
+                advanceContext( Block );
+
+                if( submit( std::move( Block ) ) == false )
+                    return fail();
+            }
+
+            // the strip may be reused by the caller once this returns
+            if( writeBlocks( BorrowedEnd, true ) == false )
+                return fail();
+            return true;
+        }
+
+        bool Finish()
+        {
+            // the last block went out with its last row
+            if( m_isFailed || m_nextRow != m_job.Height || writeBlocks( m_nextIndex, true ) == false )
+                return fail();
+            stopPool();
+
+            // the zlib trailer in its own IDAT, then IEND
+            uint8_t Trailer[ 4 ];
+            storeBigEndian( Trailer, m_adler );
+            if( !writeChunk( m_write, "IDAT", Trailer, sizeof( Trailer ) ) || !writeChunk( m_write, "IEND", nullptr, 0 ) )
+                return fail();
+
+            // one shot
+            m_isFailed = true;
+            return true;
+        }
+
+    private:
+        // also waits for the workers, so no block refers to a caller's strip any more
+        bool fail()
+        {
+            m_isFailed = true;
+            stopPool();
+            return false;
+        }
+
+        // the rows a block after Block needs in front of it, copied because the strip they are in goes away
+        void advanceContext( const tagBlockRows& Block )
+        {
+            const int32_t Begin = std::max( 0, Block.End - m_job.WindowRows - 1 );
+            const size_t SourceRowBytes = ( size_t )m_job.Width * 4;
+
+            std::vector< uint8_t > Context( ( size_t )( Block.End - Begin ) * SourceRowBytes );
+            for( int32_t y = Begin; y < Block.End; ++y )
+                memcpy( Context.data() + ( size_t )( y - Begin ) * SourceRowBytes, sourceRow( Block, y, m_job.Width ), SourceRowBytes );
+
+            m_context.swap( Context );
+            m_contextBegin = Begin;
+        }
+
+        bool submit( tagBlockRows&& Block )
+        {
+            if( m_inline != nullptr )
+            {
+                m_nextWrite = Block.Index + 1;
+                return m_inline->Encode( Block, &m_written ) && writeBlock( m_written );
+            }
+
+            if( Block.Index >= m_window && writeBlocks( Block.Index - m_window + 1, true ) == false )
+                return false;
+
+            {
+                std::lock_guard< std::mutex > Guard( m_lock );
+                m_queue.push_back( std::move( Block ) );
+                m_changed.notify_all();
+            }
+
+            // whatever already finished goes out now
+            return writeBlocks( m_nextIndex, false );
+        }
+
+        // finished blocks in order up to End, waiting for them or stopping at the first unfinished one
+        bool writeBlocks( size_t End, bool IsWait )
+        {
+            while( m_nextWrite < End )
+            {
+                {
+                    std::unique_lock< std::mutex > Guard( m_lock );
+                    auto& Slot = m_slots[ m_nextWrite % m_window ];
+                    if( Slot.IsReady == false && IsWait == false )
+                        return true;
+
+                    m_changed.wait( Guard, [&]() { return Slot.IsReady; } );
+                    std::swap( Slot, m_written );
+                    Slot.IsReady = false;
+                    ++m_nextWrite;
+                }
+
+                if( m_written.IsSuccess == false || writeBlock( m_written ) == false )
+                    return false;
+            }
+            return true;
+        }
+
+        bool writeBlock( const tagEncodedBlock& Block )
+        {
+            m_adler = ( uint32_t )adler32_combine( m_adler, Block.Adler, ( z_off_t )Block.FilteredBytes );
+            return m_write( Block.Chunk.data(), Block.Chunk.size() );
+        }
+
+        void workerProc()
+        {
+            CBlockEncoder Encoder( m_job );
+            tagEncodedBlock Block;
+            for( ;; )
+            {
+                tagBlockRows Rows;
+                {
+                    std::unique_lock< std::mutex > Guard( m_lock );
+                    m_changed.wait( Guard, [&]() { return m_isStopping || m_queue.empty() == false; } );
+                    if( m_isStopping )
+                        return;
+                    Rows = std::move( m_queue.front() );
+                    m_queue.pop_front();
+                }
+
+                Block.IsSuccess = Encoder.Encode( Rows, &Block );
+
+                std::lock_guard< std::mutex > Guard( m_lock );
+                std::swap( m_slots[ Rows.Index % m_window ], Block );
+                m_slots[ Rows.Index % m_window ].IsReady = true;
+                m_changed.notify_all();
+            }
+        }
+
+        void stopPool()
+        {
+            {
+                std::lock_guard< std::mutex > Guard( m_lock );
+                m_isStopping = true;
+                m_queue.clear();
+                m_changed.notify_all();
+            }
+
+            for( auto& Thread : m_pool )
+                Thread.join();
+            m_pool.clear();
+        }
+
+        const tagEncodeJob              m_job;
+        const ImageWriteFn              m_write;
+        const size_t                    m_window;
+
+        int32_t                         m_nextRow;                  // rows received
+        size_t                          m_nextIndex;                // blocks submitted
+        std::vector< uint8_t >          m_pending;                  // rows of a block spanning strips
+        int32_t                         m_pendingRows;
+        std::vector< uint8_t >          m_context;
+        int32_t                         m_contextBegin;
+        uint32_t                        m_adler;
+        bool                            m_isHeaderWritten;
+        bool                            m_isFailed;
+
+        std::unique_ptr< CBlockEncoder > m_inline;                  // single worker : encoded on the calling thread
+        tagEncodedBlock                 m_written;
+
+        std::mutex                      m_lock;
+        std::condition_variable         m_changed;
+        std::deque< tagBlockRows >      m_queue;
+        std::vector< tagEncodedBlock >  m_slots;                    // Window finished blocks, by Index % Window
+        size_t                          m_nextWrite;
+        bool                            m_isStopping;
+        std::vector< std::thread >      m_pool;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// CPngStreamEncoder
+
+    CPngStreamEncoder::CPngStreamEncoder( int32_t Width, int32_t Height, tagPixelSource Source, const tagPngOptions& Options, ImageWriteFn Write )
+    {
+        if( Width <= 0 || Height <= 0 || Source >= tagPixelSource_Count || !Write )
+            return;
+
+        tagEncodeJob Job;
+        Job.Width   = Width;
+        Job.Height  = Height;
+        Job.Level   = std::max( 0, std::min( Options.Level, 9 ) );
+        Job.Bpp     = Source == tagPixelSource_BGRX ? 3 : 4;
+        Job.RowBytes = ( size_t )Width * Job.Bpp;
+        Job.WindowRows = ( int32_t )( ( WINDOW_BYTES + Job.RowBytes ) / ( Job.RowBytes + 1 ) );
+
+        const tagCpuLevel CpuLevel = std::min( Options.CpuLevel, DetectCpuLevel() );
+        switch( Source )
+        {
+            case tagPixelSource_BGRX:
+                Job.Convert = PixelRowConverter( tagPixelConversion_ToRGB888, CpuLevel );
+                break;
+            case tagPixelSource_BGRA:
+                Job.Convert = PixelRowConverter( tagPixelConversion_SwapRedBlue, CpuLevel );
+                break;
+            default:
+                Job.Convert = PixelRowConverter( tagPixelConversion_Unpremultiply, CpuLevel );
+                Job.ConvertSecond = PixelRowConverter( tagPixelConversion_SwapRedBlue, CpuLevel );
+                break;
+        }
+
+        Job.FilterRow = filterRowScalar;
+#ifdef NSKERNEL_PNG_SSE2
+        if( CpuLevel >= tagCpuLevel_SSE2 )
+            Job.FilterRow = filterRowSSE2;
+#endif
+
+        Job.BlockRows = Options.BlockRows > 0 ? Options.BlockRows : ( int32_t )std::max< size_t >( 1, BLOCK_BYTES / ( Job.RowBytes + 1 ) );
+        Job.BlockRows = std::min( Job.BlockRows, Height );
+        Job.BlockCount = ( size_t )( ( Height + Job.BlockRows - 1 ) / Job.BlockRows );
+
+        int32_t Workers = ( int32_t )( Options.Threads != 0 ? Options.Threads : std::thread::hardware_concurrency() );
+        Workers = std::max( 1, std::min( Workers, ( int32_t )Job.BlockCount ) );
+
+        m_stream = std::make_unique< CStream >( Job, Workers, std::move( Write ) );
+    }
+
+    CPngStreamEncoder::~CPngStreamEncoder() = default;
+
+    bool CPngStreamEncoder::WriteRows( const tagSurface& Rows )
+    {
+        return m_stream != nullptr && m_stream->WriteRows( Rows );
+    }
+
+    bool CPngStreamEncoder::Finish()
+    {
+        return m_stream != nullptr && m_stream->Finish();
+    }
+
+    bool EncodePng( const tagSurface& Src, tagPixelSource Source, const tagPngOptions& Options, const ImageWriteFn& Write )
+    {
+        if( Src.Bits == nullptr )
+            return false;
+
+        CPngStreamEncoder Encoder( Src.Width, Src.Height, Source, Options, Write );
+        return Encoder.WriteRows( Src ) && Encoder.Finish();
+    }
+
+} // nsKernel
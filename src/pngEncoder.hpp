@@ -0,0 +1,47 @@
+#ifndef PNGENCODER_HPP
+#define PNGENCODER_HPP
+
+#include "imageCodec.hpp"
+
+#include <memory>
+
+namespace nsKernel
+{
+    // struct tagPngOptions_s
+    typedef struct tagPngOptions_s
+    {
+        int32_t                         Level           = 6;    // zlib level, 0 ( stored ) ~ 9
+        uint32_t                        Threads         = 0;    // deflate workers, 0 = hardware concurrency
+        int32_t                         BlockRows       = 0;    // rows per deflate block, 0 = about 256 KB of filtered rows
+        tagCpuLevel                     CpuLevel        = tagCpuLevel_SSSE3;    // filter selection, lowered to DetectCpuLevel()
+    } tagPngOptions;
+
+    // 8 bit non-interlaced PNG of Src, RGB for BGRX and straight RGBA for the alpha sources.
+    // One zlib stream split into row blocks that are filtered and deflated in parallel :
+    // every block is a raw deflate primed with the 32 KB before it and ended by a sync flush ( the last one finishes ),
+    // so the concatenation is a single stream and a decoder sees no seams; Adler-32 is combined from the blocks.
+    // Per-row filter is the minimum sum of absolute differences ( libpng heuristic ), SSE2 where available.
+    // The output depends on Level and BlockRows only, not on Threads or CpuLevel
+    bool                                EncodePng( const tagSurface& Src, tagPixelSource Source, const tagPngOptions& Options, const ImageWriteFn& Write );
+
+    // EncodePng fed strip by strip : a block is deflated as soon as its last row arrived, finished blocks are written
+    // in order from the calling thread ( WriteRows, Finish ) and at most 2 per worker are held. A block lying whole
+    // in one strip is read in place ( WriteRows returns once it is encoded ), the rows of the others are copied.
+    // Same output as EncodePng whatever the strip heights
+    class CPngStreamEncoder : public CImageStreamEncoder
+    {
+    public:
+        CPngStreamEncoder( int32_t Width, int32_t Height, tagPixelSource Source, const tagPngOptions& Options, ImageWriteFn Write );
+        ~CPngStreamEncoder() override;
+
+        bool                            WriteRows( const tagSurface& Rows ) override;
+        bool                            Finish() override;
+
+    private:
+        class CStream;
+        std::unique_ptr< CStream >      m_stream;
+    };
+
+} // nsKernel
+
+#endif //PNGENCODER_HPP
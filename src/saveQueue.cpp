@@ -0,0 +1,151 @@
+#include "saveQueue.hpp"
+
+#include "captureTrace.hpp"
+#include "imageFile.hpp"
+
+namespace
+{
+    const qint64 PROGRESS_STEP_BYTES = 1 << 20;
+
+    // 인코더 출력을 대상 장치로 전달하며 기록한 바이트 수를 보고
+    class CProgressDevice : public QIODevice
+    {
+    public:
+        CProgressDevice( QIODevice* Target, std::function< void( qint64 ) > Progress )
+            : target( Target ), progress( std::move( Progress ) ), written( 0 ), reported( 0 )
+        {
+        }
+
+        bool isSequential() const override { return true; }
+
+    protected:
+        qint64 readData( char* Data, qint64 MaxSize ) override
+        {
+            Q_UNUSED( Data );
+            Q_UNUSED( MaxSize );
+            return -1;
+        }
+
+        qint64 writeData( const char* Data, qint64 Size ) override
+        {
+            const qint64 Ret = target->write( Data, Size );
+            if( Ret < 0 )
+            {
+                setErrorString( target->errorString() );
+                return Ret;
+            }
+
+            written += Ret;
+            if( written - reported >= PROGRESS_STEP_BYTES )
+            {
+                reported = written;
+                progress( written );
+            }
+            return Ret;
+        }
+
+    private:
+        QIODevice*                      target;
+        std::function< void( qint64 ) > progress;
+        qint64                          written;
+        qint64                          reported;
+    };
+}
+
+QSaveQueue::QSaveQueue( int MaxInFlight, QObject* Parent )
+    : QObject( Parent ), maxInFlight( qMax( 1, MaxInFlight ) ), inFlight( 0 ), nextJobId( 1 )
+{
+    // 인코딩은 CPU 를 많이 사용하므로 GUI 와 캡처에 여유를 남김
+    pool.setMaxThreadCount( qBound( 1, QThread::idealThreadCount() / 2, maxInFlight ) );
+}
+
+QSaveQueue::~QSaveQueue()
+{
+    // 진행 중인 저장은 완료, 이후의 완료 통지는 객체와 함께 버려짐
+    WaitForDone();
+}
+
+quint64 QSaveQueue::Enqueue( const QString& FilePath, const QImage& Image, const QByteArray& Format, int Quality )
+{
+    if( Image.isNull() || FilePath.isEmpty() )
+        return 0;
+
+    int Current = inFlight.load();
+    do
+    {
+        if( Current >= maxInFlight )
+            return 0;
+    } while( inFlight.compare_exchange_weak( Current, Current + 1 ) == false );
+
+    tagSaveJob Job;
+    Job.JobId       = nextJobId.fetch_add( 1 );
+    Job.FilePath    = FilePath;
+    Job.Image       = Image;
+    Job.Format      = Format.isEmpty() ? QFileInfo( FilePath ).suffix().toLower().toLatin1() : Format;
+    Job.Quality     = Quality;
+    if( Job.Format.isEmpty() )
+        Job.Format = "png";
+
+    pool.start( [this, Job]() { runJob( Job ); } );
+    return Job.JobId;
+}
+
+int QSaveQueue::InFlight() const
+{
+    return inFlight.load();
+}
+
+void QSaveQueue::WaitForDone()
+{
+    pool.waitForDone();
+}
+
+void QSaveQueue::runJob( const tagSaveJob& Job )
+{
+    bool IsSuccess = false;
+    QImageWriter::ImageWriterError Error = QImageWriter::UnknownError;
+    QString ErrorText;
+
+    do
+    {
+        QSaveFile File( Job.FilePath );
+        if( File.open( QIODevice::WriteOnly ) == false )
+        {
+            Error = QImageWriter::DeviceError;
+            ErrorText = File.errorString();
+            break;
+        }
+
+        CProgressDevice Device( &File, [this, &Job]( qint64 BytesWritten ) {
+            QMetaObject::invokeMethod( this, [this, JobId = Job.JobId, FilePath = Job.FilePath, BytesWritten]() {
+                Q_EMIT sigProgress( JobId, FilePath, BytesWritten );
+            }, Qt::QueuedConnection );
+        } );
+        Device.open( QIODevice::WriteOnly );
+
+        nsCapture::CTraceSpan EncodeSpan( nsCapture::tagTraceStage_Encode );
+        if( nsCapture::WriteImage( &Device, Job.Image, Job.Format, Job.Quality, &Error, &ErrorText ) == false )
+        {
+            File.cancelWriting();
+            break;
+        }
+        EncodeSpan.End();
+
+        // 임시 파일을 대상 이름으로 교체, 실패 시 기존 파일은 그대로
+        if( File.commit() == false )
+        {
+            Error = QImageWriter::DeviceError;
+            ErrorText = File.errorString();
+            break;
+        }
+
+        IsSuccess = true;
+
+    } while( false );
+
+    inFlight.fetch_sub( 1 );
+
+    QMetaObject::invokeMethod( this, [this, JobId = Job.JobId, FilePath = Job.FilePath, IsSuccess, Error, ErrorText]() {
+        Q_EMIT sigFinished( JobId, FilePath, IsSuccess, Error, ErrorText );
+    }, Qt::QueuedConnection );
+}
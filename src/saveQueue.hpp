@@ -0,0 +1,49 @@
+#ifndef SAVEQUEUE_HPP
+#define SAVEQUEUE_HPP
+
+#include <QtCore>
+#include <QtGui>
+
+#include <atomic>
+
+// 이미지 저장 대기열 : 작업 스레드에서 인코딩하고 QSaveFile 로 원자적 저장 ( 임시 파일 -> 이름 변경 )
+// 인코딩은 nsCapture::WriteImage : qoi / raw 와 ( zlib 이 있으면 ) png 는 커널, 그 외 형식은 QImageWriter
+// 동시에 대기 / 진행 중인 작업 수는 MaxInFlight 로 제한, 시그널은 모두 이 객체의 스레드( GUI ) 에서 발생
+class QSaveQueue : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QSaveQueue( int MaxInFlight = 4, QObject* Parent = nullptr );
+    ~QSaveQueue() override;
+
+    // Image 는 암시적 공유로 전달되어 복사되지 않음, Format 이 비어 있으면 확장자 ( 없으면 png )
+    // 대기열이 가득 찬 경우 0
+    quint64                             Enqueue( const QString& FilePath, const QImage& Image, const QByteArray& Format = QByteArray(), int Quality = -1 );
+    int                                 InFlight() const;
+    void                                WaitForDone();
+
+Q_SIGNALS:
+    // 인코더가 기록한 바이트 수, 약 1MB 단위
+    void                                sigProgress( quint64 JobId, const QString& FilePath, qint64 BytesWritten );
+    void                                sigFinished( quint64 JobId, const QString& FilePath, bool IsSuccess, QImageWriter::ImageWriterError Error, const QString& ErrorText );
+
+private:
+    // struct tagSaveJob_s
+    typedef struct tagSaveJob_s
+    {
+        quint64                         JobId           = 0;
+        QString                         FilePath;
+        QImage                          Image;
+        QByteArray                      Format;
+        int                             Quality         = -1;
+    } tagSaveJob;
+
+    void                                runJob( const tagSaveJob& Job );
+
+    QThreadPool                         pool;
+    const int                           maxInFlight;
+    std::atomic< int >                  inFlight;
+    std::atomic< quint64 >              nextJobId;
+};
+
+#endif //SAVEQUEUE_HPP
@@ -1,17 +1,126 @@
 #include "snippingTool.hpp"
-#include "dxgiMgr.hpp"
+#include "clipboardImage.hpp"
+#include "imageFile.hpp"
+
+#ifdef Q_OS_WIN
+#include <Windows.h>
+#include <dwmapi.h>
+#pragma comment( lib, "dwmapi.lib" )
+#endif
+
+namespace
+{
+    const char* const LAST_REGION_KEY = "Capture/LastRegion";
+    // 창 숨김 확인 이벤트가 오지 않을 때의 대기 시간
+    const int HIDE_FALLBACK_MS = 500;
+    // 비동기 캡처 전체 제한 시간, 모니터별 프레임 대기( TimeoutMs ) 와 별도
+    const int CAPTURE_DEADLINE_MS = 5000;
+    // 창 크기 조절 중에는 빠른 근사 미리보기, 마지막 크기 변경 후 이 시간이 지나면 부드러운 미리보기
+    const int PREVIEW_SMOOTH_DELAY_MS = 80;
+    // 창 모드에서 마지막 캡처 후 캡처 세션( DXGI duplication, 미러 텍스처, 프레임 캐시 ) 을 해제하기까지의 시간
+    // 상주 모드는 Resident/IdleReleaseSec 설정을 사용
+    const int WINDOWED_IDLE_RELEASE_MS = 30 * 1000;
+    // 이 시간 안에 끝나는 캡처는 Esc 를 전역 단축키로 가로채지 않음 ( 대부분의 캡처는 수십 ms )
+    const int CANCEL_HOTKEY_GRACE_MS = 300;
+
+    // SNIPPINGTOOL_TRACE 가 설정된 경우에만 캡처 서비스 통계와 단계별 지연 시간 분포 출력
+    void logCaptureStats( const nsCapture::CCaptureService* Service )
+    {
+        if( nsCapture::CCaptureTrace::IsEnabled() == false )
+            return;
+
+        qDebug() << "[CAPTURE]" << Service->BackendName() << Service->FormatStats();
+        qDebug().noquote() << "[TRACE]\n" + nsCapture::CCaptureTrace::Instance().FormatStats();
+    }
+
+    // 저장 대화 상자의 형식 필터 : 저장 가능한 형식( SupportedImageFormats ) 중 설명이 있는 형식을 먼저, 나머지는 이름순
+    QString saveFileFilter()
+    {
+        const auto Formats = nsCapture::SupportedImageFormats();
+        const std::pair< QByteArray, const char* > Described[] = {
+            { "png", QT_TRANSLATE_NOOP( "QSnippingTool", "PNG 파일" ) },
+            { "jpg", QT_TRANSLATE_NOOP( "QSnippingTool", "JPEG 파일" ) },
+            { "qoi", QT_TRANSLATE_NOOP( "QSnippingTool", "QOI 파일 - 빠른 무손실" ) },
+            { "raw", QT_TRANSLATE_NOOP( "QSnippingTool", "RAW 파일 - 비압축" ) },
+        };
+
+        QStringList Filters;
+        QSet< QByteArray > Listed;
+        for( const auto& Item : Described )
+        {
+            if( Formats.contains( Item.first ) == false )
+                continue;
+
+            QString Patterns = QStringLiteral( "*." ) + QString::fromLatin1( Item.first );
+            Listed.insert( Item.first );
+
+            // jpeg 는 jpg 와 같은 형식
+            if( Item.first == "jpg" && Formats.contains( "jpeg" ) )
+            {
+                Patterns += QStringLiteral( " *.jpeg" );
+                Listed.insert( "jpeg" );
+            }
+
+            Filters.push_back( QStringLiteral( "%1 (%2)" ).arg( QCoreApplication::translate( "QSnippingTool", Item.second ), Patterns ) );
+        }
+
+        for( const auto& Format : Formats )
+        {
+            if( Listed.contains( Format ) )
+                continue;
+
+            const QString Name = QString::fromLatin1( Format );
+            Filters.push_back( QCoreApplication::translate( "QSnippingTool", "%1 파일 (*.%2)" ).arg( Name.toUpper(), Name ) );
+        }
+
+        Filters.push_back( QCoreApplication::translate( "QSnippingTool", "모든 파일 (*.*)" ) );
+        return Filters.join( QStringLiteral( ";;" ) );
+    }
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 ///
 ///
 
-QSnippingWidget::QSnippingWidget( QPixmap Scr )
-    : screenShot_( Scr ), isSelecting_( false )
+QSnippingWidget::QSnippingWidget( QWidget* Parent )
+    : QWidget( Parent ), isSelecting_( false ), isPresentPending_( false ), dwAffinity_( 0 ), repaintPixels_( 0 )
 {
     setCursor( Qt::CrossCursor );
     setWindowFlags( Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint );
+}
+
+void QSnippingWidget::Activate( const QPixmap& Scr )
+{
+    screenShot_ = Scr;
+    selectedRegion_ = QPixmap();
+    selectedRect_ = QRect();
+    isSelecting_ = false;
+    isPresentPending_ = true;
+    repaintLatency_ = nsCapture::tagLatencyStats();
+    repaintPixels_ = 0;
+
+    // 어두운 배경은 캡처마다 한 번만 합성, 이후 paintEvent 는 다시 그릴 영역만 복사
+    dimmedShot_ = Scr.copy();
+    {
+        QPainter Dimmer( &dimmedShot_ );
+        Dimmer.fillRect( dimmedShot_.rect(), QColor( 0, 0, 0, 120 ) );
+    }
+
+    setCursor( Qt::CrossCursor );
     showFullScreen();
     setWindowState( Qt::WindowFullScreen );
+    raise();
+    activateWindow();
+}
+
+void QSnippingWidget::Deactivate()
+{
+    hide();
+    isSelecting_ = false;
+    isPresentPending_ = false;
+    screenShot_ = QPixmap();
+    dimmedShot_ = QPixmap();
+    selectedRegion_ = QPixmap();
 }
 
 QPixmap QSnippingWidget::SelectedRegion()
@@ -19,6 +128,11 @@ QPixmap QSnippingWidget::SelectedRegion()
     return selectedRegion_;
 }
 
+QRect QSnippingWidget::SelectedRect() const
+{
+    return selectedRect_;
+}
+
 void QSnippingWidget::SetDisplayAffinity( quint32 dwAffinity )
 {
     dwAffinity_ = dwAffinity;
@@ -29,36 +143,53 @@ void QSnippingWidget::paintEvent( QPaintEvent* event )
 {
     ::SetWindowDisplayAffinity( (HWND)winId(), dwAffinity_ );
 
+    const auto Begin = std::chrono::steady_clock::now();
+    const qreal Dpr = devicePixelRatio();
+
     QPainter painter( this );
-    painter.save();
-    painter.scale( 1.0 / devicePixelRatio(), 1.0 / devicePixelRatio() );
-    painter.drawPixmap( 0, 0, screenShot_ );
-    painter.restore();
+    painter.scale( 1.0 / Dpr, 1.0 / Dpr );
+
+    // 다시 그릴 영역만 복사, 페인터는 이미 event->region() 으로 잘려 있음
+    QVector< QRect > vecDirty;
+    for( const QRect& Dirty : event->region() )
+        vecDirty.push_back( QRectF( QPointF( Dirty.topLeft() ) * Dpr, QSizeF( Dirty.size() ) * Dpr ).toAlignedRect() );
 
-    QColor overlayColor( 0, 0, 0, 120 );
-    painter.fillRect( QRect( 0, 0, width(), height() ), overlayColor );
+    for( const QRect& Rect : vecDirty )
+    {
+        if( dimmedShot_.rect().contains( Rect ) == false )
+            painter.fillRect( Rect, QColor( 0, 0, 0, 120 ) );
+        painter.drawPixmap( Rect, dimmedShot_, Rect );
+    }
 
-    // 선택 영역 표시
+    // 선택 영역 표시, 안쪽은 원래 밝기로 덮어 테두리는 바깥쪽만 남음
     if( isSelecting_ )
     {
-        QRect rect( startPos_ * devicePixelRatio(), endPos_ * devicePixelRatio() );
+        const QRect Selection = selectionRect();
 
-        if( endPos_.x() < startPos_.x() ||
-            endPos_.y() < startPos_.y() )
+        painter.setPen( QPen( Qt::red, 2 ) );
+        painter.drawRect( Selection );
+
+        for( const QRect& Rect : vecDirty )
         {
-            rect = QRect( endPos_ * devicePixelRatio(), startPos_ * devicePixelRatio() );
+            const QRect Bright = Rect.intersected( Selection );
+            if( Bright.isEmpty() == false )
+                painter.drawPixmap( Bright, screenShot_, Bright );
         }
 
-        painter.scale( 1.0 / devicePixelRatio(), 1.0 / devicePixelRatio() );
+        const auto End = std::chrono::steady_clock::now();
+        const auto Us = std::chrono::duration_cast< std::chrono::microseconds >( End - Begin ).count();
+        repaintLatency_.Add( ( quint64 )qMax< qint64 >( 0, Us ) );
+        for( const QRect& Dirty : event->region() )
+            repaintPixels_ += qint64( Dirty.width() ) * Dirty.height();
 
-        painter.setPen( QPen( Qt::red, 2 ) );
-        painter.drawRect( rect );
+        if( nsCapture::CCaptureTrace::IsEnabled() )
+            nsCapture::CCaptureTrace::Instance().Record( nsCapture::tagTraceStage_OverlayRepaint, Begin, End );
+    }
 
-        // 선택 영역만 원래 밝기로 표시
-        painter.setCompositionMode( QPainter::CompositionMode_Clear );
-        painter.fillRect( rect, Qt::transparent );
-        painter.setCompositionMode( QPainter::CompositionMode_SourceOver );
-        painter.drawPixmap( rect, screenShot_, rect );
+    if( isPresentPending_ )
+    {
+        isPresentPending_ = false;
+        Q_EMIT sigPresented();
     }
 }
 
@@ -81,7 +212,7 @@ void QSnippingWidget::mousePressEvent( QMouseEvent* event )
         isSelecting_ = true;
         startPos_ = event->pos();
         endPos_ = startPos_;
-        update();
+        update( selectionDirtyRect() );
     }
 }
 
@@ -89,8 +220,10 @@ void QSnippingWidget::mouseMoveEvent( QMouseEvent* event )
 {
     if( isSelecting_ )
     {
+        // 전체 화면 대신 이전 / 새 선택 영역과 테두리만 다시 그림
+        const QRect Before = selectionDirtyRect();
         endPos_ = event->pos();
-        update();
+        update( QRegion( Before ) + selectionDirtyRect() );
     }
 }
 
@@ -102,30 +235,56 @@ void QSnippingWidget::mouseReleaseEvent( QMouseEvent* event )
 
         endPos_ = event->pos();
         isSelecting_ = false;
+        logRepaintStats();
 
-        QRect rect = QRect( startPos_ * devicePixelRatio(), endPos_ * devicePixelRatio() ).normalized();
-
-        if( endPos_.x() < startPos_.x() ||
-            endPos_.y() < startPos_.y() )
-        {
-            rect = QRect( endPos_ * devicePixelRatio(), startPos_ * devicePixelRatio() );
-        }
-
+        const QRect rect = selectionRect();
         if( rect.width() > 0 && rect.height() > 0 )
         {
-            selectedRegion_ = screenShot_.copy( rect );
+            selectedRect_ = rect.intersected( screenShot_.rect() );
+            selectedRegion_ = screenShot_.copy( selectedRect_ );
             emit sigRegionSelected();
             close();
         }
     }
 }
 
+QRect QSnippingWidget::selectionRect() const
+{
+    return QRect( startPos_ * devicePixelRatio(), endPos_ * devicePixelRatio() ).normalized();
+}
+
+QRect QSnippingWidget::selectionDirtyRect() const
+{
+    // 테두리( 2 물리 픽셀 ) 가 선택 영역 바깥으로 1 픽셀 걸치므로, 논리 좌표로 바꾼 뒤 여유를 둠
+    const qreal Dpr = devicePixelRatio();
+    const QRect Rect = selectionRect();
+    const QRect Logical = QRectF( QPointF( Rect.topLeft() ) / Dpr, QSizeF( Rect.size() ) / Dpr ).toAlignedRect();
+    return Logical.adjusted( -2, -2, 2, 2 );
+}
+
+void QSnippingWidget::logRepaintStats()
+{
+    if( repaintLatency_.Count == 0 )
+        return;
+
+    // 통계는 선택마다 초기화, 출력은 SNIPPINGTOOL_TRACE 가 설정된 경우에만
+    if( nsCapture::CCaptureTrace::IsEnabled() )
+    {
+        qDebug() << "[OVERLAY] repaint n=" << repaintLatency_.Count << "avg=" << repaintLatency_.AverageUs()
+                 << "us min=" << repaintLatency_.MinUs << "us max=" << repaintLatency_.MaxUs << "us | avg area="
+                 << repaintPixels_ / qint64( repaintLatency_.Count ) << "px of" << width() * height();
+    }
+
+    repaintLatency_ = nsCapture::tagLatencyStats();
+    repaintPixels_ = 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///
 ///
 
 QSnippingTool::QSnippingTool( QWidget* Parent )
-    : ElaWidget( Parent ), dwAffinity( 0 )
+    : ElaWidget( Parent ), dwAffinity( 0 ), previewSerial( 0 ), captureWatcher( nullptr ), cancelHotkey( nullptr ), cancelHotkeyTimer( nullptr ), isResident( false ), isOverlayPending( false )
 {
     setWindowTitle( tr("스니핑 도구" ) );
     setupUi();
@@ -140,6 +299,50 @@ QSnippingTool::QSnippingTool( QWidget* Parent )
     connect( acCopyToClipboard, &QAction::triggered, this, &QSnippingTool::copyToClipboard );
     addAction( acCopyToClipboard );
 
+    acLastRegionCapture = new QAction( tr("마지막 영역 다시 캡처"), this );
+    acLastRegionCapture->setShortcut( QKeySequence( "Ctrl+R" ) );
+    connect( acLastRegionCapture, &QAction::triggered, this, &QSnippingTool::takeLastRegionScreenshot );
+    addAction( acLastRegionCapture );
+
+    captureService = std::make_unique< nsCapture::CCaptureService >( nsCapture::CreateDefaultBackend() );
+
+    // 저장은 작업 스레드에서, 완료 / 실패는 sigSaveFailed 및 메시지 상자로 통지
+    saveQueue = new QSaveQueue( 4, this );
+    connect( saveQueue, &QSaveQueue::sigFinished, this, &QSnippingTool::onSaveFinished );
+    connect( saveQueue, &QSaveQueue::sigProgress, this, [this]( quint64, const QString& FilePath, qint64 BytesWritten ) {
+        Q_EMIT sigSaveProgress( FilePath, BytesWritten );
+    } );
+
+    // 캡처 중에는 메인 창이 숨겨져 키 입력을 받지 못하므로, 오래 걸리는 캡처에 한해 Esc 를 전역 단축키로 등록하여 취소
+    // 다른 프로그램이 Esc 를 이미 등록한 경우 트레이 메뉴의 캡처 취소로 대신함
+    cancelHotkey = new QGlobalHotkey( this );
+    connect( cancelHotkey, &QGlobalHotkey::sigActivated, this, &QSnippingTool::CancelCapture );
+
+    cancelHotkeyTimer = new QTimer( this );
+    cancelHotkeyTimer->setSingleShot( true );
+    cancelHotkeyTimer->setInterval( CANCEL_HOTKEY_GRACE_MS );
+    connect( cancelHotkeyTimer, &QTimer::timeout, this, [this]() {
+        if( IsCapturing() == false )
+            return;
+
+        if( cancelHotkey->Register( QKeySequence( Qt::Key_Escape ) ) == false )
+            qWarning() << "[CAPTURE] Esc is not available as a global hotkey, cancel from the tray menu";
+    } );
+
+    // 모니터 구성이 바뀌면 다음 캡처 시 세션을 다시 확인
+    const auto invalidateCapture = [this]() {
+        captureService->Invalidate();
+        clearOverlayPool();
+    };
+    connect( qApp, &QGuiApplication::screenAdded, this, invalidateCapture );
+    connect( qApp, &QGuiApplication::screenRemoved, this, invalidateCapture );
+    connect( qApp, &QGuiApplication::primaryScreenChanged, this, invalidateCapture );
+
+    // 열린 세션의 프레임 캐시를 주기적으로 갱신, 캡처 시에는 변경된 영역만 복사
+    // MaxStalenessMs 는 0 으로 두어 창을 숨긴 뒤의 화면 변경을 항상 확인
+    // 캡처가 없으면 세션을 해제하고, 해제 후에는 다음 캡처까지 갱신 스레드도 깨어나지 않음
+    captureService->SetIdleRelease( WINDOWED_IDLE_RELEASE_MS );
+    captureService->SetBackgroundRefresh( 250 );
 }
 
 QPushButton* QSnippingTool::GetSaveButton() const
@@ -152,6 +355,11 @@ QPushButton* QSnippingTool::GetCopyButton() const
     return btnCopyToClipboard;
 }
 
+nsCapture::CCaptureService* QSnippingTool::GetCaptureService() const
+{
+    return captureService.get();
+}
+
 void QSnippingTool::SetDisplayAffinity( quint32 dwAffinity )
 {
     this->dwAffinity = dwAffinity;
@@ -160,6 +368,63 @@ void QSnippingTool::SetDisplayAffinity( quint32 dwAffinity )
     SetWindowDisplayAffinity( (HWND)winId(), dwAffinity );
 }
 
+void QSnippingTool::SetResident( bool IsResident, int IdleReleaseMs )
+{
+    isResident = IsResident;
+    captureService->SetIdleRelease( IsResident ? IdleReleaseMs : WINDOWED_IDLE_RELEASE_MS );
+
+    if( isResident == false )
+    {
+        clearOverlayPool();
+        return;
+    }
+
+    // 이벤트 루프 시작 후 캡처 세션과 오버레이 창을 미리 생성하여 첫 핫키도 콜드 초기화 없이 처리
+    QTimer::singleShot( 0, this, [this]() {
+        if( this->isResident == false )
+            return;
+
+        const int Warm = captureService->Prepare( 500 );
+        prepareOverlays();
+
+        if( nsCapture::CCaptureTrace::IsEnabled() )
+            qDebug() << "[RESIDENT] warm outputs:" << Warm << "overlays:" << overlayPool.size();
+    } );
+}
+
+bool QSnippingTool::IsResident() const
+{
+    return isResident;
+}
+
+void QSnippingTool::BeginOverlayLatency( std::chrono::steady_clock::time_point Pressed )
+{
+    overlayPressed = Pressed;
+    isOverlayPending = true;
+}
+
+void QSnippingTool::TakeFullScreenshot()
+{
+    takeFullScreenshot();
+}
+
+void QSnippingTool::TakeRegionScreenshot()
+{
+    // 이미 영역 선택 중이면 무시
+    if( vecSnippingWidget.isEmpty() == false )
+    {
+        isOverlayPending = false;
+        return;
+    }
+
+    takeRegionScreenshot();
+}
+
+void QSnippingTool::TakeLastRegionScreenshot()
+{
+    takeLastRegionScreenshot();
+}
+
 QPixmap QSnippingTool::RetrieveCaptureImage() const
 {
     return screenshot;
@@ -169,22 +434,47 @@ void QSnippingTool::closeEvent( QCloseEvent* event )
 {
     Q_EMIT sigCloseEvent( event );
 
+    // 상주 모드에서는 숨기기만 하고 캡처 결과는 해제하여 대기 중 메모리 사용을 줄임
+    if( isResident && event->isAccepted() )
+    {
+        event->ignore();
+        hide();
+        releaseScreenshot();
+        return;
+    }
+
     ElaWidget::closeEvent( event );
 }
 
+bool QSnippingTool::eventFilter( QObject* watched, QEvent* event )
+{
+    // 숨김 후 창이 더 이상 노출되지 않으면 캡처 시작 ( hide() 안에서 전달될 수 있어 이벤트 루프로 미룸 )
+    if( pendingCapture && event->type() == QEvent::Expose && watched == windowHandle() && windowHandle()->isExposed() == false )
+        QTimer::singleShot( 0, this, [this]() { runPendingCapture( "unexposed", true ); } );
+
+    return ElaWidget::eventFilter( watched, event );
+}
+
 void QSnippingTool::keyPressEvent( QKeyEvent* event )
 {
     if( event->key() == Qt::Key_Escape )
     {
-        close();
+        // 진행 중인 캡처가 있으면 창을 닫지 않고 캡처만 취소
+        if( IsCapturing() )
+            CancelCapture();
+        else
+            close();
     }
     ElaWidget::keyPressEvent( event );
 }
 
 void QSnippingTool::resizeEvent( QResizeEvent* event )
 {
-    if( screenshot.isNull() == false )
-        lblCaptureImage->setPixmap( screenshot.scaled( lblCaptureImage->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation ) );
+    if( previewPyramid.IsEmpty() == false )
+    {
+        updatePreview( false );
+        previewSmoothTimer->start();
+    }
 
     ElaWidget::resizeEvent( event );
 }
@@ -208,9 +498,43 @@ void QSnippingTool::takeDelayedScreenshot()
     delayTimer->start( delay * 1000 );
 }
 
+void QSnippingTool::takeLastRegionScreenshot()
+{
+    // 이전 캡처가 진행 중이면 무시
+    if( IsCapturing() )
+        return;
+
+    if( loadLastRegion().isEmpty() )
+    {
+        QMessageBox::warning( this, tr("오류"), tr("저장된 영역이 없습니다. 먼저 영역을 지정하여 캡처하세요.") );
+        return;
+    }
+
+    const bool includeMouse = chkIncludeCursor->isChecked();
+    const auto capture = [this, includeMouse]() {
+        bool IsCanceled = false;
+        Q_EMIT sigCaptureStart( &IsCanceled );
+        if( IsCanceled == true )
+            return;
+
+        // 결과는 완료 시 처리, sigCaptureFinished 도 그때 발생
+        takeScreenshotByLastRegion( includeMouse );
+    };
+
+    // 창이 이미 숨겨진 경우 ( 상주 모드 핫키 ) 대기 없이 캡처
+    if( this->isVisible() == false )
+    {
+        capture();
+        return;
+    }
+
+    // 메인 창을 숨기고 화면에서 빠진 것이 확인되면 캡처
+    captureAfterHide( capture );
+}
+
 void QSnippingTool::saveScreenshot()
 {
-    if( screenshot.isNull() )
+    if( screenshotImage.isNull() )
     {
         QMessageBox::warning( this, tr("오류"), tr("저장할 스크린샷이 없습니다.") );
         return;
@@ -220,7 +544,7 @@ void QSnippingTool::saveScreenshot()
     const QString defaultName = QDateTime::currentDateTime().toString( "yyyy-MM-dd_hh-mm-ss" ) + ".png";
     const QString filePath = QFileDialog::getSaveFileName( this, tr("스크린샷 저장"),
                                                            defaultName,
-                                                           tr("PNG 파일 (*.png);;JPEG 파일 (*.jpg *.jpeg);;모든 파일 (*.*)"), nullptr, QFileDialog::ReadOnly );
+                                                           saveFileFilter(), nullptr, QFileDialog::ReadOnly );
     if( filePath.isEmpty() == true )
         return;
 
@@ -231,39 +555,57 @@ void QSnippingTool::saveScreenshot()
         if( IsAccepted == false )
             break;
 
-        QImageWriter Writer( filePath );
-        bool IsSuccess = Writer.write( screenshot.toImage() );
-
-        if( IsSuccess == true  )
+        // 캡처 원본 QImage 를 공유하여 전달 ( toImage() 복사 없음 ), 인코딩과 기록은 작업 스레드에서
+        const quint64 JobId = saveQueue->Enqueue( filePath, screenshotImage );
+        if( JobId != 0 )
         {
-            if( IsHandled == true )
-                break;
-
-            QMessageBox::information( this, tr( "저장 완료" ), tr( "스크린샷이 성공적으로 저장되었습니다." ) );
+            pendingSaves.insert( JobId, IsHandled );
             break;
         }
 
         IsHandled = false;
-        Q_EMIT sigSaveFailed( filePath, Writer.error(), Writer.errorString(), &IsHandled );
+        Q_EMIT sigSaveFailed( filePath, QImageWriter::UnknownError, tr( "저장 대기 중인 작업이 너무 많습니다." ), &IsHandled );
         if( IsHandled == true )
             break;
 
-        QMessageBox::critical( this, tr( "저장 실패" ), tr( "스크린샷을 저장하는 중 오류가 발생했습니다." ) );
+        QMessageBox::warning( this, tr( "저장 실패" ), tr( "저장 대기 중인 작업이 너무 많습니다. 잠시 후 다시 시도하세요." ) );
         break;
 
     } while( false );
 }
 
+void QSnippingTool::onSaveFinished( quint64 JobId, const QString& FilePath, bool IsSuccess, QImageWriter::ImageWriterError Error, const QString& ErrorText )
+{
+    bool IsHandled = pendingSaves.take( JobId );
+
+    if( IsSuccess == true )
+    {
+        if( IsHandled == true )
+            return;
+
+        QMessageBox::information( this, tr( "저장 완료" ), tr( "스크린샷이 성공적으로 저장되었습니다." ) );
+        return;
+    }
+
+    IsHandled = false;
+    Q_EMIT sigSaveFailed( FilePath, Error, ErrorText, &IsHandled );
+    if( IsHandled == true )
+        return;
+
+    QMessageBox::critical( this, tr( "저장 실패" ), tr( "스크린샷을 저장하는 중 오류가 발생했습니다." ) );
+}
+
 void QSnippingTool::copyToClipboard()
 {
-    if( screenshot.isNull() )
+    if( screenshotImage.isNull() )
     {
         QMessageBox::warning( this, tr("오류"), tr("복사할 스크린샷이 없습니다.") );
         return;
     }
 
+    // 형식 목록만 알리고 변환 / 인코딩은 붙여넣는 쪽이 요청할 때 수행, 클립보드가 소유권을 가짐
     QClipboard* clipboard = QApplication::clipboard();
-    clipboard->setPixmap( screenshot );
+    clipboard->setMimeData( new QClipboardImage( screenshotImage ) );
     QMessageBox::information( this, tr("복사 완료"), tr("스크린샷이 클립보드에 복사되었습니다.") );
 }
 
@@ -275,8 +617,15 @@ void QSnippingTool::onRegionSelected()
     {
         screenshot = snipper->SelectedRegion();
 
+        // 다음 반복 캡처를 위해 가상 데스크톱 좌표로 저장
+        const int Idx = vecSnippingWidget.indexOf( snipper );
+        // 저장용 원본은 캡처 QImage 에서 선택 영역만 잘라냄
+        screenshotImage = Idx >= 0 ? vecSnippingImages[ Idx ].copy( snipper->SelectedRect() ) : screenshot.toImage();
+        if( Idx >= 0 && snipper->SelectedRect().isEmpty() == false )
+            saveLastRegion( snipper->SelectedRect().translated( vecSnippingBounds[ Idx ].topLeft() ) );
+
         // 이미지 라벨에 표시
-        lblCaptureImage->setPixmap( screenshot.scaled( lblCaptureImage->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation ) );
+        setPreview( screenshotImage );
 
         // 저장 및 복사 버튼 활성화
         btnSaveTo->setEnabled( true );
@@ -285,9 +634,7 @@ void QSnippingTool::onRegionSelected()
         // 애플리케이션 창 다시 표시
         this->show();
 
-        for( const auto w : vecSnippingWidget )
-            w->deleteLater();
-        vecSnippingWidget.clear();
+        closeOverlays();
     }
 }
 
@@ -323,6 +670,11 @@ void QSnippingTool::setupUi()
     btnTimerCapture = new QPushButton( tr("지연 캡처"), this );
     connect( btnTimerCapture, &QPushButton::clicked, this, &QSnippingTool::takeDelayedScreenshot );
 
+    btnLastRegionCapture = new QPushButton( tr("마지막 영역"), this );
+    btnLastRegionCapture->setToolTip( tr("마지막으로 지정한 영역만 다시 캡처 (Ctrl+R)") );
+    connect( btnLastRegionCapture, &QPushButton::clicked, this, &QSnippingTool::takeLastRegionScreenshot );
+    btnLastRegionCapture->setEnabled( loadLastRegion().isEmpty() == false );
+
     btnSaveTo = new QPushButton( tr("저장"), this );
     connect( btnSaveTo, &QPushButton::clicked, this, &QSnippingTool::saveScreenshot );
     btnSaveTo->setEnabled( false );
@@ -339,6 +691,7 @@ void QSnippingTool::setupUi()
     buttonLayout = new QHBoxLayout();
     buttonLayout->addWidget( btnFullCapture );
     buttonLayout->addWidget( btnRegionCapture );
+    buttonLayout->addWidget( btnLastRegionCapture );
     buttonLayout->addLayout( delayLayout );
     buttonLayout->addStretch();
     buttonLayout->addWidget( btnSaveTo );
@@ -350,88 +703,161 @@ void QSnippingTool::setupUi()
 
     delayTimer = new QTimer( this );
     connect( delayTimer, &QTimer::timeout, this, &QSnippingTool::takeScreenshotWithTimer );
+
+    hideFallbackTimer = new QTimer( this );
+    hideFallbackTimer->setSingleShot( true );
+    connect( hideFallbackTimer, &QTimer::timeout, this, [this]() { runPendingCapture( "fallback", true ); } );
+
+    previewSmoothTimer = new QTimer( this );
+    previewSmoothTimer->setSingleShot( true );
+    previewSmoothTimer->setInterval( PREVIEW_SMOOTH_DELAY_MS );
+    connect( previewSmoothTimer, &QTimer::timeout, this, [this]() { updatePreview( true ); } );
+
+    previewPool.setMaxThreadCount( 1 );
 }
 
 void QSnippingTool::takeScreenshot( bool region, bool includeMouse )
 {
-    // 메인 창 숨기기
-    this->hide();
+    // 이전 캡처가 진행 중이면 무시
+    if( IsCapturing() )
+    {
+        isOverlayPending = false;
+        return;
+    }
 
-    // 스크린샷을 찍기 전에 잠시 대기 (UI가 사라지도록)
-    QTimer::singleShot( 500, [this, region, includeMouse]() {
+    const auto capture = [this, region, includeMouse]() {
         bool IsCanceled = false;
         Q_EMIT sigCaptureStart( &IsCanceled );
         if( IsCanceled == true )
+        {
+            isOverlayPending = false;
             return;
+        }
 
+        // 결과는 완료 시 처리, sigCaptureFinished 도 그때 발생
         if( region )
             takeScreenshotByRegion( includeMouse );
         else
             takeScreenshotByFull( includeMouse );
+    };
 
-        Q_EMIT sigCaptureFinished();
-    } );
+    // 창이 이미 숨겨진 경우 ( 상주 모드 핫키, 지연 캡처 ) 대기 없이 캡처
+    if( this->isVisible() == false )
+    {
+        capture();
+        return;
+    }
+
+    // 메인 창을 숨기고 화면에서 빠진 것이 확인되면 캡처
+    captureAfterHide( capture );
 }
 
 void QSnippingTool::takeScreenshotByFull( bool IncludeMouse )
 {
-    nsDXGI::CDXGICapture DXGI;
-    if( FAILED( DXGI.Initialize() ) )
-        return;
+    nsCapture::tagCaptureRequest Request;
+    Request.IncludeCursor = IncludeMouse;
+
+    // 캡처 / 합성은 작업 스레드에서, 결과 표시만 GUI 스레드에서
+    watchCapture( captureService->CaptureAllAsync( Request, CAPTURE_DEADLINE_MS ), [this]( const nsCapture::tagCaptureResult& Result ) {
+        showCaptureResult( Result );
+    } );
+}
 
-    QRect FullRect;
+void QSnippingTool::takeScreenshotByRegion( bool IncludeMouse )
+{
+    nsCapture::tagCaptureRequest Request;
+    Request.IncludeCursor = IncludeMouse;
+
+    const auto Outputs = captureService->Outputs();
 
-    for( int idx = 0; idx < DXGI.GetDublicatorMonitorInfoCount(); ++idx )
+    QVector< QScreen* > vecScreens;
+    QVector< int > vecMonitorIdx;
+    QVector< QRect > vecBounds;
+    for( auto scr : QGuiApplication::screens() )
     {
-        const auto Info = DXGI.GetDublicatorMonitorInfo( idx );
-        if( Info == nullptr )
+        const int MonitorIdx = findOutputForScreen( scr, Outputs );
+        if( MonitorIdx < 0 )
             continue;
 
-        FullRect |= QRect( Info->Bounds.X, Info->Bounds.Y, Info->Bounds.Width, Info->Bounds.Height );
+        const auto Found = std::find_if( Outputs.cbegin(), Outputs.cend(), [MonitorIdx]( const nsCapture::tagOutputInfo& Info ) {
+            return Info.Idx == MonitorIdx;
+        } );
+
+        vecScreens.push_back( scr );
+        vecMonitorIdx.push_back( MonitorIdx );
+        vecBounds.push_back( Found->Bounds );
     }
 
-    QPixmap ScreenShot( FullRect.size() );
-    ScreenShot.fill( Qt::transparent );
-    QPainter Painter( &ScreenShot );
+    // 모든 모니터를 작업 스레드에서 동시에 캡처, 오버레이 창은 완료 후 GUI 스레드에서 표시
+    watchCapture( captureService->CaptureOutputsAsync( vecMonitorIdx, Request, CAPTURE_DEADLINE_MS ), [this, vecScreens, vecBounds]( const nsCapture::tagCaptureResult& Result ) {
+        showRegionOverlays( Result, vecScreens, vecBounds );
+    } );
+}
 
-    for( auto scr : QGuiApplication::screens() )
+void QSnippingTool::showRegionOverlays( const nsCapture::tagCaptureResult& Result, const QVector< QScreen* >& vecScreens, const QVector< QRect >& vecBounds )
+{
+    QVector< QImage > vecImages = Result.Images;
+    if( Result.Status != nsCapture::tagCaptureStatus_Ok )
+        qDebug() << "[CAPTURE] no image, status" << Result.Status;
+
+    for( int idx = 0; idx < vecScreens.size() && idx < vecImages.size(); ++idx )
     {
-        const auto ni = scr->nativeInterface<QNativeInterface::QWindowsScreen>();
-        if( ni == nullptr )
+        auto scr = vecScreens[ idx ];
+        // 캡처 중 제거된 화면 제외
+        if( vecImages[ idx ].isNull() || QGuiApplication::screens().contains( scr ) == false )
             continue;
 
-        const auto mon = ni->handle(); int MonitorIdx = -1;
+        nsCapture::CTraceSpan PixmapSpan( nsCapture::tagTraceStage_Pixmap );
+        QPixmap fullScreenshot = QPixmap::fromImage( vecImages[ idx ] );
+        PixmapSpan.End();
 
-        for( int idx = 0; idx < DXGI.GetDublicatorMonitorInfoCount(); ++idx )
-        {
-            const auto Info = DXGI.GetDublicatorMonitorInfo( idx );
-            if( Info == nullptr )
-                continue;
+        // 영역 선택 위젯 표시
+        QSnippingWidget* snipper = overlayFor( scr );
+        vecSnippingWidget.push_back( snipper );
+        vecSnippingBounds.push_back( vecBounds[ idx ] );
+        vecSnippingImages.push_back( vecImages[ idx ] );
+        snipper->Activate( fullScreenshot );
+    }
 
-            if( mon != Info->Handle )
-                continue;
+    logCaptureStats( captureService.get() );
 
-            MonitorIdx = Info->Idx;
-            break;
-        }
+    // 캡처된 모니터가 없으면 창을 다시 표시
+    if( vecSnippingWidget.isEmpty() )
+    {
+        isOverlayPending = false;
+        this->show();
+    }
+}
+
+void QSnippingTool::takeScreenshotByLastRegion( bool IncludeMouse )
+{
+    nsCapture::tagCaptureRequest Request;
+    Request.IncludeCursor = IncludeMouse;
 
-        const auto Info = DXGI.GetDublicatorMonitorInfo( MonitorIdx );
-        nsDXGI::tagScreenCaptureFilterConfig config;
-        config.MonitorIdx           = MonitorIdx;
-        config.ShowCursor           = IncludeMouse ? TRUE : FALSE;
-        config.RotationMode         = nsDXGI::tagFrameRotationMode_Auto;
-        config.OutputSize.Width     = Info->Bounds.Width;
-        config.OutputSize.Height    = Info->Bounds.Height;
-        config.SizeMode             = nsDXGI::tagFrameSizeMode_AutoSize;
-        DXGI.SetConfig( config );
-        QPixmap fullScreenshot = DXGI.CaptureToPixmap( L".jpg", nullptr, nullptr );
-        Painter.drawPixmap( Info->Bounds.X, Info->Bounds.Y, fullScreenshot );
+    // 저장된 영역에 걸친 모니터에서 해당 부분만 읽음
+    watchCapture( captureService->CaptureRegionAsync( loadLastRegion(), Request, CAPTURE_DEADLINE_MS ), [this]( const nsCapture::tagCaptureResult& Result ) {
+        showCaptureResult( Result );
+    } );
+}
+
+void QSnippingTool::showCaptureResult( const nsCapture::tagCaptureResult& Result )
+{
+    logCaptureStats( captureService.get() );
+    if( Result.Status != nsCapture::tagCaptureStatus_Ok || Result.Image.isNull() )
+    {
+        qDebug() << "[CAPTURE] no image, status" << Result.Status;
+        this->show();
+        return;
     }
 
-    screenshot = ScreenShot;
+    {
+        nsCapture::CTraceSpan PixmapSpan( nsCapture::tagTraceStage_Pixmap );
+        screenshotImage = Result.Image;
+        screenshot = QPixmap::fromImage( screenshotImage );
+    }
 
     // 화면에 표시
-    lblCaptureImage->setPixmap( screenshot.scaled( lblCaptureImage->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation ) );
+    setPreview( screenshotImage );
 
     // 저장 및 복사 버튼 활성화
     btnSaveTo->setEnabled( true );
@@ -441,62 +867,277 @@ void QSnippingTool::takeScreenshotByFull( bool IncludeMouse )
     this->show();
 }
 
-void QSnippingTool::takeScreenshotByRegion( bool IncludeMouse )
+QRect QSnippingTool::loadLastRegion() const
 {
-    nsDXGI::CDXGICapture DXGI;
-    if( FAILED( DXGI.Initialize() ) )
-        return;
+    QSettings Settings( QStringLiteral( "SnippingTool" ), QStringLiteral( "SnippingTool" ) );
+    return Settings.value( LAST_REGION_KEY ).toRect();
+}
+
+void QSnippingTool::saveLastRegion( const QRect& Region )
+{
+    QSettings Settings( QStringLiteral( "SnippingTool" ), QStringLiteral( "SnippingTool" ) );
+    Settings.setValue( LAST_REGION_KEY, Region );
+
+    btnLastRegionCapture->setEnabled( true );
+}
+
+int QSnippingTool::findOutputForScreen( QScreen* Screen, const QVector< nsCapture::tagOutputInfo >& Outputs ) const
+{
+    if( Screen == nullptr )
+        return -1;
+
+#ifdef Q_OS_WIN
+    const auto ni = Screen->nativeInterface<QNativeInterface::QWindowsScreen>();
+    if( ni != nullptr )
+    {
+        const auto mon = ( quintptr )ni->handle();
+        for( const auto& Output : Outputs )
+        {
+            if( Output.Handle == mon )
+                return Output.Idx;
+        }
+        return -1;
+    }
+#endif
+
+    // 핸들이 없는 출력(synthetic 등)은 물리 좌표 기준 위치로 비교
+    const QPoint Origin = Screen->geometry().topLeft() * Screen->devicePixelRatio();
+    for( const auto& Output : Outputs )
+    {
+        if( Output.Bounds.topLeft() == Origin )
+            return Output.Idx;
+    }
+
+    return -1;
+}
+
+QSnippingWidget* QSnippingTool::overlayFor( QScreen* Screen )
+{
+    if( const auto Pooled = overlayPool.value( Screen, nullptr ) )
+        return Pooled;
+
+    QSnippingWidget* snipper = new QSnippingWidget();
+    snipper->setScreen( Screen );
+    snipper->setGeometry( Screen->geometry() );
+    snipper->SetDisplayAffinity( dwAffinity );
+
+    connect( snipper, &QSnippingWidget::sigRegionSelected, this, &QSnippingTool::onRegionSelected );
+    connect( snipper, &QSnippingWidget::sigPresented, this, &QSnippingTool::onOverlayPresented );
+    connect( snipper, &QSnippingWidget::sigUserCancelled, this, [this]() {
+        // 애플리케이션 창 다시 표시
+        show();
+
+        closeOverlays();
+    } );
+
+    if( isResident )
+        overlayPool.insert( Screen, snipper );
+    return snipper;
+}
 
+void QSnippingTool::prepareOverlays()
+{
+    // 네이티브 창까지 미리 생성 ( SetDisplayAffinity 의 winId ), 표시는 Activate 에서
     for( auto scr : QGuiApplication::screens() )
+        overlayFor( scr );
+}
+
+void QSnippingTool::closeOverlays()
+{
+    for( const auto w : vecSnippingWidget )
     {
-        const auto ni = scr->nativeInterface<QNativeInterface::QWindowsScreen>();
-        if( ni == nullptr )
-            continue;
+        if( isResident && overlayPool.key( w, nullptr ) != nullptr )
+            w->Deactivate();
+        else
+            w->deleteLater();
+    }
 
-        const auto mon = ni->handle(); int MonitorIdx = -1;
+    vecSnippingWidget.clear();
+    vecSnippingBounds.clear();
+    vecSnippingImages.clear();
+}
 
-        for( int idx = 0; idx < DXGI.GetDublicatorMonitorInfoCount(); ++idx )
-        {
-            const auto Info = DXGI.GetDublicatorMonitorInfo( idx );
-            if( Info == nullptr )
-                continue;
+void QSnippingTool::clearOverlayPool()
+{
+    // 선택 중인 창은 closeOverlays 에서 정리
+    for( const auto w : std::as_const( overlayPool ) )
+    {
+        if( vecSnippingWidget.contains( w ) == false )
+            w->deleteLater();
+    }
+    overlayPool.clear();
+}
 
-            if( mon != Info->Handle )
-                continue;
+void QSnippingTool::onOverlayPresented()
+{
+    if( isOverlayPending == false )
+        return;
 
-            MonitorIdx = Info->Idx;
-            break;
-        }
+    isOverlayPending = false;
 
-        if( MonitorIdx < 0 )
-            continue;
+    const auto Now = std::chrono::steady_clock::now();
+    const auto Us = std::chrono::duration_cast< std::chrono::microseconds >( Now - overlayPressed ).count();
+    overlayLatency.Add( ( quint64 )qMax< qint64 >( 0, Us ) );
 
-        const auto Info = DXGI.GetDublicatorMonitorInfo( MonitorIdx );
-        nsDXGI::tagScreenCaptureFilterConfig config;
-        config.MonitorIdx           = MonitorIdx;
-        config.ShowCursor           = IncludeMouse ? TRUE : FALSE;
-        config.RotationMode         = nsDXGI::tagFrameRotationMode_Auto;
-        config.OutputSize.Width     = Info->Bounds.Width;
-        config.OutputSize.Height    = Info->Bounds.Height;
-        config.SizeMode             = nsDXGI::tagFrameSizeMode_AutoSize;
-        DXGI.SetConfig( config );
-        QPixmap fullScreenshot = DXGI.CaptureToPixmap( L".jpg", nullptr, nullptr );
+    // 통계는 항상 누적, 출력은 SNIPPINGTOOL_TRACE 가 설정된 경우에만
+    if( nsCapture::CCaptureTrace::IsEnabled() == false )
+        return;
 
-        // 영역 선택 위젯 표시
-        QSnippingWidget* snipper = new QSnippingWidget( fullScreenshot );
-        snipper->setScreen( scr );
-        snipper->setGeometry( scr->geometry() );
-        snipper->SetDisplayAffinity( dwAffinity );
-        vecSnippingWidget.push_back( snipper );
+    nsCapture::CCaptureTrace::Instance().Record( nsCapture::tagTraceStage_Overlay, overlayPressed, Now );
+    qDebug() << "[HOTKEY] overlay" << Us << "us | n=" << overlayLatency.Count << "avg=" << overlayLatency.AverageUs()
+             << "us min=" << overlayLatency.MinUs << "us max=" << overlayLatency.MaxUs << "us";
+}
 
-        connect( snipper, &QSnippingWidget::sigRegionSelected, this, &QSnippingTool::onRegionSelected );
-        connect( snipper, &QSnippingWidget::sigUserCancelled, [this]() {
-            // 애플리케이션 창 다시 표시
-            show();
+void QSnippingTool::setPreview( const QImage& Image )
+{
+    // 캡처마다 한 번 피라미드를 만들고, 이후 크기 조절은 가장 가까운 큰 단계에서 축소
+    // 전체 해상도 이미지를 읽는 생성은 작업 스레드에서, 교체와 표시는 GUI 스레드에서
+    previewSmoothTimer->stop();
+    previewPyramid.Clear();
+    const quint64 Serial = ++previewSerial;
+
+    previewPool.start( [this, Image, Serial]() {
+        nsCapture::CImagePyramid Pyramid;
+        Pyramid.Reset( Image );
+
+        QMetaObject::invokeMethod( this, [this, Pyramid, Serial]() {
+            // 그 사이 다른 캡처가 표시되었거나 해제된 경우 버림
+            if( Serial != previewSerial )
+                return;
+
+            previewPyramid = Pyramid;
+            updatePreview( true );
+        }, Qt::QueuedConnection );
+    } );
+}
 
-            for( const auto w : vecSnippingWidget )
-                w->deleteLater();
-            vecSnippingWidget.clear();
-        } );
+void QSnippingTool::updatePreview( bool IsSmooth )
+{
+    const QImage Scaled = previewPyramid.Scaled( lblCaptureImage->size(), IsSmooth );
+    if( Scaled.isNull() == false )
+        lblCaptureImage->setPixmap( QPixmap::fromImage( Scaled ) );
+}
+
+void QSnippingTool::releaseScreenshot()
+{
+    screenshot = QPixmap();
+    screenshotImage = QImage();
+    previewPyramid.Clear();
+    ++previewSerial;
+    previewSmoothTimer->stop();
+    lblCaptureImage->clear();
+    lblCaptureImage->setText( tr("화면 캡처를 시작하려면 버튼을 누르세요.") );
+
+    btnSaveTo->setEnabled( false );
+    btnCopyToClipboard->setEnabled( false );
+}
+
+bool QSnippingTool::isExcludedFromCapture()
+{
+#ifdef Q_OS_WIN
+    // SetDisplayAffinity 가 실제로 적용되었는지 확인 ( Windows 10 2004 이전에는 WDA_EXCLUDEFROMCAPTURE 실패 )
+    DWORD Affinity = WDA_NONE;
+    if( ::GetWindowDisplayAffinity( (HWND)winId(), &Affinity ) == FALSE )
+        return false;
+
+    return Affinity == WDA_EXCLUDEFROMCAPTURE;
+#else
+    return false;
+#endif
+}
+
+void QSnippingTool::captureAfterHide( std::function< void() > Capture )
+{
+    pendingCapture = std::move( Capture );
+    hideRequested = std::chrono::steady_clock::now();
+
+    const bool IsExcluded = isExcludedFromCapture();
+    if( windowHandle() != nullptr )
+        windowHandle()->installEventFilter( this );
+
+    this->hide();
+
+    // 캡처에서 제외된 창은 화면에 남아 있어도 결과에 포함되지 않으므로 대기 불필요
+    if( IsExcluded )
+    {
+        QTimer::singleShot( 0, this, [this]() { runPendingCapture( "excluded", false ); } );
+        return;
+    }
+
+    if( windowHandle() == nullptr || windowHandle()->isExposed() == false )
+    {
+        QTimer::singleShot( 0, this, [this]() { runPendingCapture( "hidden", true ); } );
+        return;
+    }
+
+    // 노출 해제 이벤트를 기다리고, 오지 않으면 기존의 고정 지연으로 대체
+    hideFallbackTimer->start( HIDE_FALLBACK_MS );
+}
+
+void QSnippingTool::runPendingCapture( const char* Reason, bool IsWaitComposition )
+{
+    if( !pendingCapture )
+        return;
+
+    hideFallbackTimer->stop();
+    const auto Capture = std::move( pendingCapture );
+    pendingCapture = nullptr;
+
+#ifdef Q_OS_WIN
+    // 창이 빠진 화면이 합성될 때까지 대기 ( 최대 한 번의 DWM 합성 주기 )
+    if( IsWaitComposition )
+        ::DwmFlush();
+#else
+    Q_UNUSED( IsWaitComposition );
+#endif
+
+    if( nsCapture::CCaptureTrace::IsEnabled() )
+    {
+        qDebug() << "[CAPTURE] ready:" << Reason
+                 << std::chrono::duration_cast< std::chrono::microseconds >( std::chrono::steady_clock::now() - hideRequested ).count() << "us after hide";
     }
+
+    Capture();
+}
+
+bool QSnippingTool::IsCapturing() const
+{
+    return captureWatcher != nullptr;
+}
+
+void QSnippingTool::CancelCapture()
+{
+    if( captureWatcher != nullptr )
+        captureWatcher->cancel();
+}
+
+void QSnippingTool::watchCapture( QFuture< nsCapture::tagCaptureResult > Future, std::function< void( const nsCapture::tagCaptureResult& ) > OnResult )
+{
+    auto Watcher = new QFutureWatcher< nsCapture::tagCaptureResult >( this );
+    captureWatcher = Watcher;
+#ifdef Q_OS_WIN
+    cancelHotkeyTimer->start();
+#endif
+
+    connect( Watcher, &QFutureWatcherBase::progressValueChanged, this, [this, Watcher]( int Value ) {
+        Q_EMIT sigCaptureProgress( Value, Watcher->progressMaximum() );
+    } );
+
+    connect( Watcher, &QFutureWatcherBase::finished, this, [this, Watcher, OnResult]() {
+        // 완료 전에 취소되면 결과가 없음
+        nsCapture::tagCaptureResult Result;
+        Result.Status = nsCapture::tagCaptureStatus_Canceled;
+        if( Watcher->isCanceled() == false && Watcher->future().resultCount() > 0 )
+            Result = Watcher->result();
+
+        captureWatcher = nullptr;
+        cancelHotkeyTimer->stop();
+        cancelHotkey->Unregister();
+        Watcher->deleteLater();
+
+        OnResult( Result );
+        Q_EMIT sigCaptureFinished();
+    } );
+
+    Watcher->setFuture( Future );
 }
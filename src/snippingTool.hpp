@@ -6,19 +6,33 @@
 #include "ElaWindow.h"
 #include "ElaWidget.h"
 
+#include "captureService.hpp"
+#include "globalHotkey.hpp"
+#include "imagePyramid.hpp"
+#include "saveQueue.hpp"
+
 // 스크린샷 영역 지정을 위한 위젯
 class QSnippingWidget : public QWidget
 {
     Q_OBJECT
 public:
-    QSnippingWidget( QPixmap Scr );
+    QSnippingWidget( QWidget* Parent = nullptr );
+
+    // 캡처 이미지로 선택 상태를 초기화하고 전체 화면 표시
+    void                                Activate( const QPixmap& Scr );
+    // 숨기고 이미지 해제, 창은 다음 Activate 를 위해 유지
+    void                                Deactivate();
 
     QPixmap                             SelectedRegion();
+    // 선택 영역, 캡처 이미지( 물리 픽셀 ) 기준
+    QRect                               SelectedRect() const;
     void                                SetDisplayAffinity( quint32 dwAffinity = 0 );
 
 Q_SIGNALS:
     void                                sigRegionSelected();
     void                                sigUserCancelled();
+    // Activate 이후 첫 paintEvent
+    void                                sigPresented();
 
 protected:
     void                                paintEvent( QPaintEvent* event ) override;
@@ -28,12 +42,23 @@ protected:
     void                                mouseReleaseEvent( QMouseEvent* event ) override;
 
 private:
+    // 선택 영역, 캡처 이미지( 물리 픽셀 ) 기준
+    QRect                               selectionRect() const;
+    // 선택 영역과 테두리가 덮는 창 영역( 논리 좌표 ), 마우스 이동 시 이전 / 새 영역만 다시 그림
+    QRect                               selectionDirtyRect() const;
+    void                                logRepaintStats();
+
     QPixmap                             screenShot_;
+    QPixmap                             dimmedShot_;            // 어둡게 합성해 둔 screenShot_, 선택 영역 밖의 배경
     QPixmap                             selectedRegion_;
+    QRect                               selectedRect_;
     QPoint                              startPos_;
     QPoint                              endPos_;
     bool                                isSelecting_;
+    bool                                isPresentPending_;
     quint32                             dwAffinity_;
+    nsCapture::tagLatencyStats          repaintLatency_;        // 선택 중 paintEvent 한 번의 비용
+    qint64                              repaintPixels_;         // 같은 기간 다시 그린 논리 픽셀 합
 };
 
 class QSnippingTool : public ElaWidget
@@ -44,20 +69,40 @@ public:
 
     QPushButton*                        GetSaveButton() const;
     QPushButton*                        GetCopyButton() const;
+    nsCapture::CCaptureService*         GetCaptureService() const;
     void                                SetDisplayAffinity( quint32 dwAffinity = 0 );
+    // 상주 모드 : 창을 닫아도 숨기기만 하고 캡처 세션 / 오버레이 창을 미리 준비, IdleReleaseMs 동안 캡처가 없으면 GPU 자원 해제 ( 0 = 해제 안 함 )
+    void                                SetResident( bool IsResident, int IdleReleaseMs = 0 );
+    bool                                IsResident() const;
+    // 핫키 시각, 다음 영역 선택 오버레이가 표시될 때까지의 지연을 기록
+    void                                BeginOverlayLatency( std::chrono::steady_clock::time_point Pressed );
 
     QPixmap                             RetrieveCaptureImage() const;
+    // 작업 스레드에서 캡처 중 ( 완료 시 sigCaptureFinished )
+    bool                                IsCapturing() const;
+
+public slots:
+    void                                TakeFullScreenshot();
+    void                                TakeRegionScreenshot();
+    void                                TakeLastRegionScreenshot();
+    // 진행 중인 캡처 취소, 시작되지 않은 모니터는 건너뜀 ( Esc, 트레이 메뉴 )
+    void                                CancelCapture();
 
 Q_SIGNALS:
     void                                sigCaptureStart( bool* IsCanceled );
     void                                sigCaptureFinished();
+    // Done / Total : 캡처가 끝난 모니터 수
+    void                                sigCaptureProgress( int Done, int Total );
     // IsAccepted 가 false 이면 저장하지 않음, IsHandled 가 true 이면 별도로 메시지 상자를 표시하지 않음
     void                                sigSaveTo( const QString& FilePath, bool* IsAccepted, bool* IsHandled );
+    // 저장은 비동기, 실패 시 작업 스레드가 끝난 뒤 GUI 스레드에서 발생
     void                                sigSaveFailed( const QString& FilePath, QImageWriter::ImageWriterError Error, const QString& ErrorText, bool* IsHandled );
+    void                                sigSaveProgress( const QString& FilePath, qint64 BytesWritten );
     void                                sigCloseEvent( QCloseEvent* Event );
 
 protected:
     void                                closeEvent( QCloseEvent* event ) override;
+    bool                                eventFilter( QObject* watched, QEvent* event ) override;
     void                                keyPressEvent( QKeyEvent* event ) override;
     void                                resizeEvent( QResizeEvent* event ) override;
 
@@ -65,7 +110,9 @@ private slots:
     void                                takeFullScreenshot();
     void                                takeRegionScreenshot();
     void                                takeDelayedScreenshot();
+    void                                takeLastRegionScreenshot();
     void                                saveScreenshot();
+    void                                onSaveFinished( quint64 JobId, const QString& FilePath, bool IsSuccess, QImageWriter::ImageWriterError Error, const QString& ErrorText );
     void                                copyToClipboard();
     void                                onRegionSelected();
     void                                takeScreenshotWithTimer();
@@ -76,6 +123,29 @@ private:
     void                                takeScreenshot( bool region = false, bool includeMouse = false );
     Q_INVOKABLE void                    takeScreenshotByFull( bool IncludeMouse );
     Q_INVOKABLE void                    takeScreenshotByRegion( bool IncludeMouse );
+    Q_INVOKABLE void                    takeScreenshotByLastRegion( bool IncludeMouse );
+    // 마지막 선택 영역, 가상 데스크톱 물리 좌표
+    QRect                               loadLastRegion() const;
+    void                                saveLastRegion( const QRect& Region );
+    int                                 findOutputForScreen( QScreen* Screen, const QVector< nsCapture::tagOutputInfo >& Outputs ) const;
+    // 화면별 오버레이 창, 상주 모드에서는 재사용
+    QSnippingWidget*                    overlayFor( QScreen* Screen );
+    void                                prepareOverlays();
+    void                                closeOverlays();
+    void                                clearOverlayPool();
+    void                                onOverlayPresented();
+    void                                releaseScreenshot();
+    // 미리보기 : Image 의 피라미드를 작업 스레드에서 만들고 완료되면 표시, IsSmooth 가 false 이면 크기 조절 중의 빠른 근사
+    void                                setPreview( const QImage& Image );
+    void                                updatePreview( bool IsSmooth );
+    // 창 숨김 후 캡처 : 캡처 제외( WDA_EXCLUDEFROMCAPTURE ) 확인 시 즉시, 아니면 노출 해제 이벤트 + DWM 합성 후, 고정 지연은 대체 수단
+    bool                                isExcludedFromCapture();
+    void                                captureAfterHide( std::function< void() > Capture );
+    void                                runPendingCapture( const char* Reason, bool IsWaitComposition );
+    // 비동기 캡처 완료 시 GUI 스레드에서 OnResult 호출 후 sigCaptureFinished
+    void                                watchCapture( QFuture< nsCapture::tagCaptureResult > Future, std::function< void( const nsCapture::tagCaptureResult& ) > OnResult );
+    void                                showCaptureResult( const nsCapture::tagCaptureResult& Result );
+    void                                showRegionOverlays( const nsCapture::tagCaptureResult& Result, const QVector< QScreen* >& vecScreens, const QVector< QRect >& vecBounds );
 
     ///////////////////////////////////////////////////////////////////////////
     /// UIs
@@ -85,6 +155,7 @@ private:
     QPushButton*                        btnFullCapture;
     QPushButton*                        btnRegionCapture;
     QPushButton*                        btnTimerCapture;
+    QPushButton*                        btnLastRegionCapture;
     QComboBox*                          cbxTimerInterval;
     QCheckBox*                          chkIncludeCursor;
     QPushButton*                        btnSaveTo;
@@ -93,11 +164,33 @@ private:
     QHBoxLayout*                        buttonLayout;
     QAction*                            acSaveTo;
     QAction*                            acCopyToClipboard;
+    QAction*                            acLastRegionCapture;
 
     quint32                             dwAffinity;
     QPixmap                             screenshot;
+    QImage                              screenshotImage;        // screenshot 의 원본, 저장 시 복사 없이 전달
     QTimer*                             delayTimer;
+    QTimer*                             hideFallbackTimer;
+    QTimer*                             previewSmoothTimer;     // 크기 조절이 멈춘 뒤 부드러운 미리보기
+    nsCapture::CImagePyramid            previewPyramid;         // screenshotImage 의 절반 해상도 단계들
+    quint64                             previewSerial;          // setPreview / releaseScreenshot 마다 증가, 늦게 끝난 피라미드는 버림
+    QThreadPool                         previewPool;            // 피라미드 생성, 한 번에 하나
+    std::function< void() >             pendingCapture;         // 창이 숨겨지길 기다리는 캡처
+    QFutureWatcher< nsCapture::tagCaptureResult >* captureWatcher; // 진행 중인 비동기 캡처
+    QGlobalHotkey*                      cancelHotkey;           // 캡처가 오래 걸릴 때만 등록하는 Esc, 창이 숨겨져 있어도 취소
+    QTimer*                             cancelHotkeyTimer;      // 캡처 시작 후 CANCEL_HOTKEY_GRACE_MS 가 지나면 cancelHotkey 등록
+    std::chrono::steady_clock::time_point hideRequested;
     QVector< QSnippingWidget* >         vecSnippingWidget;      // 모니터 수량만큼 생성
+    QVector< QRect >                    vecSnippingBounds;      // vecSnippingWidget 과 같은 순서, 각 모니터의 가상 데스크톱 영역
+    QVector< QImage >                   vecSnippingImages;      // vecSnippingWidget 과 같은 순서, 각 모니터의 캡처 원본
+    QHash< QScreen*, QSnippingWidget* > overlayPool;            // 상주 모드에서 미리 만들어 둔 오버레이 창
+    bool                                isResident;
+    bool                                isOverlayPending;       // 핫키 -> 오버레이 지연 측정 중
+    std::chrono::steady_clock::time_point overlayPressed;
+    nsCapture::tagLatencyStats          overlayLatency;
+    std::unique_ptr< nsCapture::CCaptureService > captureService;   // 모니터별 캡처 세션을 유지
+    QSaveQueue*                         saveQueue;
+    QHash< quint64, bool >              pendingSaves;           // 저장 작업 -> sigSaveTo 의 IsHandled
 };
 
 #endif //SNIPPINGTOOL_HPP
@@ -0,0 +1,93 @@
+#include "snippingTray.hpp"
+
+#include "snippingTool.hpp"
+
+namespace
+{
+    const int DEFAULT_IDLE_RELEASE_SEC = 300;
+}
+
+QSnippingTray::QSnippingTray( QSnippingTool* Tool, QObject* Parent )
+    : QObject( Parent ), tool( Tool )
+{
+    QSettings Settings( QStringLiteral( "SnippingTool" ), QStringLiteral( "SnippingTool" ) );
+    const int IdleReleaseSec = qMax( 0, Settings.value( QStringLiteral( "Resident/IdleReleaseSec" ), DEFAULT_IDLE_RELEASE_SEC ).toInt() );
+    tool->SetResident( true, IdleReleaseSec * 1000 );
+
+    // 창을 모두 닫아도 트레이에서 계속 대기
+    QApplication::setQuitOnLastWindowClosed( false );
+
+    trayMenu = new QMenu();
+    trayMenu->addAction( tr("영역 지정"), tool, &QSnippingTool::TakeRegionScreenshot );
+    trayMenu->addAction( tr("전체 화면"), tool, &QSnippingTool::TakeFullScreenshot );
+    trayMenu->addAction( tr("마지막 영역"), tool, &QSnippingTool::TakeLastRegionScreenshot );
+    auto acCancel = trayMenu->addAction( tr("캡처 취소"), tool, &QSnippingTool::CancelCapture );
+    trayMenu->addSeparator();
+    trayMenu->addAction( tr("열기"), this, &QSnippingTray::showTool );
+    trayMenu->addAction( tr("종료"), qApp, &QCoreApplication::quit );
+
+    // 메뉴를 열 때 진행 중인 캡처가 있는 경우에만 취소 가능
+    connect( trayMenu, &QMenu::aboutToShow, this, [this, acCancel]() {
+        acCancel->setEnabled( tool->IsCapturing() );
+    } );
+
+    trayIcon = new QSystemTrayIcon( this );
+    trayIcon->setIcon( tool->windowIcon().isNull() ? QApplication::style()->standardIcon( QStyle::SP_ComputerIcon ) : tool->windowIcon() );
+    trayIcon->setContextMenu( trayMenu );
+    connect( trayIcon, &QSystemTrayIcon::activated, this, &QSnippingTray::onTrayActivated );
+
+    hkRegion = registerHotkey( "Hotkey/Region", "Print" );
+    hkFull = registerHotkey( "Hotkey/Full", "Ctrl+Print" );
+    hkLastRegion = registerHotkey( "Hotkey/LastRegion", "Shift+Print" );
+
+    // 핫키 시각부터 오버레이 표시까지 측정
+    connect( hkRegion, &QGlobalHotkey::sigActivated, this, [this]( QGlobalHotkey::Clock::time_point Pressed ) {
+        tool->BeginOverlayLatency( Pressed );
+        tool->TakeRegionScreenshot();
+    } );
+    connect( hkFull, &QGlobalHotkey::sigActivated, tool, &QSnippingTool::TakeFullScreenshot );
+    connect( hkLastRegion, &QGlobalHotkey::sigActivated, tool, &QSnippingTool::TakeLastRegionScreenshot );
+
+    QStringList Hotkeys;
+    for( const auto hk : { hkRegion, hkFull, hkLastRegion } )
+    {
+        if( hk->IsRegistered() )
+            Hotkeys.push_back( hk->Sequence().toString( QKeySequence::NativeText ) );
+    }
+    trayIcon->setToolTip( tool->windowTitle() + ( Hotkeys.isEmpty() ? QString() : QStringLiteral( " ( %1 )" ).arg( Hotkeys.join( ", " ) ) ) );
+}
+
+QSnippingTray::~QSnippingTray()
+{
+    delete trayMenu;
+}
+
+void QSnippingTray::Show()
+{
+    trayIcon->show();
+}
+
+QGlobalHotkey* QSnippingTray::registerHotkey( const char* Key, const char* DefaultSequence )
+{
+    QSettings Settings( QStringLiteral( "SnippingTool" ), QStringLiteral( "SnippingTool" ) );
+    const QString Sequence = Settings.value( QLatin1String( Key ), QLatin1String( DefaultSequence ) ).toString();
+
+    auto hk = new QGlobalHotkey( this );
+    if( Sequence.isEmpty() == false )
+        hk->Register( QKeySequence::fromString( Sequence, QKeySequence::PortableText ) );
+    return hk;
+}
+
+void QSnippingTray::onTrayActivated( QSystemTrayIcon::ActivationReason Reason )
+{
+    // 클릭 시 창 표시, 캡처는 메뉴 또는 단축키로
+    if( Reason == QSystemTrayIcon::Trigger || Reason == QSystemTrayIcon::DoubleClick )
+        showTool();
+}
+
+void QSnippingTray::showTool()
+{
+    tool->show();
+    tool->raise();
+    tool->activateWindow();
+}
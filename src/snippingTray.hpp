@@ -0,0 +1,38 @@
+#ifndef SNIPPINGTRAY_HPP
+#define SNIPPINGTRAY_HPP
+
+#include <QtCore>
+#include <QtWidgets>
+
+#include "globalHotkey.hpp"
+
+class QSnippingTool;
+
+// 상주 모드 : 트레이 아이콘과 전역 단축키로 QSnippingTool 을 구동
+//
+// 설정 ( QSettings SnippingTool/SnippingTool )
+//   Hotkey/Region, Hotkey/Full, Hotkey/LastRegion : QKeySequence 문자열, 빈 값이면 등록 안 함
+//   Resident/IdleReleaseSec : 캡처가 없을 때 GPU 자원을 해제하기까지의 시간 ( 0 = 해제 안 함 )
+class QSnippingTray : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QSnippingTray( QSnippingTool* Tool, QObject* Parent = nullptr );
+    ~QSnippingTray() override;
+
+    void                                Show();
+
+private:
+    QGlobalHotkey*                      registerHotkey( const char* Key, const char* DefaultSequence );
+    void                                onTrayActivated( QSystemTrayIcon::ActivationReason Reason );
+    void                                showTool();
+
+    QSnippingTool*                      tool;
+    QSystemTrayIcon*                    trayIcon;
+    QMenu*                              trayMenu;
+    QGlobalHotkey*                      hkRegion;
+    QGlobalHotkey*                      hkFull;
+    QGlobalHotkey*                      hkLastRegion;
+};
+
+#endif //SNIPPINGTRAY_HPP
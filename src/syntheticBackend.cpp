@@ -0,0 +1,297 @@
+#include "syntheticBackend.hpp"
+
+namespace nsCapture
+{
+    namespace
+    {
+        class CSyntheticSession : public ICaptureSession
+        {
+        public:
+            CSyntheticSession( const tagOutputInfo& Output, const CSyntheticBackend::ScriptFn& Script )
+                : m_output( Output ), m_acquirer( &m_source, m_source.Clock() ), m_frameNo( 0 ), m_mirrorFrameNo( 0 ), m_mirrorPresentTime( 0 ), m_directFrames( 0 )
+            {
+                // equivalent of device / staging resource creation
+                m_cache.Reset( Output.Bounds.size() );
+
+                if( Script )
+                    Script( m_output, &m_source );
+                else
+                    m_source.Push( CScriptedDuplicationSource::tagScriptEvent_Present );
+            }
+
+            const tagOutputInfo& Output() const override
+            {
+                return m_output;
+            }
+
+            tagCaptureStatus Capture( const tagCaptureRequest& Request, QImage* pRetImage, tagFrameReason* pRetReason ) override
+            {
+                tagFrameReason Reason = tagFrameReason_Cached;
+                tagCaptureStatus Status = tagCaptureStatus_Ok;
+
+                if( m_cache.IsWithinStaleness( Request.MaxStalenessMs ) )
+                    m_cache.RecordHit();
+                else
+                    Status = refresh( ( m_cache.IsValid() || m_mirrorFrameNo != 0 ) ? 0 : Request.TimeoutMs, &Reason );
+
+                if( pRetReason != nullptr )
+                    *pRetReason = Reason;
+
+                if( Status != tagCaptureStatus_Ok )
+                    return Status;
+
+                if( pRetImage == nullptr )
+                    return tagCaptureStatus_Failed;
+
+                // identity output, the cached image is handed out as is
+                *pRetImage = m_cache.Image();
+                ++m_directFrames;
+                return tagCaptureStatus_Ok;
+            }
+
+            tagCaptureStatus CaptureRect( const tagCaptureRequest& Request, const QRect& Rect, QImage* pTarget, tagFrameReason* pRetReason ) override
+            {
+                if( pTarget == nullptr || pTarget->size() != Rect.size() || QRect( QPoint( 0, 0 ), m_output.Bounds.size() ).contains( Rect ) == false )
+                    return tagCaptureStatus_Failed;
+
+                // warm cache : refreshed as usual, only the rows of Rect are read from it
+                if( m_cache.IsValid() )
+                    return ICaptureSession::CaptureRect( Request, Rect, pTarget, pRetReason );
+
+                // cold cache : nothing is cached, only the region is produced ( the GPU mirror of the DXGI session )
+                const bool HasMirror = m_mirrorFrameNo != 0;
+                CTraceSpan AcquireSpan( tagTraceStage_Acquire );
+                const auto Acquired = m_acquirer.Acquire( std::chrono::milliseconds( HasMirror ? 0 : qMax( 0, Request.TimeoutMs ) ), HasMirror );
+                AcquireSpan.End();
+                if( pRetReason != nullptr )
+                    *pRetReason = Acquired.Reason;
+
+                switch( Acquired.Reason )
+                {
+                    case tagFrameReason_Fresh:
+                        m_mirrorFrameNo = ++m_frameNo;
+                        m_mirrorPresentTime = Acquired.FrameInfo.LastPresentTime;
+                        m_source.ReleaseFrame();
+                        m_cache.RecordMiss();
+                        break;
+                    case tagFrameReason_Cached:
+                        m_cache.RecordHit();
+                        break;
+                    case tagFrameReason_Timeout:
+                        return tagCaptureStatus_Timeout;
+                    case tagFrameReason_AccessLost:
+                        m_cache.Invalidate();
+                        m_mirrorFrameNo = 0;
+                        return tagCaptureStatus_AccessLost;
+                    default:
+                        return tagCaptureStatus_Failed;
+                }
+
+                // the pattern follows virtual desktop coordinates, rendering the region alone equals cutting it from the full frame
+                tagOutputInfo Region = m_output;
+                Region.Bounds = Rect.translated( m_output.Bounds.topLeft() );
+                CSyntheticBackend::RenderPattern( Region, m_mirrorFrameNo, pTarget );
+                ++m_directFrames;
+                return tagCaptureStatus_Ok;
+            }
+
+            tagCaptureStatus Refresh( int TimeoutMs ) override
+            {
+                tagFrameReason Reason = tagFrameReason_None;
+                return refresh( TimeoutMs, &Reason );
+            }
+
+            tagFrameCacheStats CacheStats() const override
+            {
+                tagFrameCacheStats Stats = m_cache.Stats();
+                Stats.DirectFrames = m_directFrames;
+                return Stats;
+            }
+
+        private:
+            tagCaptureStatus refresh( int TimeoutMs, tagFrameReason* pRetReason )
+            {
+                // a region capture left its present behind, a static desktop is served from it
+                const bool HasMirror = !m_cache.IsValid() && m_mirrorFrameNo != 0;
+                CTraceSpan AcquireSpan( tagTraceStage_Acquire );
+                const auto Acquired = m_acquirer.Acquire( std::chrono::milliseconds( qMax( 0, TimeoutMs ) ), m_cache.IsValid() || HasMirror );
+                AcquireSpan.End();
+                *pRetReason = Acquired.Reason;
+
+                switch( Acquired.Reason )
+                {
+                    case tagFrameReason_Fresh:
+                    {
+                        // the pattern changes everywhere, so every present is a full refresh
+                        auto& Image = m_cache.MutableImage();
+                        CSyntheticBackend::RenderPattern( m_output, ++m_frameNo, &Image );
+                        m_source.ReleaseFrame();
+                        m_cache.Commit( Acquired.FrameInfo.LastPresentTime, true, ( quint64 )Image.sizeInBytes() );
+                        m_cache.RecordMiss();
+                        m_mirrorFrameNo = 0;
+                    } break;
+                    case tagFrameReason_Cached:
+                        if( HasMirror )
+                        {
+                            auto& Image = m_cache.MutableImage();
+                            CSyntheticBackend::RenderPattern( m_output, m_mirrorFrameNo, &Image );
+                            m_cache.Commit( m_mirrorPresentTime, true, ( quint64 )Image.sizeInBytes() );
+                            m_cache.RecordMiss();
+                            m_mirrorFrameNo = 0;
+                            break;
+                        }
+                        m_cache.MarkVerified();
+                        m_cache.RecordHit();
+                        break;
+                    case tagFrameReason_Timeout:
+                        return tagCaptureStatus_Timeout;
+                    case tagFrameReason_AccessLost:
+                        m_cache.Invalidate();
+                        m_mirrorFrameNo = 0;
+                        return tagCaptureStatus_AccessLost;
+                    default:
+                        return tagCaptureStatus_Failed;
+                }
+
+                return tagCaptureStatus_Ok;
+            }
+
+            tagOutputInfo               m_output;
+            CScriptedDuplicationSource  m_source;
+            CFrameAcquirer              m_acquirer;
+            quint64                     m_frameNo;
+            quint64                     m_mirrorFrameNo;        // frame of the last region-only present while the cache is cold, 0 = none
+            qint64                      m_mirrorPresentTime;
+            quint64                     m_directFrames;
+            CFrameCache                 m_cache;
+        };
+    }
+
+    CSyntheticBackend::CSyntheticBackend()
+        : CSyntheticBackend( QVector< QRect >{ QRect( 0, 0, 1920, 1080 ) } )
+    {
+    }
+
+    CSyntheticBackend::CSyntheticBackend( const QVector< QRect >& Layout )
+        : m_layout( Layout ), m_generation( 1 ), m_enumeratedGeneration( 0 )
+    {
+    }
+
+    void CSyntheticBackend::SetLayout( const QVector< QRect >& Layout )
+    {
+        std::lock_guard< std::mutex > Lock( m_lock );
+        m_layout = Layout;
+        ++m_generation;
+    }
+
+    QVector< QRect > CSyntheticBackend::Layout() const
+    {
+        std::lock_guard< std::mutex > Lock( m_lock );
+        return m_layout;
+    }
+
+    void CSyntheticBackend::SetScript( ScriptFn Script )
+    {
+        std::lock_guard< std::mutex > Lock( m_lock );
+        m_script = std::move( Script );
+    }
+
+    QVector< QRect > CSyntheticBackend::ParseLayout( const QString& Text )
+    {
+        // X11 style offsets ( 1920x1080-1920+0 ) and an explicit sign after the plus ( 1920x1080+-1920+0 )
+        static const QRegularExpression Expr( R"(^\s*(\d+)x(\d+)(\+-?\d+|-\d+)(\+-?\d+|-\d+)\s*$)" );
+        const auto Offset = []( QString Value ) {
+            if( Value.startsWith( '+' ) )
+                Value.remove( 0, 1 );
+            return Value.toInt();
+        };
+
+        QVector< QRect > Layout;
+        for( const auto& Item : Text.split( ';', Qt::SkipEmptyParts ) )
+        {
+            const auto Match = Expr.match( Item );
+            if( Match.hasMatch() == false )
+                return QVector< QRect >();
+
+            Layout.push_back( QRect( Offset( Match.captured( 3 ) ), Offset( Match.captured( 4 ) ),
+                                     Match.captured( 1 ).toInt(), Match.captured( 2 ).toInt() ) );
+        }
+
+        return Layout;
+    }
+
+    QString CSyntheticBackend::Name() const
+    {
+        return QStringLiteral( "synthetic" );
+    }
+
+    bool CSyntheticBackend::IsTopologyCurrent()
+    {
+        std::lock_guard< std::mutex > Lock( m_lock );
+        return m_generation == m_enumeratedGeneration;
+    }
+
+    bool CSyntheticBackend::EnumerateOutputs( QVector< tagOutputInfo >* pRetOutputs )
+    {
+        if( pRetOutputs == nullptr )
+            return false;
+
+        std::lock_guard< std::mutex > Lock( m_lock );
+
+        pRetOutputs->clear();
+        for( int idx = 0; idx < m_layout.size(); ++idx )
+        {
+            tagOutputInfo Output;
+            Output.Idx      = idx;
+            Output.Bounds   = m_layout[ idx ];
+            Output.Name     = QString( "Synthetic %1: %2x%3 @ %4,%5" )
+                                .arg( idx + 1 )
+                                .arg( Output.Bounds.width() ).arg( Output.Bounds.height() )
+                                .arg( Output.Bounds.x() ).arg( Output.Bounds.y() );
+            pRetOutputs->push_back( Output );
+        }
+
+        m_enumeratedGeneration = m_generation;
+        return true;
+    }
+
+    std::unique_ptr< ICaptureSession > CSyntheticBackend::OpenSession( const tagOutputInfo& Output )
+    {
+        if( Output.Bounds.isEmpty() )
+            return nullptr;
+
+        ScriptFn Script;
+        {
+            std::lock_guard< std::mutex > Lock( m_lock );
+            Script = m_script;
+        }
+
+        return std::make_unique< CSyntheticSession >( Output, Script );
+    }
+
+    void CSyntheticBackend::RenderPattern( const tagOutputInfo& Output, quint64 FrameNo, QImage* pImage )
+    {
+        if( pImage == nullptr || pImage->isNull() )
+            return;
+
+        // virtual desktop coordinates drive the pattern, so a composed image is seamless across outputs
+        const int Width  = pImage->width();
+        const int Height = pImage->height();
+
+        for( int y = 0; y < Height; ++y )
+        {
+            auto Line = reinterpret_cast< quint32* >( pImage->scanLine( y ) );
+            const quint32 gy = ( quint32 )( Output.Bounds.y() + y );
+
+            for( int x = 0; x < Width; ++x )
+            {
+                const quint32 gx = ( quint32 )( Output.Bounds.x() + x );
+                const quint32 r = ( gx + ( quint32 )FrameNo ) & 0xFF;
+                const quint32 g = gy & 0xFF;
+                const quint32 b = ( ( gx >> 8 ) ^ ( gy >> 8 ) ^ ( quint32 )Output.Idx ) * 37 & 0xFF;
+                Line[ x ] = 0xFF000000u | ( r << 16 ) | ( g << 8 ) | b;
+            }
+        }
+    }
+
+} // nsCapture
@@ -0,0 +1,49 @@
+#ifndef SYNTHETICBACKEND_HPP
+#define SYNTHETICBACKEND_HPP
+
+#include "captureService.hpp"
+
+namespace nsCapture
+{
+    ///////////////////////////////////////////////////////////////////////////
+    /// CSyntheticBackend
+    ///
+    /// Portable frame source used where DXGI is not available ( headless / offscreen runs ).
+    /// Every output renders a deterministic pattern, so the session logic can be driven without a GPU.
+
+    class CSyntheticBackend : public ICaptureBackend
+    {
+    public:
+        CSyntheticBackend();
+        explicit CSyntheticBackend( const QVector< QRect >& Layout );
+
+        // replace the monitor layout, counts as a topology change
+        void                            SetLayout( const QVector< QRect >& Layout );
+        QVector< QRect >                Layout() const;
+
+        // scripts the duplication source of every new session, default: one present then a static desktop
+        typedef std::function< void( const tagOutputInfo& Output, CScriptedDuplicationSource* pSource ) >  ScriptFn;
+        void                            SetScript( ScriptFn Script );
+
+        // parse "1920x1080+0+0;2560x1440+1920+0" style layout strings, negative offsets as -1920 or +-1920
+        static QVector< QRect >         ParseLayout( const QString& Text );
+
+        QString                         Name() const override;
+        bool                            IsTopologyCurrent() override;
+        bool                            EnumerateOutputs( QVector< tagOutputInfo >* pRetOutputs ) override;
+        std::unique_ptr< ICaptureSession > OpenSession( const tagOutputInfo& Output ) override;
+
+        // fills Image with the pattern of the given output and frame number
+        static void                     RenderPattern( const tagOutputInfo& Output, quint64 FrameNo, QImage* pImage );
+
+    private:
+        mutable std::mutex              m_lock;
+        QVector< QRect >                m_layout;
+        quint64                         m_generation;
+        quint64                         m_enumeratedGeneration;
+        ScriptFn                        m_script;
+    };
+
+} // nsCapture
+
+#endif //SYNTHETICBACKEND_HPP
@@ -0,0 +1,30 @@
+# ctest 용 : SnippingToolCapture 를 synthetic 백엔드로 실행하여 종료 코드와 stdout 의 처음 바이트( 파일 서명 ) 를 확인
+#
+#   cmake -DCAPTURE=<exe> -DLAYOUT=<WxH+X+Y;...> -DARGS="<공백으로 구분한 인자>" -DEXPECT_EXIT=<0-5>
+#         [-DEXPECT_HEAD=<16 진수>] -DOUT=<stdout 파일> -P headlessCheck.cmake
+
+foreach( Var CAPTURE LAYOUT EXPECT_EXIT OUT )
+    if( NOT DEFINED ${Var} )
+        message( FATAL_ERROR "${Var} is not set" )
+    endif ()
+endforeach ()
+
+separate_arguments( Args UNIX_COMMAND "${ARGS}" )
+
+execute_process( COMMAND "${CAPTURE}" --synthetic "${LAYOUT}" ${Args}
+                 RESULT_VARIABLE Ret
+                 OUTPUT_FILE "${OUT}"
+                 ERROR_VARIABLE Err )
+
+if( NOT "${Ret}" STREQUAL "${EXPECT_EXIT}" )
+    message( FATAL_ERROR "exit code ${Ret}, expected ${EXPECT_EXIT}\n${Err}" )
+endif ()
+
+if( DEFINED EXPECT_HEAD AND NOT "${EXPECT_HEAD}" STREQUAL "" )
+    string( LENGTH "${EXPECT_HEAD}" HexLength )
+    math( EXPR ByteLength "${HexLength} / 2" )
+    file( READ "${OUT}" Head LIMIT ${ByteLength} HEX )
+    if( NOT "${Head}" STREQUAL "${EXPECT_HEAD}" )
+        message( FATAL_ERROR "stdout starts with ${Head}, expected ${EXPECT_HEAD}" )
+    endif ()
+endif ()
@@ -0,0 +1,7 @@
+#include "headlessCapture.hpp"
+
+// UI 없는 캡처 전용 실행 파일 ( CI / 스크립트 용 ), QtSnippingTool --headless 와 동일
+int main( int argc, char* argv[] )
+{
+    return nsCapture::RunHeadlessCapture( argc, argv );
+}